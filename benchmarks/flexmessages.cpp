@@ -0,0 +1,106 @@
+// Encodes a stream of 100k AcknowledgeMessages in their small form (DSK), and
+// decodes it both generically into AmfObjects and into typed messages. This is
+// the shape of the responses a BlazeDS/LCDS endpoint sends for remoting and
+// messaging calls.
+//
+// Build with `make bench` and run benchmarks/flexmessages [iterations].
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "deserializer.hpp"
+#include "serializationcontext.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfobject.hpp"
+#include "types/amfstring.hpp"
+#include "utils/amfflexmessages.hpp"
+
+using namespace amf;
+
+static const int NUM_MESSAGES = 100000;
+
+static std::string uuid(int i) {
+	static const char hex[] = "0123456789ABCDEF";
+
+	std::string ret("DE7E2A1B-0C4D-4E5F-8A9B-000000000000");
+	for (size_t pos = ret.size(); i > 0; i >>= 4)
+		ret[--pos] = hex[i & 0x0F];
+
+	return ret;
+}
+
+static AcknowledgeMessage buildMessage(int i) {
+	AmfObject result("de.ventero.AmfBench.Result", false, false);
+	result.addSealedProperty("id", AmfInteger(i));
+	result.addSealedProperty("name", AmfString("item" + std::to_string(i)));
+
+	AcknowledgeMessage msg;
+	msg.body = AmfItemPtr(result);
+	msg.clientId = "DE7E2A1B-0C4D-4E5F-8A9B-0C1D2E3F4A5B";
+	msg.messageId = uuid(i);
+	msg.correlationId = uuid(i + NUM_MESSAGES);
+	msg.timestamp = 1400000000000.0 + i;
+	return msg;
+}
+
+template<typename F>
+static double measure(int iterations, F f) {
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i)
+		f();
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+	return elapsed.count() / iterations;
+}
+
+int main(int argc, char* argv[]) {
+	int iterations = argc > 1 ? std::atoi(argv[1]) : 5;
+	if (iterations <= 0) iterations = 1;
+
+	std::vector<AcknowledgeMessage> messages;
+	messages.reserve(NUM_MESSAGES);
+	for (int i = 0; i < NUM_MESSAGES; ++i)
+		messages.push_back(buildMessage(i));
+
+	v8 data;
+	double encode = measure(iterations, [&]() {
+		// Like a response stream, all messages share one context.
+		SerializationContext ctx;
+		data.clear();
+		for (const AcknowledgeMessage& msg : messages) {
+			v8 buf = msg.serialize(ctx);
+			data.insert(data.end(), buf.begin(), buf.end());
+		}
+	});
+	std::cout << NUM_MESSAGES << " messages, " << data.size() << " bytes" << std::endl;
+	std::cout << "serialize:   " << encode << " ms" << std::endl;
+
+	double generic = measure(iterations, [&]() {
+		SerializationContext ctx;
+		auto it = data.cbegin();
+		for (int i = 0; i < NUM_MESSAGES; ++i) {
+			AmfItemPtr ptr = Deserializer::deserialize(it, data.cend(), ctx);
+			if (ptr.asPtr<AmfObject>() == nullptr)
+				std::abort();
+		}
+		if (it != data.cend())
+			std::abort();
+	});
+	std::cout << "generic:     " << generic << " ms" << std::endl;
+
+	double typed = measure(iterations, [&]() {
+		SerializationContext ctx;
+		auto it = data.cbegin();
+		for (int i = 0; i < NUM_MESSAGES; ++i) {
+			AmfItemPtr ptr = AcknowledgeMessage::deserializePtr(it, data.cend(), ctx);
+			if (ptr.as<AcknowledgeMessage>().messageId.empty())
+				std::abort();
+		}
+		if (it != data.cend())
+			std::abort();
+	});
+	std::cout << "typed:       " << typed << " ms" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,149 @@
+// Converts an array of 100k objects to JSON, both by deserializing it into
+// AmfItems and walking the tree, and with AmfJson directly from the
+// serialized bytes. The JSON is then encoded back, both by building AmfItems
+// (as a converter from a JSON DOM would, without the time to parse the JSON)
+// and with AmfJson directly from the text.
+//
+// Build with `make bench` and run benchmarks/json [iterations].
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include "deserializer.hpp"
+#include "serializationcontext.hpp"
+#include "types/amfarray.hpp"
+#include "types/amfbool.hpp"
+#include "types/amfdouble.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfobject.hpp"
+#include "types/amfstring.hpp"
+#include "utils/amfjson.hpp"
+
+using namespace amf;
+
+static const int NUM_OBJECTS = 100000;
+
+static AmfObject buildObject(int i) {
+	AmfObject obj("de.ventero.AmfBench.Item", false, false);
+	obj.addSealedProperty("id", AmfInteger(i));
+	obj.addSealedProperty("price", AmfDouble(i * 0.25));
+	obj.addSealedProperty("name", AmfString("item" + std::to_string(i)));
+	obj.addSealedProperty("enabled", AmfBool(i % 2 == 0));
+	obj.addSealedProperty("category", AmfInteger(i % 16));
+	return obj;
+}
+
+// The tree walk of the types used above, as done by consumers so far. Strings
+// are not escaped, which only favours this path.
+static void treeToJson(const AmfItemPtr& item, std::string& out) {
+	if (const AmfInteger* i = item.asPtr<AmfInteger>()) {
+		out += std::to_string(i->value);
+	} else if (const AmfDouble* d = item.asPtr<AmfDouble>()) {
+		char buf[32];
+		out.append(buf, std::snprintf(buf, sizeof(buf), "%.17g", d->value));
+	} else if (const AmfBool* b = item.asPtr<AmfBool>()) {
+		out += b->value ? "true" : "false";
+	} else if (const AmfString* s = item.asPtr<AmfString>()) {
+		out += '"' + s->value + '"';
+	} else if (const AmfArray* a = item.asPtr<AmfArray>()) {
+		out.push_back('[');
+		for (size_t i = 0; i < a->dense.size(); ++i) {
+			if (i > 0) out.push_back(',');
+			treeToJson(a->dense[i], out);
+		}
+		out.push_back(']');
+	} else if (const AmfObject* o = item.asPtr<AmfObject>()) {
+		out.push_back('{');
+		bool first = true;
+		for (const std::string& name : o->objectTraits().attributes) {
+			if (!first) out.push_back(',');
+			first = false;
+			out += '"' + name + "\":";
+			treeToJson(o->sealedProperties.at(name), out);
+		}
+		out.push_back('}');
+	} else {
+		out += "null";
+	}
+}
+
+template<typename F>
+static double measure(int iterations, F f) {
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i)
+		f();
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+	return elapsed.count() / iterations;
+}
+
+int main(int argc, char* argv[]) {
+	int iterations = argc > 1 ? std::atoi(argv[1]) : 5;
+	if (iterations <= 0) iterations = 1;
+
+	AmfArray array;
+	array.dense.reserve(NUM_OBJECTS);
+	for (int i = 0; i < NUM_OBJECTS; ++i)
+		array.push_back(buildObject(i));
+
+	SerializationContext sctx;
+	v8 data = array.serialize(sctx);
+
+	size_t size = 0;
+	double tree = measure(iterations, [&]() {
+		SerializationContext ctx;
+		auto it = data.cbegin();
+		AmfItemPtr ptr = Deserializer::deserialize(it, data.cend(), ctx);
+
+		std::string json;
+		treeToJson(ptr, json);
+		size = json.size();
+	});
+
+	std::string json;
+	double direct = measure(iterations, [&]() {
+		json.clear();
+		auto it = data.cbegin();
+		AmfJson::transcode(it, data.cend(), [&](const char* text, size_t size) {
+			json.append(text, size);
+		});
+		if (it != data.cend())
+			std::abort();
+	});
+
+	double build = measure(iterations, [&]() {
+		AmfArray items;
+		items.dense.reserve(NUM_OBJECTS);
+		for (int i = 0; i < NUM_OBJECTS; ++i) {
+			AmfObject obj("", true, false);
+			obj.addDynamicProperty("id", AmfInteger(i));
+			obj.addDynamicProperty("price", AmfDouble(i * 0.25));
+			obj.addDynamicProperty("name", AmfString("item" + std::to_string(i)));
+			obj.addDynamicProperty("enabled", AmfBool(i % 2 == 0));
+			obj.addDynamicProperty("category", AmfInteger(i % 16));
+			items.push_back(std::move(obj));
+		}
+
+		SerializationContext ctx;
+		if (items.serialize(ctx).empty())
+			std::abort();
+	});
+
+	v8 encoded;
+	double fromJson = measure(iterations, [&]() {
+		SerializationContext ctx;
+		encoded = AmfJson::fromJson(json, ctx);
+	});
+
+	std::cout << NUM_OBJECTS << " objects, " << data.size() << " bytes AMF, "
+		<< size << " bytes JSON" << std::endl;
+	std::cout << "tree:    " << tree << " ms (" << data.size() / tree / 1000 << " MB/s)" << std::endl;
+	std::cout << "AmfJson: " << direct << " ms (" << data.size() / direct / 1000 << " MB/s)" << std::endl;
+	std::cout << "JSON to AMF, " << encoded.size() << " bytes" << std::endl;
+	std::cout << "tree:    " << build << " ms" << std::endl;
+	std::cout << "AmfJson: " << fromJson << " ms (" << json.size() / fromJson / 1000 << " MB/s)" << std::endl;
+
+	return 0;
+}
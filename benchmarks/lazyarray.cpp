@@ -0,0 +1,80 @@
+// Reads 10 elements of an array of 100k objects, both by decoding the whole
+// array and through an AmfLazyArray.
+//
+// Build with `make bench` and run benchmarks/lazyarray [iterations].
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "deserializer.hpp"
+#include "serializationcontext.hpp"
+#include "types/amfarray.hpp"
+#include "types/amfdouble.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfobject.hpp"
+#include "types/amfstring.hpp"
+#include "utils/amflazyarray.hpp"
+
+using namespace amf;
+
+static const int NUM_OBJECTS = 100000;
+static const int NUM_ACCESSED = 10;
+
+static AmfObject buildObject(int i) {
+	AmfObject obj("de.ventero.AmfBench.Item", false, false);
+	obj.addSealedProperty("id", AmfInteger(i));
+	obj.addSealedProperty("name", AmfString("item" + std::to_string(i)));
+	obj.addSealedProperty("price", AmfDouble(i * 0.25));
+	obj.addSealedProperty("tags", AmfArray(std::vector<AmfString> { "a", "b", "c" }));
+	return obj;
+}
+
+template<typename F>
+static double measure(int iterations, F f) {
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i)
+		f();
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+	return elapsed.count() / iterations;
+}
+
+int main(int argc, char* argv[]) {
+	int iterations = argc > 1 ? std::atoi(argv[1]) : 5;
+	if (iterations <= 0) iterations = 1;
+
+	AmfArray array;
+	for (int i = 0; i < NUM_OBJECTS; ++i)
+		array.push_back(buildObject(i));
+
+	SerializationContext sctx;
+	v8 data = array.serialize(sctx);
+	std::cout << NUM_OBJECTS << " objects, " << data.size() << " bytes, "
+		<< NUM_ACCESSED << " accessed" << std::endl;
+
+	double full = measure(iterations, [&]() {
+		SerializationContext ctx;
+		auto it = data.cbegin();
+		AmfItemPtr ptr = Deserializer::deserialize(it, data.cend(), ctx);
+		AmfArray& ret = ptr.as<AmfArray>();
+		for (int i = 0; i < NUM_ACCESSED; ++i) {
+			if (ret.at<AmfObject>(i * (NUM_OBJECTS / NUM_ACCESSED)).sealedProperties.size() != 4)
+				std::abort();
+		}
+	});
+	std::cout << "full: " << full << " ms" << std::endl;
+
+	double lazy = measure(iterations, [&]() {
+		SerializationContext ctx;
+		auto it = data.cbegin();
+		AmfLazyArray ret = AmfLazyArray::deserialize(it, data.cend(), ctx);
+		for (int i = 0; i < NUM_ACCESSED; ++i) {
+			if (ret.at<AmfObject>(i * (NUM_OBJECTS / NUM_ACCESSED)).sealedProperties.size() != 4)
+				std::abort();
+		}
+	});
+	std::cout << "lazy: " << lazy << " ms" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,87 @@
+// Encodes an array of 100k objects sharing the same traits, and decodes it both
+// into objects and into columns. This is the most common shape of real world payloads (e.g.
+// a list of value objects returned by a remoting call).
+//
+// Build with `make bench` and run benchmarks/objectarray [iterations].
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "deserializer.hpp"
+#include "serializationcontext.hpp"
+#include "types/amfarray.hpp"
+#include "types/amfbool.hpp"
+#include "types/amfdouble.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfobject.hpp"
+#include "types/amfstring.hpp"
+#include "utils/amfcolumns.hpp"
+
+using namespace amf;
+
+static const int NUM_OBJECTS = 100000;
+
+static AmfObject buildObject(int i) {
+	AmfObject obj("de.ventero.AmfBench.Item", false, false);
+	obj.addSealedProperty("id", AmfInteger(i));
+	obj.addSealedProperty("price", AmfDouble(i * 0.25));
+	obj.addSealedProperty("name", AmfString("item" + std::to_string(i)));
+	obj.addSealedProperty("enabled", AmfBool(i % 2 == 0));
+	obj.addSealedProperty("category", AmfInteger(i % 16));
+	return obj;
+}
+
+static AmfArray buildArray() {
+	AmfArray array;
+	array.dense.reserve(NUM_OBJECTS);
+	for (int i = 0; i < NUM_OBJECTS; ++i)
+		array.push_back(buildObject(i));
+
+	return array;
+}
+
+template<typename F>
+static double measure(int iterations, F f) {
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i)
+		f();
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+	return elapsed.count() / iterations;
+}
+
+int main(int argc, char* argv[]) {
+	int iterations = argc > 1 ? std::atoi(argv[1]) : 5;
+	if (iterations <= 0) iterations = 1;
+
+	AmfArray array = buildArray();
+	v8 data;
+
+	double encode = measure(iterations, [&]() {
+		SerializationContext ctx;
+		data = array.serialize(ctx);
+	});
+	std::cout << NUM_OBJECTS << " objects, " << data.size() << " bytes" << std::endl;
+	std::cout << "serialize:   " << encode << " ms" << std::endl;
+
+	double decode = measure(iterations, [&]() {
+		SerializationContext ctx;
+		auto it = data.cbegin();
+		AmfItemPtr ptr = Deserializer::deserialize(it, data.cend(), ctx);
+		if (it != data.cend() || ptr.as<AmfArray>().dense.size() != NUM_OBJECTS)
+			std::abort();
+	});
+	std::cout << "deserialize: " << decode << " ms" << std::endl;
+
+	double columns = measure(iterations, [&]() {
+		SerializationContext ctx;
+		auto it = data.cbegin();
+		AmfColumns cols = AmfColumns::deserialize(it, data.cend(), ctx);
+		if (it != data.cend() || cols.rows != NUM_OBJECTS)
+			std::abort();
+	});
+	std::cout << "columns:     " << columns << " ms" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,91 @@
+// Decodes and encodes an array of 200k objects sequentially and with
+// AmfParallel on 1 to 32 threads.
+//
+// Build with `make bench` and run benchmarks/parallel [iterations].
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "deserializer.hpp"
+#include "serializationcontext.hpp"
+#include "types/amfarray.hpp"
+#include "types/amfdouble.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfobject.hpp"
+#include "types/amfstring.hpp"
+#include "utils/amfparallel.hpp"
+
+using namespace amf;
+
+static const int NUM_OBJECTS = 200000;
+
+static AmfObject buildObject(int i) {
+	AmfObject obj("de.ventero.AmfBench.Item", false, false);
+	obj.addSealedProperty("id", AmfInteger(i));
+	obj.addSealedProperty("name", AmfString("item" + std::to_string(i)));
+	obj.addSealedProperty("price", AmfDouble(i * 0.25));
+	obj.addSealedProperty("tags", AmfArray(std::vector<AmfString> { "a", "b", "c" }));
+	return obj;
+}
+
+template<typename F>
+static double measure(int iterations, F f) {
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i)
+		f();
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+	return elapsed.count() / iterations;
+}
+
+int main(int argc, char* argv[]) {
+	int iterations = argc > 1 ? std::atoi(argv[1]) : 5;
+	if (iterations <= 0) iterations = 1;
+
+	AmfArray array;
+	for (int i = 0; i < NUM_OBJECTS; ++i)
+		array.push_back(buildObject(i));
+
+	SerializationContext sctx;
+	v8 data = array.serialize(sctx);
+	std::cout << NUM_OBJECTS << " objects, " << data.size() << " bytes" << std::endl;
+
+	double sequential = measure(iterations, [&]() {
+		SerializationContext ctx;
+		auto it = data.cbegin();
+		AmfItemPtr ptr = Deserializer::deserialize(it, data.cend(), ctx);
+		if (ptr.as<AmfArray>().dense.size() != NUM_OBJECTS)
+			std::abort();
+	});
+	std::cout << "sequential: " << sequential << " ms" << std::endl;
+
+	for (unsigned threads : { 1, 2, 4, 8, 16, 32 }) {
+		double parallel = measure(iterations, [&]() {
+			SerializationContext ctx;
+			auto it = data.cbegin();
+			AmfItemPtr ptr = AmfParallel::deserialize(it, data.cend(), ctx, threads);
+			if (ptr.as<AmfArray>().dense.size() != NUM_OBJECTS)
+				std::abort();
+		});
+		std::cout << threads << " threads: " << parallel << " ms" << std::endl;
+	}
+
+	double encode = measure(iterations, [&]() {
+		SerializationContext ctx;
+		if (array.serialize(ctx).size() != data.size())
+			std::abort();
+	});
+	std::cout << "sequential serialize: " << encode << " ms" << std::endl;
+
+	for (unsigned threads : { 1, 2, 4, 8, 16, 32 }) {
+		double parallel = measure(iterations, [&]() {
+			SerializationContext ctx;
+			if (AmfParallel::serialize(array, ctx, threads) != data)
+				std::abort();
+		});
+		std::cout << threads << " threads serialize: " << parallel << " ms" << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,89 @@
+// Extracts the operation and a header from a RemotingMessage whose body and
+// headers are preceded by a large payload, both with AmfPath and by decoding
+// the whole message. This is what a router looking at incoming requests does.
+//
+// Build with `make bench` and run benchmarks/path [iterations].
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "deserializer.hpp"
+#include "serializationcontext.hpp"
+#include "types/amfarray.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfobject.hpp"
+#include "types/amfstring.hpp"
+#include "utils/amfpath.hpp"
+
+using namespace amf;
+
+static const int NUM_ITEMS = 10000;
+
+static v8 buildMessage() {
+	AmfArray payload;
+	for (int i = 0; i < NUM_ITEMS; ++i) {
+		AmfObject item("de.ventero.AmfBench.Item", false, false);
+		item.addSealedProperty("id", AmfInteger(i));
+		item.addSealedProperty("name", AmfString("item" + std::to_string(i)));
+		payload.push_back(item);
+	}
+
+	AmfObject call("de.ventero.AmfBench.Call", false, false);
+	call.addSealedProperty("operation", AmfString("saveItems"));
+	call.addSealedProperty("items", payload);
+
+	AmfObject headers("", true, false);
+	headers.addDynamicProperty("DSEndpoint", AmfString("my-amf"));
+	headers.addDynamicProperty("DSId", AmfString("0A1B2C3D-4E5F-6A7B-8C9D-0E1F2A3B4C5D"));
+
+	AmfObject msg("flex.messaging.messages.RemotingMessage", false, false);
+	msg.addSealedProperty("body", AmfArray(std::vector<AmfObject> { call }));
+	msg.addSealedProperty("headers", headers);
+
+	SerializationContext ctx;
+	return msg.serialize(ctx);
+}
+
+template<typename F>
+static double measure(int iterations, F f) {
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i)
+		f();
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+	return elapsed.count() / iterations;
+}
+
+int main(int argc, char* argv[]) {
+	int iterations = argc > 1 ? std::atoi(argv[1]) : 20;
+	if (iterations <= 0) iterations = 1;
+
+	v8 data = buildMessage();
+	std::cout << NUM_ITEMS << " items, " << data.size() << " bytes" << std::endl;
+
+	double full = measure(iterations, [&]() {
+		SerializationContext ctx;
+		auto it = data.cbegin();
+		AmfItemPtr ptr = Deserializer::deserialize(it, data.cend(), ctx);
+		AmfObject& msg = ptr.as<AmfObject>();
+		AmfObject& call = msg.getSealedProperty<AmfArray>("body").at<AmfObject>(0);
+		AmfObject& headers = msg.getSealedProperty<AmfObject>("headers");
+		if (call.getSealedProperty<AmfString>("operation").value.empty() ||
+			headers.getDynamicProperty<AmfString>("DSId").value.empty())
+			std::abort();
+	});
+	std::cout << "full decode: " << full << " ms" << std::endl;
+
+	AmfPath operation("body[0].operation");
+	AmfPath dsId("headers.DSId");
+	double path = measure(iterations, [&]() {
+		AmfItemPtr op = operation.get(data.cbegin(), data.cend());
+		AmfItemPtr id = dsId.get(data.cbegin(), data.cend());
+		if (op.as<AmfString>().value.empty() || id.as<AmfString>().value.empty())
+			std::abort();
+	});
+	std::cout << "AmfPath:     " << path << " ms" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,77 @@
+// Decodes an array of 100k objects with a nested payload both completely and
+// with a projection that only keeps their id.
+//
+// Build with `make bench` and run benchmarks/projection [iterations].
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "deserializer.hpp"
+#include "serializationcontext.hpp"
+#include "types/amfarray.hpp"
+#include "types/amfdouble.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfobject.hpp"
+#include "types/amfstring.hpp"
+#include "utils/amfprojection.hpp"
+
+using namespace amf;
+
+static const int NUM_OBJECTS = 100000;
+
+static AmfObject buildObject(int i) {
+	AmfObject details("", true, false);
+	details.addDynamicProperty("description", AmfString("description of item " + std::to_string(i)));
+	details.addDynamicProperty("tags", AmfArray(std::vector<AmfString> { "a", "b", "c" }));
+
+	AmfObject obj("de.ventero.AmfBench.Item", false, false);
+	obj.addSealedProperty("id", AmfInteger(i));
+	obj.addSealedProperty("name", AmfString("item" + std::to_string(i)));
+	obj.addSealedProperty("price", AmfDouble(i * 0.25));
+	obj.addSealedProperty("details", details);
+	return obj;
+}
+
+template<typename F>
+static double measure(int iterations, F f) {
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i)
+		f();
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+	return elapsed.count() / iterations;
+}
+
+int main(int argc, char* argv[]) {
+	int iterations = argc > 1 ? std::atoi(argv[1]) : 5;
+	if (iterations <= 0) iterations = 1;
+
+	AmfArray array;
+	for (int i = 0; i < NUM_OBJECTS; ++i)
+		array.push_back(buildObject(i));
+
+	SerializationContext sctx;
+	v8 data = array.serialize(sctx);
+	std::cout << NUM_OBJECTS << " objects, " << data.size() << " bytes" << std::endl;
+
+	double full = measure(iterations, [&]() {
+		Deserializer d;
+		AmfItemPtr ptr = d.deserialize(data);
+		if (ptr.as<AmfArray>().dense.size() != NUM_OBJECTS)
+			std::abort();
+	});
+	std::cout << "full:       " << full << " ms" << std::endl;
+
+	auto projection = std::make_shared<AmfProjection>();
+	projection->keepClass("de.ventero.AmfBench.Item", { "id" });
+	double projected = measure(iterations, [&]() {
+		Deserializer d(projection);
+		AmfItemPtr ptr = d.deserialize(data);
+		if (ptr.as<AmfArray>().at<AmfObject>(1).sealedProperties.size() != 1)
+			std::abort();
+	});
+	std::cout << "projection: " << projected << " ms" << std::endl;
+
+	return 0;
+}
@@ -23,6 +23,11 @@ namespace amf {
 typedef unsigned char u8;
 typedef std::vector<u8> v8;
 
+// Mixes value into seed, see boost::hash_combine.
+inline size_t hash_combine(size_t seed, size_t value) {
+	return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
 template <typename T>
 T swap_endian(T x) {
 	u8* bytes = reinterpret_cast<u8 *>(&x);
@@ -56,13 +56,13 @@ AmfItemPtr Deserializer::deserialize(v8::const_iterator& it, v8::const_iterator
 		case AMF_XML:
 			return AmfItemPtr(AmfXml::deserialize(it, end, ctx));
 		case AMF_BYTEARRAY:
-			return AmfItemPtr(AmfByteArray::deserialize(it, end, ctx));
+			return AmfByteArray::deserializePtr(it, end, ctx);
 		case AMF_VECTOR_INT:
-			return AmfItemPtr(AmfVector<int>::deserialize(it, end, ctx));
+			return AmfVector<int>::deserializePtr(it, end, ctx);
 		case AMF_VECTOR_UINT:
-			return AmfItemPtr(AmfVector<unsigned int>::deserialize(it, end, ctx));
+			return AmfVector<unsigned int>::deserializePtr(it, end, ctx);
 		case AMF_VECTOR_DOUBLE:
-			return AmfItemPtr(AmfVector<double>::deserialize(it, end, ctx));
+			return AmfVector<double>::deserializePtr(it, end, ctx);
 		case AMF_VECTOR_OBJECT:
 			return AmfVector<AmfItem>::deserializePtr(it, end, ctx);
 		case AMF_DICTIONARY:
@@ -8,19 +8,23 @@
 
 #include "amf.hpp"
 #include "serializationcontext.hpp"
+#include "utils/amfexternalregistry.hpp"
 #include "utils/amfitemptr.hpp"
 
 namespace amf {
 
 class AmfObject;
 
-typedef std::function<AmfObject(v8::const_iterator&, v8::const_iterator,
-	SerializationContext&)> ExternalDeserializerFunction;
-
 class Deserializer {
 public:
 	Deserializer() : ctx() { }
 	Deserializer(SerializationContext ctx) : ctx(ctx) { }
+	explicit Deserializer(std::shared_ptr<const ExternalDeserializerRegistry> externals) : ctx() {
+		ctx.setExternalDeserializers(externals);
+	}
+	explicit Deserializer(std::shared_ptr<const AmfProjection> projection) : ctx() {
+		ctx.setProjection(projection);
+	}
 
 	AmfItemPtr deserialize(v8 buf);
 	AmfItemPtr deserialize(v8::const_iterator& it, v8::const_iterator end) {
@@ -32,6 +36,9 @@ public:
 	static AmfItemPtr deserialize(v8 data, SerializationContext& ctx);
 	static AmfItemPtr deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
 
+	// Used for contexts without their own ExternalDeserializerRegistry. This
+	// map is looked up for every externalizable object and must not be
+	// modified while any context is deserializing.
 	static std::map<std::string, ExternalDeserializerFunction> externalDeserializers;
 
 private:
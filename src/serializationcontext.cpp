@@ -1,27 +1,267 @@
 #include "serializationcontext.hpp"
 
+#include <algorithm>
+
+#include "deserializer.hpp"
+#include "types/amfinteger.hpp"
+#include "utils/amfgraph.hpp"
+
 namespace amf {
 
+SerializationContext::~SerializationContext() {
+	if (resolvedReferences)
+		AmfGraph::releaseCycles(objects);
+}
+
 void SerializationContext::clear() {
+	if (resolvedReferences)
+		AmfGraph::releaseCycles(objects);
+	resolvedReferences = false;
+	chunkedValues = 0;
+
 	strings.clear();
 	traits.clear();
 	objects.clear();
+	stringsIndex.clear();
+	indexedStrings = 0;
+	objectsIndex.clear();
+	indexedObjects = 0;
+	traitsIndex.clear();
+	plans.clear();
+
+	skipped.clear();
+	replaying = false;
+	node = projections ? projections->root() : nullptr;
+}
+
+void SerializationContext::setChunkSink(size_t threshold, AmfChunkSink sink, size_t size) {
+	if (size == 0)
+		throw std::invalid_argument("SerializationContext::setChunkSink chunk size must not be 0");
+
+	chunkSink = sink;
+	chunkThreshold = threshold;
+	chunkSize = size;
+}
+
+void SerializationContext::emitChunks(u8 marker, const u8* data, size_t size) {
+	AmfChunk chunk;
+	chunk.marker = marker;
+	chunk.id = chunkedValues++;
+	chunk.total = size;
+
+	chunk.offset = 0;
+	do {
+		chunk.data = data + chunk.offset;
+		chunk.size = std::min(chunkSize, size - chunk.offset);
+		chunkSink(chunk);
+		chunk.offset += chunk.size;
+	} while (chunk.offset < size);
+}
+
+void SerializationContext::setExternalDeserializers(std::shared_ptr<const ExternalDeserializerRegistry> registry) {
+	externals = registry;
+	// Plans refer to the functions of the previous registry.
+	plans.clear();
+}
+
+void SerializationContext::setProjection(std::shared_ptr<const AmfProjection> projection) {
+	projections = projection;
+	node = projections ? projections->root() : nullptr;
+}
+
+void SerializationContext::addSkipped(size_t index, v8 data) {
+	addSkipped(index, objects.size() - index, std::make_shared<const v8>(std::move(data)), 0);
+}
+
+void SerializationContext::addSkipped(size_t index, size_t count, std::shared_ptr<const v8> data, size_t offset) {
+	SkippedValue value;
+	value.count = count;
+	value.data = std::move(data);
+	value.offset = offset;
+	skipped.emplace(index, std::move(value));
+}
+
+void SerializationContext::addDeferred(size_t index, AmfItemPtr item, std::function<void()> complete) {
+	SkippedValue value;
+	value.count = 1;
+	value.offset = 0;
+	value.item = std::move(item);
+	value.complete = std::move(complete);
+	skipped.emplace(index, std::move(value));
+}
+
+void SerializationContext::decodeSkipped(size_t index) {
+	auto value = skipped.upper_bound(index);
+	if (value == skipped.begin())
+		return;
+
+	--value;
+	if (index >= value->first + value->second.count)
+		return;
+
+	size_t first = value->first;
+	SkippedValue skippedValue = std::move(value->second);
+	skipped.erase(value);
+
+	// The entries may already have been indexed as placeholders.
+	if (first < indexedObjects) {
+		objectsIndex.clear();
+		indexedObjects = 0;
+	}
+
+	if (skippedValue.item.get() != nullptr) {
+		// Stored first, so that completing it can refer to it.
+		objects[first] = skippedValue.item;
+		skippedValue.complete();
+		return;
+	}
+
+	// Referenced objects are decoded in full. Skipped values may refer to
+	// other skipped values, so this can be reentered.
+	bool wasReplaying = replaying;
+	size_t wasNext = nextReplayed;
+	std::shared_ptr<const AmfProjection> projection = std::move(projections);
+	const AmfProjection::Node* projectionNode = node;
+
+	auto restore = [&]() {
+		replaying = wasReplaying;
+		nextReplayed = wasNext;
+		projections = std::move(projection);
+		node = projectionNode;
+	};
+
+	replaying = true;
+	nextReplayed = first;
+	projections.reset();
+	node = nullptr;
+
+	try {
+		const v8& data = *skippedValue.data;
+		auto it = data.cbegin() + skippedValue.offset;
+		Deserializer::deserialize(it, data.cend(), *this);
+	} catch (...) {
+		restore();
+		throw;
+	}
+
+	restore();
 }
 
 int SerializationContext::getIndex(const std::string& str) const {
-	auto it = std::find(strings.begin(), strings.end(), str);
-	if (it == strings.end())
+	indexStrings();
+
+	auto it = stringsIndex.find(str);
+	if (it == stringsIndex.end())
 		return -1;
 
-	return it - strings.begin();
+	if (recorded != nullptr)
+		recorded->strings.push_back(it->second);
+	return it->second;
 }
 
 int SerializationContext::getIndex(const AmfObjectTraits& str) const {
-	auto it = std::find(traits.begin(), traits.end(), str);
-	if (it == traits.end())
+	auto it = traitsIndex.find(str);
+	if (it == traitsIndex.end())
 		return -1;
 
-	return it - traits.begin();
+	return it->second;
+}
+
+bool SerializationContext::hasObject(const AmfItem& item) const {
+	indexObjects();
+
+	auto range = objectsIndex.equal_range(item.hash());
+	for (auto it = range.first; it != range.second; ++it) {
+		if (*objects[it->second] == item) {
+			if (recorded != nullptr)
+				recorded->objects.push_back(it->second);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void SerializationContext::copyObjects(const SerializationContext& other, size_t index, size_t count) {
+	for (size_t i = index; i < index + count; ++i) {
+		AmfItemPtr& entry = objects.at(i);
+		if (entry.get() == nullptr)
+			entry = other.objects.at(i);
+	}
+
+	// The entries may already have been indexed as placeholders.
+	if (index < indexedObjects) {
+		objectsIndex.clear();
+		indexedObjects = 0;
+	}
+
+	resolvedReferences = resolvedReferences || other.resolvedReferences;
+}
+
+void SerializationContext::indexStrings() const {
+	// Only the first occurrence of equal strings is ever referenced. Empty
+	// entries were reserved for chunked strings.
+	for (; indexedStrings < strings.size(); ++indexedStrings) {
+		const std::string& str = strings[indexedStrings];
+		if (!str.empty())
+			stringsIndex.emplace(str, static_cast<int>(indexedStrings));
+	}
+}
+
+void SerializationContext::indexObjects() const {
+	for (; indexedObjects < objects.size(); ++indexedObjects) {
+		const AmfItemPtr& ptr = objects[indexedObjects];
+		if (ptr.get() != nullptr)
+			objectsIndex.emplace(ptr->hash(), indexedObjects);
+	}
+}
+
+const TraitsPlan* SerializationContext::getPlan(const AmfObjectTraits& trait) {
+	int index = getIndex(trait);
+	if (index == -1)
+		return nullptr;
+
+	return &getPlan(static_cast<size_t>(index));
+}
+
+const TraitsPlan& SerializationContext::getPlan(size_t index) {
+	const AmfObjectTraits& trait = traits.at(index);
+
+	if (plans.size() <= index)
+		plans.resize(index + 1);
+
+	std::shared_ptr<TraitsPlan>& plan = plans[index];
+	if (!plan) {
+		plan.reset(new TraitsPlan());
+		plan->traits = std::make_shared<AmfObjectTraits>(trait);
+
+		// ensure we do not serialize duplicate attribute names (see the
+		// comment on traits.attributes in amfobjecttraits.hpp).
+		std::set<std::string> unique = trait.getUniqueAttributes();
+		plan->attributes.assign(unique.begin(), unique.end());
+
+		plan->inOrder = (plan->attributes == trait.attributes);
+		plan->slots.reserve(trait.attributes.size());
+		for (const std::string& attribute : trait.attributes) {
+			auto slot = std::lower_bound(plan->attributes.begin(), plan->attributes.end(), attribute);
+			plan->slots.push_back(slot - plan->attributes.begin());
+		}
+
+		// U29O-traits-ref = 0b..01
+		SerializationContext dummy;
+		plan->reference = AmfInteger(static_cast<int>(index) << 2 | 0x01).serialize(dummy);
+		plan->reference.erase(plan->reference.begin());
+
+		plan->external = nullptr;
+		if (trait.externalizable) {
+			if (externals)
+				plan->external = externals->find(trait.className);
+			if (plan->external == nullptr)
+				plan->external = ExternalDeserializerRegistry::builtin().find(trait.className);
+		}
+	}
+
+	return *plan;
 }
 
 }
@@ -2,22 +2,87 @@
 #ifndef SERIALIZATIONCONTEXT_HPP
 #define SERIALIZATIONCONTEXT_HPP
 
+#include <functional>
+#include <map>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "amf.hpp"
+#include "utils/amfexternalregistry.hpp"
 #include "utils/amfitemptr.hpp"
 #include "utils/amfobjecttraits.hpp"
+#include "utils/amfprojection.hpp"
 
 namespace amf {
 
+// Everything AmfObject needs to know to (de)serialize objects using a set of
+// traits that has already been added to the context. Built once per traits
+// table entry, so that arrays of many objects of the same class don't have to
+// recompute it for every element.
+struct TraitsPlan {
+	// Shared by all objects deserialized with these traits.
+	std::shared_ptr<const AmfObjectTraits> traits;
+	// Unique sealed attribute names, in serialization order.
+	std::vector<std::string> attributes;
+	// For every attribute in traits->attributes (i.e. in wire order), the
+	// index of the corresponding name in attributes.
+	std::vector<size_t> slots;
+	// True if the wire order already matches attributes, i.e. if the sealed
+	// attribute names were sent sorted and without duplicates.
+	bool inOrder;
+	// The encoded U29O-traits-ref pointing to these traits.
+	std::vector<u8> reference;
+	// For externalizable traits, their deserializer from the context's
+	// ExternalDeserializerRegistry, or else from the builtin one. Null if
+	// neither has one.
+	const ExternalDeserializer* external;
+};
+
+// A piece of a large value that is delivered to the chunk sink instead of
+// being decoded, see SerializationContext::setChunkSink.
+struct AmfChunk {
+	// AMF_BYTEARRAY or AMF_STRING
+	u8 marker;
+	// Counts the chunked values of a context, starting at 0.
+	size_t id;
+	// Position of data within the value.
+	size_t offset;
+	// Size of the whole value.
+	size_t total;
+	// Points into the input, only valid during the call to the sink.
+	const u8* data;
+	size_t size;
+
+	bool last() const {
+		return offset + size == total;
+	}
+};
+
+typedef std::function<void(const AmfChunk&)> AmfChunkSink;
+
+// The entries of the string and object tables that lookups found while
+// serializing, see SerializationContext::recordLookups.
+struct AmfLookups {
+	std::vector<size_t> strings;
+	std::vector<size_t> objects;
+};
+
 class SerializationContext {
 public:
 	SerializationContext() { }
+	// Frees reference cycles among the stored objects that were created by
+	// deserializing object references, unless the objects are still
+	// referenced from elsewhere. See AmfGraph.
+	~SerializationContext();
+
+	SerializationContext(const SerializationContext&) = default;
+	SerializationContext& operator=(const SerializationContext&) = default;
 
 	void clear();
 
 	void addString(const std::string& str) {
-		if (str.empty()) return;
+		if (str.empty() || replaying) return;
 
 		strings.push_back(str);
 	}
@@ -26,7 +91,84 @@ public:
 		return strings.at(index);
 	}
 
+	size_t stringCount() const {
+		return strings.size();
+	}
+
+	// Reserves a string table entry for a string that was delivered to the
+	// chunk sink. References to it resolve to an empty string.
+	void addChunkedString() {
+		if (!replaying)
+			strings.push_back(std::string());
+	}
+
+	// While deserializing, ByteArray and String values of at least threshold
+	// bytes are passed to sink in chunks of at most chunkSize bytes, straight
+	// from the input, instead of being copied into the decoded item, which
+	// is left empty. References to such values also resolve to empty values.
+	// The sink stays set when clearing the context.
+	void setChunkSink(size_t threshold, AmfChunkSink sink, size_t chunkSize = 64 * 1024);
+
+	// Whether a value of the given size is delivered to the chunk sink.
+	bool isChunked(size_t size) const {
+		return chunkSink && size >= chunkThreshold;
+	}
+
+	// Passes size bytes starting at data to the chunk sink.
+	void emitChunks(u8 marker, const u8* data, size_t size);
+
+	// Sets the registry used to deserialize externalizable objects. Without
+	// one, Deserializer::externalDeserializers is used. The registry stays set
+	// when clearing the context.
+	void setExternalDeserializers(std::shared_ptr<const ExternalDeserializerRegistry> registry);
+
+	const std::shared_ptr<const ExternalDeserializerRegistry>& externalDeserializers() const {
+		return externals;
+	}
+
+	// Sets the projection selecting the object properties that are decoded.
+	// The projection stays set when clearing the context.
+	void setProjection(std::shared_ptr<const AmfProjection> projection);
+
+	const std::shared_ptr<const AmfProjection>& projection() const {
+		return projections;
+	}
+
+	// The node of the projection's paths that applies to the value being
+	// deserialized, or nullptr if no path applies to it.
+	const AmfProjection::Node* projectionNode() const {
+		return node;
+	}
+
+	void setProjectionNode(const AmfProjection::Node* projectionNode) {
+		node = projectionNode;
+	}
+
+	// Records that the object table entries from index on were reserved by
+	// skipping the encoded value data, see AmfProjection::skip.
+	void addSkipped(size_t index, v8 data);
+	// Records that the count entries from index on were reserved by skipping
+	// the value at offset in data.
+	void addSkipped(size_t index, size_t count, std::shared_ptr<const v8> data, size_t offset);
+	// Records that the (reserved) entry at index is item. It is stored once
+	// it is referenced, and complete is called afterwards to fill it in.
+	void addDeferred(size_t index, AmfItemPtr item, std::function<void()> complete);
+	// Stores the count entries from index on of other in the entries of this
+	// context that were reserved for them, e.g. after decoding a skipped
+	// value with a copy of the reference tables.
+	void copyObjects(const SerializationContext& other, size_t index, size_t count);
+
+	// While lookups isn't null, the index of every string and object that
+	// getIndex or hasObject finds is appended to it.
+	void recordLookups(AmfLookups* lookups) {
+		recorded = lookups;
+	}
+
 	void addTraits(const AmfObjectTraits& trait) {
+		if (replaying) return;
+
+		// Only the first occurrence of equal traits is ever referenced.
+		traitsIndex.emplace(trait, static_cast<int>(traits.size()));
 		traits.push_back(trait);
 	}
 
@@ -34,28 +176,51 @@ public:
 		return traits.at(index);
 	}
 
+	size_t traitsCount() const {
+		return traits.size();
+	}
+
 	template<typename T>
 	void addObject(const T & obj) {
-		objects.emplace_back(new T(obj));
+		addPointer(AmfItemPtr(new T(obj)));
 	}
 
 	template<typename T>
-	const T & getObject(size_t index) const {
+	const T & getObject(size_t index) {
 		AmfItemPtr ptr = getPointer<T>(index);
 		return ptr.as<T>();
 	}
 
 	void addPointer(const AmfItemPtr & ptr) {
+		if (replaying) {
+			// Entries of skipped values that were decoded while skipping
+			// (externalizable objects) keep their object.
+			AmfItemPtr & entry = objects.at(nextReplayed++);
+			if (entry.get() == nullptr)
+				entry = ptr;
+			return;
+		}
+
 		objects.push_back(ptr);
 	}
 
+	size_t objectCount() const {
+		return objects.size();
+	}
+
 	template<typename T>
-	const AmfItemPtr & getPointer(size_t index) const {
-		const AmfItemPtr & ptr = objects.at(index);
+	const AmfItemPtr & getPointer(size_t index) {
+		if (objects.at(index).get() == nullptr)
+			decodeSkipped(index);
+
+		const AmfItemPtr & ptr = objects[index];
 
 		if (ptr.asPtr<T>() == nullptr)
 			throw std::invalid_argument("SerializationContext::getPointer wrong type");
 
+		// The returned pointer may point to an object that is still being
+		// deserialized, i.e. create a cycle.
+		resolvedReferences = true;
 		return ptr;
 	}
 
@@ -63,22 +228,101 @@ public:
 
 	int getIndex(const AmfObjectTraits& str) const;
 
+	// Returns the serialization plan for the given traits, or nullptr if they
+	// have not been added to the context yet.
+	const TraitsPlan* getPlan(const AmfObjectTraits& traits);
+	// Returns the plan for the traits table entry at index.
+	const TraitsPlan& getPlan(size_t index);
+
+	// Returns whether an object comparing equal to item is already stored,
+	// independent of its static type.
+	bool hasObject(const AmfItem& item) const;
+
+	// Objects are looked up by their hash(), which is computed the first time
+	// the object table is searched after adding them. Objects must not be
+	// modified after that.
 	template<typename T>
 	int getIndex(const T & obj) const {
-		for (size_t i = 0; i < objects.size(); ++i) {
-			const T* typeval = objects[i].asPtr<T>();
+		indexObjects();
 
+		// Equal objects may have been added more than once, but only the
+		// first one is ever referenced.
+		int index = -1;
+		auto range = objectsIndex.equal_range(obj.hash());
+		for (auto it = range.first; it != range.second; ++it) {
+			int i = static_cast<int>(it->second);
+			if (index != -1 && index < i)
+				continue;
+
+			const T* typeval = objects[i].asPtr<T>();
 			if (typeval != nullptr && *typeval == obj)
-				return static_cast<int>(i);
+				index = i;
 		}
 
-		return -1;
+		if (index != -1 && recorded != nullptr)
+			recorded->objects.push_back(index);
+
+		return index;
 	}
 
 private:
+	void indexObjects() const;
+	void indexStrings() const;
+	// Decodes the skipped value that reserved the object table entry at
+	// index, if there is one.
+	void decodeSkipped(size_t index);
+
 	std::vector<std::string> strings;
 	std::vector<AmfObjectTraits> traits;
 	std::vector<AmfItemPtr> objects;
+
+	// Maps strings to their index, covering the first indexedStrings
+	// entries. Only needed for serializing, so it is built on the first
+	// lookup.
+	mutable std::unordered_map<std::string, int> stringsIndex;
+	mutable size_t indexedStrings = 0;
+	// Maps hashes to indices into objects, covering the first indexedObjects
+	// entries. Null placeholders are skipped.
+	mutable std::unordered_multimap<size_t, size_t> objectsIndex;
+	mutable size_t indexedObjects = 0;
+
+	mutable bool resolvedReferences = false;
+
+	AmfChunkSink chunkSink;
+	size_t chunkThreshold = 0;
+	size_t chunkSize = 0;
+	size_t chunkedValues = 0;
+
+	std::shared_ptr<const ExternalDeserializerRegistry> externals;
+
+	std::shared_ptr<const AmfProjection> projections;
+	const AmfProjection::Node* node = nullptr;
+
+	AmfLookups* recorded = nullptr;
+
+	struct SkippedValue {
+		// Number of object table entries reserved by the value.
+		size_t count;
+		std::shared_ptr<const v8> data;
+		size_t offset;
+
+		// Set instead of data for deferred entries.
+		AmfItemPtr item;
+		std::function<void()> complete;
+	};
+
+	// Maps the first object table entry of skipped values to the value.
+	std::map<size_t, SkippedValue> skipped;
+	// While decoding a skipped value, objects are stored in the entries it
+	// reserved, starting at nextReplayed, and strings and traits aren't added
+	// again.
+	bool replaying = false;
+	size_t nextReplayed = 0;
+
+	std::unordered_map<AmfObjectTraits, int, AmfObjectTraitsHash> traitsIndex;
+	// Lazily built, indexed like traits. Plans are immutable once built, so
+	// copies of a context can share them.
+	std::vector<std::shared_ptr<TraitsPlan>> plans;
 };
 
 } // namespace amf
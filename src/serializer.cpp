@@ -11,4 +11,8 @@ Serializer& Serializer::operator<<(const AmfItem& item) {
 	return *this;
 }
 
+void Serializer::serializeInto(const AmfItem& item, AmfSegments& out) {
+	item.serializeInto(ctx, out);
+}
+
 } // namespace amf
@@ -10,6 +10,7 @@
 namespace amf {
 
 class AmfItem;
+class AmfSegments;
 
 class Serializer {
 public:
@@ -18,6 +19,10 @@ public:
 
 	Serializer& operator<<(const AmfItem& item);
 
+	// Serializes item into out instead of data(), using the same context, so
+	// that large payloads are referenced instead of copied.
+	void serializeInto(const AmfItem& item, AmfSegments& out);
+
 	const std::vector<u8> & data() const { return buf; }
 	void clear() { buf.clear(); ctx.clear(); }
 
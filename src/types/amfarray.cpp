@@ -1,9 +1,13 @@
 #include "amfarray.hpp"
 
+#include <functional>
+
 #include "deserializer.hpp"
 #include "serializationcontext.hpp"
 #include "types/amfinteger.hpp"
 #include "types/amfstring.hpp"
+#include "utils/amfhashstate.hpp"
+#include "utils/amfsegments.hpp"
 
 namespace amf {
 
@@ -12,7 +16,42 @@ bool AmfArray::operator==(const AmfItem& other) const {
 	return p != nullptr && dense == p->dense && associative == p->associative;
 }
 
+size_t AmfArray::hashValue(int depth, AmfHashState& state) const {
+	size_t seed = hash_combine(dense.size(), associative.size());
+	if (depth <= 0)
+		return seed;
+
+	for (const AmfItemPtr& it : dense)
+		seed = hash_combine(seed, state.hash(it, depth - 1));
+
+	for (const auto& it : associative) {
+		seed = hash_combine(seed, std::hash<std::string>()(it.first));
+		seed = hash_combine(seed, state.hash(it.second, depth - 1));
+	}
+
+	return seed;
+}
+
+void AmfArray::children(std::vector<const AmfItemPtr*>& out) const {
+	for (const AmfItemPtr& it : dense)
+		out.push_back(&it);
+
+	for (const auto& it : associative)
+		out.push_back(&it.second);
+}
+
+void AmfArray::clearChildren() {
+	dense.clear();
+	associative.clear();
+}
+
 std::vector<u8> AmfArray::serialize(SerializationContext& ctx) const {
+	AmfSegments out = AmfSegments::contiguous();
+	serializeInto(ctx, out);
+	return out.release();
+}
+
+void AmfArray::serializeInto(SerializationContext& ctx, AmfSegments& out) const {
 	/*
 	 * array-marker
 	 * (
@@ -22,34 +61,29 @@ std::vector<u8> AmfArray::serialize(SerializationContext& ctx) const {
 	 */
 
 	int index = ctx.getIndex(*this);
-	if (index != -1)
-		return std::vector<u8> { AMF_ARRAY, u8(index << 1) };
+	if (index != -1) {
+		out.append(std::vector<u8> { AMF_ARRAY, u8(index << 1) });
+		return;
+	}
 	ctx.addObject(*this);
 
 	// U29A-value
-	std::vector<u8> buf = AmfInteger::asLength(dense.size(), AMF_ARRAY);
+	out.append(AmfInteger::asLength(dense.size(), AMF_ARRAY));
 
 	// *(assoc-value) = (UTF-8-vr value-type)
 	for (const auto& it : associative) {
-		auto name = AmfString(it.first).serializeValue(ctx);
-		auto value = it.second->serialize(ctx);
-
 		// UTF-8-vr
-		buf.insert(buf.end(), name.begin(), name.end());
+		out.append(AmfString(it.first).serializeValue(ctx));
 		// value-type
-		buf.insert(buf.end(), value.begin(), value.end());
+		it.second->serializeInto(ctx, out);
 	}
 
 	// UTF-8-empty
-	buf.push_back(0x01);
+	out.push_back(0x01);
 
 	// *(value-type)
-	for (const auto& it : dense) {
-		auto s = it->serialize(ctx);
-		buf.insert(buf.end(), s.begin(), s.end());
-	}
-
-	return buf;
+	for (const auto& it : dense)
+		it->serializeInto(ctx, out);
 }
 
 AmfItemPtr AmfArray::deserializePtr(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
@@ -18,31 +18,35 @@ public:
 
 	template<class V>
 	AmfArray(std::vector<V> densePart) {
-		for (const V& it : densePart)
-			push_back(it);
+		dense.reserve(densePart.size());
+		for (V& it : densePart)
+			push_back(std::move(it));
 	}
 
 	template<class V, class A>
 	AmfArray(std::vector<V> densePart, std::map<std::string, A> associativePart) {
-		for (const V& it : densePart)
-			push_back(it);
+		dense.reserve(densePart.size());
+		for (V& it : densePart)
+			push_back(std::move(it));
 
-		for (const auto& it : associativePart)
-			insert(it.first, it.second);
+		for (auto& it : associativePart)
+			insert(it.first, std::move(it.second));
 	}
 
 	template<class T>
-	void push_back(const T& item) {
-		static_assert(std::is_base_of<AmfItem, T>::value, "Elements must extend AmfItem");
+	void push_back(T&& item) {
+		typedef typename std::decay<T>::type V;
+		static_assert(std::is_base_of<AmfItem, V>::value, "Elements must extend AmfItem");
 
-		dense.emplace_back(new T(item));
+		dense.emplace_back(new V(std::forward<T>(item)));
 	}
 
 	template<class T>
-	void insert(const std::string key, const T& item) {
-		static_assert(std::is_base_of<AmfItem, T>::value, "Elements must extend AmfItem");
+	void insert(const std::string key, T&& item) {
+		typedef typename std::decay<T>::type V;
+		static_assert(std::is_base_of<AmfItem, V>::value, "Elements must extend AmfItem");
 
-		associative[key] = AmfItemPtr(new T(item));
+		associative[key] = AmfItemPtr(new V(std::forward<T>(item)));
 	}
 
 	template<class T>
@@ -66,7 +70,11 @@ public:
 	}
 
 	bool operator==(const AmfItem& other) const;
+	size_t hashValue(int depth, AmfHashState& state) const;
+	void children(std::vector<const AmfItemPtr*>& out) const;
+	void clearChildren();
 	std::vector<u8> serialize(SerializationContext& ctx) const;
+	void serializeInto(SerializationContext& ctx, AmfSegments& out) const;
 	static AmfItemPtr deserializePtr(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
 	static AmfArray deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
 
@@ -19,6 +19,10 @@ public:
 		return std::vector<u8>{ value ? AMF_TRUE : AMF_FALSE };
 	}
 
+	size_t hashValue(int, AmfHashState&) const {
+		return value ? AMF_TRUE : AMF_FALSE;
+	}
+
 	static AmfBool deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext&);
 
 	bool value;
@@ -2,6 +2,7 @@
 
 #include "serializationcontext.hpp"
 #include "types/amfinteger.hpp"
+#include "utils/amfsegments.hpp"
 
 namespace amf {
 
@@ -10,6 +11,14 @@ bool AmfByteArray::operator==(const AmfItem& other) const {
 	return p != nullptr && value == p->value;
 }
 
+size_t AmfByteArray::hashValue(int, AmfHashState&) const {
+	size_t seed = AMF_BYTEARRAY;
+	for (u8 byte : value)
+		seed = hash_combine(seed, byte);
+
+	return seed;
+}
+
 std::vector<u8> AmfByteArray::serialize(SerializationContext& ctx) const {
 	int index = ctx.getIndex(*this);
 	if (index != -1)
@@ -21,25 +30,53 @@ std::vector<u8> AmfByteArray::serialize(SerializationContext& ctx) const {
 
 	return buf;
 }
+void AmfByteArray::serializeInto(SerializationContext& ctx, AmfSegments& out) const {
+	int index = ctx.getIndex(*this);
+	if (index != -1) {
+		out.append(std::vector<u8> { AMF_BYTEARRAY, u8(index << 1) });
+		return;
+	}
 
-AmfByteArray AmfByteArray::deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	out.append(AmfInteger::asLength(value.size(), AMF_BYTEARRAY));
+
+	// If the payload is referenced in place, don't copy it into the context
+	// either.
+	if (out.appendPayload(value.data(), value.size()))
+		ctx.addPointer(AmfItemPtr::unowned(*this));
+	else
+		ctx.addObject(*this);
+}
+
+
+AmfItemPtr AmfByteArray::deserializePtr(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
 	if (it == end || *it++ != AMF_BYTEARRAY)
 		throw std::invalid_argument("AmfByteArray: Invalid type marker");
 
 	int type = AmfInteger::deserializeValue(it, end);
 	if ((type & 0x01) == 0)
-		return ctx.getObject<AmfByteArray>(type >> 1);
+		return ctx.getPointer<AmfByteArray>(type >> 1);
 
 	int length = type >> 1;
 	if (end - it < length)
 		throw std::out_of_range("Not enough bytes for AmfByteArray");
 
-	AmfByteArray ret(it, it + length);
+	// Shared with the context instead of copying the data into it.
+	AmfItemPtr ret;
+	if (length > 0 && ctx.isChunked(length)) {
+		ctx.emitChunks(AMF_BYTEARRAY, &*it, length);
+		ret.reset(new AmfByteArray());
+	} else {
+		ret.reset(new AmfByteArray(it, it + length));
+	}
 	it += length;
 
-	ctx.addObject<AmfByteArray>(ret);
+	ctx.addPointer(ret);
 
 	return ret;
 }
 
+AmfByteArray AmfByteArray::deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	return deserializePtr(it, end, ctx).as<AmfByteArray>();
+}
+
 } // namespace amf
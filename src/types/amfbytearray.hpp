@@ -3,6 +3,7 @@
 #define AMFBYTEARRAY_HPP
 
 #include "types/amfitem.hpp"
+#include "utils/amfitemptr.hpp"
 
 namespace amf {
 
@@ -12,6 +13,18 @@ class AmfByteArray : public AmfItem {
 public:
 	AmfByteArray() { }
 	AmfByteArray(const AmfByteArray& other) : value(other.value) { }
+	AmfByteArray(AmfByteArray&& other) : value(std::move(other.value)) { }
+	AmfByteArray(std::vector<u8>&& v) : value(std::move(v)) { }
+
+	AmfByteArray& operator=(const AmfByteArray& other) {
+		value = other.value;
+		return *this;
+	}
+
+	AmfByteArray& operator=(AmfByteArray&& other) {
+		value = std::move(other.value);
+		return *this;
+	}
 
 	template<typename T>
 	AmfByteArray(const T& v) {
@@ -26,7 +39,10 @@ public:
 	}
 
 	bool operator==(const AmfItem& other) const;
+	size_t hashValue(int depth, AmfHashState& state) const;
 	std::vector<u8> serialize(SerializationContext& ctx) const;
+	void serializeInto(SerializationContext& ctx, AmfSegments& out) const;
+	static AmfItemPtr deserializePtr(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
 	static AmfByteArray deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
 
 	std::vector<u8> value;
@@ -1,5 +1,7 @@
 #include "amfdate.hpp"
 
+#include <functional>
+
 #include "serializationcontext.hpp"
 #include "types/amfdouble.hpp"
 #include "types/amfinteger.hpp"
@@ -17,6 +19,10 @@ bool AmfDate::operator==(const AmfItem& other) const {
 	return p != nullptr && value == p->value;
 }
 
+size_t AmfDate::hashValue(int, AmfHashState&) const {
+	return hash_combine(AMF_DATE, std::hash<long long>()(value));
+}
+
 std::vector<u8> AmfDate::serialize(SerializationContext& ctx) const {
 	// AmfDate is date-marker (U29O-ref | (U29D-value date-time)),
 	// where U29D-value is 1 and date-time is a int64 describing the number of
@@ -24,6 +24,7 @@ public:
 	AmfDate(std::chrono::system_clock::time_point date);
 
 	bool operator==(const AmfItem& other) const;
+	size_t hashValue(int depth, AmfHashState& state) const;
 	std::vector<u8> serialize(SerializationContext& ctx) const;
 	static AmfDate deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
 
@@ -12,15 +12,13 @@
 #include "types/amfnull.hpp"
 #include "types/amfstring.hpp"
 #include "types/amfundefined.hpp"
+#include "utils/amfhashstate.hpp"
+#include "utils/amfsegments.hpp"
 
 namespace amf {
 
 size_t AmfDictionaryHash::operator()(const AmfItemPtr& val) const {
-	// TODO: use new context here?
-	// TODO: maybe use slightly more performant hashing method instead ...
-	SerializationContext ctx;
-	auto s = val->serialize(ctx);
-	return std::hash<std::string>()(std::string(s.begin(), s.end()));
+	return val->hash();
 }
 
 bool AmfDictionary::operator==(const AmfItem& other) const {
@@ -29,25 +27,47 @@ bool AmfDictionary::operator==(const AmfItem& other) const {
 		values == p->values;
 }
 
+size_t AmfDictionary::hashValue(int, AmfHashState&) const {
+	// Dictionaries may be used as keys in themselves (and are then modified
+	// after being inserted while deserializing), so their hash must not depend
+	// on their entries.
+	return hash_combine(AMF_DICTIONARY, (asString ? 0x02 : 0x00) | (weak ? 0x01 : 0x00));
+}
+
+void AmfDictionary::children(std::vector<const AmfItemPtr*>& out) const {
+	for (const auto& it : values) {
+		out.push_back(&it.first);
+		out.push_back(&it.second);
+	}
+}
+
+void AmfDictionary::clearChildren() {
+	values.clear();
+}
+
 std::vector<u8> AmfDictionary::serialize(SerializationContext & ctx) const {
+	AmfSegments out = AmfSegments::contiguous();
+	serializeInto(ctx, out);
+	return out.release();
+}
+
+void AmfDictionary::serializeInto(SerializationContext& ctx, AmfSegments& out) const {
 	int index = ctx.getIndex(*this);
-	if (index != -1)
-		return std::vector<u8> { AMF_DICTIONARY, u8(index << 1) };
+	if (index != -1) {
+		out.append(std::vector<u8> { AMF_DICTIONARY, u8(index << 1) });
+		return;
+	}
 	ctx.addObject(*this);
 
-	std::vector<u8> buf = AmfInteger::asLength(values.size(), AMF_DICTIONARY);
+	out.append(AmfInteger::asLength(values.size(), AMF_DICTIONARY));
 
-	buf.push_back(weak ? 0x01 : 0x00);
+	out.push_back(weak ? 0x01 : 0x00);
 
-	for (auto it : values) {
+	for (const auto& it : values) {
 		// convert key's value to string if necessary
-		auto k = serializeKey(it.first, ctx);
-		auto v = it.second->serialize(ctx);
-		buf.insert(buf.end(), k.begin(), k.end());
-		buf.insert(buf.end(), v.begin(), v.end());
+		out.append(serializeKey(it.first, ctx));
+		it.second->serializeInto(ctx, out);
 	}
-
-	return buf;
 }
 
 AmfItemPtr AmfDictionary::deserializePtr(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
@@ -21,25 +21,42 @@ public:
 		asString(numbersAsStrings), weak(weak) { }
 
 	bool operator==(const AmfItem& other) const;
+	size_t hashValue(int depth, AmfHashState& state) const;
+	void children(std::vector<const AmfItemPtr*>& out) const;
+	void clearChildren();
 
 	template<class T, class V>
-	void insert(const T& key, const V& value) {
-		static_assert(std::is_base_of<AmfItem, V>::value, "Values must extend AmfItem");
-
-		(*this)[key].reset(new V(value));
+	void insert(T&& key, V&& value) {
+		typedef typename std::decay<T>::type K;
+		typedef typename std::decay<V>::type D;
+		static_assert(std::is_base_of<AmfItem, K>::value, "Keys must extend AmfItem");
+		static_assert(std::is_base_of<AmfItem, D>::value, "Values must extend AmfItem");
+
+		// Only copy the key if it's not in the dictionary yet.
+		auto it = values.find(AmfItemPtr::unowned(key));
+		if (it != values.end())
+			it->second.reset(new D(std::forward<V>(value)));
+		else
+			values.emplace(AmfItemPtr(new K(std::forward<T>(key))), AmfItemPtr(new D(std::forward<V>(value))));
 	}
 
 	template<class T, class V>
 	T& at(const V& key) {
-		auto ptr = (*this)[key];
+		AmfItemPtr ptr = find(key);
 		return ptr.template as<T>();
 	}
 
+	template<class T, class V>
+	const T& at(const V& key) const {
+		return find(key).template as<T>();
+	}
+
 	void clear() {
 		values.clear();
 	}
 
 	std::vector<u8> serialize(SerializationContext & ctx) const;
+	void serializeInto(SerializationContext& ctx, AmfSegments& out) const;
 	static AmfItemPtr deserializePtr(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
 	static AmfDictionary deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
 
@@ -53,9 +70,14 @@ public:
 
 private:
 	template<class T>
-	AmfItemPtr& operator[](const T& item) {
+	const AmfItemPtr& find(const T& key) const {
 		static_assert(std::is_base_of<AmfItem, T>::value, "Keys must extend AmfItem");
-		return values[AmfItemPtr(new T(item))];
+
+		auto it = values.find(AmfItemPtr::unowned(key));
+		if (it == values.end())
+			throw std::out_of_range("AmfDictionary::at");
+
+		return it->second;
 	}
 
 	// Flash Player doesn't support deserializing booleans and number types
@@ -1,5 +1,7 @@
 #include "amfdouble.hpp"
 
+#include <functional>
+
 namespace amf {
 
 bool AmfDouble::operator==(const AmfItem& other) const {
@@ -7,6 +9,11 @@ bool AmfDouble::operator==(const AmfItem& other) const {
 	return p != nullptr && value == p->value;
 }
 
+size_t AmfDouble::hashValue(int, AmfHashState&) const {
+	// 0.0 and -0.0 compare equal
+	return std::hash<double>()(value == 0 ? 0.0 : value);
+}
+
 std::vector<u8> AmfDouble::serialize(SerializationContext&) const {
 	std::vector<u8> buf = { AMF_DOUBLE };
 
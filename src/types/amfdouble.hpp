@@ -15,6 +15,7 @@ public:
 	operator double() const { return value; }
 
 	bool operator==(const AmfItem& other) const;
+	size_t hashValue(int depth, AmfHashState& state) const;
 	std::vector<u8> serialize(SerializationContext&) const;
 	static AmfDouble deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext&);
 
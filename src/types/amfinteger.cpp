@@ -1,5 +1,7 @@
 #include "amfinteger.hpp"
 
+#include <functional>
+
 #include "serializationcontext.hpp"
 #include "types/amfdouble.hpp"
 
@@ -10,6 +12,10 @@ bool AmfInteger::operator==(const AmfItem& other) const {
 	return p != nullptr && value == p->value;
 }
 
+size_t AmfInteger::hashValue(int, AmfHashState&) const {
+	return std::hash<int>()(value);
+}
+
 std::vector<u8> AmfInteger::serialize(SerializationContext& ctx) const {
 	// According to the spec:
 	// If the value of an unsigned integer (uint) or signed integer (int)
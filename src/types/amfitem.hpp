@@ -29,6 +29,9 @@ enum AmfMarker : u8 {
 	AMF_DICTIONARY
 };
 
+class AmfHashState;
+class AmfItemPtr;
+class AmfSegments;
 class SerializationContext;
 
 class AmfItem {
@@ -36,10 +39,39 @@ public:
 	virtual ~AmfItem() { };
 
 	virtual std::vector<u8> serialize(SerializationContext& ctx) const = 0;
+
+	// Appends the serialized item to out. Types with large payloads reference
+	// them from out instead of copying them (and register themselves in the
+	// context without copying the payload either), so such items must not be
+	// modified or destroyed while out or ctx are still in use. Types that
+	// don't override this append the result of serialize(). Defined in
+	// utils/amfsegments.cpp.
+	virtual void serializeInto(SerializationContext& ctx, AmfSegments& out) const;
 	virtual bool operator==(const AmfItem&) const = 0;
 	virtual bool operator!=(const AmfItem& other) const {
 		return !(*this == other);
 	}
+
+	// Structural hash, consistent with operator==: items that compare equal
+	// have the same hash. Defined in utils/amfhashstate.cpp.
+	size_t hash() const;
+
+	// Computes the hash, descending at most depth more levels into nested
+	// items, which also keeps hashing self-referential items finite. Nested
+	// items have to be hashed through state.hash(). Types that don't override
+	// this all hash to the same value.
+	virtual size_t hashValue(int /* depth */, AmfHashState& /* state */) const {
+		return 0;
+	}
+
+	static const int HASH_DEPTH = 4;
+
+	// Appends all pointers to other items held by this item. Used together
+	// with clearChildren() by AmfGraph to free reference cycles.
+	virtual void children(std::vector<const AmfItemPtr*>& /* out */) const { }
+
+	// Drops all pointers to other items.
+	virtual void clearChildren() { }
 };
 
 } // namespace amf
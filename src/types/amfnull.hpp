@@ -23,6 +23,10 @@ public:
 		return std::vector<u8>{ AMF_NULL };
 	}
 
+	size_t hashValue(int, AmfHashState&) const {
+		return AMF_NULL;
+	}
+
 	static AmfNull deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext&) {
 		if (it == end || *it++ != AMF_NULL)
 			throw std::invalid_argument("AmfNull: Invalid type marker");
@@ -4,6 +4,8 @@
 #include "serializationcontext.hpp"
 #include "types/amfinteger.hpp"
 #include "types/amfstring.hpp"
+#include "utils/amfhashstate.hpp"
+#include "utils/amfsegments.hpp"
 
 namespace amf {
 
@@ -13,10 +15,10 @@ bool AmfObject::operator==(const AmfItem& other) const {
 	if (p == nullptr)
 		return false;
 
-	if (traits != p->traits)
+	if (traits != p->traits && *traits != *p->traits)
 		return false;
 
-	if (traits.dynamic && dynamicProperties != p->dynamicProperties)
+	if (traits->dynamic && dynamicProperties != p->dynamicProperties)
 		return false;
 
 	// TODO: only compare properties that are in attributes?
@@ -25,7 +27,7 @@ bool AmfObject::operator==(const AmfItem& other) const {
 
 	// If this is an externalizable object, compare equal when they serialize
 	// to the same data.
-	if (traits.externalizable) {
+	if (traits->externalizable) {
 		SerializationContext this_ctx, p_ctx;
 		return (externalizer(this, this_ctx) == p->externalizer(p, p_ctx));
 	}
@@ -33,7 +35,47 @@ bool AmfObject::operator==(const AmfItem& other) const {
 	return true;
 }
 
+size_t AmfObject::hashValue(int depth, AmfHashState& state) const {
+	size_t seed = AmfObjectTraitsHash()(*traits);
+	if (depth <= 0)
+		return seed;
+
+	for (const auto& it : sealedProperties) {
+		seed = hash_combine(seed, std::hash<std::string>()(it.first));
+		seed = hash_combine(seed, state.hash(it.second, depth - 1));
+	}
+
+	// dynamic properties are only compared for dynamic objects
+	if (traits->dynamic) {
+		for (const auto& it : dynamicProperties) {
+			seed = hash_combine(seed, std::hash<std::string>()(it.first));
+			seed = hash_combine(seed, state.hash(it.second, depth - 1));
+		}
+	}
+
+	return seed;
+}
+
+void AmfObject::children(std::vector<const AmfItemPtr*>& out) const {
+	for (const auto& it : sealedProperties)
+		out.push_back(&it.second);
+
+	for (const auto& it : dynamicProperties)
+		out.push_back(&it.second);
+}
+
+void AmfObject::clearChildren() {
+	sealedProperties.clear();
+	dynamicProperties.clear();
+}
+
 std::vector<u8> AmfObject::serialize(SerializationContext& ctx) const {
+	AmfSegments out = AmfSegments::contiguous();
+	serializeInto(ctx, out);
+	return out.release();
+}
+
+void AmfObject::serializeInto(SerializationContext& ctx, AmfSegments& out) const {
 	/* AmfObject is defined as
 	 * object-marker
 	 * (
@@ -45,85 +87,116 @@ std::vector<u8> AmfObject::serialize(SerializationContext& ctx) const {
 	 * *(value-type) *(dynamic-member)
 	 */
 	int index = ctx.getIndex(*this);
-	if (index != -1)
-		return std::vector<u8> { AMF_OBJECT, u8(index << 1) };
+	if (index != -1) {
+		out.append(std::vector<u8> { AMF_OBJECT, u8(index << 1) });
+		return;
+	}
 	ctx.addObject(*this);
 
-	std::vector<u8> buf = { AMF_OBJECT };
+	out.push_back(AMF_OBJECT);
 
-	AmfString className(traits.className);
-	// serialized class name as UTF-8-vr
-	std::vector<u8> name(className.serializeValue(ctx));
-
-	// ensure we do not serialize duplicate attribute names (see the
-	// comment on traits.attributes in amfobjecttraits.hpp).
-	std::set<std::string> attributes = traits.getUniqueAttributes();
-
-	int trait_index = ctx.getIndex(traits);
-	if (trait_index != -1) {
-		// U29O-traits-ref = 0b..01
-		buf.push_back(u8((trait_index << 2) | 1));
+	const TraitsPlan* plan = ctx.getPlan(*traits);
+	if (plan != nullptr) {
+		// U29O-traits-ref, encoded once per context
+		out.append(plan->reference);
 	} else {
-		ctx.addTraits(traits);
+		ctx.addTraits(*traits);
+		plan = ctx.getPlan(*traits);
 
-		if (traits.externalizable) {
+		// serialized class name as UTF-8-vr
+		std::vector<u8> name(AmfString(traits->className).serializeValue(ctx));
+
+		if (traits->externalizable) {
 			// U29O-traits-ext = 0b0111 = 0x07
-			buf.push_back(0x07);
+			out.push_back(0x07);
 			// class-name
-			buf.insert(buf.end(), name.begin(), name.end());
+			out.append(name);
 		} else {
 			// U29-traits = 0b0011 = 0x03
-			size_t traitMarker = attributes.size() << 4 | 0x03;
+			size_t traitMarker = plan->attributes.size() << 4 | 0x03;
 			// dynamic marker = 0b1000 = 0x08
-			if (traits.dynamic)
+			if (traits->dynamic)
 				traitMarker |= 0x08;
 
 			std::vector<u8> marker(AmfInteger(traitMarker).serialize(ctx));
-			buf.insert(buf.end(), marker.begin() + 1, marker.end());
+			out.append(marker.begin() + 1, marker.end());
 
 			// class-name
-			buf.insert(buf.end(), name.begin(), name.end());
+			out.append(name);
 
 			// sealed property names = *(UTF-8-vr)
-			for (const std::string& attribute : attributes) {
-				std::vector<u8> attr(AmfString(attribute).serializeValue(ctx));
-				buf.insert(buf.end(), attr.begin(), attr.end());
+			for (const std::string& attribute : plan->attributes) {
+				out.append(AmfString(attribute).serializeValue(ctx));
 			}
 		}
 	}
 
-	if (traits.externalizable) {
+	if (traits->externalizable) {
 		// externalized value = *(U8)
 		// note: this may throw if externalizer is not properly initialized
-		std::vector<u8> externalized(externalizer(this, ctx));
-		buf.insert(buf.end(), externalized.begin(), externalized.end());
-		return buf;
+		out.append(externalizer(this, ctx));
+		return;
 	}
 
 	// sealed property values = *(value-type)
-	for (const std::string& attribute : attributes) {
-		auto s = sealedProperties.at(attribute)->serialize(ctx);
-		buf.insert(buf.end(), s.begin(), s.end());
+	// Both the plan's attributes and sealedProperties are sorted by name, so
+	// we can walk them in lockstep instead of looking up every attribute.
+	auto prop = sealedProperties.begin();
+	for (const std::string& attribute : plan->attributes) {
+		while (prop != sealedProperties.end() && prop->first < attribute)
+			++prop;
+
+		if (prop == sealedProperties.end() || prop->first != attribute)
+			throw std::out_of_range("AmfObject::serialize missing sealed property");
+
+		prop->second->serializeInto(ctx, out);
+		++prop;
 	}
 
 	// only encode *(dynamic-member) (including the end marker) if the object
 	// is actually dynamic
-	if (traits.dynamic) {
+	if (traits->dynamic) {
 		// dynamic-members = UTF-8-vr value-type
 		for (const auto& it : dynamicProperties) {
-			AmfString attribute(it.first);
-			const std::vector<u8> name(attribute.serializeValue(ctx));
-			buf.insert(buf.end(), name.begin(), name.end());
-
-			auto s = it.second->serialize(ctx);
-			buf.insert(buf.end(), s.begin(), s.end());
+			out.append(AmfString(it.first).serializeValue(ctx));
+			it.second->serializeInto(ctx, out);
 		}
 
 		// final dynamic member = UTF-8-empty
-		buf.push_back(0x01);
+		out.push_back(0x01);
 	}
+}
 
-	return buf;
+// Decodes the value of a property of an object deserialized with a
+// projection, or skips it and returns a null pointer if it isn't kept.
+static AmfItemPtr deserializeProperty(const std::string& name, const std::set<std::string>* keep,
+		v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	const AmfProjection::Node* node = ctx.projectionNode();
+	const AmfProjection::Node* member = nullptr;
+	if (node != nullptr) {
+		auto found = node->members.find(name);
+		if (found == node->members.end()) {
+			AmfProjection::skip(it, end, ctx);
+			return AmfItemPtr();
+		}
+
+		if (!found->second.all)
+			member = &found->second;
+	} else if (keep != nullptr && keep->count(name) == 0) {
+		AmfProjection::skip(it, end, ctx);
+		return AmfItemPtr();
+	}
+
+	// The node has to be restored even if deserializing fails, as the
+	// context may be used for further values.
+	struct Restore {
+		~Restore() { ctx.setProjectionNode(node); }
+		SerializationContext& ctx;
+		const AmfProjection::Node* node;
+	} restore { ctx, node };
+
+	ctx.setProjectionNode(member);
+	return Deserializer::deserialize(it, end, ctx);
 }
 
 AmfItemPtr AmfObject::deserializePtr(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
@@ -136,11 +209,12 @@ AmfItemPtr AmfObject::deserializePtr(v8::const_iterator& it, v8::const_iterator
 		return ctx.getPointer<AmfObject>(type >> 1);
 	}
 
-	AmfObjectTraits traits("", false, false);
+	size_t traitsIndex;
 	if ((type & 0x03) == 0x01) {
 		// 0b..01 == U29O-traits-ref
-		traits = ctx.getTraits(type >> 2);
+		traitsIndex = type >> 2;
 	} else {
+		AmfObjectTraits traits("", false, false);
 		if ((type & 0x07) == 0x07) {
 			// 0b.111 == U29O-traits-ext
 			traits.externalizable = true;
@@ -150,6 +224,7 @@ AmfItemPtr AmfObject::deserializePtr(v8::const_iterator& it, v8::const_iterator
 			traits.dynamic = ((type & 0x08) == 0x08);
 			traits.className = AmfString::deserializeValue(it, end, ctx);
 			int numSealed = type >> 4;
+			traits.attributes.reserve(numSealed);
 			for (int i = 0; i < numSealed; ++i) {
 				// Always add all attribute names, even if they're duplicates.
 				// See the comment in amfobjecttraits.hpp
@@ -157,24 +232,88 @@ AmfItemPtr AmfObject::deserializePtr(v8::const_iterator& it, v8::const_iterator
 			}
 		}
 
+		// Equal traits share the plan of their first occurrence.
 		ctx.addTraits(traits);
+		traitsIndex = ctx.getIndex(traits);
 	}
 
+	// Plans are never modified once built, so this stays valid even if
+	// deserializing the values below adds new traits to the context.
+	const TraitsPlan& plan = ctx.getPlan(traitsIndex);
+	const std::shared_ptr<const AmfObjectTraits>& traits = plan.traits;
+
 	AmfItemPtr ptr(new AmfObject(traits));
 	AmfObject & ret = ptr.as<AmfObject>();
 	ctx.addPointer(ptr);
 
-	if (traits.externalizable) {
-		ret = Deserializer::externalDeserializers.at(traits.className)(it, end, ctx);
+	if (traits->externalizable) {
+		if (!ctx.externalDeserializers()) {
+			auto global = Deserializer::externalDeserializers.find(traits->className);
+			if (global != Deserializer::externalDeserializers.end()) {
+				ret = global->second(it, end, ctx);
+				return ptr;
+			}
+		}
+
+		// Resolved once per traits table entry.
+		if (plan.external == nullptr)
+			throw std::out_of_range("AmfObject: No deserializer for " + traits->className);
+
+		if (plan.external->reader)
+			plan.external->reader(ret, it, end, ctx);
+		else
+			ret = plan.external->function(it, end, ctx);
+
 		return ptr;
 	}
 
-	for (auto name : traits.attributes) {
-		AmfItemPtr val = Deserializer::deserialize(it, end, ctx);
-		ret.sealedProperties[name] = val;
+	if (ctx.projection()) {
+		// Paths take precedence over the rules for the class.
+		const std::set<std::string>* keep = ctx.projectionNode() == nullptr ?
+			ctx.projection()->properties(traits->className) : nullptr;
+
+		std::vector<AmfItemPtr> values(plan.attributes.size());
+		for (size_t slot : plan.slots)
+			values[slot] = deserializeProperty(plan.attributes[slot], keep, it, end, ctx);
+
+		for (size_t i = 0; i < values.size(); ++i) {
+			if (values[i].get() != nullptr)
+				ret.sealedProperties.emplace_hint(ret.sealedProperties.end(), plan.attributes[i], values[i]);
+		}
+
+		if (traits->dynamic) {
+			while (true) {
+				std::string name = AmfString::deserializeValue(it, end, ctx);
+				if (name == "") break;
+
+				AmfItemPtr val = deserializeProperty(name, keep, it, end, ctx);
+				if (val.get() != nullptr)
+					ret.dynamicProperties[name] = val;
+			}
+		}
+
+		return ptr;
+	}
+
+	if (plan.inOrder) {
+		// Sealed names are sorted and unique, so every value can be appended
+		// to the end of the map without searching for its position.
+		for (const std::string& name : plan.attributes) {
+			AmfItemPtr val = Deserializer::deserialize(it, end, ctx);
+			ret.sealedProperties.emplace_hint(ret.sealedProperties.end(), name, val);
+		}
+	} else {
+		// Read the values into their sorted slot first. For duplicate names,
+		// the last value wins.
+		std::vector<AmfItemPtr> values(plan.attributes.size());
+		for (size_t slot : plan.slots)
+			values[slot] = Deserializer::deserialize(it, end, ctx);
+
+		for (size_t i = 0; i < values.size(); ++i)
+			ret.sealedProperties.emplace_hint(ret.sealedProperties.end(), plan.attributes[i], values[i]);
 	}
 
-	if (traits.dynamic) {
+	if (traits->dynamic) {
 		while (true) {
 			std::string name = AmfString::deserializeValue(it, end, ctx);
 			if (name == "") break;
@@ -191,4 +330,12 @@ AmfObject AmfObject::deserialize(v8::const_iterator& it, v8::const_iterator end,
 	return deserializePtr(it, end, ctx).as<AmfObject>();
 }
 
+AmfObjectTraits& AmfObject::mutableTraits() {
+	if (traits.use_count() > 1)
+		traits = std::make_shared<AmfObjectTraits>(*traits);
+
+	// Safe, since traits are always created as non-const objects.
+	return const_cast<AmfObjectTraits&>(*traits);
+}
+
 } // namespace amf
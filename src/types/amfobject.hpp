@@ -4,6 +4,7 @@
 
 #include <functional>
 #include <map>
+#include <memory>
 
 #include "types/amfitem.hpp"
 #include "utils/amfitemptr.hpp"
@@ -15,27 +16,31 @@ class SerializationContext;
 
 class AmfObject : public AmfItem {
 public:
-	AmfObject() : traits("", false, false) { }
+	AmfObject() : traits(std::make_shared<AmfObjectTraits>("", false, false)) { }
 	AmfObject(std::string className, bool dynamic, bool externalizable) :
-		traits(className, dynamic, externalizable) { }
+		traits(std::make_shared<AmfObjectTraits>(className, dynamic, externalizable)) { }
 
 	bool operator==(const AmfItem& other) const;
+	size_t hashValue(int depth, AmfHashState& state) const;
+	void children(std::vector<const AmfItemPtr*>& out) const;
+	void clearChildren();
 	std::vector<u8> serialize(SerializationContext& ctx) const;
+	void serializeInto(SerializationContext& ctx, AmfSegments& out) const;
 
 	template<class T>
-	void addSealedProperty(std::string name, const T& value) {
-		traits.addAttribute(name);
-		sealedProperties[name] = AmfItemPtr(new T(value));
+	void addSealedProperty(std::string name, T&& value) {
+		mutableTraits().addAttribute(name);
+		sealedProperties[name] = AmfItemPtr(new typename std::decay<T>::type(std::forward<T>(value)));
 	}
 
 	template<class T>
-	void addDynamicProperty(std::string name, const T& value) {
-		dynamicProperties[name] = AmfItemPtr(new T(value));
+	void addDynamicProperty(std::string name, T&& value) {
+		dynamicProperties[name] = AmfItemPtr(new typename std::decay<T>::type(std::forward<T>(value)));
 	}
 
 	template<class T>
 	T& getSealedProperty(std::string name) {
-		if (!traits.hasAttribute(name))
+		if (!traits->hasAttribute(name))
 			throw std::out_of_range("AmfObject::getSealedProperty");
 
 		return sealedProperties.at(name).as<T>();
@@ -50,7 +55,7 @@ public:
 	static AmfObject deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
 
 	const AmfObjectTraits& objectTraits() const {
-		return traits;
+		return *traits;
 	}
 
 	std::map<std::string, AmfItemPtr> sealedProperties;
@@ -60,9 +65,13 @@ public:
 	Externalizer externalizer;
 
 private:
-	AmfObject(AmfObjectTraits traits) : traits(traits) { }
+	AmfObject(std::shared_ptr<const AmfObjectTraits> traits) : traits(traits) { }
 
-	AmfObjectTraits traits;
+	AmfObjectTraits& mutableTraits();
+
+	// Deserialized objects share the traits of the context's traits table
+	// entry, so copy them before modifying.
+	std::shared_ptr<const AmfObjectTraits> traits;
 };
 
 } // namespace amf
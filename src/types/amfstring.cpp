@@ -1,5 +1,7 @@
 #include "amfstring.hpp"
 
+#include <functional>
+
 #include "serializationcontext.hpp"
 #include "types/amfinteger.hpp"
 
@@ -10,6 +12,10 @@ bool AmfString::operator==(const AmfItem& other) const {
 	return p != nullptr && value == p->value;
 }
 
+size_t AmfString::hashValue(int, AmfHashState&) const {
+	return std::hash<std::string>()(value);
+}
+
 std::vector<u8> AmfString::serialize(SerializationContext& ctx) const {
 	// AmfString = string-marker UTF-8-vr
 	std::vector<u8> buf { AMF_STRING };
@@ -60,6 +66,14 @@ std::string AmfString::deserializeValue(v8::const_iterator& it, v8::const_iterat
 	if (end - it < length)
 		throw std::out_of_range("Not enough bytes for AmfString");
 
+	if (length > 0 && ctx.isChunked(length)) {
+		ctx.emitChunks(AMF_STRING, &*it, length);
+		it += length;
+
+		ctx.addChunkedString();
+		return std::string();
+	}
+
 	std::string val(it, it + length);
 	it += length;
 
@@ -14,10 +14,11 @@ class AmfString : public AmfItem {
 public:
 	AmfString() { }
 	AmfString(const char* v) : value(v == nullptr ? "" : v) { }
-	AmfString(std::string v) : value(v) { }
+	AmfString(std::string v) : value(std::move(v)) { }
 	operator std::string() const { return value; }
 
 	bool operator==(const AmfItem& other) const;
+	size_t hashValue(int depth, AmfHashState& state) const;
 	std::vector<u8> serialize(SerializationContext& ctx) const;
 	std::vector<u8> serializeValue(SerializationContext& ctx) const;
 	static AmfString deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
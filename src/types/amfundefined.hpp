@@ -23,6 +23,10 @@ public:
 		return std::vector<u8>{ AMF_UNDEFINED };
 	}
 
+	size_t hashValue(int, AmfHashState&) const {
+		return AMF_UNDEFINED;
+	}
+
 	static AmfUndefined deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext&) {
 		if (it == end || *it++ != AMF_UNDEFINED)
 			throw std::invalid_argument("AmfUndefined: Invalid type marker");
@@ -1,9 +1,13 @@
 #include "amfvector.hpp"
 
+#include <functional>
+
 #include "deserializer.hpp"
 #include "serializationcontext.hpp"
 #include "types/amfinteger.hpp"
 #include "types/amfstring.hpp"
+#include "utils/amfhashstate.hpp"
+#include "utils/amfsegments.hpp"
 
 namespace amf {
 
@@ -13,6 +17,25 @@ bool AmfVector<T, typename VectorProperties<T>::type>::operator==(const AmfItem&
 	return p != nullptr && fixed == p->fixed && values == p->values;
 }
 
+template<typename T>
+static size_t hashElement(T value) {
+	return std::hash<T>()(value);
+}
+
+static size_t hashElement(double value) {
+	// 0.0 and -0.0 compare equal
+	return std::hash<double>()(value == 0 ? 0.0 : value);
+}
+
+template<typename T>
+size_t AmfVector<T, typename VectorProperties<T>::type>::hashValue(int, AmfHashState&) const {
+	size_t seed = hash_combine(VectorProperties<T>::marker, fixed);
+	for (const T& it : values)
+		seed = hash_combine(seed, hashElement(it));
+
+	return seed;
+}
+
 template<typename T>
 std::vector<u8> AmfVector<T, typename VectorProperties<T>::type>::serialize(SerializationContext& ctx) const {
 	int index = ctx.getIndex(*this);
@@ -39,14 +62,14 @@ std::vector<u8> AmfVector<T, typename VectorProperties<T>::type>::serialize(Seri
 }
 
 template<typename T>
-AmfVector<T> AmfVector<T, typename VectorProperties<T>::type>::deserialize(
+AmfItemPtr AmfVector<T, typename VectorProperties<T>::type>::deserializePtr(
 	v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
 	if (it == end || *it++ != VectorProperties<T>::marker)
 		throw std::invalid_argument("AmfVector: Invalid type marker");
 
 	int type = AmfInteger::deserializeValue(it, end);
 	if ((type & 0x01) == 0)
-		return ctx.getObject<AmfVector<T>>(type >> 1);
+		return ctx.getPointer<AmfVector<T>>(type >> 1);
 
 	unsigned int stride = VectorProperties<T>::size;
 	size_t count = type >> 1;
@@ -70,39 +93,70 @@ AmfVector<T> AmfVector<T, typename VectorProperties<T>::type>::deserialize(
 		values[i] = ntoh(val);
 	}
 
-	AmfVector<T> ret(values, fixed);
-	ctx.addObject<AmfVector<T>>(ret);
+	// Shared with the context instead of copying the values into it.
+	AmfItemPtr ret(new AmfVector<T>(std::move(values), fixed));
+	ctx.addPointer(ret);
 
 	return ret;
 }
 
+template<typename T>
+AmfVector<T> AmfVector<T, typename VectorProperties<T>::type>::deserialize(
+	v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	return deserializePtr(it, end, ctx).template as<AmfVector<T>>();
+}
+
 bool AmfVector<AmfItem>::operator==(const AmfItem& other) const {
 	const AmfVector<AmfItem>* p = dynamic_cast<const AmfVector<AmfItem>*>(&other);
 	return p != nullptr && fixed == p->fixed && type == p->type && values == p->values;
 }
 
+size_t AmfVector<AmfItem>::hashValue(int depth, AmfHashState& state) const {
+	size_t seed = hash_combine(std::hash<std::string>()(type), fixed);
+	seed = hash_combine(seed, values.size());
+	if (depth <= 0)
+		return seed;
+
+	for (const AmfItemPtr& it : values)
+		seed = hash_combine(seed, state.hash(it, depth - 1));
+
+	return seed;
+}
+
+void AmfVector<AmfItem>::children(std::vector<const AmfItemPtr*>& out) const {
+	for (const AmfItemPtr& it : values)
+		out.push_back(&it);
+}
+
+void AmfVector<AmfItem>::clearChildren() {
+	values.clear();
+}
+
 std::vector<u8> AmfVector<AmfItem>::serialize(SerializationContext& ctx) const {
+	AmfSegments out = AmfSegments::contiguous();
+	serializeInto(ctx, out);
+	return out.release();
+}
+
+void AmfVector<AmfItem>::serializeInto(SerializationContext& ctx, AmfSegments& out) const {
 	int index = ctx.getIndex(*this);
-	if (index != -1)
-		return std::vector<u8> { AMF_VECTOR_OBJECT, u8(index << 1) };
+	if (index != -1) {
+		out.append(std::vector<u8> { AMF_VECTOR_OBJECT, u8(index << 1) });
+		return;
+	}
 	ctx.addObject(*this);
 
 	// U29V value, encoding the length
-	std::vector<u8> buf = AmfInteger::asLength(values.size(), AMF_VECTOR_OBJECT);
+	out.append(AmfInteger::asLength(values.size(), AMF_VECTOR_OBJECT));
 
 	// fixed-vector marker
-	buf.push_back(fixed ? 0x01 : 0x00);
+	out.push_back(fixed ? 0x01 : 0x00);
 
 	// object type name
-	std::vector<u8> typeName = AmfString(type).serializeValue(ctx);
-	buf.insert(buf.end(), typeName.begin(), typeName.end());
-
-	for (const auto& it : values) {
-		auto s = it->serialize(ctx);
-		buf.insert(buf.end(), s.begin(), s.end());
-	}
+	out.append(AmfString(type).serializeValue(ctx));
 
-	return buf;
+	for (const auto& it : values)
+		it->serializeInto(ctx, out);
 }
 
 AmfItemPtr AmfVector<AmfItem>::deserializePtr(
@@ -44,9 +44,10 @@ class AmfVector<T, typename VectorProperties<T>::type> : public AmfItem {
 public:
 	AmfVector() : values({}), fixed(false) { }
 	AmfVector(std::vector<T> vector, bool fixed = false) :
-		values(vector), fixed(fixed) { }
+		values(std::move(vector)), fixed(fixed) { }
 
 	bool operator==(const AmfItem& other) const;
+	size_t hashValue(int depth, AmfHashState& state) const;
 
 	void push_back(T item) {
 		values.push_back(item);
@@ -57,6 +58,7 @@ public:
 	}
 
 	std::vector<u8> serialize(SerializationContext& ctx) const;
+	static AmfItemPtr deserializePtr(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
 	static AmfVector<T> deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
 
 	std::vector<T> values;
@@ -66,20 +68,31 @@ public:
 template<>
 class AmfVector<AmfItem> : public AmfItem {
 public:
-	AmfVector(std::string type, bool fixed = false) : type(type), fixed(fixed) { }
+	AmfVector(std::string type, bool fixed = false) : type(std::move(type)), fixed(fixed) { }
 
 	bool operator==(const AmfItem& other) const;
+	size_t hashValue(int depth, AmfHashState& state) const;
+	void children(std::vector<const AmfItemPtr*>& out) const;
+	void clearChildren();
 	std::vector<u8> serialize(SerializationContext& ctx) const;
+	void serializeInto(SerializationContext& ctx, AmfSegments& out) const;
 	static AmfItemPtr deserializePtr(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
 	static AmfVector<AmfItem> deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
 
 	template<typename V, typename std::enable_if<std::is_base_of<AmfItem, V>::value, int>::type = 0>
-	AmfVector<V> as() {
+	AmfVector<V> as() const & {
 		AmfVector<V> ret({}, type, fixed);
 		ret.values = values;
 		return ret;
 	}
 
+	template<typename V, typename std::enable_if<std::is_base_of<AmfItem, V>::value, int>::type = 0>
+	AmfVector<V> as() && {
+		AmfVector<V> ret({}, std::move(type), fixed);
+		ret.values = std::move(values);
+		return ret;
+	}
+
 	std::vector<AmfItemPtr> values;
 	std::string type;
 	bool fixed;
@@ -90,9 +103,10 @@ class AmfVector<T, typename std::enable_if<
 	std::is_base_of<AmfItem, T>::value>::type> : public AmfVector<AmfItem> {
 public:
 	AmfVector(std::vector<T> vector, std::string type, bool fixed = false) :
-		AmfVector<AmfItem>(type, fixed) {
-		for (const auto& it : vector)
-			push_back(it);
+		AmfVector<AmfItem>(std::move(type), fixed) {
+		values.reserve(vector.size());
+		for (auto& it : vector)
+			push_back(std::move(it));
 	}
 
 	bool operator==(const AmfItem& other) const {
@@ -104,6 +118,10 @@ public:
 		values.emplace_back(new T(item));
 	}
 
+	void push_back(T&& item) {
+		values.emplace_back(new T(std::move(item)));
+	}
+
 	T& at(int index) {
 		return values.at(index).template as<T>();
 	}
@@ -1,7 +1,10 @@
 #include "amfxml.hpp"
 
+#include <functional>
+
 #include "serializationcontext.hpp"
 #include "types/amfinteger.hpp"
+#include "utils/amfsegments.hpp"
 
 namespace amf {
 
@@ -10,6 +13,10 @@ bool AmfXml::operator==(const AmfItem& other) const {
 	return p != nullptr && value == p->value;
 }
 
+size_t AmfXml::hashValue(int, AmfHashState&) const {
+	return hash_combine(AMF_XML, std::hash<std::string>()(value));
+}
+
 std::vector<u8> AmfXml::serialize(SerializationContext& ctx) const {
 	int index = ctx.getIndex(*this);
 	if (index != -1)
@@ -23,6 +30,23 @@ std::vector<u8> AmfXml::serialize(SerializationContext& ctx) const {
 
 	return buf;
 }
+void AmfXml::serializeInto(SerializationContext& ctx, AmfSegments& out) const {
+	int index = ctx.getIndex(*this);
+	if (index != -1) {
+		out.append(std::vector<u8> { AMF_XML, u8(index << 1) });
+		return;
+	}
+
+	out.append(AmfInteger::asLength(value.size(), AMF_XML));
+
+	// If the payload is referenced in place, don't copy it into the context
+	// either.
+	if (out.appendPayload(reinterpret_cast<const u8*>(value.data()), value.size()))
+		ctx.addPointer(AmfItemPtr::unowned(*this));
+	else
+		ctx.addObject(*this);
+}
+
 
 AmfXml AmfXml::deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
 	if (it == end || *it++ != AMF_XML)
@@ -13,10 +13,12 @@ class SerializationContext;
 class AmfXml : public AmfItem {
 public:
 	AmfXml() { }
-	AmfXml(std::string value) : value(value) { }
+	AmfXml(std::string value) : value(std::move(value)) { }
 
 	bool operator==(const AmfItem& other) const;
+	size_t hashValue(int depth, AmfHashState& state) const;
 	std::vector<u8> serialize(SerializationContext& ctx) const;
+	void serializeInto(SerializationContext& ctx, AmfSegments& out) const;
 	static AmfXml deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
 
 	std::string value;
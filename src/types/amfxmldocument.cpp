@@ -1,8 +1,11 @@
 #include "amfxmldocument.hpp"
 
+#include <functional>
+
 #include "serializationcontext.hpp"
 #include "types/amfinteger.hpp"
 #include "types/amfxml.hpp"
+#include "utils/amfsegments.hpp"
 
 namespace amf {
 
@@ -11,6 +14,10 @@ bool AmfXmlDocument::operator==(const AmfItem& other) const {
 	return p != nullptr && value == p->value;
 }
 
+size_t AmfXmlDocument::hashValue(int, AmfHashState&) const {
+	return hash_combine(AMF_XMLDOC, std::hash<std::string>()(value));
+}
+
 std::vector<u8> AmfXmlDocument::serialize(SerializationContext& ctx) const {
 	int index = ctx.getIndex(*this);
 	if (index != -1)
@@ -26,6 +33,23 @@ std::vector<u8> AmfXmlDocument::serialize(SerializationContext& ctx) const {
 
 	return buf;
 }
+void AmfXmlDocument::serializeInto(SerializationContext& ctx, AmfSegments& out) const {
+	int index = ctx.getIndex(*this);
+	if (index != -1) {
+		out.append(std::vector<u8> { AMF_XMLDOC, u8(index << 1) });
+		return;
+	}
+
+	out.append(AmfInteger::asLength(value.size(), AMF_XMLDOC));
+
+	// If the payload is referenced in place, don't copy it into the context
+	// either.
+	if (out.appendPayload(reinterpret_cast<const u8*>(value.data()), value.size()))
+		ctx.addPointer(AmfItemPtr::unowned(*this));
+	else
+		ctx.addObject(*this);
+}
+
 
 AmfXmlDocument AmfXmlDocument::deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
 	if (it == end || *it++ != AMF_XMLDOC)
@@ -0,0 +1,123 @@
+#include "amf0deserializer.hpp"
+
+#include "amfpacket.hpp"
+#include "deserializer.hpp"
+#include "types/amfarray.hpp"
+#include "types/amfbool.hpp"
+#include "types/amfdate.hpp"
+#include "types/amfdouble.hpp"
+#include "types/amfnull.hpp"
+#include "types/amfobject.hpp"
+#include "types/amfstring.hpp"
+#include "types/amfundefined.hpp"
+#include "types/amfxmldocument.hpp"
+
+namespace amf {
+
+static std::string readString(v8::const_iterator& it, v8::const_iterator end, size_t length) {
+	if (static_cast<size_t>(end - it) < length)
+		throw std::out_of_range("Not enough bytes for AMF0 string");
+
+	std::string ret(it, it + length);
+	it += length;
+	return ret;
+}
+
+std::string Amf0Deserializer::deserializeString(v8::const_iterator& it, v8::const_iterator end) {
+	return readString(it, end, read_network<uint16_t>(it, end));
+}
+
+void Amf0Deserializer::deserializeProperties(v8::const_iterator& it, v8::const_iterator end,
+	std::map<std::string, AmfItemPtr>& properties) {
+	while (true) {
+		std::string name = deserializeString(it, end);
+		if (name.empty()) {
+			if (it == end)
+				throw std::out_of_range("Not enough bytes for AMF0 object");
+			if (*it++ != AMF0_OBJECT_END)
+				throw std::invalid_argument("Amf0Deserializer: Expected object end marker");
+			break;
+		}
+
+		properties[name] = deserialize(it, end);
+	}
+}
+
+AmfItemPtr Amf0Deserializer::deserialize(v8::const_iterator& it, v8::const_iterator end) {
+	if (it == end)
+		throw std::out_of_range("Not enough bytes for AMF0 value");
+
+	switch (*it++) {
+		case AMF0_NUMBER:
+			return AmfItemPtr(AmfDouble(read_network<double>(it, end)));
+		case AMF0_BOOLEAN:
+			if (it == end)
+				throw std::out_of_range("Not enough bytes for AMF0 boolean");
+			return AmfItemPtr(AmfBool(*it++ != 0x00));
+		case AMF0_STRING:
+			return AmfItemPtr(AmfString(deserializeString(it, end)));
+		case AMF0_LONG_STRING:
+			return AmfItemPtr(AmfString(readString(it, end, read_network<uint32_t>(it, end))));
+		case AMF0_XML_DOCUMENT:
+			return AmfItemPtr(AmfXmlDocument(readString(it, end, read_network<uint32_t>(it, end))));
+		case AMF0_NULL:
+			return AmfItemPtr(AmfNull());
+		case AMF0_UNDEFINED:
+			return AmfItemPtr(AmfUndefined());
+		case AMF0_DATE: {
+			double date = read_network<double>(it, end);
+			// The time zone is reserved and should be ignored.
+			read_network<int16_t>(it, end);
+			return AmfItemPtr(AmfDate(static_cast<long long>(date)));
+		}
+		case AMF0_OBJECT:
+		case AMF0_TYPED_OBJECT: {
+			std::string className;
+			if (*(it - 1) == AMF0_TYPED_OBJECT)
+				className = deserializeString(it, end);
+
+			// Added to the reference table before reading the properties, as
+			// they may refer to the object itself.
+			AmfItemPtr ptr(new AmfObject(className, true, false));
+			references.push_back(ptr);
+			deserializeProperties(it, end, ptr.as<AmfObject>().dynamicProperties);
+			return ptr;
+		}
+		case AMF0_ECMA_ARRAY: {
+			// The associative count is only a hint, the members are terminated
+			// by an object end marker like those of an object.
+			read_network<uint32_t>(it, end);
+
+			AmfItemPtr ptr(new AmfArray());
+			references.push_back(ptr);
+			deserializeProperties(it, end, ptr.as<AmfArray>().associative);
+			return ptr;
+		}
+		case AMF0_STRICT_ARRAY: {
+			uint32_t count = read_network<uint32_t>(it, end);
+			// Every element takes up at least one byte.
+			if (static_cast<size_t>(end - it) < count)
+				throw std::out_of_range("Not enough bytes for AMF0 strict array");
+
+			AmfItemPtr ptr(new AmfArray());
+			references.push_back(ptr);
+			AmfArray& array = ptr.as<AmfArray>();
+			array.dense.reserve(count);
+			for (uint32_t i = 0; i < count; ++i)
+				array.dense.push_back(deserialize(it, end));
+			return ptr;
+		}
+		case AMF0_REFERENCE: {
+			uint16_t index = read_network<uint16_t>(it, end);
+			if (index >= references.size())
+				throw std::out_of_range("Amf0Deserializer: Invalid reference");
+			return references[index];
+		}
+		case AVMPLUS_OBJECT:
+			return Deserializer::deserialize(it, end, ctx);
+		default:
+			throw std::invalid_argument("Amf0Deserializer: Unsupported type marker");
+	}
+}
+
+} // namespace amf
@@ -0,0 +1,43 @@
+#pragma once
+#ifndef AMF0DESERIALIZER_HPP
+#define AMF0DESERIALIZER_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "amf.hpp"
+#include "serializationcontext.hpp"
+#include "utils/amfitemptr.hpp"
+
+namespace amf {
+
+// Decodes AMF0 values into the corresponding AMF3 types:
+//   Number -> AmfDouble, Boolean -> AmfBool, (long) String -> AmfString,
+//   anonymous and typed Objects -> dynamic AmfObject, ECMA Array -> associative
+//   AmfArray, Strict Array -> dense AmfArray, Date -> AmfDate,
+//   XML Document -> AmfXmlDocument, Null -> AmfNull, Undefined -> AmfUndefined.
+// Values following an AVM+ marker are decoded as AMF3.
+//
+// Object references are resolved against the values read by the same
+// instance, so consecutive values of a message should be read through one
+// Amf0Deserializer.
+class Amf0Deserializer {
+public:
+	AmfItemPtr deserialize(v8::const_iterator& it, v8::const_iterator end);
+
+	// Reads a UTF-8 string without type marker, i.e.
+	// U16 length (in network order) U8* value
+	static std::string deserializeString(v8::const_iterator& it, v8::const_iterator end);
+
+private:
+	void deserializeProperties(v8::const_iterator& it, v8::const_iterator end,
+		std::map<std::string, AmfItemPtr>& properties);
+
+	std::vector<AmfItemPtr> references;
+	SerializationContext ctx;
+};
+
+} // namespace amf
+
+#endif
@@ -0,0 +1,200 @@
+#include "amfcodegen.hpp"
+
+#include "deserializer.hpp"
+#include "types/amfbool.hpp"
+#include "types/amfdouble.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfstring.hpp"
+
+namespace amf {
+
+// Appends a U29 value without type marker.
+static void appendU29(v8& buf, int value, SerializationContext& ctx) {
+	if (value < 0 || value >= 0x10000000)
+		throw std::invalid_argument("AmfCodegen: U29 value out of range");
+
+	v8 encoded = AmfInteger(value).serialize(ctx);
+	buf.insert(buf.end(), encoded.begin() + 1, encoded.end());
+}
+
+static void append(v8& buf, const v8& data) {
+	buf.insert(buf.end(), data.begin(), data.end());
+}
+
+AmfCodegen::Header AmfCodegen::readHeader(v8::const_iterator& it,
+	v8::const_iterator end, SerializationContext& ctx,
+	const std::string& className, const std::vector<std::string>& expected) {
+	if (it == end || *it++ != AMF_OBJECT)
+		throw std::invalid_argument("AmfCodegen: Invalid type marker");
+
+	Header header;
+	int type = AmfInteger::deserializeValue(it, end);
+	if ((type & 0x01) == 0x00) {
+		// 0b...0 == U29O-ref
+		header.reference = type >> 1;
+		return header;
+	}
+
+	if ((type & 0x07) == 0x07)
+		throw std::invalid_argument("AmfCodegen: Externalizable objects are not supported");
+
+	const AmfObjectTraits* traits;
+	AmfObjectTraits inlineTraits("", false, false);
+	if ((type & 0x03) == 0x01) {
+		// 0b..01 == U29O-traits-ref
+		traits = &ctx.getTraits(type >> 2);
+	} else {
+		// 0b.011 == U29O-traits
+		inlineTraits.dynamic = ((type & 0x08) == 0x08);
+		inlineTraits.className = AmfString::deserializeValue(it, end, ctx);
+		int numSealed = type >> 4;
+		for (int i = 0; i < numSealed; ++i)
+			inlineTraits.attributes.push_back(AmfString::deserializeValue(it, end, ctx));
+
+		ctx.addTraits(inlineTraits);
+		traits = &inlineTraits;
+	}
+
+	if (traits->className != className)
+		throw std::invalid_argument("AmfCodegen: Unexpected class name " + traits->className);
+
+	header.dynamic = traits->dynamic;
+	header.inOrder = (traits->attributes == expected);
+	if (!header.inOrder)
+		header.attributes = traits->attributes;
+
+	return header;
+}
+
+void AmfCodegen::skipDynamicMembers(v8::const_iterator& it, v8::const_iterator end,
+	SerializationContext& ctx) {
+	while (true) {
+		std::string name = AmfString::deserializeValue(it, end, ctx);
+		if (name == "") break;
+
+		Deserializer::deserialize(it, end, ctx);
+	}
+}
+
+int AmfCodegen::readInt(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	if (it != end && *it == AMF_INTEGER) {
+		++it;
+		return AmfInteger::deserializeValue(it, end);
+	}
+
+	// Integers outside of the U29 range are sent as doubles.
+	return static_cast<int>(AmfDouble::deserialize(it, end, ctx).value);
+}
+
+unsigned int AmfCodegen::readUint(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	return static_cast<unsigned int>(readDouble(it, end, ctx));
+}
+
+double AmfCodegen::readDouble(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	if (it != end && *it == AMF_INTEGER) {
+		++it;
+		return AmfInteger::deserializeValue(it, end);
+	}
+
+	return AmfDouble::deserialize(it, end, ctx).value;
+}
+
+bool AmfCodegen::readBool(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	return AmfBool::deserialize(it, end, ctx).value;
+}
+
+std::string AmfCodegen::readString(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	if (it != end && *it == AMF_NULL) {
+		++it;
+		return std::string();
+	}
+
+	if (it == end || *it++ != AMF_STRING)
+		throw std::invalid_argument("AmfCodegen: Invalid type marker for String");
+
+	return AmfString::deserializeValue(it, end, ctx);
+}
+
+AmfItemPtr AmfCodegen::readItem(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	if (it != end && *it == AMF_NULL) {
+		++it;
+		return AmfItemPtr();
+	}
+
+	return Deserializer::deserialize(it, end, ctx);
+}
+
+void AmfCodegen::writeHeader(v8& buf, const AmfObjectTraits& traits, SerializationContext& ctx) {
+	buf.push_back(AMF_OBJECT);
+
+	const TraitsPlan* plan = ctx.getPlan(traits);
+	if (plan != nullptr) {
+		// U29O-traits-ref
+		buf.insert(buf.end(), plan->reference.begin(), plan->reference.end());
+		return;
+	}
+	ctx.addTraits(traits);
+
+	// U29O-traits = 0b.011, dynamic marker = 0b1000
+	int marker = static_cast<int>(traits.attributes.size()) << 4 | 0x03;
+	if (traits.dynamic)
+		marker |= 0x08;
+	appendU29(buf, marker, ctx);
+
+	append(buf, AmfString(traits.className).serializeValue(ctx));
+	for (const std::string& attribute : traits.attributes)
+		append(buf, AmfString(attribute).serializeValue(ctx));
+}
+
+void AmfCodegen::writeInt(v8& buf, int value, SerializationContext& ctx) {
+	append(buf, AmfInteger(value).serialize(ctx));
+}
+
+void AmfCodegen::writeUint(v8& buf, unsigned int value, SerializationContext& ctx) {
+	if (value < 0x10000000)
+		writeInt(buf, static_cast<int>(value), ctx);
+	else
+		writeDouble(buf, value, ctx);
+}
+
+void AmfCodegen::writeDouble(v8& buf, double value, SerializationContext& ctx) {
+	append(buf, AmfDouble(value).serialize(ctx));
+}
+
+void AmfCodegen::writeBool(v8& buf, bool value, SerializationContext&) {
+	buf.push_back(value ? AMF_TRUE : AMF_FALSE);
+}
+
+void AmfCodegen::writeString(v8& buf, const std::string& value, SerializationContext& ctx) {
+	append(buf, AmfString(value).serialize(ctx));
+}
+
+void AmfCodegen::writeItem(v8& buf, const AmfItemPtr& value, SerializationContext& ctx) {
+	if (value.get() == nullptr) {
+		buf.push_back(AMF_NULL);
+		return;
+	}
+
+	append(buf, value->serialize(ctx));
+}
+
+void AmfCodegen::writeDynamicEnd(v8& buf) {
+	// UTF-8-empty
+	buf.push_back(0x01);
+}
+
+bool AmfCodegen::equal(const AmfItemPtr& a, const AmfItemPtr& b) {
+	if (a.get() == nullptr || b.get() == nullptr)
+		return a.get() == b.get();
+
+	return a == b;
+}
+
+v8 AmfCodegen::referenceBytes(int index) {
+	SerializationContext ctx;
+	v8 buf { AMF_OBJECT };
+	appendU29(buf, index << 1, ctx);
+	return buf;
+}
+
+} // namespace amf
@@ -0,0 +1,93 @@
+#pragma once
+#ifndef AMFCODEGEN_HPP
+#define AMFCODEGEN_HPP
+
+#include <string>
+#include <vector>
+
+#include "amf.hpp"
+#include "serializationcontext.hpp"
+#include "utils/amfitemptr.hpp"
+#include "utils/amfobjecttraits.hpp"
+
+namespace amf {
+
+// Runtime support for the value object codecs emitted by tools/amfgen.
+// Generated classes know the sealed attribute order of their ActionScript
+// counterpart, so they only need these helpers to read the object header and
+// the individual, statically typed, property values.
+class AmfCodegen {
+public:
+	struct Header {
+		Header() : reference(-1), inOrder(false), dynamic(false) { }
+
+		// Index into the object table if the object was sent by reference,
+		// -1 otherwise.
+		int reference;
+		// True if the sealed attributes on the wire match the expected ones,
+		// in the same order. In that case, the values can be read in
+		// declaration order without looking at the attribute names.
+		bool inOrder;
+		// Whether the sender marked the object as dynamic, i.e. whether
+		// dynamic members follow the sealed values.
+		bool dynamic;
+		// Attribute names as sent on the wire. Only filled in if !inOrder.
+		std::vector<std::string> attributes;
+	};
+
+	static Header readHeader(v8::const_iterator& it, v8::const_iterator end,
+		SerializationContext& ctx, const std::string& className,
+		const std::vector<std::string>& expected);
+	static void skipDynamicMembers(v8::const_iterator& it, v8::const_iterator end,
+		SerializationContext& ctx);
+
+	static int readInt(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
+	static unsigned int readUint(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
+	static double readDouble(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
+	static bool readBool(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
+	static std::string readString(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
+	static AmfItemPtr readItem(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
+
+	// Reads a property typed as another generated class T, which may also be
+	// sent as null.
+	template<typename T>
+	static AmfItemPtr readObject(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+		if (it != end && *it == AMF_NULL) {
+			++it;
+			return AmfItemPtr();
+		}
+
+		return T::deserializePtr(it, end, ctx);
+	}
+
+	// Returns the serialized reference if obj is already known to ctx,
+	// otherwise registers it and returns an empty vector.
+	template<typename T>
+	static v8 writeReference(const T& obj, SerializationContext& ctx) {
+		int index = ctx.getIndex(obj);
+		if (index != -1)
+			return referenceBytes(index);
+
+		ctx.addObject(obj);
+		return v8();
+	}
+
+	static void writeHeader(v8& buf, const AmfObjectTraits& traits, SerializationContext& ctx);
+	static void writeInt(v8& buf, int value, SerializationContext& ctx);
+	static void writeUint(v8& buf, unsigned int value, SerializationContext& ctx);
+	static void writeDouble(v8& buf, double value, SerializationContext& ctx);
+	static void writeBool(v8& buf, bool value, SerializationContext& ctx);
+	static void writeString(v8& buf, const std::string& value, SerializationContext& ctx);
+	static void writeItem(v8& buf, const AmfItemPtr& value, SerializationContext& ctx);
+	static void writeDynamicEnd(v8& buf);
+
+	// Null-safe comparison for AmfItemPtr members.
+	static bool equal(const AmfItemPtr& a, const AmfItemPtr& b);
+
+private:
+	static v8 referenceBytes(int index);
+};
+
+} // namespace amf
+
+#endif
@@ -0,0 +1,302 @@
+#include "amfcolumns.hpp"
+
+#include <unordered_map>
+
+#include "deserializer.hpp"
+#include "types/amfbool.hpp"
+#include "types/amfdouble.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfstring.hpp"
+
+namespace amf {
+
+size_t AmfColumn::size() const {
+	switch (type) {
+		case INTEGER: return integers.size();
+		case DOUBLE: return doubles.size();
+		case STRING: return strings.size();
+		case BOOL: return bools.size();
+		default: return items.size();
+	}
+}
+
+AmfItemPtr AmfColumn::item(size_t row) const {
+	switch (type) {
+		case INTEGER: return AmfItemPtr(AmfInteger(integers.at(row)));
+		case DOUBLE: return AmfItemPtr(AmfDouble(doubles.at(row)));
+		case STRING: return AmfItemPtr(AmfString(strings.at(row).str()));
+		case BOOL: return AmfItemPtr(AmfBool(bools.at(row)));
+		default: return items.at(row);
+	}
+}
+
+void AmfColumn::promote(Type to) {
+	if (type == to)
+		return;
+
+	if (type == INTEGER && to == DOUBLE) {
+		doubles.assign(integers.begin(), integers.end());
+	} else {
+		size_t rows = size();
+		items.reserve(rows);
+		for (size_t i = 0; i < rows; ++i)
+			items.push_back(item(i));
+	}
+
+	integers.clear();
+	strings.clear();
+	bools.clear();
+	if (to != DOUBLE)
+		doubles.clear();
+
+	type = to;
+}
+
+namespace {
+
+// Appends single values to their column.
+class ColumnReader {
+public:
+	ColumnReader(SerializationContext& ctx, std::deque<std::string>& storage) :
+		ctx(ctx), storage(storage) { }
+
+	void readValue(AmfColumn& column, v8::const_iterator& it, v8::const_iterator end);
+	void copyValue(AmfColumn& column, size_t row);
+
+private:
+	AmfColumn::Type typeOf(u8 marker);
+	AmfStringView readString(v8::const_iterator& it, v8::const_iterator end);
+
+	SerializationContext& ctx;
+	std::deque<std::string>& storage;
+
+	// Indexed like the context's string table. Strings that were not read by
+	// us (e.g. while deserializing an ITEM value) have a null data pointer
+	// until they are first referenced.
+	std::vector<AmfStringView> views;
+};
+
+AmfColumn::Type ColumnReader::typeOf(u8 marker) {
+	switch (marker) {
+		case AMF_INTEGER: return AmfColumn::INTEGER;
+		case AMF_DOUBLE: return AmfColumn::DOUBLE;
+		case AMF_STRING: return AmfColumn::STRING;
+		case AMF_FALSE:
+		case AMF_TRUE: return AmfColumn::BOOL;
+		default: return AmfColumn::ITEM;
+	}
+}
+
+AmfStringView ColumnReader::readString(v8::const_iterator& it, v8::const_iterator end) {
+	int type = AmfInteger::deserializeValue(it, end);
+	if ((type & 0x01) == 0) {
+		size_t index = type >> 1;
+		if (index < views.size() && views[index].data != nullptr)
+			return views[index];
+
+		storage.push_back(ctx.getString(index));
+		if (views.size() <= index)
+			views.resize(index + 1, AmfStringView(nullptr, 0));
+
+		views[index] = AmfStringView(storage.back().data(), storage.back().size());
+		return views[index];
+	}
+
+	int length = type >> 1;
+	if (end - it < length)
+		throw std::out_of_range("Not enough bytes for AmfString");
+
+	// Empty strings are never added to the string table.
+	if (length == 0)
+		return AmfStringView();
+
+	AmfStringView view(reinterpret_cast<const char*>(&*it), length);
+	size_t index = ctx.stringCount();
+	ctx.addString(std::string(it, it + length));
+	it += length;
+
+	if (views.size() <= index)
+		views.resize(index + 1, AmfStringView(nullptr, 0));
+	views[index] = view;
+
+	return view;
+}
+
+void ColumnReader::readValue(AmfColumn& column, v8::const_iterator& it, v8::const_iterator end) {
+	if (it == end)
+		throw std::out_of_range("Not enough bytes for AmfColumns");
+
+	u8 marker = *it;
+	AmfColumn::Type type = typeOf(marker);
+	if (column.size() == 0) {
+		// first row
+		column.type = type;
+	} else if (column.type != type) {
+		if (column.type == AmfColumn::INTEGER && type == AmfColumn::DOUBLE)
+			column.promote(AmfColumn::DOUBLE);
+		else if (column.type != AmfColumn::DOUBLE || type != AmfColumn::INTEGER)
+			column.promote(AmfColumn::ITEM);
+	}
+
+	switch (column.type) {
+		case AmfColumn::INTEGER:
+			++it;
+			column.integers.push_back(AmfInteger::deserializeValue(it, end));
+			break;
+		case AmfColumn::DOUBLE:
+			if (marker == AMF_INTEGER) {
+				++it;
+				column.doubles.push_back(AmfInteger::deserializeValue(it, end));
+			} else {
+				column.doubles.push_back(AmfDouble::deserialize(it, end, ctx).value);
+			}
+			break;
+		case AmfColumn::STRING:
+			++it;
+			column.strings.push_back(readString(it, end));
+			break;
+		case AmfColumn::BOOL:
+			++it;
+			column.bools.push_back(marker == AMF_TRUE);
+			break;
+		default:
+			column.items.push_back(Deserializer::deserialize(it, end, ctx));
+			break;
+	}
+}
+
+void ColumnReader::copyValue(AmfColumn& column, size_t row) {
+	switch (column.type) {
+		case AmfColumn::INTEGER: column.integers.push_back(column.integers.at(row)); break;
+		case AmfColumn::DOUBLE: column.doubles.push_back(column.doubles.at(row)); break;
+		case AmfColumn::STRING: column.strings.push_back(column.strings.at(row)); break;
+		case AmfColumn::BOOL: column.bools.push_back(column.bools.at(row)); break;
+		default: column.items.push_back(column.items.at(row)); break;
+	}
+}
+
+} // namespace
+
+const AmfColumn& AmfColumns::column(const std::string& name) const {
+	auto it = std::lower_bound(columns.begin(), columns.end(), name,
+		[](const AmfColumn& column, const std::string& name) {
+			return column.name < name;
+		});
+
+	if (it == columns.end() || it->name != name)
+		throw std::out_of_range("AmfColumns::column");
+
+	return *it;
+}
+
+AmfColumns AmfColumns::deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	if (it == end || (*it != AMF_ARRAY && *it != AMF_VECTOR_OBJECT))
+		throw std::invalid_argument("AmfColumns: Invalid type marker");
+	u8 marker = *it++;
+
+	int type = AmfInteger::deserializeValue(it, end);
+	if ((type & 0x01) == 0)
+		throw std::invalid_argument("AmfColumns: Array references are not supported");
+
+	if (marker == AMF_ARRAY) {
+		// The array only takes up a slot in the reference table.
+		ctx.addPointer(AmfItemPtr());
+
+		if (AmfString::deserializeValue(it, end, ctx) != "")
+			throw std::invalid_argument("AmfColumns: Associative array members are not supported");
+	} else {
+		if (it == end)
+			throw std::out_of_range("Not enough bytes for AmfVector");
+		// fixed marker and object type name
+		++it;
+		AmfString::deserializeValue(it, end, ctx);
+
+		ctx.addPointer(AmfItemPtr());
+	}
+
+	AmfColumns ret;
+	ColumnReader reader(ctx, *ret.storage);
+
+	const TraitsPlan* plan = nullptr;
+	// For every sealed value in wire order, whether it is the last one for
+	// its attribute name. Earlier values for duplicate names are skipped.
+	std::vector<bool> keep;
+	// Object table index of each row, to resolve references to earlier rows.
+	std::unordered_map<int, size_t> rowOfObject;
+
+	int count = type >> 1;
+	for (int row = 0; row < count; ++row, ++ret.rows) {
+		if (it == end || *it++ != AMF_OBJECT)
+			throw std::invalid_argument("AmfColumns: Elements have to be objects");
+
+		int header = AmfInteger::deserializeValue(it, end);
+		if ((header & 0x01) == 0x00) {
+			// 0b...0 == U29O-ref
+			auto found = rowOfObject.find(header >> 1);
+			if (found == rowOfObject.end())
+				throw std::invalid_argument("AmfColumns: Unsupported object reference");
+
+			for (AmfColumn& column : ret.columns)
+				reader.copyValue(column, found->second);
+			continue;
+		}
+
+		size_t traitsIndex;
+		if ((header & 0x03) == 0x01) {
+			// 0b..01 == U29O-traits-ref
+			traitsIndex = header >> 2;
+		} else if ((header & 0x07) == 0x07) {
+			throw std::invalid_argument("AmfColumns: Externalizable objects are not supported");
+		} else {
+			// 0b.011 == U29O-traits
+			AmfObjectTraits traits("", (header & 0x08) == 0x08, false);
+			traits.className = AmfString::deserializeValue(it, end, ctx);
+			int numSealed = header >> 4;
+			for (int i = 0; i < numSealed; ++i)
+				traits.attributes.push_back(AmfString::deserializeValue(it, end, ctx));
+
+			ctx.addTraits(traits);
+			traitsIndex = ctx.getIndex(traits);
+		}
+
+		const TraitsPlan& rowPlan = ctx.getPlan(traitsIndex);
+		if (plan == nullptr) {
+			if (rowPlan.traits->externalizable)
+				throw std::invalid_argument("AmfColumns: Externalizable objects are not supported");
+
+			plan = &rowPlan;
+			ret.traits = *plan->traits;
+			for (const std::string& name : plan->attributes)
+				ret.columns.emplace_back(name);
+
+			keep.assign(plan->slots.size(), true);
+			for (size_t i = 0; i < plan->slots.size(); ++i) {
+				for (size_t j = i + 1; j < plan->slots.size(); ++j) {
+					if (plan->slots[i] == plan->slots[j])
+						keep[i] = false;
+				}
+			}
+		} else if (&rowPlan != plan && *rowPlan.traits != ret.traits) {
+			throw std::invalid_argument("AmfColumns: Elements do not share traits");
+		}
+
+		rowOfObject.emplace(static_cast<int>(ctx.objectCount()), ret.rows);
+		ctx.addPointer(AmfItemPtr());
+
+		for (size_t i = 0; i < plan->slots.size(); ++i) {
+			if (keep[i])
+				reader.readValue(ret.columns[plan->slots[i]], it, end);
+			else
+				Deserializer::deserialize(it, end, ctx);
+		}
+
+		if (ret.traits.dynamic) {
+			if (AmfString::deserializeValue(it, end, ctx) != "")
+				throw std::invalid_argument("AmfColumns: Dynamic members are not supported");
+		}
+	}
+
+	return ret;
+}
+
+} // namespace amf
@@ -0,0 +1,113 @@
+#pragma once
+#ifndef AMFCOLUMNS_HPP
+#define AMFCOLUMNS_HPP
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "amf.hpp"
+#include "serializationcontext.hpp"
+#include "utils/amfitemptr.hpp"
+#include "utils/amfobjecttraits.hpp"
+
+namespace amf {
+
+// Non-owning reference to string data, either inside the buffer that was
+// deserialized or inside the AmfColumns it belongs to.
+struct AmfStringView {
+	AmfStringView() : data(""), size(0) { }
+	AmfStringView(const char* data, size_t size) : data(data), size(size) { }
+
+	std::string str() const {
+		return std::string(data, size);
+	}
+
+	bool operator==(const AmfStringView& other) const {
+		return size == other.size && std::equal(data, data + size, other.data);
+	}
+
+	bool operator!=(const AmfStringView& other) const {
+		return !(*this == other);
+	}
+
+	const char* data;
+	size_t size;
+};
+
+// All values of a single sealed attribute. Only the vector matching type is
+// filled in.
+class AmfColumn {
+public:
+	enum Type {
+		INTEGER,
+		DOUBLE,
+		STRING,
+		BOOL,
+		// Any other type, or a mix of types.
+		ITEM
+	};
+
+	AmfColumn(std::string name) : name(name), type(INTEGER) { }
+
+	size_t size() const;
+
+	// Returns the value in the given row as a newly created item, independent
+	// of the column type.
+	AmfItemPtr item(size_t row) const;
+
+	// Converts all values to the given type, which has to be either DOUBLE
+	// (for INTEGER columns) or ITEM.
+	void promote(Type to);
+
+	std::string name;
+	Type type;
+
+	std::vector<int> integers;
+	std::vector<double> doubles;
+	std::vector<AmfStringView> strings;
+	std::vector<bool> bools;
+	std::vector<AmfItemPtr> items;
+};
+
+// Struct-of-arrays representation of a dense array (or an object vector)
+// whose elements are all objects with the same traits. Values are read
+// directly from the serialized data into one column per sealed attribute,
+// without creating an AmfObject for each element.
+//
+// A column keeps a primitive type (int, double, string or bool) as long as
+// all of its values have that type. Integers are widened to doubles if
+// necessary, all other mixes fall back to ITEM.
+//
+// The array and its elements still take up their slots in the object
+// reference table, but the context only stores null placeholders for them.
+// Deserializing an item that refers to one of them throws.
+class AmfColumns {
+public:
+	AmfColumns() : rows(0), traits("", false, false),
+		storage(std::make_shared<std::deque<std::string>>()) { }
+
+	const AmfColumn& column(const std::string& name) const;
+
+	// Throws std::invalid_argument if the data is not a dense array (or
+	// Vector.<Object>) of non-externalizable objects sharing the same traits,
+	// or if any of the objects has dynamic members.
+	//
+	// String views point into the [it, end) range for strings that are sent
+	// inline, so the buffer has to outlive the returned value.
+	static AmfColumns deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
+
+	size_t rows;
+	AmfObjectTraits traits;
+	// Sorted by name, see TraitsPlan::attributes.
+	std::vector<AmfColumn> columns;
+
+private:
+	// Strings that were sent by reference to a string not read by us.
+	std::shared_ptr<std::deque<std::string>> storage;
+};
+
+} // namespace amf
+
+#endif
@@ -0,0 +1,19 @@
+#include "amfexternalregistry.hpp"
+
+#include "utils/amfflex.hpp"
+#include "utils/amfflexmessages.hpp"
+
+namespace amf {
+
+const ExternalDeserializerRegistry& ExternalDeserializerRegistry::builtin() {
+	static const ExternalDeserializerRegistry registry = []() {
+		ExternalDeserializerRegistry ret;
+		AmfFlex::registerCodecs(ret);
+		AbstractMessage::registerCodecs(ret);
+		return ret;
+	}();
+
+	return registry;
+}
+
+} // namespace amf
@@ -0,0 +1,73 @@
+#pragma once
+#ifndef AMFEXTERNALREGISTRY_HPP
+#define AMFEXTERNALREGISTRY_HPP
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "amf.hpp"
+
+namespace amf {
+
+class AmfObject;
+class SerializationContext;
+
+typedef std::function<AmfObject(v8::const_iterator&, v8::const_iterator,
+	SerializationContext&)> ExternalDeserializerFunction;
+
+// Reads the externalized data into obj, which already has the right traits
+// and is stored in the context's object table, instead of returning a new
+// object that has to be copied into place.
+typedef std::function<void(AmfObject& obj, v8::const_iterator&, v8::const_iterator,
+	SerializationContext&)> ExternalReaderFunction;
+
+// Either of the two ways of deserializing an externalizable object.
+struct ExternalDeserializer {
+	ExternalDeserializerFunction function;
+	ExternalReaderFunction reader;
+};
+
+// Maps class names of externalizable objects to the functions deserializing
+// them. A registry is meant to be filled once and then shared as a
+// std::shared_ptr<const ExternalDeserializerRegistry> between any number of
+// contexts, which may be used on different threads concurrently.
+class ExternalDeserializerRegistry {
+public:
+	ExternalDeserializerRegistry() { }
+	ExternalDeserializerRegistry(std::initializer_list<std::pair<const std::string, ExternalDeserializerFunction>> functions) {
+		for (const auto& it : functions)
+			add(it.first, it.second);
+	}
+
+	void add(std::string className, ExternalDeserializerFunction function) {
+		entries[std::move(className)] = ExternalDeserializer { std::move(function), nullptr };
+	}
+
+	void addReader(std::string className, ExternalReaderFunction reader) {
+		entries[std::move(className)] = ExternalDeserializer { nullptr, std::move(reader) };
+	}
+
+	// Returns nullptr if nothing is registered for className.
+	const ExternalDeserializer* find(const std::string& className) const {
+		auto it = entries.find(className);
+		return it == entries.end() ? nullptr : &it->second;
+	}
+
+	size_t size() const {
+		return entries.size();
+	}
+
+	// Readers for common externalizable classes (see AmfFlex and
+	// AbstractMessage), used for class names that are neither found in a
+	// context's registry nor in Deserializer::externalDeserializers.
+	static const ExternalDeserializerRegistry& builtin();
+
+private:
+	std::unordered_map<std::string, ExternalDeserializer> entries;
+};
+
+} // namespace amf
+
+#endif
@@ -0,0 +1,59 @@
+#include "amfflex.hpp"
+
+#include "deserializer.hpp"
+#include "serializationcontext.hpp"
+#include "utils/amfexternalregistry.hpp"
+
+namespace amf {
+
+const std::string AmfFlex::ArrayCollection("flex.messaging.io.ArrayCollection");
+const std::string AmfFlex::ArrayList("flex.messaging.io.ArrayList");
+const std::string AmfFlex::ObjectProxy("flex.messaging.io.ObjectProxy");
+
+static const std::string& wrappedName(const std::string& className) {
+	static const std::string source("source"), object("object");
+	return className == AmfFlex::ObjectProxy ? object : source;
+}
+
+// writeExternal of all three classes consists of writeObject(wrapped).
+static v8 externalizeWrapped(const AmfObject* obj, SerializationContext& ctx) {
+	return AmfFlex::wrapped(*obj)->serialize(ctx);
+}
+
+static void readWrapped(AmfObject& obj, v8::const_iterator& it, v8::const_iterator end,
+	SerializationContext& ctx) {
+	const std::string& name = wrappedName(obj.objectTraits().className);
+	obj.sealedProperties[name] = Deserializer::deserialize(it, end, ctx);
+	obj.externalizer = externalizeWrapped;
+}
+
+static AmfObject makeWrapper(const std::string& className, AmfItemPtr value) {
+	AmfObject ret(className, false, true);
+	ret.sealedProperties[wrappedName(className)] = std::move(value);
+	ret.externalizer = externalizeWrapped;
+	return ret;
+}
+
+AmfObject AmfFlex::arrayCollection(AmfItemPtr source) {
+	return makeWrapper(ArrayCollection, std::move(source));
+}
+
+AmfObject AmfFlex::arrayList(AmfItemPtr source) {
+	return makeWrapper(ArrayList, std::move(source));
+}
+
+AmfObject AmfFlex::objectProxy(AmfItemPtr object) {
+	return makeWrapper(ObjectProxy, std::move(object));
+}
+
+const AmfItemPtr& AmfFlex::wrapped(const AmfObject& obj) {
+	return obj.sealedProperties.at(wrappedName(obj.objectTraits().className));
+}
+
+void AmfFlex::registerCodecs(ExternalDeserializerRegistry& registry) {
+	registry.addReader(ArrayCollection, readWrapped);
+	registry.addReader(ArrayList, readWrapped);
+	registry.addReader(ObjectProxy, readWrapped);
+}
+
+} // namespace amf
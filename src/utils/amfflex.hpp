@@ -0,0 +1,41 @@
+#pragma once
+#ifndef AMFFLEX_HPP
+#define AMFFLEX_HPP
+
+#include <string>
+
+#include "amf.hpp"
+#include "types/amfobject.hpp"
+#include "utils/amfitemptr.hpp"
+
+namespace amf {
+
+class ExternalDeserializerRegistry;
+
+// Codecs for the externalizable classes of the Flex framework.
+//
+// ArrayCollection, ArrayList and ObjectProxy externalize themselves as a
+// single wrapped value (the source array, or the proxied object). They are
+// represented as externalizable AmfObjects that keep the wrapped value in
+// their sealed properties under the name "source" and "object" respectively,
+// without adding it to their traits.
+class AmfFlex {
+public:
+	static const std::string ArrayCollection;
+	static const std::string ArrayList;
+	static const std::string ObjectProxy;
+
+	static AmfObject arrayCollection(AmfItemPtr source);
+	static AmfObject arrayList(AmfItemPtr source);
+	static AmfObject objectProxy(AmfItemPtr object);
+
+	// Returns the value wrapped by one of the objects above.
+	static const AmfItemPtr& wrapped(const AmfObject& obj);
+
+	// Adds readers for the classes above to registry.
+	static void registerCodecs(ExternalDeserializerRegistry& registry);
+};
+
+} // namespace amf
+
+#endif
@@ -0,0 +1,623 @@
+#include "amfflexmessages.hpp"
+
+#include "deserializer.hpp"
+#include "serializationcontext.hpp"
+#include "types/amfbytearray.hpp"
+#include "types/amfdouble.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfnull.hpp"
+#include "types/amfobject.hpp"
+#include "types/amfstring.hpp"
+#include "types/amfundefined.hpp"
+#include "utils/amfcodegen.hpp"
+#include "utils/amfexternalregistry.hpp"
+#include "utils/amfhashstate.hpp"
+
+namespace amf {
+
+const std::string AsyncMessage::className("flex.messaging.messages.AsyncMessage");
+const std::string AsyncMessage::smallName("DSA");
+const std::string AcknowledgeMessage::className("flex.messaging.messages.AcknowledgeMessage");
+const std::string AcknowledgeMessage::smallName("DSK");
+const std::string CommandMessage::className("flex.messaging.messages.CommandMessage");
+const std::string CommandMessage::smallName("DSC");
+const std::string RemotingMessage::className("flex.messaging.messages.RemotingMessage");
+const std::string RemotingMessage::smallName("");
+
+// Flags of the small message forms. The highest bit of every flag byte
+// signals that another flag byte follows.
+enum : u8 {
+	HAS_NEXT_FLAG = 0x80,
+
+	// AbstractMessage, first byte
+	BODY_FLAG = 0x01,
+	CLIENT_ID_FLAG = 0x02,
+	DESTINATION_FLAG = 0x04,
+	HEADERS_FLAG = 0x08,
+	MESSAGE_ID_FLAG = 0x10,
+	TIMESTAMP_FLAG = 0x20,
+	TIME_TO_LIVE_FLAG = 0x40,
+	// AbstractMessage, second byte
+	CLIENT_ID_BYTES_FLAG = 0x01,
+	MESSAGE_ID_BYTES_FLAG = 0x02,
+
+	// AsyncMessage
+	CORRELATION_ID_FLAG = 0x01,
+	CORRELATION_ID_BYTES_FLAG = 0x02,
+
+	// CommandMessage
+	OPERATION_FLAG = 0x01
+};
+
+static std::string uuidString(const v8& bytes) {
+	static const char hex[] = "0123456789ABCDEF";
+
+	std::string ret;
+	ret.reserve(36);
+	for (size_t i = 0; i < bytes.size(); ++i) {
+		if (i == 4 || i == 6 || i == 8 || i == 10)
+			ret.push_back('-');
+		ret.push_back(hex[bytes[i] >> 4]);
+		ret.push_back(hex[bytes[i] & 0x0F]);
+	}
+
+	return ret;
+}
+
+// Returns the 16 bytes of id if it is a UUID in the canonical (upper case)
+// form, which Flex sends as bytes. Returns an empty vector otherwise.
+static v8 uuidBytes(const std::string& id) {
+	if (id.size() != 36)
+		return v8();
+
+	v8 ret;
+	ret.reserve(16);
+	for (size_t i = 0; i < id.size(); ) {
+		if (i == 8 || i == 13 || i == 18 || i == 23) {
+			if (id[i++] != '-')
+				return v8();
+			continue;
+		}
+
+		u8 byte = 0;
+		for (size_t j = i; j < i + 2; ++j) {
+			char c = id[j];
+			if (c >= '0' && c <= '9')
+				byte = byte << 4 | (c - '0');
+			else if (c >= 'A' && c <= 'F')
+				byte = byte << 4 | (c - 'A' + 10);
+			else
+				return v8();
+		}
+
+		ret.push_back(byte);
+		i += 2;
+	}
+
+	return ret;
+}
+
+static std::vector<u8> readFlags(v8::const_iterator& it, v8::const_iterator end) {
+	std::vector<u8> flags;
+	do {
+		if (it == end)
+			throw std::out_of_range("Not enough bytes for Flex message flags");
+		flags.push_back(*it++);
+	} while (flags.back() & HAS_NEXT_FLAG);
+
+	return flags;
+}
+
+// Skips the values of flags from bit reserved on, which were added by newer
+// versions of the protocol.
+static void skipFlagged(u8 flags, int reserved, v8::const_iterator& it, v8::const_iterator end,
+	SerializationContext& ctx) {
+	for (int bit = reserved; bit < 7; ++bit) {
+		if ((flags >> bit) & 0x01)
+			Deserializer::deserialize(it, end, ctx);
+	}
+}
+
+static std::string readUuid(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	AmfItemPtr item = Deserializer::deserialize(it, end, ctx);
+	const AmfByteArray* bytes = item.asPtr<AmfByteArray>();
+	if (bytes == nullptr || bytes->value.size() != 16)
+		throw std::invalid_argument("Flex message: Invalid UUID");
+
+	return uuidString(bytes->value);
+}
+
+static void append(v8& buf, const v8& data) {
+	buf.insert(buf.end(), data.begin(), data.end());
+}
+
+static void writeNullableString(v8& buf, const std::string& value, SerializationContext& ctx) {
+	if (value.empty())
+		buf.push_back(AMF_NULL);
+	else
+		AmfCodegen::writeString(buf, value, ctx);
+}
+
+static bool isNull(const AmfItemPtr& value) {
+	return value.get() == nullptr || value.asPtr<AmfNull>() != nullptr ||
+		value.asPtr<AmfUndefined>() != nullptr;
+}
+
+static std::string stringValue(const AmfItemPtr& value) {
+	if (isNull(value))
+		return std::string();
+
+	const AmfString* str = value.asPtr<AmfString>();
+	if (str == nullptr)
+		throw std::invalid_argument("Flex message: Expected a string");
+
+	return str->value;
+}
+
+static double numberValue(const AmfItemPtr& value) {
+	if (isNull(value))
+		return 0;
+
+	if (const AmfInteger* i = value.asPtr<AmfInteger>())
+		return i->value;
+
+	const AmfDouble* d = value.asPtr<AmfDouble>();
+	if (d == nullptr)
+		throw std::invalid_argument("Flex message: Expected a number");
+
+	return d->value;
+}
+
+static AmfItemPtr itemValue(const AmfItemPtr& value) {
+	return isNull(value) ? AmfItemPtr() : value;
+}
+
+static AmfItemPtr stringItem(const std::string& value) {
+	return value.empty() ? AmfItemPtr(AmfNull()) : AmfItemPtr(AmfString(value));
+}
+
+static AmfItemPtr itemOrNull(const AmfItemPtr& value) {
+	return value.get() == nullptr ? AmfItemPtr(AmfNull()) : value;
+}
+
+// Writes the object header of the small form of a message, i.e. its
+// externalizable traits.
+static void writeExternalHeader(v8& buf, const std::string& smallName, SerializationContext& ctx) {
+	buf.push_back(AMF_OBJECT);
+
+	AmfObjectTraits traits(smallName, false, true);
+	const TraitsPlan* plan = ctx.getPlan(traits);
+	if (plan != nullptr) {
+		// U29O-traits-ref
+		append(buf, plan->reference);
+		return;
+	}
+	ctx.addTraits(traits);
+
+	// U29O-traits-ext = 0b0111
+	buf.push_back(0x07);
+	append(buf, AmfString(smallName).serializeValue(ctx));
+}
+
+template<typename T>
+static v8 serializeSmall(const T& msg, SerializationContext& ctx) {
+	v8 buf = AmfCodegen::writeReference(msg, ctx);
+	if (!buf.empty())
+		return buf;
+
+	writeExternalHeader(buf, T::smallName, ctx);
+	msg.writeExternal(buf, ctx);
+	return buf;
+}
+
+// Reads a message of type T in its small or its regular form.
+template<typename T>
+static AmfItemPtr deserializeMessage(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	if (it == end || *it++ != AMF_OBJECT)
+		throw std::invalid_argument("Flex message: Invalid type marker");
+
+	int type = AmfInteger::deserializeValue(it, end);
+	if ((type & 0x01) == 0x00) {
+		// 0b...0 == U29O-ref
+		return ctx.getPointer<T>(type >> 1);
+	}
+
+	size_t traitsIndex;
+	if ((type & 0x03) == 0x01) {
+		// 0b..01 == U29O-traits-ref
+		traitsIndex = type >> 2;
+	} else {
+		AmfObjectTraits traits("", false, false);
+		if ((type & 0x07) == 0x07) {
+			// 0b.111 == U29O-traits-ext
+			traits.externalizable = true;
+			traits.className = AmfString::deserializeValue(it, end, ctx);
+		} else {
+			// 0b.011 == U29O-traits
+			traits.dynamic = ((type & 0x08) == 0x08);
+			traits.className = AmfString::deserializeValue(it, end, ctx);
+			int numSealed = type >> 4;
+			for (int i = 0; i < numSealed; ++i)
+				traits.attributes.push_back(AmfString::deserializeValue(it, end, ctx));
+		}
+
+		ctx.addTraits(traits);
+		traitsIndex = ctx.getIndex(traits);
+	}
+
+	// Unlike the context's traits table, plans stay valid while the values
+	// below are read.
+	std::shared_ptr<const AmfObjectTraits> traits = ctx.getPlan(traitsIndex).traits;
+
+	T* ret = new T();
+	AmfItemPtr ptr(ret);
+	ctx.addPointer(ptr);
+
+	if (traits->externalizable && !T::smallName.empty() && traits->className == T::smallName) {
+		ret->readExternal(it, end, ctx);
+	} else if (!traits->externalizable && traits->className == T::className) {
+		for (const std::string& name : traits->attributes)
+			ret->setProperty(name, Deserializer::deserialize(it, end, ctx));
+
+		if (traits->dynamic)
+			AmfCodegen::skipDynamicMembers(it, end, ctx);
+	} else {
+		throw std::invalid_argument("Flex message: Unexpected class " + traits->className);
+	}
+
+	return ptr;
+}
+
+// Reads the small form of T into a generic object.
+template<typename T>
+static void readGeneric(AmfObject& obj, v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	T msg;
+	msg.readExternal(it, end, ctx);
+	msg.toProperties(obj.sealedProperties);
+
+	obj.externalizer = [](const AmfObject* o, SerializationContext& ctx) {
+		T msg;
+		for (const auto& property : o->sealedProperties)
+			msg.setProperty(property.first, property.second);
+
+		v8 buf;
+		msg.writeExternal(buf, ctx);
+		return buf;
+	};
+}
+
+size_t AbstractMessage::hashValue(int, AmfHashState&) const {
+	return std::hash<std::string>()(messageId);
+}
+
+void AbstractMessage::children(std::vector<const AmfItemPtr*>& out) const {
+	out.push_back(&body);
+	out.push_back(&headers);
+}
+
+void AbstractMessage::clearChildren() {
+	body.reset();
+	headers.reset();
+}
+
+bool AbstractMessage::equalFields(const AbstractMessage& other) const {
+	return AmfCodegen::equal(body, other.body) &&
+		clientId == other.clientId &&
+		destination == other.destination &&
+		AmfCodegen::equal(headers, other.headers) &&
+		messageId == other.messageId &&
+		timestamp == other.timestamp &&
+		timeToLive == other.timeToLive;
+}
+
+void AbstractMessage::setProperty(const std::string& name, const AmfItemPtr& value) {
+	if (name == "body")
+		body = itemValue(value);
+	else if (name == "clientId")
+		clientId = stringValue(value);
+	else if (name == "destination")
+		destination = stringValue(value);
+	else if (name == "headers")
+		headers = itemValue(value);
+	else if (name == "messageId")
+		messageId = stringValue(value);
+	else if (name == "timestamp")
+		timestamp = numberValue(value);
+	else if (name == "timeToLive")
+		timeToLive = numberValue(value);
+}
+
+void AbstractMessage::toProperties(std::map<std::string, AmfItemPtr>& properties) const {
+	properties["body"] = itemOrNull(body);
+	properties["clientId"] = stringItem(clientId);
+	properties["destination"] = stringItem(destination);
+	properties["headers"] = itemOrNull(headers);
+	properties["messageId"] = stringItem(messageId);
+	properties["timestamp"] = AmfItemPtr(AmfDouble(timestamp));
+	properties["timeToLive"] = AmfItemPtr(AmfDouble(timeToLive));
+}
+
+void AbstractMessage::readExternal(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	std::vector<u8> flags = readFlags(it, end);
+	for (size_t i = 0; i < flags.size(); ++i) {
+		u8 f = flags[i];
+		int reserved = 0;
+
+		if (i == 0) {
+			body = (f & BODY_FLAG) ? AmfCodegen::readItem(it, end, ctx) : AmfItemPtr();
+			if (f & CLIENT_ID_FLAG)
+				clientId = AmfCodegen::readString(it, end, ctx);
+			if (f & DESTINATION_FLAG)
+				destination = AmfCodegen::readString(it, end, ctx);
+			if (f & HEADERS_FLAG)
+				headers = AmfCodegen::readItem(it, end, ctx);
+			if (f & MESSAGE_ID_FLAG)
+				messageId = AmfCodegen::readString(it, end, ctx);
+			if (f & TIMESTAMP_FLAG)
+				timestamp = AmfCodegen::readDouble(it, end, ctx);
+			if (f & TIME_TO_LIVE_FLAG)
+				timeToLive = AmfCodegen::readDouble(it, end, ctx);
+			reserved = 7;
+		} else if (i == 1) {
+			if (f & CLIENT_ID_BYTES_FLAG)
+				clientId = readUuid(it, end, ctx);
+			if (f & MESSAGE_ID_BYTES_FLAG)
+				messageId = readUuid(it, end, ctx);
+			reserved = 2;
+		}
+
+		skipFlagged(f, reserved, it, end, ctx);
+	}
+}
+
+void AbstractMessage::writeExternal(v8& buf, SerializationContext& ctx) const {
+	v8 clientIdBytes = uuidBytes(clientId);
+	v8 messageIdBytes = uuidBytes(messageId);
+
+	u8 flags = 0;
+	if (body.get() != nullptr) flags |= BODY_FLAG;
+	if (!clientId.empty() && clientIdBytes.empty()) flags |= CLIENT_ID_FLAG;
+	if (!destination.empty()) flags |= DESTINATION_FLAG;
+	if (headers.get() != nullptr) flags |= HEADERS_FLAG;
+	if (!messageId.empty() && messageIdBytes.empty()) flags |= MESSAGE_ID_FLAG;
+	if (timestamp != 0) flags |= TIMESTAMP_FLAG;
+	if (timeToLive != 0) flags |= TIME_TO_LIVE_FLAG;
+
+	u8 byteFlags = 0;
+	if (!clientIdBytes.empty()) byteFlags |= CLIENT_ID_BYTES_FLAG;
+	if (!messageIdBytes.empty()) byteFlags |= MESSAGE_ID_BYTES_FLAG;
+
+	if (byteFlags != 0) {
+		buf.push_back(flags | HAS_NEXT_FLAG);
+		buf.push_back(byteFlags);
+	} else {
+		buf.push_back(flags);
+	}
+
+	if (flags & BODY_FLAG) AmfCodegen::writeItem(buf, body, ctx);
+	if (flags & CLIENT_ID_FLAG) AmfCodegen::writeString(buf, clientId, ctx);
+	if (flags & DESTINATION_FLAG) AmfCodegen::writeString(buf, destination, ctx);
+	if (flags & HEADERS_FLAG) AmfCodegen::writeItem(buf, headers, ctx);
+	if (flags & MESSAGE_ID_FLAG) AmfCodegen::writeString(buf, messageId, ctx);
+	if (flags & TIMESTAMP_FLAG) AmfCodegen::writeDouble(buf, timestamp, ctx);
+	if (flags & TIME_TO_LIVE_FLAG) AmfCodegen::writeDouble(buf, timeToLive, ctx);
+
+	if (byteFlags & CLIENT_ID_BYTES_FLAG) append(buf, AmfByteArray(std::move(clientIdBytes)).serialize(ctx));
+	if (byteFlags & MESSAGE_ID_BYTES_FLAG) append(buf, AmfByteArray(std::move(messageIdBytes)).serialize(ctx));
+}
+
+void AbstractMessage::registerCodecs(ExternalDeserializerRegistry& registry) {
+	registry.addReader(AsyncMessage::smallName, readGeneric<AsyncMessage>);
+	registry.addReader(AcknowledgeMessage::smallName, readGeneric<AcknowledgeMessage>);
+	registry.addReader(CommandMessage::smallName, readGeneric<CommandMessage>);
+}
+
+bool AsyncMessage::operator==(const AmfItem& other) const {
+	const AsyncMessage* p = dynamic_cast<const AsyncMessage*>(&other);
+	return p != nullptr && typeid(*this) == typeid(*p) && equalFields(*p) &&
+		correlationId == p->correlationId;
+}
+
+v8 AsyncMessage::serialize(SerializationContext& ctx) const {
+	return serializeSmall(*this, ctx);
+}
+
+AmfItemPtr AsyncMessage::deserializePtr(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	return deserializeMessage<AsyncMessage>(it, end, ctx);
+}
+
+AsyncMessage AsyncMessage::deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	return deserializePtr(it, end, ctx).as<AsyncMessage>();
+}
+
+void AsyncMessage::setProperty(const std::string& name, const AmfItemPtr& value) {
+	if (name == "correlationId")
+		correlationId = stringValue(value);
+	else
+		AbstractMessage::setProperty(name, value);
+}
+
+void AsyncMessage::toProperties(std::map<std::string, AmfItemPtr>& properties) const {
+	AbstractMessage::toProperties(properties);
+	properties["correlationId"] = stringItem(correlationId);
+}
+
+void AsyncMessage::readExternal(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	AbstractMessage::readExternal(it, end, ctx);
+
+	std::vector<u8> flags = readFlags(it, end);
+	for (size_t i = 0; i < flags.size(); ++i) {
+		u8 f = flags[i];
+		int reserved = 0;
+
+		if (i == 0) {
+			if (f & CORRELATION_ID_FLAG)
+				correlationId = AmfCodegen::readString(it, end, ctx);
+			if (f & CORRELATION_ID_BYTES_FLAG)
+				correlationId = readUuid(it, end, ctx);
+			reserved = 2;
+		}
+
+		skipFlagged(f, reserved, it, end, ctx);
+	}
+}
+
+void AsyncMessage::writeExternal(v8& buf, SerializationContext& ctx) const {
+	AbstractMessage::writeExternal(buf, ctx);
+
+	v8 correlationIdBytes = uuidBytes(correlationId);
+	if (!correlationIdBytes.empty()) {
+		buf.push_back(CORRELATION_ID_BYTES_FLAG);
+		append(buf, AmfByteArray(std::move(correlationIdBytes)).serialize(ctx));
+	} else if (!correlationId.empty()) {
+		buf.push_back(CORRELATION_ID_FLAG);
+		AmfCodegen::writeString(buf, correlationId, ctx);
+	} else {
+		buf.push_back(0x00);
+	}
+}
+
+bool AcknowledgeMessage::operator==(const AmfItem& other) const {
+	return AsyncMessage::operator==(other);
+}
+
+v8 AcknowledgeMessage::serialize(SerializationContext& ctx) const {
+	return serializeSmall(*this, ctx);
+}
+
+AmfItemPtr AcknowledgeMessage::deserializePtr(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	return deserializeMessage<AcknowledgeMessage>(it, end, ctx);
+}
+
+AcknowledgeMessage AcknowledgeMessage::deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	return deserializePtr(it, end, ctx).as<AcknowledgeMessage>();
+}
+
+void AcknowledgeMessage::readExternal(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	AsyncMessage::readExternal(it, end, ctx);
+
+	// No fields of its own yet.
+	for (u8 f : readFlags(it, end))
+		skipFlagged(f, 0, it, end, ctx);
+}
+
+void AcknowledgeMessage::writeExternal(v8& buf, SerializationContext& ctx) const {
+	AsyncMessage::writeExternal(buf, ctx);
+	buf.push_back(0x00);
+}
+
+bool CommandMessage::operator==(const AmfItem& other) const {
+	const CommandMessage* p = dynamic_cast<const CommandMessage*>(&other);
+	return p != nullptr && AsyncMessage::operator==(other) && operation == p->operation;
+}
+
+v8 CommandMessage::serialize(SerializationContext& ctx) const {
+	return serializeSmall(*this, ctx);
+}
+
+AmfItemPtr CommandMessage::deserializePtr(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	return deserializeMessage<CommandMessage>(it, end, ctx);
+}
+
+CommandMessage CommandMessage::deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	return deserializePtr(it, end, ctx).as<CommandMessage>();
+}
+
+void CommandMessage::setProperty(const std::string& name, const AmfItemPtr& value) {
+	if (name == "operation")
+		operation = static_cast<int>(numberValue(value));
+	else
+		AsyncMessage::setProperty(name, value);
+}
+
+void CommandMessage::toProperties(std::map<std::string, AmfItemPtr>& properties) const {
+	AsyncMessage::toProperties(properties);
+	properties["operation"] = AmfItemPtr(AmfInteger(operation));
+}
+
+void CommandMessage::readExternal(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	AsyncMessage::readExternal(it, end, ctx);
+
+	std::vector<u8> flags = readFlags(it, end);
+	for (size_t i = 0; i < flags.size(); ++i) {
+		u8 f = flags[i];
+		int reserved = 0;
+
+		if (i == 0) {
+			if (f & OPERATION_FLAG)
+				operation = AmfCodegen::readInt(it, end, ctx);
+			reserved = 1;
+		}
+
+		skipFlagged(f, reserved, it, end, ctx);
+	}
+}
+
+void CommandMessage::writeExternal(v8& buf, SerializationContext& ctx) const {
+	AsyncMessage::writeExternal(buf, ctx);
+
+	// A missing operation is read as 0.
+	if (operation != 0) {
+		buf.push_back(OPERATION_FLAG);
+		AmfCodegen::writeInt(buf, operation, ctx);
+	} else {
+		buf.push_back(0x00);
+	}
+}
+
+bool RemotingMessage::operator==(const AmfItem& other) const {
+	const RemotingMessage* p = dynamic_cast<const RemotingMessage*>(&other);
+	return p != nullptr && equalFields(*p) && source == p->source && operation == p->operation;
+}
+
+v8 RemotingMessage::serialize(SerializationContext& ctx) const {
+	static const AmfObjectTraits traits = [] {
+		AmfObjectTraits t(className, false, false);
+		for (const char* name : { "body", "clientId", "destination", "headers", "messageId",
+			"operation", "source", "timeToLive", "timestamp" })
+			t.attributes.push_back(name);
+		return t;
+	}();
+
+	v8 buf = AmfCodegen::writeReference(*this, ctx);
+	if (!buf.empty())
+		return buf;
+
+	AmfCodegen::writeHeader(buf, traits, ctx);
+	AmfCodegen::writeItem(buf, body, ctx);
+	writeNullableString(buf, clientId, ctx);
+	writeNullableString(buf, destination, ctx);
+	AmfCodegen::writeItem(buf, headers, ctx);
+	writeNullableString(buf, messageId, ctx);
+	writeNullableString(buf, operation, ctx);
+	writeNullableString(buf, source, ctx);
+	AmfCodegen::writeDouble(buf, timeToLive, ctx);
+	AmfCodegen::writeDouble(buf, timestamp, ctx);
+
+	return buf;
+}
+
+AmfItemPtr RemotingMessage::deserializePtr(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	return deserializeMessage<RemotingMessage>(it, end, ctx);
+}
+
+RemotingMessage RemotingMessage::deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	return deserializePtr(it, end, ctx).as<RemotingMessage>();
+}
+
+void RemotingMessage::setProperty(const std::string& name, const AmfItemPtr& value) {
+	if (name == "source")
+		source = stringValue(value);
+	else if (name == "operation")
+		operation = stringValue(value);
+	else
+		AbstractMessage::setProperty(name, value);
+}
+
+void RemotingMessage::toProperties(std::map<std::string, AmfItemPtr>& properties) const {
+	AbstractMessage::toProperties(properties);
+	properties["source"] = stringItem(source);
+	properties["operation"] = stringItem(operation);
+}
+
+} // namespace amf
@@ -0,0 +1,132 @@
+#pragma once
+#ifndef AMFFLEXMESSAGES_HPP
+#define AMFFLEXMESSAGES_HPP
+
+#include <map>
+#include <string>
+
+#include "amf.hpp"
+#include "types/amfitem.hpp"
+#include "utils/amfitemptr.hpp"
+
+namespace amf {
+
+class ExternalDeserializerRegistry;
+
+// Typed versions of the Flex messaging classes (flex.messaging.messages.*).
+//
+// AsyncMessage, AcknowledgeMessage and CommandMessage are serialized in their
+// small form, i.e. as the externalizable classes DSA, DSK and DSC, which
+// encode the set fields as flag bytes and send ids that are UUIDs as 16 byte
+// ByteArrays. When deserializing, both the small form and the regular form
+// (a sealed object of the full class name) are accepted. RemotingMessage has
+// no small form.
+//
+// Empty strings stand for null strings, and ids are converted between
+// their UUID string and byte representations as needed.
+class AbstractMessage : public AmfItem {
+public:
+	AbstractMessage() : timestamp(0), timeToLive(0) { }
+
+	size_t hashValue(int depth, AmfHashState& state) const;
+	void children(std::vector<const AmfItemPtr*>& out) const;
+	void clearChildren();
+
+	// Converts from and to the sealed properties of a generic AmfObject of
+	// the same class. Unknown properties are ignored.
+	virtual void setProperty(const std::string& name, const AmfItemPtr& value);
+	virtual void toProperties(std::map<std::string, AmfItemPtr>& properties) const;
+
+	// Reads and writes the externalized data of the small form.
+	virtual void readExternal(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
+	virtual void writeExternal(v8& buf, SerializationContext& ctx) const;
+
+	// Adds readers for DSA, DSK and DSC, which deserialize them into generic
+	// externalizable AmfObjects with the message fields as sealed properties.
+	static void registerCodecs(ExternalDeserializerRegistry& registry);
+
+	AmfItemPtr body;
+	std::string clientId;
+	std::string destination;
+	AmfItemPtr headers;
+	std::string messageId;
+	// Milliseconds since the epoch
+	double timestamp;
+	double timeToLive;
+
+protected:
+	bool equalFields(const AbstractMessage& other) const;
+};
+
+class AsyncMessage : public AbstractMessage {
+public:
+	static const std::string className;
+	static const std::string smallName;
+
+	bool operator==(const AmfItem& other) const;
+	v8 serialize(SerializationContext& ctx) const;
+	static AmfItemPtr deserializePtr(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
+	static AsyncMessage deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
+
+	void setProperty(const std::string& name, const AmfItemPtr& value);
+	void toProperties(std::map<std::string, AmfItemPtr>& properties) const;
+	void readExternal(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
+	void writeExternal(v8& buf, SerializationContext& ctx) const;
+
+	std::string correlationId;
+};
+
+class AcknowledgeMessage : public AsyncMessage {
+public:
+	static const std::string className;
+	static const std::string smallName;
+
+	bool operator==(const AmfItem& other) const;
+	v8 serialize(SerializationContext& ctx) const;
+	static AmfItemPtr deserializePtr(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
+	static AcknowledgeMessage deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
+
+	void readExternal(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
+	void writeExternal(v8& buf, SerializationContext& ctx) const;
+};
+
+class CommandMessage : public AsyncMessage {
+public:
+	CommandMessage() : operation(0) { }
+
+	static const std::string className;
+	static const std::string smallName;
+
+	bool operator==(const AmfItem& other) const;
+	v8 serialize(SerializationContext& ctx) const;
+	static AmfItemPtr deserializePtr(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
+	static CommandMessage deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
+
+	void setProperty(const std::string& name, const AmfItemPtr& value);
+	void toProperties(std::map<std::string, AmfItemPtr>& properties) const;
+	void readExternal(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
+	void writeExternal(v8& buf, SerializationContext& ctx) const;
+
+	int operation;
+};
+
+class RemotingMessage : public AbstractMessage {
+public:
+	static const std::string className;
+	static const std::string smallName;
+
+	bool operator==(const AmfItem& other) const;
+	v8 serialize(SerializationContext& ctx) const;
+	static AmfItemPtr deserializePtr(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
+	static RemotingMessage deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
+
+	void setProperty(const std::string& name, const AmfItemPtr& value);
+	void toProperties(std::map<std::string, AmfItemPtr>& properties) const;
+
+	std::string source;
+	std::string operation;
+};
+
+} // namespace amf
+
+#endif
@@ -0,0 +1,126 @@
+#include "amfflvfile.hpp"
+
+#include "types/amfstring.hpp"
+#include "utils/amf0deserializer.hpp"
+
+namespace amf {
+
+// FLV header: "FLV" U8 version U8 flags U32 header size
+static const size_t flvHeaderSize = 9;
+// U8 type U24 data size U24 timestamp U8 extended timestamp U24 stream id
+static const size_t tagHeaderSize = 11;
+static const u8 scriptTagType = 18;
+static const u8 encryptedTagFlag = 0x20;
+
+static uint32_t readU24(const u8* data) {
+	return static_cast<uint32_t>(data[0]) << 16 | static_cast<uint32_t>(data[1]) << 8 | data[2];
+}
+
+static uint32_t readU32(const u8* data) {
+	return static_cast<uint32_t>(data[0]) << 24 | readU24(data + 1);
+}
+
+// Checks the file header and returns the offset of the first tag.
+static size_t firstTag(const u8* data, size_t size) {
+	if (size < flvHeaderSize)
+		throw std::out_of_range("Not enough bytes for AmfFlvFile");
+
+	if (data[0] != 'F' || data[1] != 'L' || data[2] != 'V')
+		throw std::invalid_argument("AmfFlvFile: Invalid signature");
+
+	uint32_t headerSize = readU32(data + 5);
+	// Every tag is preceded by the size of the previous one, which is 0 for
+	// the first tag.
+	if (headerSize < flvHeaderSize || headerSize > size || size - headerSize < 4)
+		throw std::out_of_range("Not enough bytes for AmfFlvFile");
+
+	return headerSize + 4;
+}
+
+static AmfFlvScriptTag readScriptTag(const u8* tag, size_t offset) {
+	AmfFlvScriptTag ret;
+	ret.offset = offset;
+	ret.timestamp = static_cast<uint32_t>(tag[7]) << 24 | readU24(tag + 4);
+
+	// Only the script tags are copied into a buffer for the decoders.
+	const u8* body = tag + tagHeaderSize;
+	v8 data(body, body + readU24(tag + 1));
+	auto it = data.cbegin();
+
+	// Script tags contain an AMF0 string with the name of the event followed
+	// by its value.
+	Amf0Deserializer deserializer;
+	AmfItemPtr name = deserializer.deserialize(it, data.cend());
+	const AmfString* str = dynamic_cast<const AmfString*>(name.get());
+	if (str == nullptr)
+		throw std::invalid_argument("AmfFlvFile: Script tag doesn't start with a name");
+
+	ret.name = str->value;
+	if (it != data.cend())
+		ret.value = deserializer.deserialize(it, data.cend());
+
+	return ret;
+}
+
+AmfFlvFile::AmfFlvFile(const std::string& path) : file(path) {
+	firstTag(file.data(), file.size());
+}
+
+bool AmfFlvFile::hasAudio() const {
+	return (file.data()[4] & 0x04) != 0;
+}
+
+bool AmfFlvFile::hasVideo() const {
+	return (file.data()[4] & 0x01) != 0;
+}
+
+void AmfFlvFile::scan(Callback callback) const {
+	scan(file.data(), file.size(), callback);
+}
+
+std::vector<AmfFlvScriptTag> AmfFlvFile::scriptTags() const {
+	std::vector<AmfFlvScriptTag> ret;
+	scan([&](const AmfFlvScriptTag& tag) {
+		ret.push_back(tag);
+		return true;
+	});
+
+	return ret;
+}
+
+AmfItemPtr AmfFlvFile::metaData() const {
+	AmfItemPtr ret;
+	scan([&](const AmfFlvScriptTag& tag) {
+		if (tag.name != "onMetaData")
+			return true;
+
+		ret = tag.value;
+		return false;
+	});
+
+	return ret;
+}
+
+void AmfFlvFile::scan(const u8* data, size_t size, Callback callback) {
+	// Tags are followed by their size, which has to match the data size in
+	// their header. A tag that is cut off ends the scan, as the file is
+	// probably still being written.
+	for (size_t offset = firstTag(data, size); size - offset >= tagHeaderSize; ) {
+		const u8* tag = data + offset;
+		size_t tagSize = tagHeaderSize + readU24(tag + 1);
+		if (size - offset < tagSize + 4)
+			break;
+
+		if (readU32(tag + tagSize) != tagSize)
+			throw std::invalid_argument("AmfFlvFile: Tag size mismatch");
+
+		if ((tag[0] & 0x1F) == scriptTagType && (tag[0] & encryptedTagFlag) == 0) {
+			if (!callback(readScriptTag(tag, offset)))
+				break;
+		}
+
+		offset += tagSize + 4;
+	}
+}
+
+} // namespace amf
@@ -0,0 +1,56 @@
+#pragma once
+#ifndef AMFFLVFILE_HPP
+#define AMFFLVFILE_HPP
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "amf.hpp"
+#include "utils/amfitemptr.hpp"
+#include "utils/amfmappedfile.hpp"
+
+namespace amf {
+
+struct AmfFlvScriptTag {
+	// Position of the tag header in the file.
+	uint64_t offset;
+	// In milliseconds
+	uint32_t timestamp;
+	// e.g. "onMetaData" or "onCuePoint"
+	std::string name;
+	// Null if the tag only contains a name.
+	AmfItemPtr value;
+};
+
+// Reads the script data tags of an FLV file. The file is mapped into memory
+// and only the tag headers and the contents of script tags are accessed;
+// audio and video data is skipped.
+class AmfFlvFile {
+public:
+	explicit AmfFlvFile(const std::string& path);
+
+	bool hasAudio() const;
+	bool hasVideo() const;
+
+	// Calls callback for each script tag, in file order, until it returns
+	// false.
+	typedef std::function<bool(const AmfFlvScriptTag& tag)> Callback;
+	void scan(Callback callback) const;
+
+	std::vector<AmfFlvScriptTag> scriptTags() const;
+
+	// Returns the value of the first onMetaData tag, or a null pointer if
+	// there is none.
+	AmfItemPtr metaData() const;
+
+	// Same as scan, for an FLV file that is already in memory.
+	static void scan(const u8* data, size_t size, Callback callback);
+
+private:
+	AmfMappedFile file;
+};
+
+} // namespace amf
+
+#endif
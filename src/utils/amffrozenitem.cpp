@@ -0,0 +1,94 @@
+#include "amffrozenitem.hpp"
+
+#include "serializationcontext.hpp"
+#include "types/amfundefined.hpp"
+#include "utils/amfhashstate.hpp"
+
+namespace amf {
+
+bool AmfFrozenItem::operator==(const AmfItem& other) const {
+	const AmfFrozenItem* p = dynamic_cast<const AmfFrozenItem*>(&other);
+	if (p != nullptr)
+		return ptr == p->ptr;
+
+	return *ptr == other;
+}
+
+size_t AmfFrozenItem::hashValue(int depth, AmfHashState& state) const {
+	if (depth < 0 || static_cast<size_t>(depth) >= hashes.size())
+		return ptr->hashValue(depth, state);
+
+	return hashes[depth];
+}
+
+void AmfFrozenItem::freeze() {
+	AmfHashState state;
+	for (int depth = 0; depth <= HASH_DEPTH; ++depth)
+		hashes.push_back(ptr->hashValue(depth, state));
+
+	SerializationContext ctx;
+	data = ptr->serialize(ctx);
+
+	for (size_t i = 0; i < ctx.stringCount(); ++i)
+		strings.push_back(ctx.getString(i));
+
+	for (size_t i = 0; i < ctx.traitsCount(); ++i)
+		traits.push_back(ctx.getTraits(i));
+
+	// These are the context's own copies, taken while serializing, so they can
+	// be shared with every target context.
+	for (size_t i = 0; i < ctx.objectCount(); ++i)
+		objects.push_back(ctx.getPointer<AmfItem>(i));
+
+	// Any reference in the data would change if the reference tables already
+	// contained an entry. Entries that happen to be equal to something in the
+	// item only cause a false negative.
+	SerializationContext shifted;
+	shifted.addString(std::string(1, '\0'));
+	shifted.addTraits(AmfObjectTraits("", false, true));
+	shifted.addPointer(AmfItemPtr(new AmfUndefined()));
+	isRelocatable = (ptr->serialize(shifted) == data);
+}
+
+bool AmfFrozenItem::canReuse(const SerializationContext& ctx) const {
+	if (ctx.stringCount() == 0 && ctx.traitsCount() == 0 && ctx.objectCount() == 0)
+		return true;
+
+	if (!isRelocatable)
+		return false;
+
+	for (const std::string& str : strings) {
+		if (ctx.getIndex(str) != -1)
+			return false;
+	}
+
+	for (const AmfObjectTraits& trait : traits) {
+		if (ctx.getIndex(trait) != -1)
+			return false;
+	}
+
+	for (const AmfItemPtr& obj : objects) {
+		if (ctx.hasObject(*obj))
+			return false;
+	}
+
+	return true;
+}
+
+std::vector<u8> AmfFrozenItem::serialize(SerializationContext& ctx) const {
+	if (!canReuse(ctx))
+		return ptr->serialize(ctx);
+
+	for (const std::string& str : strings)
+		ctx.addString(str);
+
+	for (const AmfObjectTraits& trait : traits)
+		ctx.addTraits(trait);
+
+	for (const AmfItemPtr& obj : objects)
+		ctx.addPointer(obj);
+
+	return data;
+}
+
+} // namespace amf
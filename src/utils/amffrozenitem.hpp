@@ -0,0 +1,78 @@
+#pragma once
+#ifndef AMFFROZENITEM_HPP
+#define AMFFROZENITEM_HPP
+
+#include <string>
+#include <vector>
+
+#include "types/amfitem.hpp"
+#include "utils/amfitemptr.hpp"
+#include "utils/amfobjecttraits.hpp"
+
+namespace amf {
+
+class SerializationContext;
+
+// Wraps an item that won't change anymore and caches its serialized form, so
+// that items which are sent over and over (e.g. large configuration objects)
+// don't have to be encoded again every time.
+//
+// The cached data is encoded against an empty context, along with the
+// strings, traits and objects it adds to the reference tables. It is reused
+// as is, followed by adding those entries to the target context, if either
+// - the target context is empty, or
+// - the data contains no references at all (i.e. the item doesn't use the
+//   same string, traits or object twice), and none of the added entries is
+//   already known to the target context.
+// Otherwise, the wrapped item is serialized normally, so the output is always
+// identical to serializing the item itself.
+//
+// The wrapped item must not be modified after wrapping it.
+class AmfFrozenItem : public AmfItem {
+public:
+	template<typename T, typename std::enable_if<std::is_base_of<AmfItem, T>::value, int>::type = 0>
+	explicit AmfFrozenItem(const T& item) : ptr(item) {
+		freeze();
+	}
+
+	explicit AmfFrozenItem(AmfItemPtr item) : ptr(item) {
+		freeze();
+	}
+
+	// Compares equal to both other frozen items and plain items that compare
+	// equal to the wrapped item.
+	bool operator==(const AmfItem& other) const;
+	std::vector<u8> serialize(SerializationContext& ctx) const;
+
+	// Hashes are computed once when freezing the item.
+	size_t hashValue(int depth, AmfHashState& state) const;
+
+	const AmfItem& item() const {
+		return *ptr;
+	}
+
+	// Whether the cached data can be reused in non-empty contexts.
+	bool relocatable() const {
+		return isRelocatable;
+	}
+
+private:
+	void freeze();
+	bool canReuse(const SerializationContext& ctx) const;
+
+	AmfItemPtr ptr;
+
+	std::vector<u8> data;
+	bool isRelocatable;
+	// Indexed by depth.
+	std::vector<size_t> hashes;
+
+	// Reference table entries added while serializing the item.
+	std::vector<std::string> strings;
+	std::vector<AmfObjectTraits> traits;
+	std::vector<AmfItemPtr> objects;
+};
+
+} // namespace amf
+
+#endif
@@ -0,0 +1,129 @@
+#include "amfgraph.hpp"
+
+#include <limits>
+#include <unordered_map>
+
+#include "deserializer.hpp"
+
+namespace amf {
+
+AmfGraph& AmfGraph::operator=(AmfGraph&& other) {
+	if (this != &other) {
+		reset();
+		ptr = std::move(other.ptr);
+	}
+
+	return *this;
+}
+
+AmfGraph AmfGraph::deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	return AmfGraph(Deserializer::deserialize(it, end, ctx));
+}
+
+size_t AmfGraph::reset() {
+	if (ptr.get() == nullptr)
+		return 0;
+
+	std::vector<AmfItemPtr> owned;
+	owned.push_back(std::move(ptr));
+	ptr.reset();
+
+	return releaseCycles(owned);
+}
+
+namespace {
+
+struct Node {
+	explicit Node(const AmfItemPtr* ptr) : ptr(ptr), refs(ptr->use_count()), reachable(false) {
+		// Pointers that don't own the item (see AmfItemPtr::unowned) are
+		// always treated as being referenced from outside.
+		if (refs == 0)
+			refs = std::numeric_limits<long>::max();
+	}
+
+	// Any of the pointers to the item.
+	const AmfItemPtr* ptr;
+	// References from outside of the graph.
+	long refs;
+	bool reachable;
+	std::vector<const AmfItemPtr*> children;
+};
+
+} // namespace
+
+size_t AmfGraph::releaseCycles(const std::vector<AmfItemPtr>& owned) {
+	std::unordered_map<const AmfItem*, Node> nodes;
+	std::vector<Node*> stack;
+	std::vector<const AmfItemPtr*> children;
+
+	// Subtract all references within the graph (including the ones held by
+	// owned) from the reference counts. Items without children can't be part
+	// of a cycle and are skipped.
+	auto visit = [&](const AmfItemPtr& ptr) {
+		auto found = nodes.find(ptr.get());
+		if (found == nodes.end()) {
+			children.clear();
+			ptr->children(children);
+			if (children.empty())
+				return;
+
+			found = nodes.emplace(ptr.get(), Node(&ptr)).first;
+			found->second.children.swap(children);
+			stack.push_back(&found->second);
+		}
+
+		--found->second.refs;
+	};
+
+	for (const AmfItemPtr& ptr : owned) {
+		if (ptr.get() != nullptr)
+			visit(ptr);
+	}
+
+	while (!stack.empty()) {
+		Node* node = stack.back();
+		stack.pop_back();
+
+		for (const AmfItemPtr* child : node->children) {
+			if (child->get() != nullptr)
+				visit(*child);
+		}
+	}
+
+	// Everything reachable from items that are referenced from outside of the
+	// graph has to stay intact.
+	for (auto& it : nodes) {
+		if (it.second.refs > 0 && !it.second.reachable) {
+			it.second.reachable = true;
+			stack.push_back(&it.second);
+		}
+	}
+
+	while (!stack.empty()) {
+		Node* node = stack.back();
+		stack.pop_back();
+
+		for (const AmfItemPtr* child : node->children) {
+			auto next = nodes.find(child->get());
+			if (next != nodes.end() && !next->second.reachable) {
+				next->second.reachable = true;
+				stack.push_back(&next->second);
+			}
+		}
+	}
+
+	// Keep the unreachable items alive until all of them have been cleared,
+	// as clearing one may free others.
+	std::vector<AmfItemPtr> garbage;
+	for (const auto& it : nodes) {
+		if (!it.second.reachable)
+			garbage.push_back(*it.second.ptr);
+	}
+
+	for (AmfItemPtr& it : garbage)
+		it->clearChildren();
+
+	return garbage.size();
+}
+
+} // namespace amf
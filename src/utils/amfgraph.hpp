@@ -0,0 +1,57 @@
+#pragma once
+#ifndef AMFGRAPH_HPP
+#define AMFGRAPH_HPP
+
+#include <vector>
+
+#include "amf.hpp"
+#include "utils/amfitemptr.hpp"
+
+namespace amf {
+
+class SerializationContext;
+
+// Owns a graph of items through its root, and frees the graph when it is
+// destroyed, even if it contains reference cycles (e.g. an array containing
+// itself), which would otherwise keep the items alive forever.
+//
+// Only items that are not referenced from outside of the graph anymore are
+// freed, so items that are still in use (e.g. by a SerializationContext that
+// is still alive) stay intact. References held by types other than the ones
+// in src/types (e.g. generated value objects) are considered to be outside of
+// the graph.
+class AmfGraph {
+public:
+	AmfGraph() { }
+	explicit AmfGraph(AmfItemPtr root) : ptr(root) { }
+	~AmfGraph() { reset(); }
+
+	AmfGraph(AmfGraph&& other) : ptr(std::move(other.ptr)) { }
+	AmfGraph& operator=(AmfGraph&& other);
+
+	AmfGraph(const AmfGraph&) = delete;
+	AmfGraph& operator=(const AmfGraph&) = delete;
+
+	static AmfGraph deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
+
+	const AmfItemPtr& root() const {
+		return ptr;
+	}
+
+	// Drops the root, freeing the graph. Returns the number of items whose
+	// references to other items had to be dropped to do so.
+	size_t reset();
+
+	// Breaks all reference cycles among the items reachable from owned that
+	// are only referenced by owned itself and by each other. Returns the
+	// number of items whose references were dropped. The items themselves are
+	// freed once owned releases them.
+	static size_t releaseCycles(const std::vector<AmfItemPtr>& owned);
+
+private:
+	AmfItemPtr ptr;
+};
+
+} // namespace amf
+
+#endif
@@ -0,0 +1,26 @@
+#include "amfhashstate.hpp"
+
+namespace amf {
+
+size_t AmfItem::hash() const {
+	AmfHashState state;
+	return hashValue(HASH_DEPTH, state);
+}
+
+size_t AmfHashState::hash(const AmfItemPtr& item, int depth) {
+	// Items that are only owned by a single pointer (i.e. their parent) can't
+	// be reached through any other path.
+	if (item.use_count() <= 1)
+		return item->hashValue(depth, *this);
+
+	auto key = std::make_pair(item.get(), depth);
+	auto it = memo.find(key);
+	if (it != memo.end())
+		return it->second;
+
+	size_t value = item->hashValue(depth, *this);
+	memo.emplace(key, value);
+	return value;
+}
+
+} // namespace amf
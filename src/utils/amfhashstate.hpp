@@ -0,0 +1,27 @@
+#pragma once
+#ifndef AMFHASHSTATE_HPP
+#define AMFHASHSTATE_HPP
+
+#include <map>
+#include <utility>
+
+#include "types/amfitem.hpp"
+#include "utils/amfitemptr.hpp"
+
+namespace amf {
+
+// State of a single AmfItem::hash() call. Remembers the hashes of items that
+// are referenced from more than one place, so that shared (and
+// self-referential) items are only hashed once per depth, which keeps hashing
+// linear in the size of the graph.
+class AmfHashState {
+public:
+	size_t hash(const AmfItemPtr& item, int depth);
+
+private:
+	std::map<std::pair<const AmfItem*, int>, size_t> memo;
+};
+
+} // namespace amf
+
+#endif
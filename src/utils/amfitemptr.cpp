@@ -0,0 +1,81 @@
+#include "amfitemptr.hpp"
+
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace amf {
+
+namespace {
+
+typedef std::pair<const AmfItem*, const AmfItem*> ItemPair;
+
+// State of the outermost comparison of shared items on this thread.
+struct EqualityState {
+	// Pairs that are currently being compared are assumed to be equal, which
+	// is what makes comparing cycles terminate.
+	std::map<ItemPair, bool> results;
+	// Pairs recorded as equal, in order, so that results derived from an
+	// assumption that turned out to be wrong can be dropped again.
+	std::vector<ItemPair> equal;
+};
+
+thread_local EqualityState* current = nullptr;
+
+class StateGuard {
+public:
+	StateGuard() : outermost(current == nullptr) {
+		if (outermost)
+			current = &state;
+	}
+
+	~StateGuard() {
+		if (outermost)
+			current = nullptr;
+	}
+
+private:
+	bool outermost;
+	EqualityState state;
+};
+
+} // namespace
+
+bool AmfItemPtr::operator==(const AmfItemPtr& other) const {
+	if (get() == other.get())
+		return true;
+
+	if (get() == nullptr || other.get() == nullptr)
+		return false;
+
+	// A pair can only be reached again if both items are shared.
+	if (use_count() <= 1 || other.use_count() <= 1)
+		return *get() == *other.get();
+
+	StateGuard guard;
+	EqualityState& state = *current;
+
+	ItemPair key(get(), other.get());
+	auto it = state.results.find(key);
+	if (it != state.results.end())
+		return it->second;
+
+	size_t mark = state.equal.size();
+	state.results.emplace(key, true);
+	state.equal.push_back(key);
+
+	bool result = (*get() == *other.get());
+	if (!result) {
+		// Items not being equal doesn't depend on any assumptions, but
+		// everything that was concluded while assuming key to be equal might.
+		for (size_t i = mark; i < state.equal.size(); ++i)
+			state.results.erase(state.equal[i]);
+		state.equal.resize(mark);
+
+		state.results.emplace(key, false);
+	}
+
+	return result;
+}
+
+} // namespace amf
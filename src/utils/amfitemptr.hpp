@@ -3,6 +3,8 @@
 #define AMFITEMPTR_HPP
 
 #include <memory>
+#include <type_traits>
+#include <utility>
 
 #include "types/amfitem.hpp"
 
@@ -13,8 +15,21 @@ public:
 	explicit AmfItemPtr() : std::shared_ptr<AmfItem>() { }
 	explicit AmfItemPtr(AmfItem* ptr) : std::shared_ptr<AmfItem>(ptr) { }
 
-	template<typename T, typename std::enable_if<std::is_base_of<AmfItem, T>::value, int>::type = 0>
-	explicit AmfItemPtr(const T& ref) : std::shared_ptr<AmfItem>(new T(ref)) { }
+	// Copies or moves ref into a new item.
+	template<typename T, typename std::enable_if<std::is_base_of<AmfItem,
+		typename std::decay<T>::type>::value, int>::type = 0>
+	explicit AmfItemPtr(T&& ref) :
+		std::shared_ptr<AmfItem>(new typename std::decay<T>::type(std::forward<T>(ref))) { }
+
+	// Returns a pointer to item that does not take ownership of it (and thus
+	// doesn't allocate), e.g. to look up item in containers keyed by
+	// AmfItemPtr. WARNING: the returned pointer must not outlive item.
+	static AmfItemPtr unowned(const AmfItem& item) {
+		AmfItemPtr ptr;
+		static_cast<std::shared_ptr<AmfItem>&>(ptr) =
+			std::shared_ptr<AmfItem>(std::shared_ptr<AmfItem>(), const_cast<AmfItem*>(&item));
+		return ptr;
+	}
 
 	template<typename T, typename std::enable_if<std::is_base_of<AmfItem, T>::value, int>::type = 0>
 	T& as() {
@@ -38,15 +53,18 @@ public:
 		return dynamic_cast<const T*>(get());
 	}
 
-	bool operator==(const AmfItemPtr& other) const {
-		return this->get() == other.get() || *this->get() == *other.get();
-	}
+	// Compares the pointed-to items. Nested items compare equal if the graphs
+	// reachable from them are structurally equal, so comparing
+	// self-referential items terminates, and items that are shared by several
+	// parents are only compared once.
+	bool operator==(const AmfItemPtr& other) const;
 
 	bool operator!=(const AmfItemPtr& other) const {
 		return !(*this == other);
 	}
 
 	using std::shared_ptr<AmfItem>::get;
+	using std::shared_ptr<AmfItem>::use_count;
 	using std::shared_ptr<AmfItem>::reset;
 	using std::shared_ptr<AmfItem>::operator*;
 	using std::shared_ptr<AmfItem>::operator->;
@@ -0,0 +1,970 @@
+#include "amfjson.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+
+#include "serializationcontext.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfitem.hpp"
+#include "utils/amfcolumns.hpp"
+#include "utils/amfflex.hpp"
+#include "utils/amfobjecttraits.hpp"
+
+namespace amf {
+
+static const size_t flushSize = 1 << 16;
+
+// U29 values used as lengths and reference indices are unsigned.
+static size_t readU29(v8::const_iterator& it, v8::const_iterator end) {
+	return AmfInteger::deserializeValue(it, end) & 0x1FFFFFFF;
+}
+
+template<typename T>
+static T readValue(v8::const_iterator& it, v8::const_iterator end) {
+	if (static_cast<size_t>(end - it) < sizeof(T))
+		throw std::out_of_range("Not enough bytes for AmfJson");
+
+	T val;
+	std::copy(it, it + sizeof(T), reinterpret_cast<u8 *>(&val));
+	it += sizeof(T);
+
+	return ntoh(val);
+}
+
+static void appendNumber(std::string& out, double value) {
+	if (std::isnan(value) || std::isinf(value)) {
+		out += "null";
+		return;
+	}
+
+	// Use the shortest of the two representations that reads back exactly.
+	char buf[32];
+	int length = std::snprintf(buf, sizeof(buf), "%.15g", value);
+	if (std::strtod(buf, nullptr) != value)
+		length = std::snprintf(buf, sizeof(buf), "%.17g", value);
+
+	out.append(buf, length);
+}
+
+static void appendString(std::string& out, const char* data, size_t size) {
+	static const char hex[] = "0123456789abcdef";
+
+	out.push_back('"');
+	const char* run = data;
+	for (const char* c = data; c != data + size; ++c) {
+		unsigned char ch = static_cast<unsigned char>(*c);
+		if (ch >= 0x20 && ch != '"' && ch != '\\')
+			continue;
+
+		out.append(run, c);
+		run = c + 1;
+
+		switch (ch) {
+			case '"': out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\b': out += "\\b"; break;
+			case '\f': out += "\\f"; break;
+			case '\n': out += "\\n"; break;
+			case '\r': out += "\\r"; break;
+			case '\t': out += "\\t"; break;
+			default:
+				out += "\\u00";
+				out.push_back(hex[ch >> 4]);
+				out.push_back(hex[ch & 0x0F]);
+		}
+	}
+	out.append(run, data + size);
+	out.push_back('"');
+}
+
+static void appendBase64(std::string& out, const u8* data, size_t size) {
+	static const char alphabet[] =
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	out.push_back('"');
+	size_t i = 0;
+	for (; i + 2 < size; i += 3) {
+		uint32_t bits = data[i] << 16 | data[i + 1] << 8 | data[i + 2];
+		out.push_back(alphabet[bits >> 18]);
+		out.push_back(alphabet[(bits >> 12) & 0x3F]);
+		out.push_back(alphabet[(bits >> 6) & 0x3F]);
+		out.push_back(alphabet[bits & 0x3F]);
+	}
+
+	if (i < size) {
+		uint32_t bits = data[i] << 16 | (i + 1 < size ? data[i + 1] << 8 : 0);
+		out.push_back(alphabet[bits >> 18]);
+		out.push_back(alphabet[(bits >> 12) & 0x3F]);
+		out.push_back(i + 1 < size ? alphabet[(bits >> 6) & 0x3F] : '=');
+		out.push_back('=');
+	}
+	out.push_back('"');
+}
+
+// Writes milliseconds since the epoch as e.g. "2014-05-13T16:53:20.000Z".
+static void appendDate(std::string& out, double millis) {
+	if (std::isnan(millis) || std::fabs(millis) > 8.64e15) {
+		// Outside of the range of ActionScript dates
+		out += "null";
+		return;
+	}
+
+	long long ms = static_cast<long long>(millis);
+	long long days = ms / 86400000;
+	long long rest = ms % 86400000;
+	if (rest < 0) {
+		rest += 86400000;
+		--days;
+	}
+
+	// Civil date from days since 1970-01-01, see
+	// http://howardhinnant.github.io/date_algorithms.html#civil_from_days
+	long long z = days + 719468;
+	long long era = (z >= 0 ? z : z - 146096) / 146097;
+	long long doe = z - era * 146097;
+	long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	long long mp = (5 * doy + 2) / 153;
+	long long day = doy - (153 * mp + 2) / 5 + 1;
+	long long month = mp < 10 ? mp + 3 : mp - 9;
+	long long year = yoe + era * 400 + (month <= 2 ? 1 : 0);
+
+	char buf[48];
+	int length = std::snprintf(buf, sizeof(buf), "\"%04lld-%02lld-%02lldT%02lld:%02lld:%02lld.%03lldZ\"",
+		year, month, day, rest / 3600000, rest / 60000 % 60, rest / 1000 % 60, rest % 1000);
+	out.append(buf, length);
+}
+
+namespace {
+
+struct JsonTraits {
+	AmfStringView className;
+	bool dynamic;
+	bool externalizable;
+	std::vector<AmfStringView> attributes;
+};
+
+// Writes JSON while reading the AMF3 value. The reference tables only hold
+// views of and positions in the input, and a reference to an object is
+// expanded by reading the object again. While doing so (replaying), nothing
+// is added to the tables, since all of their entries up to the end of the
+// object were added when it was first read.
+class JsonTranscoder {
+public:
+	JsonTranscoder(v8::const_iterator begin, v8::const_iterator end,
+		const AmfJson::Sink& sink, const AmfJson::Options& options) :
+		begin(begin), end(end), sink(sink), options(options), replaying(0), keys(0) { }
+
+	void value(v8::const_iterator& it);
+	void flush();
+
+	std::string out;
+
+private:
+	AmfStringView readString(v8::const_iterator& it);
+	size_t addObject(v8::const_iterator marker);
+	bool reference(size_t type);
+
+	void array(v8::const_iterator& it, v8::const_iterator marker, size_t type);
+	void object(v8::const_iterator& it, v8::const_iterator marker, size_t type);
+	void dictionary(v8::const_iterator& it, v8::const_iterator marker, size_t type);
+	template<typename T>
+	void vector(v8::const_iterator& it, v8::const_iterator marker, size_t type);
+	void objectVector(v8::const_iterator& it, v8::const_iterator marker, size_t type);
+
+	v8::const_iterator begin;
+	v8::const_iterator end;
+	const AmfJson::Sink& sink;
+	const AmfJson::Options& options;
+
+	std::vector<AmfStringView> strings;
+	// A deque keeps the traits in place while nested objects add theirs.
+	std::deque<JsonTraits> traits;
+	// Offset of the type marker of every object, in increasing order.
+	std::vector<size_t> objects;
+	// Whether the object is currently being written.
+	std::vector<bool> active;
+
+	int replaying;
+	// Number of dictionary keys being written. Keys are written to a
+	// temporary buffer, so out must not be flushed meanwhile.
+	int keys;
+};
+
+void JsonTranscoder::flush() {
+	if (!out.empty())
+		sink(out.data(), out.size());
+	out.clear();
+}
+
+AmfStringView JsonTranscoder::readString(v8::const_iterator& it) {
+	size_t type = readU29(it, end);
+	if ((type & 0x01) == 0)
+		return strings.at(type >> 1);
+
+	size_t length = type >> 1;
+	if (static_cast<size_t>(end - it) < length)
+		throw std::out_of_range("Not enough bytes for AmfString");
+
+	// Empty strings are never added to the string table.
+	if (length == 0)
+		return AmfStringView();
+
+	AmfStringView ret(reinterpret_cast<const char*>(&*it), length);
+	it += length;
+
+	if (replaying == 0)
+		strings.push_back(ret);
+
+	return ret;
+}
+
+size_t JsonTranscoder::addObject(v8::const_iterator marker) {
+	size_t offset = marker - begin;
+	if (replaying == 0) {
+		objects.push_back(offset);
+		active.push_back(false);
+		return objects.size() - 1;
+	}
+
+	return std::lower_bound(objects.begin(), objects.end(), offset) - objects.begin();
+}
+
+// Writes the object referenced by type if it is a reference and returns
+// whether it was.
+bool JsonTranscoder::reference(size_t type) {
+	if ((type & 0x01) != 0)
+		return false;
+
+	size_t index = type >> 1;
+	if (index >= objects.size())
+		throw std::out_of_range("AmfJson: Invalid object reference");
+
+	bool cycle = active[index];
+	if (cycle && options.cycles == AmfJson::CYCLE_THROW)
+		throw std::invalid_argument("AmfJson: Cyclic reference");
+
+	if (cycle && options.cycles == AmfJson::CYCLE_NULL) {
+		out += "null";
+	} else if (cycle || !options.expandReferences) {
+		out += "{\"$ref\":";
+		out += std::to_string(index);
+		out.push_back('}');
+	} else {
+		v8::const_iterator it = begin + objects[index];
+		++replaying;
+		value(it);
+		--replaying;
+	}
+
+	return true;
+}
+
+void JsonTranscoder::value(v8::const_iterator& it) {
+	if (it == end)
+		throw std::out_of_range("Not enough bytes for AmfJson");
+
+	v8::const_iterator marker = it;
+	switch (*it++) {
+		case AMF_UNDEFINED:
+		case AMF_NULL:
+			out += "null";
+			break;
+		case AMF_FALSE:
+			out += "false";
+			break;
+		case AMF_TRUE:
+			out += "true";
+			break;
+		case AMF_INTEGER:
+			out += std::to_string(AmfInteger::deserializeValue(it, end));
+			break;
+		case AMF_DOUBLE:
+			appendNumber(out, readValue<double>(it, end));
+			break;
+		case AMF_STRING: {
+			AmfStringView str = readString(it);
+			appendString(out, str.data, str.size);
+			break;
+		}
+		case AMF_XMLDOC:
+		case AMF_XML:
+		case AMF_BYTEARRAY: {
+			size_t type = readU29(it, end);
+			if (reference(type))
+				break;
+
+			size_t length = type >> 1;
+			if (static_cast<size_t>(end - it) < length)
+				throw std::out_of_range("Not enough bytes for AmfJson");
+
+			addObject(marker);
+			// it may be the end iterator if the value is empty.
+			const u8* data = length > 0 ? &*it : nullptr;
+			if (*marker == AMF_BYTEARRAY)
+				appendBase64(out, data, length);
+			else
+				appendString(out, reinterpret_cast<const char*>(data), length);
+			it += length;
+			break;
+		}
+		case AMF_DATE: {
+			size_t type = readU29(it, end);
+			if (reference(type))
+				break;
+
+			addObject(marker);
+			appendDate(out, readValue<double>(it, end));
+			break;
+		}
+		case AMF_ARRAY:
+			array(it, marker, readU29(it, end));
+			break;
+		case AMF_OBJECT:
+			object(it, marker, readU29(it, end));
+			break;
+		case AMF_VECTOR_INT:
+			vector<int32_t>(it, marker, readU29(it, end));
+			break;
+		case AMF_VECTOR_UINT:
+			vector<uint32_t>(it, marker, readU29(it, end));
+			break;
+		case AMF_VECTOR_DOUBLE:
+			vector<double>(it, marker, readU29(it, end));
+			break;
+		case AMF_VECTOR_OBJECT:
+			objectVector(it, marker, readU29(it, end));
+			break;
+		case AMF_DICTIONARY:
+			dictionary(it, marker, readU29(it, end));
+			break;
+		default:
+			throw std::invalid_argument("AmfJson: Invalid type marker");
+	}
+
+	if (out.size() >= flushSize && keys == 0)
+		flush();
+}
+
+void JsonTranscoder::array(v8::const_iterator& it, v8::const_iterator marker, size_t type) {
+	if (reference(type))
+		return;
+
+	size_t index = addObject(marker);
+	active[index] = true;
+
+	size_t length = type >> 1;
+	AmfStringView key = readString(it);
+	if (key.size == 0) {
+		out.push_back('[');
+		for (size_t i = 0; i < length; ++i) {
+			if (i > 0)
+				out.push_back(',');
+			value(it);
+		}
+		out.push_back(']');
+	} else {
+		// associative until UTF-8-empty, followed by the dense elements
+		out.push_back('{');
+		for (bool first = true; key.size != 0; key = readString(it), first = false) {
+			if (!first)
+				out.push_back(',');
+			appendString(out, key.data, key.size);
+			out.push_back(':');
+			value(it);
+		}
+
+		for (size_t i = 0; i < length; ++i) {
+			out += ",\"";
+			out += std::to_string(i);
+			out += "\":";
+			value(it);
+		}
+		out.push_back('}');
+	}
+
+	active[index] = false;
+}
+
+void JsonTranscoder::object(v8::const_iterator& it, v8::const_iterator marker, size_t type) {
+	if (reference(type))
+		return;
+
+	JsonTraits inlineTraits;
+	const JsonTraits* objectTraits = &inlineTraits;
+	if ((type & 0x03) == 0x01) {
+		// U29O-traits-ref
+		size_t traitsIndex = type >> 2;
+		if (traitsIndex >= traits.size())
+			throw std::out_of_range("AmfJson: Invalid traits reference");
+		objectTraits = &traits[traitsIndex];
+	} else {
+		// U29O-traits-ext or U29O-traits
+		inlineTraits.externalizable = ((type & 0x07) == 0x07);
+		inlineTraits.dynamic = !inlineTraits.externalizable && ((type & 0x08) == 0x08);
+		inlineTraits.className = readString(it);
+		if (!inlineTraits.externalizable) {
+			size_t numSealed = type >> 4;
+			for (size_t i = 0; i < numSealed; ++i)
+				inlineTraits.attributes.push_back(readString(it));
+		}
+
+		if (replaying == 0) {
+			traits.push_back(std::move(inlineTraits));
+			objectTraits = &traits.back();
+		}
+	}
+
+	size_t index = addObject(marker);
+	active[index] = true;
+
+	if (objectTraits->externalizable) {
+		// The Flex collections externalize the value they wrap.
+		std::string className = objectTraits->className.str();
+		if (className != AmfFlex::ArrayCollection && className != AmfFlex::ArrayList &&
+			className != AmfFlex::ObjectProxy)
+			throw std::invalid_argument("AmfJson: Can't convert externalizable class " + className);
+
+		value(it);
+	} else {
+		out.push_back('{');
+		bool first = true;
+		for (const AmfStringView& name : objectTraits->attributes) {
+			if (!first)
+				out.push_back(',');
+			first = false;
+
+			appendString(out, name.data, name.size);
+			out.push_back(':');
+			value(it);
+		}
+
+		if (objectTraits->dynamic) {
+			for (AmfStringView name = readString(it); name.size != 0; name = readString(it)) {
+				if (!first)
+					out.push_back(',');
+				first = false;
+
+				appendString(out, name.data, name.size);
+				out.push_back(':');
+				value(it);
+			}
+		}
+		out.push_back('}');
+	}
+
+	active[index] = false;
+}
+
+void JsonTranscoder::dictionary(v8::const_iterator& it, v8::const_iterator marker, size_t type) {
+	if (reference(type))
+		return;
+
+	// weak keys flag
+	if (it == end)
+		throw std::out_of_range("Not enough bytes for AmfJson");
+	++it;
+
+	size_t index = addObject(marker);
+	active[index] = true;
+
+	out.push_back('{');
+	size_t length = type >> 1;
+	for (size_t i = 0; i < length; ++i) {
+		if (i > 0)
+			out.push_back(',');
+
+		if (it != end && *it == AMF_STRING) {
+			++it;
+			AmfStringView key = readString(it);
+			appendString(out, key.data, key.size);
+		} else {
+			// Use the JSON of other keys as key.
+			std::string json;
+			std::swap(json, out);
+			++keys;
+			value(it);
+			--keys;
+			std::swap(json, out);
+			appendString(out, json.data(), json.size());
+		}
+
+		out.push_back(':');
+		value(it);
+	}
+	out.push_back('}');
+
+	active[index] = false;
+}
+
+template<typename T>
+void JsonTranscoder::vector(v8::const_iterator& it, v8::const_iterator marker, size_t type) {
+	if (reference(type))
+		return;
+
+	// fixed flag
+	if (it == end)
+		throw std::out_of_range("Not enough bytes for AmfJson");
+	++it;
+
+	size_t length = type >> 1;
+	if (static_cast<size_t>(end - it) / sizeof(T) < length)
+		throw std::out_of_range("Not enough bytes for AmfJson");
+
+	addObject(marker);
+
+	out.push_back('[');
+	for (size_t i = 0; i < length; ++i) {
+		if (i > 0)
+			out.push_back(',');
+		appendNumber(out, readValue<T>(it, end));
+	}
+	out.push_back(']');
+}
+
+void JsonTranscoder::objectVector(v8::const_iterator& it, v8::const_iterator marker, size_t type) {
+	if (reference(type))
+		return;
+
+	// fixed flag
+	if (it == end)
+		throw std::out_of_range("Not enough bytes for AmfJson");
+	++it;
+
+	size_t index = addObject(marker);
+	active[index] = true;
+
+	// The type name of the elements isn't needed.
+	readString(it);
+
+	out.push_back('[');
+	size_t length = type >> 1;
+	for (size_t i = 0; i < length; ++i) {
+		if (i > 0)
+			out.push_back(',');
+		value(it);
+	}
+	out.push_back(']');
+
+	active[index] = false;
+}
+
+// Appends U29 value, which has to fit into 29 bits.
+static void appendU29(v8& out, uint32_t value) {
+	if (value < 0x80) {
+		out.push_back(value);
+	} else if (value < 0x4000) {
+		out.push_back(value >> 7 | 0x80);
+		out.push_back(value & 0x7F);
+	} else if (value < 0x200000) {
+		out.push_back(value >> 14 | 0x80);
+		out.push_back((value >> 7 & 0x7F) | 0x80);
+		out.push_back(value & 0x7F);
+	} else {
+		out.push_back(value >> 22 | 0x80);
+		out.push_back((value >> 15 & 0x7F) | 0x80);
+		out.push_back((value >> 8 & 0x7F) | 0x80);
+		out.push_back(value & 0xFF);
+	}
+}
+
+// Appends a U29 value with the lowest bit set, as used for inline values.
+static void appendLength(v8& out, size_t length) {
+	// See AmfInteger::asLength
+	if (length >= (1 << 27))
+		throw std::invalid_argument("Length outside of valid range for AmfInteger.");
+
+	appendU29(out, static_cast<uint32_t>(length << 1 | 1));
+}
+
+// Reads JSON text and writes the AMF3 encoding of each value as soon as it
+// has been read. Only arrays, whose length precedes their elements, are
+// completed afterwards.
+class JsonEncoder {
+public:
+	JsonEncoder(const char* data, size_t size, v8& out, SerializationContext& ctx) :
+		pos(data), begin(data), end(data + size), out(out), ctx(ctx), traitsIndex(-1) { }
+
+	void value();
+	void finish();
+
+private:
+	[[noreturn]] void error(const char* message);
+	void skipWhitespace();
+	void expect(const char* literal);
+
+	// Reads a string into str. pos has to be at its opening quote.
+	void readString();
+	void string();
+	void number();
+	void array();
+	void object();
+
+	const char* pos;
+	const char* begin;
+	const char* end;
+	v8& out;
+	SerializationContext& ctx;
+
+	// Reused for all strings, to avoid reallocating it.
+	std::string str;
+	int traitsIndex;
+};
+
+void JsonEncoder::error(const char* message) {
+	throw std::invalid_argument(std::string("AmfJson: ") + message + " at offset " +
+		std::to_string(pos - begin));
+}
+
+void JsonEncoder::skipWhitespace() {
+	while (pos != end && (*pos == ' ' || *pos == '\n' || *pos == '\r' || *pos == '\t'))
+		++pos;
+}
+
+void JsonEncoder::expect(const char* literal) {
+	size_t length = std::strlen(literal);
+	if (static_cast<size_t>(end - pos) < length || std::memcmp(pos, literal, length) != 0)
+		error("Invalid literal");
+
+	pos += length;
+}
+
+void JsonEncoder::finish() {
+	skipWhitespace();
+	if (pos != end)
+		error("Trailing characters");
+}
+
+void JsonEncoder::value() {
+	skipWhitespace();
+	if (pos == end)
+		error("Unexpected end of input");
+
+	switch (*pos) {
+		case 'n':
+			expect("null");
+			out.push_back(AMF_NULL);
+			break;
+		case 't':
+			expect("true");
+			out.push_back(AMF_TRUE);
+			break;
+		case 'f':
+			expect("false");
+			out.push_back(AMF_FALSE);
+			break;
+		case '"':
+			out.push_back(AMF_STRING);
+			string();
+			break;
+		case '[':
+			array();
+			break;
+		case '{':
+			object();
+			break;
+		default:
+			number();
+	}
+}
+
+static int hexValue(char c) {
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+	return -1;
+}
+
+static void appendUtf8(std::string& out, uint32_t codePoint) {
+	if (codePoint < 0x80) {
+		out.push_back(codePoint);
+	} else if (codePoint < 0x800) {
+		out.push_back(0xC0 | codePoint >> 6);
+		out.push_back(0x80 | (codePoint & 0x3F));
+	} else if (codePoint < 0x10000) {
+		out.push_back(0xE0 | codePoint >> 12);
+		out.push_back(0x80 | (codePoint >> 6 & 0x3F));
+		out.push_back(0x80 | (codePoint & 0x3F));
+	} else {
+		out.push_back(0xF0 | codePoint >> 18);
+		out.push_back(0x80 | (codePoint >> 12 & 0x3F));
+		out.push_back(0x80 | (codePoint >> 6 & 0x3F));
+		out.push_back(0x80 | (codePoint & 0x3F));
+	}
+}
+
+void JsonEncoder::readString() {
+	str.clear();
+	++pos;
+
+	while (true) {
+		const char* run = pos;
+		while (pos != end && *pos != '"' && *pos != '\\' && static_cast<unsigned char>(*pos) >= 0x20)
+			++pos;
+		str.append(run, pos);
+
+		if (pos == end)
+			error("Unterminated string");
+		if (*pos == '"')
+			break;
+		if (*pos != '\\')
+			error("Control character in string");
+
+		if (++pos == end)
+			error("Unterminated string");
+
+		switch (*pos++) {
+			case '"': str.push_back('"'); break;
+			case '\\': str.push_back('\\'); break;
+			case '/': str.push_back('/'); break;
+			case 'b': str.push_back('\b'); break;
+			case 'f': str.push_back('\f'); break;
+			case 'n': str.push_back('\n'); break;
+			case 'r': str.push_back('\r'); break;
+			case 't': str.push_back('\t'); break;
+			case 'u': {
+				uint32_t codePoint = 0;
+				for (int i = 0; i < 4; ++i) {
+					int digit = pos != end ? hexValue(*pos++) : -1;
+					if (digit < 0)
+						error("Invalid unicode escape");
+					codePoint = codePoint << 4 | digit;
+				}
+
+				// Combine surrogate pairs, leave lone surrogates as they are.
+				if (codePoint >= 0xD800 && codePoint < 0xDC00 && end - pos >= 6 &&
+					pos[0] == '\\' && pos[1] == 'u') {
+					uint32_t low = 0;
+					for (int i = 2; i < 6; ++i) {
+						int digit = hexValue(pos[i]);
+						if (digit < 0)
+							error("Invalid unicode escape");
+						low = low << 4 | digit;
+					}
+
+					if (low >= 0xDC00 && low < 0xE000) {
+						codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+						pos += 6;
+					}
+				}
+
+				appendUtf8(str, codePoint);
+				break;
+			}
+			default:
+				--pos;
+				error("Invalid escape sequence");
+		}
+	}
+
+	++pos;
+}
+
+// Writes the string at pos as UTF-8-vr, i.e. without type marker.
+void JsonEncoder::string() {
+	readString();
+
+	// UTF-8-empty is never sent by reference.
+	if (str.empty()) {
+		out.push_back(0x01);
+		return;
+	}
+
+	int index = ctx.getIndex(str);
+	if (index != -1) {
+		appendU29(out, index << 1);
+		return;
+	}
+	ctx.addString(str);
+
+	appendLength(out, str.size());
+	out.insert(out.end(), str.begin(), str.end());
+}
+
+void JsonEncoder::number() {
+	// -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+	const char* start = pos;
+	if (pos != end && *pos == '-')
+		++pos;
+
+	auto digits = [&]() {
+		const char* first = pos;
+		while (pos != end && *pos >= '0' && *pos <= '9')
+			++pos;
+		if (pos == first)
+			error("Invalid number");
+	};
+
+	const char* intStart = pos;
+	digits();
+	if (*intStart == '0' && pos - intStart > 1)
+		error("Invalid number");
+	const char* intEnd = pos;
+
+	bool integral = true;
+	if (pos != end && *pos == '.') {
+		++pos;
+		digits();
+		integral = false;
+	}
+	if (pos != end && (*pos == 'e' || *pos == 'E')) {
+		++pos;
+		if (pos != end && (*pos == '+' || *pos == '-'))
+			++pos;
+		digits();
+		integral = false;
+	}
+
+	// At most 9 digits can't overflow, and all 29 bit integers have at most
+	// 9 digits. -0 has to be a double to keep its sign.
+	if (integral && intEnd - intStart <= 9 && (*start != '-' || *intStart != '0')) {
+		int value = 0;
+		for (const char* c = intStart; c != intEnd; ++c)
+			value = value * 10 + (*c - '0');
+		if (*start == '-')
+			value = -value;
+
+		if (value >= -(1 << 28) && value < (1 << 28)) {
+			out.push_back(AMF_INTEGER);
+			appendU29(out, value & 0x1FFFFFFF);
+			return;
+		}
+	}
+
+	// strtod needs a terminated string.
+	double value = std::strtod(std::string(start, pos).c_str(), nullptr);
+	v8 bytes = network_bytes<double>(value);
+	out.push_back(AMF_DOUBLE);
+	out.insert(out.end(), bytes.begin(), bytes.end());
+}
+
+void JsonEncoder::array() {
+	++pos;
+	out.push_back(AMF_ARRAY);
+	// The array is read before its elements.
+	ctx.addPointer(AmfItemPtr());
+
+	size_t start = out.size();
+	size_t length = 0;
+
+	skipWhitespace();
+	if (pos != end && *pos == ']') {
+		++pos;
+	} else {
+		while (true) {
+			value();
+			++length;
+
+			skipWhitespace();
+			if (pos != end && *pos == ',') {
+				++pos;
+			} else if (pos != end && *pos == ']') {
+				++pos;
+				break;
+			} else {
+				error("Expected ',' or ']'");
+			}
+		}
+	}
+
+	// U29A-value, followed by UTF-8-empty, as there are no associative
+	// elements.
+	v8 header;
+	appendLength(header, length);
+	header.push_back(0x01);
+	out.insert(out.begin() + start, header.begin(), header.end());
+}
+
+void JsonEncoder::object() {
+	++pos;
+	out.push_back(AMF_OBJECT);
+	ctx.addPointer(AmfItemPtr());
+
+	// All objects share the anonymous dynamic traits.
+	if (traitsIndex == -1) {
+		AmfObjectTraits traits("", true, false);
+		traitsIndex = ctx.getIndex(traits);
+		if (traitsIndex == -1) {
+			ctx.addTraits(traits);
+			// U29O-traits with no sealed members, dynamic, followed by the
+			// empty class name.
+			out.push_back(0x0b);
+			out.push_back(0x01);
+			traitsIndex = static_cast<int>(ctx.traitsCount() - 1);
+		} else {
+			appendU29(out, traitsIndex << 2 | 0x01);
+		}
+	} else {
+		// U29O-traits-ref
+		appendU29(out, traitsIndex << 2 | 0x01);
+	}
+
+	skipWhitespace();
+	if (pos != end && *pos == '}') {
+		++pos;
+	} else {
+		while (true) {
+			skipWhitespace();
+			if (pos == end || *pos != '"')
+				error("Expected a key");
+			if (pos + 1 != end && pos[1] == '"')
+				error("Empty keys can't be encoded");
+			string();
+
+			skipWhitespace();
+			if (pos == end || *pos != ':')
+				error("Expected ':'");
+			++pos;
+
+			value();
+
+			skipWhitespace();
+			if (pos != end && *pos == ',') {
+				++pos;
+			} else if (pos != end && *pos == '}') {
+				++pos;
+				break;
+			} else {
+				error("Expected ',' or '}'");
+			}
+		}
+	}
+
+	// UTF-8-empty ends the dynamic members.
+	out.push_back(0x01);
+}
+
+} // namespace
+
+void AmfJson::transcode(v8::const_iterator& it, v8::const_iterator end,
+	const Sink& sink, const Options& options) {
+	JsonTranscoder transcoder(it, end, sink, options);
+	transcoder.value(it);
+	transcoder.flush();
+}
+
+std::string AmfJson::toJson(v8::const_iterator& it, v8::const_iterator end, const Options& options) {
+	std::string ret;
+	transcode(it, end, [&ret](const char* data, size_t size) {
+		ret.append(data, size);
+	}, options);
+
+	return ret;
+}
+
+void AmfJson::fromJson(const char* data, size_t size, v8& out, SerializationContext& ctx) {
+	JsonEncoder encoder(data, size, out, ctx);
+	encoder.value();
+	encoder.finish();
+}
+
+v8 AmfJson::fromJson(const std::string& json, SerializationContext& ctx) {
+	v8 ret;
+	fromJson(json.data(), json.size(), ret, ctx);
+	return ret;
+}
+
+} // namespace amf
@@ -0,0 +1,77 @@
+#pragma once
+#ifndef AMFJSON_HPP
+#define AMFJSON_HPP
+
+#include <functional>
+#include <string>
+
+#include "amf.hpp"
+
+namespace amf {
+
+class SerializationContext;
+
+// Converts between AMF3 values and JSON text in a single pass over the
+// serialized bytes or the text, without building AmfItems first.
+//
+// AMF3 values are converted to JSON as follows:
+//   undefined, null         null
+//   integer, double         number (NaN and infinities as null)
+//   string, XML, XMLDocument string
+//   date                    string, ISO 8601 in UTC with milliseconds
+//   byte array              string, base64 encoded
+//   array                   array if it only has dense elements, otherwise
+//                           an object of the associative elements followed
+//                           by the dense ones with their index as key
+//   object, dictionary      object; dictionary keys that aren't strings are
+//                           converted to JSON and used as key
+//   vectors                 array
+// Externalizable objects other than the Flex collections handled by AmfFlex
+// can't be converted and throw std::invalid_argument.
+class AmfJson {
+public:
+	// How to write a reference to an object that is still being written,
+	// i.e. a cycle.
+	enum CyclePolicy {
+		CYCLE_THROW,
+		CYCLE_NULL,
+		// {"$ref":index}, where index is the position of the object in the
+		// AMF object reference table.
+		CYCLE_MARKER
+	};
+
+	struct Options {
+		Options() : expandReferences(true), cycles(CYCLE_THROW) { }
+
+		// Whether references to objects that were already written are written
+		// out again, or as {"$ref":index} like cycles with CYCLE_MARKER.
+		bool expandReferences;
+		CyclePolicy cycles;
+	};
+
+	// Receives the JSON text in pieces of about 64 KiB.
+	typedef std::function<void(const char* data, size_t size)> Sink;
+
+	// Converts the value at it, which has to be encoded with its own
+	// reference tables, and leaves it after its end.
+	static void transcode(v8::const_iterator& it, v8::const_iterator end,
+		const Sink& sink, const Options& options = Options());
+	static std::string toJson(v8::const_iterator& it, v8::const_iterator end,
+		const Options& options = Options());
+
+	// Encodes the JSON text at data as an AMF3 value and appends it to out.
+	// Objects become anonymous dynamic objects, numbers without fraction and
+	// exponent that fit into 29 bits integers and all other numbers doubles.
+	// Strings and the traits of the objects are taken from and added to the
+	// reference tables of ctx, while the objects and arrays only reserve
+	// their entries in the object table, so ctx can be used for further
+	// values of the same stream. Throws std::invalid_argument if the text
+	// isn't valid JSON or contains an object with an empty key, which AMF3
+	// can't encode.
+	static void fromJson(const char* data, size_t size, v8& out, SerializationContext& ctx);
+	static v8 fromJson(const std::string& json, SerializationContext& ctx);
+};
+
+} // namespace amf
+
+#endif
@@ -0,0 +1,207 @@
+#include "amflazyarray.hpp"
+
+#include <vector>
+
+#include "deserializer.hpp"
+#include "serializationcontext.hpp"
+#include "types/amfarray.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfstring.hpp"
+#include "types/amfvector.hpp"
+#include "utils/amfprojection.hpp"
+
+namespace amf {
+
+struct AmfLazyArray::State {
+	struct Element {
+		// Position of the element in data.
+		size_t offset;
+		// Whether the element is stored in the object table, at entry.
+		bool object;
+		size_t entry;
+	};
+
+	void complete();
+	const AmfItemPtr& item(size_t index);
+
+	SerializationContext* ctx;
+	// Object table entry of the array.
+	size_t index;
+	// The array without its dense elements until complete() is called.
+	AmfItemPtr array;
+
+	// The encoded array.
+	std::shared_ptr<const v8> data;
+	std::vector<Element> elements;
+	std::vector<AmfItemPtr> items;
+};
+
+void AmfLazyArray::State::complete() {
+	if (array.asPtr<AmfArray>() != nullptr) {
+		AmfArray& ret = array.as<AmfArray>();
+		ret.dense.reserve(elements.size());
+		for (size_t i = 0; i < elements.size(); ++i)
+			ret.dense.push_back(item(i));
+	} else {
+		AmfVector<AmfItem>& ret = array.as<AmfVector<AmfItem>>();
+		ret.values.reserve(elements.size());
+		for (size_t i = 0; i < elements.size(); ++i)
+			ret.values.push_back(item(i));
+	}
+}
+
+const AmfItemPtr& AmfLazyArray::State::item(size_t index) {
+	AmfItemPtr& ret = items.at(index);
+	if (ret.get() != nullptr)
+		return ret;
+
+	const Element& element = elements[index];
+	if (element.object) {
+		ret = ctx->getPointer<AmfItem>(element.entry);
+		return ret;
+	}
+
+	v8::const_iterator it = data->cbegin() + element.offset;
+	if (*it == AMF_STRING) {
+		// The string table already contains the string if it was sent inline.
+		++it;
+		int type = AmfInteger::deserializeValue(it, data->cend());
+		if ((type & 0x01) == 0) {
+			ret = AmfItemPtr(AmfString(ctx->getString(type >> 1)));
+		} else {
+			v8::const_iterator start = it;
+			ret = AmfItemPtr(AmfString(std::string(start, start + (type >> 1))));
+		}
+	} else {
+		// Everything else doesn't use the reference tables.
+		SerializationContext scalars;
+		ret = Deserializer::deserialize(it, data->cend(), scalars);
+	}
+
+	return ret;
+}
+
+size_t AmfLazyArray::size() const {
+	return state->items.size();
+}
+
+const AmfItemPtr& AmfLazyArray::item(size_t index) {
+	return state->item(index);
+}
+
+bool AmfLazyArray::isDecoded(size_t index) const {
+	return state->items.at(index).get() != nullptr;
+}
+
+const AmfItemPtr& AmfLazyArray::array() {
+	// Completes the array if it hasn't been referenced yet.
+	return state->ctx->getPointer<AmfItem>(state->index);
+}
+
+static bool isObjectMarker(u8 marker) {
+	return marker == AMF_XMLDOC || marker == AMF_DATE || marker == AMF_ARRAY ||
+		marker == AMF_OBJECT || marker == AMF_XML || marker == AMF_BYTEARRAY ||
+		(marker >= AMF_VECTOR_INT && marker <= AMF_DICTIONARY);
+}
+
+AmfLazyArray AmfLazyArray::deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	v8::const_iterator start = it;
+	if (it == end)
+		throw std::out_of_range("Not enough bytes for AmfLazyArray");
+
+	u8 marker = *it++;
+	if (marker != AMF_ARRAY && marker != AMF_VECTOR_OBJECT)
+		throw std::invalid_argument("AmfLazyArray: Invalid type marker");
+
+	AmfLazyArray ret;
+	ret.state = std::make_shared<State>();
+	State& state = *ret.state;
+	state.ctx = &ctx;
+
+	int type = AmfInteger::deserializeValue(it, end);
+	if ((type & 0x01) == 0) {
+		state.index = type >> 1;
+		state.array = ctx.getPointer<AmfItem>(state.index);
+		if (state.array.asPtr<AmfArray>() != nullptr)
+			state.items = state.array.as<AmfArray>().dense;
+		else if (state.array.asPtr<AmfVector<AmfItem>>() != nullptr)
+			state.items = state.array.as<AmfVector<AmfItem>>().values;
+		else
+			throw std::invalid_argument("AmfLazyArray: Reference to a different type");
+
+		state.elements.resize(state.items.size());
+		return ret;
+	}
+
+	state.index = ctx.objectCount();
+	ctx.addPointer(AmfItemPtr());
+
+	if (marker == AMF_ARRAY) {
+		state.array = AmfItemPtr(new AmfArray());
+
+		// associative until UTF-8-empty
+		AmfArray& array = state.array.as<AmfArray>();
+		while (true) {
+			std::string name = AmfString::deserializeValue(it, end, ctx);
+			if (name == "") break;
+
+			array.associative[name] = Deserializer::deserialize(it, end, ctx);
+		}
+	} else {
+		if (it == end)
+			throw std::out_of_range("Not enough bytes for AmfLazyArray");
+		bool fixed = (*it++ == 0x01);
+
+		std::string name = AmfString::deserializeValue(it, end, ctx);
+		state.array = AmfItemPtr(new AmfVector<AmfItem>(name, fixed));
+	}
+
+	size_t length = type >> 1;
+	state.elements.reserve(length);
+	std::vector<size_t> counts;
+	for (size_t i = 0; i < length; ++i) {
+		if (it == end)
+			throw std::out_of_range("Not enough bytes for AmfLazyArray");
+
+		State::Element element;
+		element.offset = it - start;
+		element.object = isObjectMarker(*it);
+		element.entry = ctx.objectCount();
+
+		if (element.object) {
+			v8::const_iterator value = it + 1;
+			int header = AmfInteger::deserializeValue(value, end);
+			if ((header & 0x01) == 0) {
+				element.entry = header >> 1;
+				if (element.entry >= ctx.objectCount())
+					throw std::out_of_range("AmfLazyArray: Invalid object reference");
+
+				it = value;
+				counts.push_back(0);
+				state.elements.push_back(element);
+				continue;
+			}
+		}
+
+		AmfProjection::skipValue(it, end, ctx);
+		counts.push_back(ctx.objectCount() - element.entry);
+		state.elements.push_back(element);
+	}
+
+	state.items.resize(length);
+	state.data = std::make_shared<const v8>(start, it);
+
+	for (size_t i = 0; i < length; ++i) {
+		if (counts[i] != 0)
+			ctx.addSkipped(state.elements[i].entry, counts[i], state.data, state.elements[i].offset);
+	}
+
+	std::shared_ptr<State> shared = ret.state;
+	ctx.addDeferred(state.index, state.array, [shared]() {
+		shared->complete();
+	});
+
+	return ret;
+}
+
+} // namespace amf
@@ -0,0 +1,56 @@
+#pragma once
+#ifndef AMFLAZYARRAY_HPP
+#define AMFLAZYARRAY_HPP
+
+#include <memory>
+
+#include "amf.hpp"
+#include "utils/amfitemptr.hpp"
+
+namespace amf {
+
+class SerializationContext;
+
+// The dense elements of an array or Vector.<Object> that are only decoded
+// when they are accessed. Deserializing it skips the elements on the wire,
+// recording where each of them starts, while adding their strings, traits
+// and objects to the reference tables as usual (see AmfProjection::skip).
+// The associative part of an array is decoded right away.
+//
+// Decoded elements are the same items later references to them in the
+// stream resolve to, and a later reference to the array itself resolves to
+// array(), which decodes all elements. Accessing elements requires the
+// context, so it has to outlive the AmfLazyArray and must not be cleared
+// while elements are still accessed. An associative element referring to
+// the array itself isn't supported and throws std::invalid_argument.
+class AmfLazyArray {
+public:
+	size_t size() const;
+
+	// Decodes the element at index on the first call. Throws
+	// std::out_of_range if there is no such element.
+	const AmfItemPtr& item(size_t index);
+
+	template<class T>
+	T& at(size_t index) {
+		return dynamic_cast<T&>(*item(index).get());
+	}
+
+	bool isDecoded(size_t index) const;
+
+	// The AmfArray or AmfVector<AmfItem>, with all elements decoded.
+	const AmfItemPtr& array();
+
+	// Throws std::invalid_argument if the value at it is neither an array
+	// nor a Vector.<Object>. A reference to one that was already decoded
+	// returns its elements.
+	static AmfLazyArray deserialize(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
+
+private:
+	struct State;
+	std::shared_ptr<State> state;
+};
+
+} // namespace amf
+
+#endif
@@ -0,0 +1,76 @@
+#include "amfmappedfile.hpp"
+
+#ifdef _WIN32
+	#include <fstream>
+	#include <iterator>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace amf {
+
+#ifdef _WIN32
+
+AmfMappedFile::AmfMappedFile(const std::string& path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		throw std::runtime_error("AmfMappedFile: Could not open " + path);
+
+	buf.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	ptr = buf.data();
+	length = buf.size();
+}
+
+AmfMappedFile::~AmfMappedFile() { }
+
+AmfMappedFile::AmfMappedFile(AmfMappedFile&& other) : buf(std::move(other.buf)) {
+	ptr = buf.data();
+	length = buf.size();
+	other.ptr = nullptr;
+	other.length = 0;
+}
+
+#else
+
+AmfMappedFile::AmfMappedFile(const std::string& path) : ptr(nullptr), length(0) {
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw std::runtime_error("AmfMappedFile: Could not open " + path);
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		throw std::runtime_error("AmfMappedFile: Could not stat " + path);
+	}
+
+	// Empty files can't be mapped.
+	if (st.st_size == 0) {
+		close(fd);
+		return;
+	}
+
+	void* mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapped == MAP_FAILED)
+		throw std::runtime_error("AmfMappedFile: Could not map " + path);
+
+	ptr = static_cast<const u8*>(mapped);
+	length = static_cast<size_t>(st.st_size);
+}
+
+AmfMappedFile::~AmfMappedFile() {
+	if (ptr != nullptr)
+		munmap(const_cast<u8*>(ptr), length);
+}
+
+AmfMappedFile::AmfMappedFile(AmfMappedFile&& other) : ptr(other.ptr), length(other.length) {
+	other.ptr = nullptr;
+	other.length = 0;
+}
+
+#endif
+
+} // namespace amf
@@ -0,0 +1,40 @@
+#pragma once
+#ifndef AMFMAPPEDFILE_HPP
+#define AMFMAPPEDFILE_HPP
+
+#include <string>
+
+#include "amf.hpp"
+
+namespace amf {
+
+// A read-only view of a file that is mapped into memory. On Windows, the file
+// is read into a buffer instead.
+class AmfMappedFile {
+public:
+	explicit AmfMappedFile(const std::string& path);
+	~AmfMappedFile();
+
+	AmfMappedFile(AmfMappedFile&& other);
+	AmfMappedFile(const AmfMappedFile&) = delete;
+	AmfMappedFile& operator=(const AmfMappedFile&) = delete;
+
+	const u8* data() const {
+		return ptr;
+	}
+
+	size_t size() const {
+		return length;
+	}
+
+private:
+	const u8* ptr;
+	size_t length;
+#ifdef _WIN32
+	v8 buf;
+#endif
+};
+
+} // namespace amf
+
+#endif
@@ -2,6 +2,7 @@
 #ifndef AMFOBJECTTRAITS_HPP
 #define AMFOBJECTTRAITS_HPP
 
+#include <functional>
 #include <set>
 #include <string>
 #include <vector>
@@ -56,6 +57,19 @@ public:
 
 };
 
+struct AmfObjectTraitsHash {
+	size_t operator()(const AmfObjectTraits& traits) const {
+		std::hash<std::string> hasher;
+		size_t seed = hasher(traits.className);
+		seed ^= (traits.dynamic ? 0x02 : 0x00) | (traits.externalizable ? 0x01 : 0x00);
+
+		for (const std::string& attribute : traits.attributes)
+			seed ^= hasher(attribute) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+
+		return seed;
+	}
+};
+
 } // namespace amf
 
 #endif
@@ -0,0 +1,499 @@
+#include "amfparallel.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <typeinfo>
+#include <vector>
+
+#include "deserializer.hpp"
+#include "serializationcontext.hpp"
+#include "types/amfarray.hpp"
+#include "types/amfbool.hpp"
+#include "types/amfdouble.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfnull.hpp"
+#include "types/amfobject.hpp"
+#include "types/amfstring.hpp"
+#include "types/amfundefined.hpp"
+#include "types/amfvector.hpp"
+#include "utils/amfprojection.hpp"
+#include "utils/amfsegments.hpp"
+
+namespace amf {
+
+namespace {
+
+// The sizes of the reference tables before a dense element.
+struct Boundary {
+	// Position of the element, relative to the array marker.
+	size_t offset;
+	size_t strings;
+	size_t traits;
+	size_t objects;
+	// Whether the element refers to objects outside of itself. These are
+	// decoded sequentially into the shared context.
+	bool dependent;
+};
+
+// The sizes of the reference tables and of the recorded lookups before an
+// element that is serialized.
+struct TableSizes {
+	size_t strings;
+	size_t traits;
+	size_t objects;
+	size_t stringLookups;
+	size_t objectLookups;
+};
+
+// Records the lookups of ctx for as long as it exists.
+class Recording {
+public:
+	Recording(SerializationContext& ctx, AmfLookups& lookups) : ctx(ctx) {
+		ctx.recordLookups(&lookups);
+	}
+
+	~Recording() {
+		ctx.recordLookups(nullptr);
+	}
+
+private:
+	SerializationContext& ctx;
+};
+
+} // namespace
+
+// Splits the elements into at most threads ranges of about the same weight.
+// positions holds the total weight before every element, followed by the
+// total weight. Returns the first element of every range, followed by the
+// number of elements.
+static std::vector<size_t> splitRanges(const std::vector<size_t>& positions, unsigned threads) {
+	size_t length = positions.size() - 1;
+	threads = static_cast<unsigned>(std::min<size_t>(threads, length));
+
+	std::vector<size_t> ranges { 0 };
+	for (unsigned n = 1; n < threads; ++n) {
+		size_t target = positions.front() + (positions.back() - positions.front()) * n / threads;
+		size_t i = std::lower_bound(positions.begin(), positions.end(), target) - positions.begin();
+		if (i > ranges.back() && i < length)
+			ranges.push_back(i);
+	}
+	ranges.push_back(length);
+
+	return ranges;
+}
+
+// Adds the strings and traits between from and to, and placeholders for the
+// objects in between, to local.
+static void fillTables(SerializationContext& local, const SerializationContext& ctx,
+	const Boundary& from, const Boundary& to) {
+	for (size_t i = from.strings; i < to.strings; ++i) {
+		const std::string& str = ctx.getString(i);
+		if (str.empty())
+			local.addChunkedString();
+		else
+			local.addString(str);
+	}
+
+	for (size_t i = from.traits; i < to.traits; ++i)
+		local.addTraits(ctx.getTraits(i));
+
+	for (size_t i = from.objects; i < to.objects; ++i)
+		local.addPointer(AmfItemPtr());
+}
+
+AmfItemPtr AmfParallel::deserialize(v8::const_iterator& it, v8::const_iterator end,
+	SerializationContext& ctx, unsigned threads) {
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+
+	// Projections and chunked values would have to be applied on every
+	// thread in the same way as sequentially, so they aren't supported.
+	bool chunked = ctx.isChunked(std::numeric_limits<size_t>::max());
+	if (threads == 1 || ctx.projection() || chunked || it == end ||
+		(*it != AMF_ARRAY && *it != AMF_VECTOR_OBJECT))
+		return Deserializer::deserialize(it, end, ctx);
+
+	v8::const_iterator start = it;
+	v8::const_iterator value = it + 1;
+	int type = AmfInteger::deserializeValue(value, end);
+	if ((type & 0x01) == 0)
+		return Deserializer::deserialize(it, end, ctx);
+
+	it = value;
+	AmfItemPtr ret;
+	if (*start == AMF_ARRAY) {
+		ret = AmfItemPtr(new AmfArray());
+		ctx.addPointer(ret);
+
+		// associative until UTF-8-empty
+		AmfArray& array = ret.as<AmfArray>();
+		while (true) {
+			std::string name = AmfString::deserializeValue(it, end, ctx);
+			if (name == "") break;
+
+			array.associative[name] = Deserializer::deserialize(it, end, ctx);
+		}
+	} else {
+		if (it == end)
+			throw std::out_of_range("Not enough bytes for AmfVector");
+		bool fixed = (*it++ == 0x01);
+
+		std::string name = AmfString::deserializeValue(it, end, ctx);
+		ret = AmfItemPtr(new AmfVector<AmfItem>(name, fixed));
+		ctx.addPointer(ret);
+	}
+
+	// Skip over the dense elements, adding their strings, traits and
+	// placeholders for their objects to ctx.
+	size_t length = type >> 1;
+	std::vector<Boundary> boundaries;
+	boundaries.reserve(length + 1);
+	for (size_t i = 0; ; ++i) {
+		Boundary boundary;
+		boundary.offset = it - start;
+		boundary.strings = ctx.stringCount();
+		boundary.traits = ctx.traitsCount();
+		boundary.objects = ctx.objectCount();
+		boundary.dependent = false;
+		boundaries.push_back(boundary);
+		if (i == length)
+			break;
+
+		size_t firstReference = std::numeric_limits<size_t>::max();
+		AmfProjection::skipValue(it, end, ctx, &firstReference);
+		boundaries[i].dependent = firstReference < boundary.objects;
+	}
+
+	// Split the elements into ranges of about the same encoded size.
+	std::vector<size_t> offsets;
+	offsets.reserve(length + 1);
+	for (const Boundary& boundary : boundaries)
+		offsets.push_back(boundary.offset);
+	std::vector<size_t> ranges = splitRanges(offsets, threads);
+
+	size_t numRanges = ranges.size() - 1;
+	std::vector<AmfItemPtr> items(length);
+	std::vector<SerializationContext> contexts(numRanges);
+
+	std::mutex errorMutex;
+	std::exception_ptr error;
+
+	// Only reads from ctx, which isn't modified until all threads are done.
+	auto work = [&](size_t range) {
+		try {
+			SerializationContext& local = contexts[range];
+			Boundary empty = { 0, 0, 0, 0, false };
+			fillTables(local, ctx, empty, boundaries[ranges[range]]);
+
+			for (size_t i = ranges[range]; i < ranges[range + 1]; ++i) {
+				const Boundary& boundary = boundaries[i];
+				const Boundary& next = boundaries[i + 1];
+				if (boundary.dependent) {
+					fillTables(local, ctx, boundary, next);
+					continue;
+				}
+
+				v8::const_iterator element = start + boundary.offset;
+				items[i] = Deserializer::deserialize(element, start + next.offset, local);
+			}
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(errorMutex);
+			if (!error)
+				error = std::current_exception();
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (size_t range = 1; range < numRanges; ++range)
+		workers.emplace_back(work, range);
+	// The calling thread handles the first range.
+	work(0);
+
+	for (std::thread& worker : workers)
+		worker.join();
+
+	if (error)
+		std::rethrow_exception(error);
+
+	// Move the objects of the decoded elements into ctx, and register the
+	// remaining ones to be decoded when they are referenced.
+	for (size_t range = 0; range < numRanges; ++range) {
+		for (size_t i = ranges[range]; i < ranges[range + 1]; ++i) {
+			const Boundary& boundary = boundaries[i];
+			size_t count = boundaries[i + 1].objects - boundary.objects;
+			if (count == 0)
+				continue;
+
+			if (!boundary.dependent) {
+				ctx.copyObjects(contexts[range], boundary.objects, count);
+			} else {
+				auto data = std::make_shared<const v8>(start + boundary.offset, start + boundaries[i + 1].offset);
+				ctx.addSkipped(boundary.objects, count, data, 0);
+			}
+		}
+	}
+	contexts.clear();
+
+	for (size_t i = 0; i < length; ++i) {
+		if (!boundaries[i].dependent)
+			continue;
+
+		if (boundaries[i + 1].objects > boundaries[i].objects) {
+			items[i] = ctx.getPointer<AmfItem>(boundaries[i].objects);
+		} else {
+			// A reference, which doesn't change the reference tables.
+			v8::const_iterator element = start + boundaries[i].offset;
+			items[i] = Deserializer::deserialize(element, start + boundaries[i + 1].offset, ctx);
+		}
+	}
+
+	if (*start == AMF_ARRAY)
+		ret.as<AmfArray>().dense = std::move(items);
+	else
+		ret.as<AmfVector<AmfItem>>().values = std::move(items);
+
+	return ret;
+}
+
+static void addString(const std::string& str, SerializationContext& ctx) {
+	// UTF-8-empty is never added.
+	if (!str.empty() && ctx.getIndex(str) == -1)
+		ctx.addString(str);
+}
+
+// Makes the same changes to the reference tables of ctx as serializing the
+// item at ptr, without encoding it. Mirrors the serializeInto implementations
+// of the types that are common in large arrays, and serializes everything
+// else.
+static void addReferences(const AmfItemPtr& ptr, SerializationContext& ctx) {
+	const AmfItem& item = *ptr;
+	const std::type_info& type = typeid(item);
+	if (type == typeid(AmfInteger) || type == typeid(AmfDouble) || type == typeid(AmfBool) ||
+		type == typeid(AmfNull) || type == typeid(AmfUndefined))
+		return;
+
+	if (type == typeid(AmfString)) {
+		addString(static_cast<const AmfString&>(item).value, ctx);
+		return;
+	}
+
+	if (type == typeid(AmfObject) && !static_cast<const AmfObject&>(item).objectTraits().externalizable) {
+		const AmfObject& obj = static_cast<const AmfObject&>(item);
+		const AmfObjectTraits& traits = obj.objectTraits();
+		if (ctx.getIndex(obj) != -1)
+			return;
+		ctx.addPointer(ptr);
+
+		const TraitsPlan* plan = ctx.getPlan(traits);
+		if (plan == nullptr) {
+			ctx.addTraits(traits);
+			plan = ctx.getPlan(traits);
+
+			addString(traits.className, ctx);
+			for (const std::string& attribute : plan->attributes)
+				addString(attribute, ctx);
+		}
+
+		auto prop = obj.sealedProperties.begin();
+		for (const std::string& attribute : plan->attributes) {
+			while (prop != obj.sealedProperties.end() && prop->first < attribute)
+				++prop;
+
+			if (prop == obj.sealedProperties.end() || prop->first != attribute)
+				throw std::out_of_range("AmfObject::serialize missing sealed property");
+
+			addReferences(prop->second, ctx);
+			++prop;
+		}
+
+		if (traits.dynamic) {
+			for (const auto& it : obj.dynamicProperties) {
+				addString(it.first, ctx);
+				addReferences(it.second, ctx);
+			}
+		}
+		return;
+	}
+
+	if (type == typeid(AmfArray)) {
+		const AmfArray& array = static_cast<const AmfArray&>(item);
+		if (ctx.getIndex(array) != -1)
+			return;
+		ctx.addPointer(ptr);
+
+		for (const auto& it : array.associative) {
+			addString(it.first, ctx);
+			addReferences(it.second, ctx);
+		}
+
+		for (const AmfItemPtr& it : array.dense)
+			addReferences(it, ctx);
+		return;
+	}
+
+	AmfSegments out = AmfSegments::contiguous();
+	item.serializeInto(ctx, out);
+}
+
+std::vector<v8> AmfParallel::serializeBuffers(const AmfItem& item, SerializationContext& ctx, unsigned threads) {
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+
+	const AmfArray* array = typeid(item) == typeid(AmfArray) ? static_cast<const AmfArray*>(&item) : nullptr;
+	const AmfVector<AmfItem>* vector = dynamic_cast<const AmfVector<AmfItem>*>(&item);
+	if (threads == 1 || (array == nullptr && vector == nullptr))
+		return std::vector<v8> { item.serialize(ctx) };
+
+	// The first buffer contains everything up to the dense elements, which
+	// is encoded the same way AmfArray and AmfVector<AmfItem> do.
+	AmfSegments head = AmfSegments::contiguous();
+	const std::vector<AmfItemPtr>* elements;
+	if (array != nullptr) {
+		if (ctx.getIndex(*array) != -1)
+			return std::vector<v8> { item.serialize(ctx) };
+		ctx.addObject(*array);
+
+		head.append(AmfInteger::asLength(array->dense.size(), AMF_ARRAY));
+		for (const auto& it : array->associative) {
+			head.append(AmfString(it.first).serializeValue(ctx));
+			it.second->serializeInto(ctx, head);
+		}
+		head.push_back(0x01);
+
+		elements = &array->dense;
+	} else {
+		if (ctx.getIndex(*vector) != -1)
+			return std::vector<v8> { item.serialize(ctx) };
+		ctx.addObject(*vector);
+
+		head.append(AmfInteger::asLength(vector->values.size(), AMF_VECTOR_OBJECT));
+		head.push_back(vector->fixed ? 0x01 : 0x00);
+		head.append(AmfString(vector->type).serializeValue(ctx));
+
+		elements = &vector->values;
+	}
+
+	// Add what the elements add to the reference tables, recording the
+	// entries they refer to.
+	size_t length = elements->size();
+	std::vector<TableSizes> sizes;
+	sizes.reserve(length + 1);
+	AmfLookups lookups;
+	{
+		Recording recording(ctx, lookups);
+		for (size_t i = 0; ; ++i) {
+			TableSizes current;
+			current.strings = ctx.stringCount();
+			current.traits = ctx.traitsCount();
+			current.objects = ctx.objectCount();
+			current.stringLookups = lookups.strings.size();
+			current.objectLookups = lookups.objects.size();
+			sizes.push_back(current);
+			if (i == length)
+				break;
+
+			addReferences((*elements)[i], ctx);
+		}
+	}
+
+	// Balance the ranges by the number of table entries each element adds
+	// or refers to.
+	std::vector<size_t> weights;
+	weights.reserve(length + 1);
+	for (size_t i = 0; i <= length; ++i) {
+		const TableSizes& current = sizes[i];
+		weights.push_back(i + current.strings + current.objects + current.stringLookups + current.objectLookups);
+	}
+	std::vector<size_t> ranges = splitRanges(weights, threads);
+
+	size_t numRanges = ranges.size() - 1;
+	std::vector<v8> ret(numRanges + 1);
+	ret[0] = head.release();
+
+	std::mutex errorMutex;
+	std::exception_ptr error;
+
+	// Only reads from ctx, which isn't modified until all threads are done.
+	auto work = [&](size_t range) {
+		try {
+			const TableSizes& first = sizes[ranges[range]];
+			const TableSizes& last = sizes[ranges[range + 1]];
+
+			// Only the entries before the range that it refers to are
+			// needed. The others are left empty, so that they never match.
+			std::vector<bool> strings(first.strings);
+			for (size_t i = first.stringLookups; i < last.stringLookups; ++i) {
+				if (lookups.strings[i] < first.strings)
+					strings[lookups.strings[i]] = true;
+			}
+
+			std::vector<bool> objects(first.objects);
+			for (size_t i = first.objectLookups; i < last.objectLookups; ++i) {
+				if (lookups.objects[i] < first.objects)
+					objects[lookups.objects[i]] = true;
+			}
+
+			SerializationContext local;
+			for (size_t i = 0; i < first.strings; ++i) {
+				if (strings[i])
+					local.addString(ctx.getString(i));
+				else
+					local.addChunkedString();
+			}
+
+			for (size_t i = 0; i < first.traits; ++i)
+				local.addTraits(ctx.getTraits(i));
+
+			for (size_t i = 0; i < first.objects; ++i)
+				local.addPointer(AmfItemPtr());
+			for (size_t i = 0; i < first.objects; ++i) {
+				if (objects[i])
+					local.copyObjects(ctx, i, 1);
+			}
+
+			AmfSegments out = AmfSegments::contiguous();
+			for (size_t i = ranges[range]; i < ranges[range + 1]; ++i)
+				(*elements)[i]->serializeInto(local, out);
+			ret[range + 1] = out.release();
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(errorMutex);
+			if (!error)
+				error = std::current_exception();
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (size_t range = 1; range < numRanges; ++range)
+		workers.emplace_back(work, range);
+	// The calling thread handles the first range.
+	work(0);
+
+	for (std::thread& worker : workers)
+		worker.join();
+
+	if (error)
+		std::rethrow_exception(error);
+
+	return ret;
+}
+
+v8 AmfParallel::serialize(const AmfItem& item, SerializationContext& ctx, unsigned threads) {
+	std::vector<v8> buffers = serializeBuffers(item, ctx, threads);
+	if (buffers.size() == 1)
+		return std::move(buffers[0]);
+
+	size_t size = 0;
+	for (const v8& buffer : buffers)
+		size += buffer.size();
+
+	v8 ret;
+	ret.reserve(size);
+	for (const v8& buffer : buffers)
+		ret.insert(ret.end(), buffer.begin(), buffer.end());
+
+	return ret;
+}
+
+} // namespace amf
@@ -0,0 +1,61 @@
+#pragma once
+#ifndef AMFPARALLEL_HPP
+#define AMFPARALLEL_HPP
+
+#include <vector>
+
+#include "amf.hpp"
+#include "utils/amfitemptr.hpp"
+
+namespace amf {
+
+class AmfItem;
+class SerializationContext;
+
+// Decodes or encodes a single large array or Vector.<Object> on multiple
+// threads.
+//
+// Decoding:
+//
+// A sequential pass first skips over the dense elements, recording where each
+// of them starts and how many strings, traits and objects the reference
+// tables contain at that point. The elements are then split into one range
+// per thread, and every thread decodes its range with its own context, whose
+// tables are filled up to the start of the range from the recorded state.
+// Elements referring to objects outside of themselves (e.g. to an earlier
+// element) are decoded sequentially afterwards, so that they share those
+// objects. The result and the state of ctx afterwards are the same as
+// after Deserializer::deserialize.
+//
+// Values containing externalizable objects other than the Flex collections
+// handled by AmfFlex, contexts with a projection or a chunk sink, and
+// anything that isn't a new array or Vector.<Object> are decoded
+// sequentially.
+//
+// Encoding:
+// A sequential pass adds everything the elements add to the reference tables
+// of ctx, recording which existing entries they refer to, without encoding
+// anything. The elements are then encoded in ranges, each on its own thread
+// and into its own buffer, with a context that contains the entries the range
+// refers to at their original indices. The output is the same as that of
+// item.serialize(ctx), as is the state of ctx afterwards, except that ctx
+// stores the (non-externalizable) objects and arrays within the elements
+// themselves instead of copies, so they must not be modified while ctx is
+// used. Other types of items are encoded sequentially. Elements are encoded
+// on worker threads, so externalizers have to be thread-safe.
+class AmfParallel {
+public:
+	// Uses std::thread::hardware_concurrency() threads if threads is 0.
+	static AmfItemPtr deserialize(v8::const_iterator& it, v8::const_iterator end,
+		SerializationContext& ctx, unsigned threads = 0);
+
+	static v8 serialize(const AmfItem& item, SerializationContext& ctx, unsigned threads = 0);
+	// Like serialize, but returns the buffers of the ranges without
+	// concatenating them, e.g. to pass them to writev.
+	static std::vector<v8> serializeBuffers(const AmfItem& item, SerializationContext& ctx,
+		unsigned threads = 0);
+};
+
+} // namespace amf
+
+#endif
@@ -0,0 +1,644 @@
+#include "amfpath.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <set>
+
+#include "deserializer.hpp"
+#include "serializationcontext.hpp"
+#include "types/amfdouble.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfstring.hpp"
+#include "types/amfitem.hpp"
+#include "utils/amfcolumns.hpp"
+#include "utils/amfflex.hpp"
+#include "utils/amfobjecttraits.hpp"
+
+namespace amf {
+
+// U29 values used as lengths and reference indices are unsigned.
+static size_t readU29(v8::const_iterator& it, v8::const_iterator end) {
+	return AmfInteger::deserializeValue(it, end) & 0x1FFFFFFF;
+}
+
+static bool isObjectMarker(u8 marker) {
+	switch (marker) {
+		case AMF_XMLDOC:
+		case AMF_DATE:
+		case AMF_ARRAY:
+		case AMF_OBJECT:
+		case AMF_XML:
+		case AMF_BYTEARRAY:
+		case AMF_VECTOR_INT:
+		case AMF_VECTOR_UINT:
+		case AMF_VECTOR_DOUBLE:
+		case AMF_VECTOR_OBJECT:
+		case AMF_DICTIONARY:
+			return true;
+		default:
+			return false;
+	}
+}
+
+static bool isFlexCollection(const AmfStringView& className) {
+	return className == AmfStringView(AmfFlex::ArrayCollection.data(), AmfFlex::ArrayCollection.size()) ||
+		className == AmfStringView(AmfFlex::ArrayList.data(), AmfFlex::ArrayList.size()) ||
+		className == AmfStringView(AmfFlex::ObjectProxy.data(), AmfFlex::ObjectProxy.size());
+}
+
+struct ScanTraits {
+	AmfStringView className;
+	bool dynamic;
+	bool externalizable;
+	std::vector<AmfStringView> attributes;
+};
+
+// Walks serialized values without decoding them. The reference tables only
+// hold views of and positions in the input. Since the path may lead back into
+// values that were already scanned (through an object reference), every entry
+// is only added when it is read for the first time, i.e. if it is located
+// after everything scanned so far.
+class AmfPathScanner {
+public:
+	enum Kind { VALUE, INT, UINT, DOUBLE };
+
+	AmfPathScanner(v8::const_iterator begin, v8::const_iterator end) :
+		begin(begin), end(end), kind(VALUE), scanned(0), refs(nullptr) { }
+
+	// If the value at it is an object reference, moves it to the referenced
+	// object.
+	void resolve(v8::const_iterator& it);
+	// Moves it from the value at it to the element selected by the segment.
+	// Sets kind if the element is an element of a primitive vector.
+	bool select(v8::const_iterator& it, bool isIndex, const std::string& name, size_t index);
+	void skip(v8::const_iterator& it);
+
+	// Decodes the (already scanned) value at offset.
+	AmfItemPtr decode(size_t offset);
+
+	v8::const_iterator begin;
+	v8::const_iterator end;
+
+	Kind kind;
+
+private:
+	bool isNew(v8::const_iterator it) const {
+		return static_cast<size_t>(it - begin) >= scanned;
+	}
+
+	void advance(v8::const_iterator it) {
+		scanned = std::max(scanned, static_cast<size_t>(it - begin));
+	}
+
+	void need(v8::const_iterator it, size_t bytes) {
+		if (static_cast<size_t>(end - it) < bytes)
+			throw std::out_of_range("Not enough bytes for AmfPath");
+	}
+
+	AmfStringView readString(v8::const_iterator& it);
+	const ScanTraits& readTraits(v8::const_iterator& it, size_t type, ScanTraits& local);
+	size_t addObject(v8::const_iterator marker);
+	bool reference(size_t type);
+
+	std::vector<size_t> referencesOutside(size_t offset, size_t index);
+	AmfItemPtr decodeWith(size_t offset, size_t index, const std::map<size_t, AmfItemPtr>& items);
+
+	std::vector<AmfStringView> strings;
+	// A deque keeps the traits in place while nested objects add theirs.
+	std::deque<ScanTraits> traits;
+	// Offset of the type marker of every object, in increasing order.
+	std::vector<size_t> objects;
+	// Everything before this offset has been scanned.
+	size_t scanned;
+
+	// If set, object references are appended to it while skipping.
+	std::vector<size_t>* refs;
+};
+
+AmfStringView AmfPathScanner::readString(v8::const_iterator& it) {
+	bool added = isNew(it);
+	size_t type = readU29(it, end);
+	if ((type & 0x01) == 0)
+		return strings.at(type >> 1);
+
+	size_t length = type >> 1;
+	need(it, length);
+
+	// Empty strings are never added to the string table.
+	if (length == 0)
+		return AmfStringView();
+
+	AmfStringView ret(reinterpret_cast<const char*>(&*it), length);
+	it += length;
+
+	if (added) {
+		strings.push_back(ret);
+		advance(it);
+	}
+
+	return ret;
+}
+
+const ScanTraits& AmfPathScanner::readTraits(v8::const_iterator& it, size_t type, ScanTraits& local) {
+	if ((type & 0x03) == 0x01) {
+		// U29O-traits-ref
+		size_t index = type >> 2;
+		if (index >= traits.size())
+			throw std::out_of_range("AmfPath: Invalid traits reference");
+		return traits[index];
+	}
+
+	// U29O-traits-ext or U29O-traits
+	bool added = isNew(it);
+	local.externalizable = ((type & 0x07) == 0x07);
+	local.dynamic = !local.externalizable && ((type & 0x08) == 0x08);
+	local.className = readString(it);
+	if (!local.externalizable) {
+		size_t numSealed = type >> 4;
+		for (size_t i = 0; i < numSealed; ++i)
+			local.attributes.push_back(readString(it));
+	}
+
+	if (!added)
+		return local;
+
+	traits.push_back(std::move(local));
+	advance(it);
+	return traits.back();
+}
+
+size_t AmfPathScanner::addObject(v8::const_iterator marker) {
+	size_t offset = marker - begin;
+	if (isNew(marker)) {
+		objects.push_back(offset);
+		advance(marker + 1);
+		return objects.size() - 1;
+	}
+
+	return std::lower_bound(objects.begin(), objects.end(), offset) - objects.begin();
+}
+
+// Returns whether type is an object reference, which is then recorded.
+bool AmfPathScanner::reference(size_t type) {
+	if ((type & 0x01) != 0)
+		return false;
+
+	size_t index = type >> 1;
+	if (index >= objects.size())
+		throw std::out_of_range("AmfPath: Invalid object reference");
+
+	if (refs != nullptr)
+		refs->push_back(index);
+
+	return true;
+}
+
+void AmfPathScanner::resolve(v8::const_iterator& it) {
+	if (it == end || !isObjectMarker(*it))
+		return;
+
+	v8::const_iterator type = it + 1;
+	size_t value = readU29(type, end);
+	if (reference(value))
+		it = begin + objects[value >> 1];
+}
+
+bool AmfPathScanner::select(v8::const_iterator& it, bool isIndex, const std::string& name, size_t index) {
+	if (it == end)
+		throw std::out_of_range("Not enough bytes for AmfPath");
+
+	AmfStringView key(name.data(), name.size());
+	v8::const_iterator marker = it;
+	switch (*it++) {
+		case AMF_OBJECT: {
+			size_t type = readU29(it, end);
+			addObject(marker);
+
+			ScanTraits local;
+			const ScanTraits& objectTraits = readTraits(it, type, local);
+
+			if (objectTraits.externalizable) {
+				// Only the Flex collections can be looked into.
+				if (!isFlexCollection(objectTraits.className))
+					return false;
+
+				resolve(it);
+				return select(it, isIndex, name, index);
+			}
+
+			if (isIndex)
+				return false;
+
+			for (const AmfStringView& attribute : objectTraits.attributes) {
+				if (attribute == key)
+					return true;
+				skip(it);
+			}
+
+			if (objectTraits.dynamic) {
+				for (AmfStringView member = readString(it); member.size != 0; member = readString(it)) {
+					if (member == key)
+						return true;
+					skip(it);
+				}
+			}
+
+			return false;
+		}
+		case AMF_ARRAY: {
+			size_t length = readU29(it, end) >> 1;
+			addObject(marker);
+
+			// associative until UTF-8-empty
+			for (AmfStringView member = readString(it); member.size != 0; member = readString(it)) {
+				if (!isIndex && member == key)
+					return true;
+				skip(it);
+			}
+
+			if (!isIndex || index >= length)
+				return false;
+
+			for (size_t i = 0; i < index; ++i)
+				skip(it);
+			return true;
+		}
+		case AMF_VECTOR_INT:
+		case AMF_VECTOR_UINT:
+		case AMF_VECTOR_DOUBLE: {
+			size_t length = readU29(it, end) >> 1;
+			addObject(marker);
+
+			// fixed flag
+			need(it, 1);
+			++it;
+
+			size_t stride = *marker == AMF_VECTOR_DOUBLE ? 8 : 4;
+			need(it, length * stride);
+			if (!isIndex || index >= length)
+				return false;
+
+			kind = *marker == AMF_VECTOR_INT ? INT : (*marker == AMF_VECTOR_UINT ? UINT : DOUBLE);
+			it += index * stride;
+			return true;
+		}
+		case AMF_VECTOR_OBJECT: {
+			size_t length = readU29(it, end) >> 1;
+			addObject(marker);
+
+			// fixed flag, followed by the type name of the elements
+			need(it, 1);
+			++it;
+			readString(it);
+
+			if (!isIndex || index >= length)
+				return false;
+
+			for (size_t i = 0; i < index; ++i)
+				skip(it);
+			return true;
+		}
+		case AMF_DICTIONARY: {
+			size_t length = readU29(it, end) >> 1;
+			addObject(marker);
+
+			// weak keys flag
+			need(it, 1);
+			++it;
+
+			for (size_t i = 0; i < length; ++i) {
+				need(it, 1);
+				bool match = false;
+				if (*it == AMF_STRING && !isIndex) {
+					++it;
+					match = (readString(it) == key);
+				} else if (*it == AMF_INTEGER && isIndex) {
+					++it;
+					int value = AmfInteger::deserializeValue(it, end);
+					match = (value >= 0 && static_cast<size_t>(value) == index);
+				} else {
+					skip(it);
+				}
+
+				if (match)
+					return true;
+				skip(it);
+			}
+
+			return false;
+		}
+		default:
+			return false;
+	}
+}
+
+void AmfPathScanner::skip(v8::const_iterator& it) {
+	need(it, 1);
+
+	v8::const_iterator marker = it;
+	switch (*it++) {
+		case AMF_UNDEFINED:
+		case AMF_NULL:
+		case AMF_FALSE:
+		case AMF_TRUE:
+			break;
+		case AMF_INTEGER:
+			AmfInteger::deserializeValue(it, end);
+			break;
+		case AMF_DOUBLE:
+			need(it, 8);
+			it += 8;
+			break;
+		case AMF_STRING:
+			readString(it);
+			break;
+		case AMF_XMLDOC:
+		case AMF_XML:
+		case AMF_BYTEARRAY: {
+			size_t type = readU29(it, end);
+			if (reference(type))
+				break;
+
+			addObject(marker);
+			need(it, type >> 1);
+			it += type >> 1;
+			break;
+		}
+		case AMF_DATE: {
+			size_t type = readU29(it, end);
+			if (reference(type))
+				break;
+
+			addObject(marker);
+			need(it, 8);
+			it += 8;
+			break;
+		}
+		case AMF_ARRAY: {
+			size_t type = readU29(it, end);
+			if (reference(type))
+				break;
+
+			addObject(marker);
+			while (readString(it).size != 0)
+				skip(it);
+
+			for (size_t i = 0; i < type >> 1; ++i)
+				skip(it);
+			break;
+		}
+		case AMF_OBJECT: {
+			size_t type = readU29(it, end);
+			if (reference(type))
+				break;
+
+			// Reading new traits moves past the marker, so add the object first.
+			addObject(marker);
+			ScanTraits local;
+			const ScanTraits& objectTraits = readTraits(it, type, local);
+
+			if (objectTraits.externalizable) {
+				// The Flex collections externalize the value they wrap, the
+				// length of other externalized data is unknown.
+				if (!isFlexCollection(objectTraits.className))
+					throw std::invalid_argument("AmfPath: Can't skip externalizable class " +
+						objectTraits.className.str());
+
+				skip(it);
+				break;
+			}
+
+			for (size_t i = 0; i < objectTraits.attributes.size(); ++i)
+				skip(it);
+
+			if (objectTraits.dynamic) {
+				while (readString(it).size != 0)
+					skip(it);
+			}
+			break;
+		}
+		case AMF_VECTOR_INT:
+		case AMF_VECTOR_UINT:
+		case AMF_VECTOR_DOUBLE: {
+			size_t type = readU29(it, end);
+			if (reference(type))
+				break;
+
+			addObject(marker);
+			size_t stride = *marker == AMF_VECTOR_DOUBLE ? 8 : 4;
+			need(it, 1 + (type >> 1) * stride);
+			it += 1 + (type >> 1) * stride;
+			break;
+		}
+		case AMF_VECTOR_OBJECT: {
+			size_t type = readU29(it, end);
+			if (reference(type))
+				break;
+
+			addObject(marker);
+			need(it, 1);
+			++it;
+			readString(it);
+
+			for (size_t i = 0; i < type >> 1; ++i)
+				skip(it);
+			break;
+		}
+		case AMF_DICTIONARY: {
+			size_t type = readU29(it, end);
+			if (reference(type))
+				break;
+
+			addObject(marker);
+			need(it, 1);
+			++it;
+
+			for (size_t i = 0; i < type >> 1; ++i) {
+				skip(it);
+				skip(it);
+			}
+			break;
+		}
+		default:
+			throw std::invalid_argument("AmfPath: Invalid type marker");
+	}
+}
+
+// Returns the objects preceding the object with the given index that are
+// referenced from within it.
+std::vector<size_t> AmfPathScanner::referencesOutside(size_t offset, size_t index) {
+	std::vector<size_t> found;
+	refs = &found;
+
+	v8::const_iterator it = begin + offset;
+	skip(it);
+	refs = nullptr;
+
+	found.erase(std::remove_if(found.begin(), found.end(), [index](size_t i) {
+		return i >= index;
+	}), found.end());
+	return found;
+}
+
+// Decodes the value at offset with a context that contains all strings and
+// traits scanned so far, and the given items in place of the objects
+// preceding the value. Strings and traits the value adds again are appended
+// after the ones it refers to, so they don't change any indices.
+AmfItemPtr AmfPathScanner::decodeWith(size_t offset, size_t index, const std::map<size_t, AmfItemPtr>& items) {
+	SerializationContext ctx;
+	for (const AmfStringView& str : strings)
+		ctx.addString(str.str());
+
+	for (const ScanTraits& scanned : traits) {
+		AmfObjectTraits objectTraits(scanned.className.str(), scanned.dynamic, scanned.externalizable);
+		for (const AmfStringView& attribute : scanned.attributes)
+			objectTraits.attributes.push_back(attribute.str());
+		ctx.addTraits(objectTraits);
+	}
+
+	for (size_t i = 0; i < index; ++i) {
+		auto item = items.find(i);
+		ctx.addPointer(item != items.end() ? item->second : AmfItemPtr());
+	}
+
+	v8::const_iterator it = begin + offset;
+	return Deserializer::deserialize(it, end, ctx);
+}
+
+AmfItemPtr AmfPathScanner::decode(size_t offset) {
+	// Strings and other scalars don't need the object table, and copying
+	// the string table into a context is more expensive than reading them.
+	v8::const_iterator it = begin + offset;
+	if (*it == AMF_STRING) {
+		++it;
+		return AmfItemPtr(AmfString(readString(it).str()));
+	}
+
+	if (!isObjectMarker(*it)) {
+		SerializationContext ctx;
+		return Deserializer::deserialize(it, end, ctx);
+	}
+
+	size_t index = std::lower_bound(objects.begin(), objects.end(), offset) - objects.begin();
+
+	// Decode the objects the value refers to first, including the ones they
+	// refer to themselves.
+	std::set<size_t> needed;
+	std::vector<size_t> pending = referencesOutside(offset, index);
+	while (!pending.empty()) {
+		size_t i = pending.back();
+		pending.pop_back();
+		if (!needed.insert(i).second)
+			continue;
+
+		std::vector<size_t> more = referencesOutside(objects[i], i);
+		pending.insert(pending.end(), more.begin(), more.end());
+	}
+
+	std::map<size_t, AmfItemPtr> items;
+	for (size_t i : needed)
+		items[i] = decodeWith(objects[i], i, items);
+
+	return decodeWith(offset, index, items);
+}
+
+AmfPath::AmfPath(const std::string& path) {
+	size_t pos = 0;
+	while (pos < path.size()) {
+		Segment segment;
+		if (path[pos] == '[') {
+			size_t close = path.find(']', pos);
+			if (close == std::string::npos || close == pos + 1)
+				throw std::invalid_argument("AmfPath: Invalid index in " + path);
+
+			std::string digits = path.substr(pos + 1, close - pos - 1);
+			if (digits.find_first_not_of("0123456789") != std::string::npos || digits.size() > 9)
+				throw std::invalid_argument("AmfPath: Invalid index in " + path);
+
+			segment.isIndex = true;
+			segment.index = std::stoul(digits);
+			pos = close + 1;
+		} else {
+			if (path[pos] == '.') {
+				if (segments.empty())
+					throw std::invalid_argument("AmfPath: Empty name in " + path);
+				++pos;
+			} else if (!segments.empty()) {
+				throw std::invalid_argument("AmfPath: Missing separator in " + path);
+			}
+
+			size_t next = path.find_first_of(".[", pos);
+			if (next == std::string::npos)
+				next = path.size();
+			if (next == pos)
+				throw std::invalid_argument("AmfPath: Empty name in " + path);
+
+			segment.isIndex = false;
+			segment.index = 0;
+			segment.name = path.substr(pos, next - pos);
+			pos = next;
+		}
+
+		segments.push_back(std::move(segment));
+	}
+}
+
+bool AmfPath::locate(AmfPathScanner& scanner, size_t& offset, size_t& size) const {
+	v8::const_iterator it = scanner.begin;
+	for (const Segment& segment : segments) {
+		// Elements of primitive vectors have no members.
+		if (scanner.kind != AmfPathScanner::VALUE)
+			return false;
+
+		scanner.resolve(it);
+		if (!scanner.select(it, segment.isIndex, segment.name, segment.index))
+			return false;
+	}
+
+	offset = it - scanner.begin;
+	switch (scanner.kind) {
+		case AmfPathScanner::VALUE: {
+			scanner.resolve(it);
+			offset = it - scanner.begin;
+
+			v8::const_iterator valueEnd = it;
+			scanner.skip(valueEnd);
+			size = valueEnd - it;
+			break;
+		}
+		case AmfPathScanner::DOUBLE:
+			size = 8;
+			break;
+		default:
+			size = 4;
+	}
+
+	return true;
+}
+
+bool AmfPath::find(v8::const_iterator begin, v8::const_iterator end, size_t& offset, size_t& size) const {
+	AmfPathScanner scanner(begin, end);
+	return locate(scanner, offset, size);
+}
+
+AmfItemPtr AmfPath::get(v8::const_iterator begin, v8::const_iterator end) const {
+	AmfPathScanner scanner(begin, end);
+	size_t offset, size;
+	if (!locate(scanner, offset, size))
+		return AmfItemPtr();
+
+	v8::const_iterator it = begin + offset;
+	switch (scanner.kind) {
+		case AmfPathScanner::INT:
+			return AmfItemPtr(AmfInteger(read_network<int32_t>(it, end)));
+		case AmfPathScanner::UINT:
+			return AmfItemPtr(AmfDouble(read_network<uint32_t>(it, end)));
+		case AmfPathScanner::DOUBLE:
+			return AmfItemPtr(AmfDouble(read_network<double>(it, end)));
+		default:
+			return scanner.decode(offset);
+	}
+}
+
+} // namespace amf
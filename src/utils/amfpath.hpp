@@ -0,0 +1,60 @@
+#pragma once
+#ifndef AMFPATH_HPP
+#define AMFPATH_HPP
+
+#include <string>
+#include <vector>
+
+#include "amf.hpp"
+#include "utils/amfitemptr.hpp"
+
+namespace amf {
+
+class AmfPathScanner;
+
+// Extracts single values from a serialized AMF3 value without decoding all of
+// it, e.g. "body[0].operation" or "headers.DSId". Values preceding the wanted
+// one are skipped on the wire, only recording their strings, traits and
+// positions so that later references resolve.
+//
+// A path consists of names, separated by dots, and [n] indices. Names select
+// members of objects, associative elements of arrays and string keys of
+// dictionaries. Indices select dense elements of arrays, elements of vectors
+// and integer keys of dictionaries. The Flex collections handled by AmfFlex
+// are transparent, i.e. their wrapped value is used instead.
+class AmfPath {
+public:
+	// Throws std::invalid_argument if path isn't valid. The empty path
+	// selects the whole value.
+	explicit AmfPath(const std::string& path);
+
+	// Finds the value at the path in the value starting at begin, which has to
+	// be encoded with its own reference tables. Returns false if there is no
+	// such value. Otherwise, sets offset and size to the extent of its
+	// encoding, relative to begin. References to objects are resolved to the
+	// referenced object, but strings, traits and objects inside the value
+	// may still refer to ones preceding it. Elements of Vector.<int>,
+	// Vector.<uint> and Vector.<Number> are the 4 or 8 bytes of their value.
+	bool find(v8::const_iterator begin, v8::const_iterator end, size_t& offset, size_t& size) const;
+
+	// Returns the decoded value at the path, or a null AmfItemPtr if there is
+	// no such value. Objects outside of the value that it refers to are
+	// decoded as well, but nothing else.
+	AmfItemPtr get(v8::const_iterator begin, v8::const_iterator end) const;
+
+private:
+	struct Segment {
+		std::string name;
+		size_t index;
+		bool isIndex;
+	};
+
+	// Moves the scanner to the value at the path and scans it.
+	bool locate(AmfPathScanner& scanner, size_t& offset, size_t& size) const;
+
+	std::vector<Segment> segments;
+};
+
+} // namespace amf
+
+#endif
@@ -0,0 +1,214 @@
+#include "amfprojection.hpp"
+
+#include "deserializer.hpp"
+#include "serializationcontext.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfstring.hpp"
+
+namespace amf {
+
+AmfProjection& AmfProjection::keepClass(const std::string& className, const std::vector<std::string>& properties) {
+	classes[className].insert(properties.begin(), properties.end());
+	return *this;
+}
+
+AmfProjection& AmfProjection::keepPath(const std::string& path) {
+	std::vector<std::string> names;
+	size_t pos = 0;
+	while (true) {
+		size_t next = path.find('.', pos);
+		if (next == std::string::npos)
+			next = path.size();
+		if (next == pos)
+			throw std::invalid_argument("AmfProjection: Invalid path " + path);
+
+		names.push_back(path.substr(pos, next - pos));
+		if (next == path.size())
+			break;
+		pos = next + 1;
+	}
+
+	Node* node = &paths;
+	for (const std::string& name : names) {
+		node->all = false;
+
+		auto member = node->members.find(name);
+		if (member == node->members.end()) {
+			member = node->members.emplace(name, Node()).first;
+		} else if (member->second.all) {
+			// A shorter path already keeps all of it.
+			return *this;
+		}
+
+		node = &member->second;
+	}
+
+	node->all = true;
+	node->members.clear();
+	return *this;
+}
+
+static void need(v8::const_iterator it, v8::const_iterator end, size_t bytes) {
+	if (static_cast<size_t>(end - it) < bytes)
+		throw std::out_of_range("Not enough bytes for AmfProjection::skip");
+}
+
+static void addReference(size_t* firstReference, size_t index) {
+	if (firstReference != nullptr && index < *firstReference)
+		*firstReference = index;
+}
+
+// Reads the U29 header of a value that can be an object reference. Returns
+// false for references, and otherwise reserves the object table entry of
+// the value.
+static bool readHeader(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx, int& type,
+	size_t* firstReference) {
+	type = AmfInteger::deserializeValue(it, end);
+	if ((type & 0x01) == 0) {
+		addReference(firstReference, type >> 1);
+		return false;
+	}
+
+	ctx.addPointer(AmfItemPtr());
+	return true;
+}
+
+void AmfProjection::skipValue(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx,
+	size_t* firstReference) {
+	if (it == end)
+		throw std::out_of_range("Not enough bytes for AmfProjection::skip");
+
+	int type;
+	v8::const_iterator marker = it;
+	switch (*it++) {
+		case AMF_UNDEFINED:
+		case AMF_NULL:
+		case AMF_FALSE:
+		case AMF_TRUE:
+			break;
+		case AMF_INTEGER:
+			AmfInteger::deserializeValue(it, end);
+			break;
+		case AMF_DOUBLE:
+			need(it, end, 8);
+			it += 8;
+			break;
+		case AMF_STRING:
+			AmfString::deserializeValue(it, end, ctx);
+			break;
+		case AMF_XMLDOC:
+		case AMF_XML:
+		case AMF_BYTEARRAY:
+			if (readHeader(it, end, ctx, type, firstReference)) {
+				need(it, end, type >> 1);
+				it += type >> 1;
+			}
+			break;
+		case AMF_DATE:
+			if (readHeader(it, end, ctx, type, firstReference)) {
+				need(it, end, 8);
+				it += 8;
+			}
+			break;
+		case AMF_ARRAY:
+			if (readHeader(it, end, ctx, type, firstReference)) {
+				while (AmfString::deserializeValue(it, end, ctx) != "")
+					skipValue(it, end, ctx, firstReference);
+
+				for (int i = 0; i < type >> 1; ++i)
+					skipValue(it, end, ctx, firstReference);
+			}
+			break;
+		case AMF_OBJECT: {
+			type = AmfInteger::deserializeValue(it, end);
+			if ((type & 0x01) == 0) {
+				addReference(firstReference, type >> 1);
+				break;
+			}
+
+			// The length of externalized data is only known to their
+			// deserializer, so these objects are decoded.
+			bool externalizable = ((type & 0x03) == 0x01) ?
+				ctx.getTraits(type >> 2).externalizable : ((type & 0x07) == 0x07);
+			if (externalizable) {
+				// Whatever they refer to isn't known.
+				addReference(firstReference, 0);
+				it = marker;
+				Deserializer::deserialize(it, end, ctx);
+				break;
+			}
+
+			size_t traitsIndex;
+			if ((type & 0x03) == 0x01) {
+				traitsIndex = type >> 2;
+			} else {
+				AmfObjectTraits traits("", (type & 0x08) == 0x08, false);
+				traits.className = AmfString::deserializeValue(it, end, ctx);
+				for (int i = 0; i < type >> 4; ++i)
+					traits.attributes.push_back(AmfString::deserializeValue(it, end, ctx));
+
+				ctx.addTraits(traits);
+				traitsIndex = ctx.getIndex(traits);
+			}
+
+			const AmfObjectTraits& traits = ctx.getTraits(traitsIndex);
+			size_t numSealed = traits.attributes.size();
+			bool dynamic = traits.dynamic;
+			ctx.addPointer(AmfItemPtr());
+
+			for (size_t i = 0; i < numSealed; ++i)
+				skipValue(it, end, ctx, firstReference);
+
+			if (dynamic) {
+				while (AmfString::deserializeValue(it, end, ctx) != "")
+					skipValue(it, end, ctx, firstReference);
+			}
+			break;
+		}
+		case AMF_VECTOR_INT:
+		case AMF_VECTOR_UINT:
+		case AMF_VECTOR_DOUBLE:
+			if (readHeader(it, end, ctx, type, firstReference)) {
+				size_t stride = *marker == AMF_VECTOR_DOUBLE ? 8 : 4;
+				need(it, end, 1 + (type >> 1) * stride);
+				it += 1 + (type >> 1) * stride;
+			}
+			break;
+		case AMF_VECTOR_OBJECT:
+			if (readHeader(it, end, ctx, type, firstReference)) {
+				// fixed flag, followed by the type name of the elements
+				need(it, end, 1);
+				++it;
+				AmfString::deserializeValue(it, end, ctx);
+
+				for (int i = 0; i < type >> 1; ++i)
+					skipValue(it, end, ctx, firstReference);
+			}
+			break;
+		case AMF_DICTIONARY:
+			if (readHeader(it, end, ctx, type, firstReference)) {
+				// weak keys flag
+				need(it, end, 1);
+				++it;
+
+				for (int i = 0; i < type >> 1; ++i) {
+					skipValue(it, end, ctx, firstReference);
+					skipValue(it, end, ctx, firstReference);
+				}
+			}
+			break;
+		default:
+			throw std::invalid_argument("AmfProjection::skip: Invalid type marker");
+	}
+}
+
+void AmfProjection::skip(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+	v8::const_iterator start = it;
+	size_t first = ctx.objectCount();
+	skipValue(it, end, ctx);
+
+	if (ctx.objectCount() > first)
+		ctx.addSkipped(first, v8(start, it));
+}
+
+} // namespace amf
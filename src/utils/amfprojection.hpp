@@ -0,0 +1,81 @@
+#pragma once
+#ifndef AMFPROJECTION_HPP
+#define AMFPROJECTION_HPP
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "amf.hpp"
+
+namespace amf {
+
+class SerializationContext;
+
+// Selects the properties of objects that are decoded when the projection is
+// set on a context (see SerializationContext::setProjection). The values of
+// all other properties are skipped on the wire, but the strings, traits and
+// objects they contain are still added to the context's reference tables. A
+// later reference to a skipped object decodes it in full at that point.
+//
+// Objects decoded with a projection miss the sealed properties that weren't
+// kept, so they can't be serialized again. An object that is referenced more
+// than once keeps the properties selected where it occurred first.
+//
+// Like ExternalDeserializerRegistry, a projection is meant to be filled once
+// and then shared between any number of contexts.
+class AmfProjection {
+public:
+	struct Node {
+		Node() : all(true) { }
+
+		// If false, only the values of members are kept.
+		bool all;
+		std::map<std::string, Node> members;
+	};
+
+	// Keeps only the given sealed and dynamic properties of objects of class
+	// className, unless a path applies to them.
+	AmfProjection& keepClass(const std::string& className, const std::vector<std::string>& properties);
+
+	// Keeps only the values on path below the top-level value. A path
+	// consists of property names separated by dots. Arrays, vectors,
+	// dictionaries and the Flex collections handled by AmfFlex pass the
+	// path on to their elements, so "body.operation" keeps the operation
+	// of every object in body. Everything below the end of a path is kept,
+	// apart from what the class rules exclude. Throws std::invalid_argument
+	// if the path is empty or contains an empty name.
+	AmfProjection& keepPath(const std::string& path);
+
+	// The root of the paths, or nullptr if there are none.
+	const Node* root() const {
+		return paths.all ? nullptr : &paths;
+	}
+
+	// Returns the properties to keep of objects of class className, or
+	// nullptr if all of them are kept.
+	const std::set<std::string>* properties(const std::string& className) const {
+		auto it = classes.find(className);
+		return it == classes.end() ? nullptr : &it->second;
+	}
+
+	// Skips the value at it, adding everything it contains to the reference
+	// tables of ctx. If it adds any objects, ctx keeps a copy of the value to
+	// decode them if they are referenced later.
+	static void skip(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx);
+	// Like skip, but the caller has to record the objects the value added
+	// with SerializationContext::addSkipped. If firstReference isn't null, it
+	// is lowered to the smallest object table index the value refers to, or
+	// to 0 if it contains externalizable objects.
+	static void skipValue(v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx,
+		size_t* firstReference = nullptr);
+
+private:
+	Node paths;
+	std::map<std::string, std::set<std::string>> classes;
+};
+
+} // namespace amf
+
+#endif
@@ -0,0 +1,221 @@
+#include "amfrecordlog.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include "deserializer.hpp"
+#include "serializationcontext.hpp"
+#include "types/amfitem.hpp"
+
+namespace amf {
+
+// U32 length, U32 checksum
+static const size_t recordHeaderSize = 8;
+
+static uint32_t readU32(const u8* data) {
+	return static_cast<uint32_t>(data[0]) << 24 | static_cast<uint32_t>(data[1]) << 16 |
+		static_cast<uint32_t>(data[2]) << 8 | data[3];
+}
+
+static uint64_t readU64(const u8* data) {
+	return static_cast<uint64_t>(readU32(data)) << 32 | readU32(data + 4);
+}
+
+// Returns the offset following the record at offset, or 0 if the log doesn't
+// contain all of it.
+static uint64_t recordEnd(const u8* data, size_t size, uint64_t offset) {
+	if (offset > size || size - offset < recordHeaderSize)
+		return 0;
+
+	uint64_t end = offset + recordHeaderSize + readU32(data + offset);
+	return end <= size ? end : 0;
+}
+
+// Fills offsets with the records of the log, using the entries of the index at
+// indexPath as far as they are valid. Returns the end of the last complete
+// record and sets indexed to the number of offsets taken from the index.
+static uint64_t readOffsets(const u8* data, size_t size, const std::string& indexPath,
+	std::vector<uint64_t>& offsets, size_t& indexed) {
+	uint64_t end = 0;
+	offsets.clear();
+
+	std::ifstream index(indexPath, std::ios::binary);
+	u8 entry[8];
+	while (index.read(reinterpret_cast<char*>(entry), sizeof(entry))) {
+		uint64_t offset = readU64(entry);
+		uint64_t next = recordEnd(data, size, offset);
+		if (offset != end || next == 0)
+			break;
+
+		offsets.push_back(offset);
+		end = next;
+	}
+	indexed = offsets.size();
+
+	// Records that were written after the index was last flushed.
+	for (uint64_t next; (next = recordEnd(data, size, end)) != 0; end = next)
+		offsets.push_back(end);
+
+	return end;
+}
+
+AmfRecordLogWriter::AmfRecordLogWriter(const std::string& path) :
+	logBuffer(1 << 16), indexBuffer(1 << 12), offset(0), records(0) {
+	std::string indexPath = path + ".idx";
+
+	std::vector<uint64_t> offsets;
+	size_t indexed = 0;
+	if (std::ifstream(path).good()) {
+		bool incomplete;
+		v8 complete;
+		{
+			AmfMappedFile file(path);
+			offset = readOffsets(file.data(), file.size(), indexPath, offsets, indexed);
+			incomplete = (offset != file.size());
+			if (incomplete)
+				complete.assign(file.data(), file.data() + offset);
+		}
+
+		// Drop an incomplete record at the end of the log, which would
+		// otherwise hide all records appended after it. The file can't be
+		// truncated while it is mapped.
+		if (incomplete) {
+			std::ofstream trimmed(path, std::ios::binary | std::ios::trunc);
+			trimmed.write(reinterpret_cast<const char*>(complete.data()), complete.size());
+			if (!trimmed)
+				throw std::runtime_error("AmfRecordLogWriter: Could not write " + path);
+		}
+	}
+	records = offsets.size();
+
+	log.rdbuf()->pubsetbuf(logBuffer.data(), logBuffer.size());
+	log.open(path, std::ios::binary | std::ios::app);
+	if (!log)
+		throw std::runtime_error("AmfRecordLogWriter: Could not open " + path);
+
+	index.rdbuf()->pubsetbuf(indexBuffer.data(), indexBuffer.size());
+	if (indexed == records) {
+		index.open(indexPath, std::ios::binary | std::ios::app);
+	} else {
+		// Rewrite the index if it didn't cover all records.
+		index.open(indexPath, std::ios::binary | std::ios::trunc);
+		for (uint64_t recordOffset : offsets) {
+			v8 entry = network_bytes<uint64_t>(recordOffset);
+			index.write(reinterpret_cast<const char*>(entry.data()), entry.size());
+		}
+	}
+
+	if (!index)
+		throw std::runtime_error("AmfRecordLogWriter: Could not open " + indexPath);
+}
+
+size_t AmfRecordLogWriter::append(const AmfItem& item) {
+	SerializationContext ctx;
+	v8 value = item.serialize(ctx);
+	if (value.size() > 0xFFFFFFFFu)
+		throw std::length_error("AmfRecordLogWriter::append record too large");
+
+	v8 header = network_bytes<uint32_t>(value.size());
+	v8 crc = network_bytes<uint32_t>(AmfRecordLog::checksum(value.data(), value.size()));
+	header.insert(header.end(), crc.begin(), crc.end());
+
+	log.write(reinterpret_cast<const char*>(header.data()), header.size());
+	log.write(reinterpret_cast<const char*>(value.data()), value.size());
+
+	v8 entry = network_bytes<uint64_t>(offset);
+	index.write(reinterpret_cast<const char*>(entry.data()), entry.size());
+
+	if (!log || !index)
+		throw std::runtime_error("AmfRecordLogWriter: Could not write record");
+
+	offset += header.size() + value.size();
+	return records++;
+}
+
+void AmfRecordLogWriter::flush() {
+	log.flush();
+	index.flush();
+
+	if (!log || !index)
+		throw std::runtime_error("AmfRecordLogWriter: Could not write record");
+}
+
+AmfRecordLog::AmfRecordLog(const std::string& path) : file(path) {
+	size_t indexed;
+	readOffsets(file.data(), file.size(), path + ".idx", offsets, indexed);
+}
+
+AmfItemPtr AmfRecordLog::get(size_t n) const {
+	const u8* record = file.data() + offsets.at(n);
+	uint32_t length = readU32(record);
+	const u8* value = record + recordHeaderSize;
+
+	if (checksum(value, length) != readU32(record + 4))
+		throw std::invalid_argument("AmfRecordLog: Checksum mismatch");
+
+	v8 data(value, value + length);
+	SerializationContext ctx;
+	auto it = data.cbegin();
+	AmfItemPtr ret = Deserializer::deserialize(it, data.cend(), ctx);
+	if (it != data.cend())
+		throw std::invalid_argument("AmfRecordLog: Trailing bytes after record");
+
+	return ret;
+}
+
+void AmfRecordLog::scan(Callback callback, unsigned int threads) const {
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	threads = static_cast<unsigned int>(std::min<size_t>(threads, size()));
+
+	std::mutex errorMutex;
+	std::exception_ptr error;
+
+	auto work = [&](size_t begin, size_t end) {
+		try {
+			for (size_t n = begin; n < end; ++n)
+				callback(n, get(n));
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(errorMutex);
+			if (!error)
+				error = std::current_exception();
+		}
+	};
+
+	std::vector<std::thread> workers;
+	size_t perThread = threads > 0 ? (size() + threads - 1) / threads : 0;
+	for (unsigned int i = 1; i < threads; ++i)
+		workers.emplace_back(work, std::min(size(), i * perThread), std::min(size(), (i + 1) * perThread));
+	// The calling thread handles the first range.
+	work(0, perThread);
+
+	for (std::thread& worker : workers)
+		worker.join();
+
+	if (error)
+		std::rethrow_exception(error);
+}
+
+uint32_t AmfRecordLog::checksum(const u8* data, size_t size) {
+	// CRC-32 as used by zlib, with the reflected polynomial 0xEDB88320.
+	static const std::vector<uint32_t> table = []() {
+		std::vector<uint32_t> ret(256);
+		for (uint32_t i = 0; i < 256; ++i) {
+			uint32_t crc = i;
+			for (int bit = 0; bit < 8; ++bit)
+				crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+			ret[i] = crc;
+		}
+		return ret;
+	}();
+
+	uint32_t crc = 0xFFFFFFFFu;
+	for (size_t i = 0; i < size; ++i)
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+	return crc ^ 0xFFFFFFFFu;
+}
+
+} // namespace amf
@@ -0,0 +1,81 @@
+#pragma once
+#ifndef AMFRECORDLOG_HPP
+#define AMFRECORDLOG_HPP
+
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "amf.hpp"
+#include "utils/amfitemptr.hpp"
+#include "utils/amfmappedfile.hpp"
+
+namespace amf {
+
+class AmfItem;
+
+// A log of AMF3 values. Every record is serialized with its own context, so it
+// can be decoded on its own, and is stored as
+//   U32 length (in network order) U32 CRC-32 of the value U8* value
+// The byte offsets of the records are kept in a sidecar index file (the path
+// of the log with ".idx" appended) as U64 values in network order.
+class AmfRecordLogWriter {
+public:
+	// Opens the log at path for appending, creating it if necessary.
+	explicit AmfRecordLogWriter(const std::string& path);
+
+	AmfRecordLogWriter(const AmfRecordLogWriter&) = delete;
+	AmfRecordLogWriter& operator=(const AmfRecordLogWriter&) = delete;
+
+	// Appends item to the log and returns its record number. Writes are
+	// buffered until flush() is called or the writer is destroyed.
+	size_t append(const AmfItem& item);
+	void flush();
+
+	size_t size() const {
+		return records;
+	}
+
+private:
+	std::vector<char> logBuffer;
+	std::vector<char> indexBuffer;
+	std::ofstream log;
+	std::ofstream index;
+	uint64_t offset;
+	size_t records;
+};
+
+class AmfRecordLog {
+public:
+	// Maps the log at path into memory. If its index is missing or doesn't
+	// cover the whole log (e.g. because the writer didn't finish), the
+	// offsets are recovered by walking the log. An incomplete record at the
+	// end of the log is ignored.
+	explicit AmfRecordLog(const std::string& path);
+
+	size_t size() const {
+		return offsets.size();
+	}
+
+	// Decodes record n. Throws std::invalid_argument if its checksum doesn't
+	// match.
+	AmfItemPtr get(size_t n) const;
+
+	// Decodes all records on up to threads threads, each of them handling a
+	// contiguous range of records, and calls callback for each of them,
+	// possibly concurrently. The first exception thrown while decoding or by
+	// callback is rethrown once all threads are done.
+	typedef std::function<void(size_t n, const AmfItemPtr& item)> Callback;
+	void scan(Callback callback, unsigned int threads = 0) const;
+
+	static uint32_t checksum(const u8* data, size_t size);
+
+private:
+	AmfMappedFile file;
+	std::vector<uint64_t> offsets;
+};
+
+} // namespace amf
+
+#endif
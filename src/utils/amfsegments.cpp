@@ -0,0 +1,96 @@
+#include "amfsegments.hpp"
+
+#include "types/amfitem.hpp"
+
+namespace amf {
+
+void AmfItem::serializeInto(SerializationContext& ctx, AmfSegments& out) const {
+	out.append(serialize(ctx));
+}
+
+bool AmfSegments::appendPayload(const u8* data, size_t size) {
+	if (size < threshold) {
+		buf.insert(buf.end(), data, data + size);
+		return false;
+	}
+
+	if (buf.size() > flushed) {
+		parts.push_back(Segment { nullptr, flushed, buf.size() - flushed });
+		flushed = buf.size();
+	}
+
+	parts.push_back(Segment { data, 0, size });
+	return true;
+}
+
+size_t AmfSegments::size() const {
+	size_t ret = buf.size();
+	for (const Segment& part : parts) {
+		if (part.data != nullptr)
+			ret += part.size;
+	}
+
+	return ret;
+}
+
+std::vector<std::pair<const u8*, size_t>> AmfSegments::segments() const {
+	std::vector<std::pair<const u8*, size_t>> ret;
+	ret.reserve(parts.size() + 1);
+
+	for (const Segment& part : parts) {
+		if (part.data != nullptr)
+			ret.emplace_back(part.data, part.size);
+		else
+			ret.emplace_back(buf.data() + part.offset, part.size);
+	}
+
+	if (buf.size() > flushed)
+		ret.emplace_back(buf.data() + flushed, buf.size() - flushed);
+
+	return ret;
+}
+
+#ifndef _WIN32
+std::vector<struct iovec> AmfSegments::iovecs() const {
+	std::vector<struct iovec> ret;
+	for (const auto& segment : segments()) {
+		struct iovec vec;
+		vec.iov_base = const_cast<u8*>(segment.first);
+		vec.iov_len = segment.second;
+		ret.push_back(vec);
+	}
+
+	return ret;
+}
+#endif
+
+std::vector<u8> AmfSegments::data() const {
+	if (parts.empty())
+		return buf;
+
+	std::vector<u8> ret;
+	ret.reserve(size());
+	for (const auto& segment : segments())
+		ret.insert(ret.end(), segment.first, segment.first + segment.second);
+
+	return ret;
+}
+
+std::vector<u8> AmfSegments::release() {
+	std::vector<u8> ret;
+	if (parts.empty())
+		ret.swap(buf);
+	else
+		ret = data();
+
+	clear();
+	return ret;
+}
+
+void AmfSegments::clear() {
+	buf.clear();
+	parts.clear();
+	flushed = 0;
+}
+
+} // namespace amf
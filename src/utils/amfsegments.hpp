@@ -0,0 +1,90 @@
+#pragma once
+#ifndef AMFSEGMENTS_HPP
+#define AMFSEGMENTS_HPP
+
+#include <limits>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
+
+#include "amf.hpp"
+
+namespace amf {
+
+// Serialized data made up of segments, which either point into a buffer
+// owned by this object, or directly to the payload of a large item (e.g. the
+// value of an AmfByteArray), which is then not copied at all. The segments
+// can be passed to writev/sendmsg through iovecs().
+//
+// Items whose payloads are referenced must not be modified or destroyed as
+// long as the segments are in use. See AmfItem::serialize.
+class AmfSegments {
+public:
+	// Payloads smaller than threshold are copied, since referencing them
+	// would cost more than copying.
+	explicit AmfSegments(size_t threshold = 64 * 1024) : threshold(threshold), flushed(0) { }
+
+	// Never references any payloads.
+	static AmfSegments contiguous() {
+		return AmfSegments(std::numeric_limits<size_t>::max());
+	}
+
+	void push_back(u8 byte) {
+		buf.push_back(byte);
+	}
+
+	void append(const std::vector<u8>& data) {
+		buf.insert(buf.end(), data.begin(), data.end());
+	}
+
+	template<typename It>
+	void append(It begin, It end) {
+		buf.insert(buf.end(), begin, end);
+	}
+
+	// Appends size bytes at data, referencing them if there are at least
+	// threshold many. Returns whether the data was referenced.
+	bool appendPayload(const u8* data, size_t size);
+
+	// Total number of bytes.
+	size_t size() const;
+
+	// The segments in order, as pointer and size. Only valid until the next
+	// modification.
+	std::vector<std::pair<const u8*, size_t>> segments() const;
+
+#ifndef _WIN32
+	std::vector<struct iovec> iovecs() const;
+#endif
+
+	// Copies all segments into a single buffer.
+	std::vector<u8> data() const;
+	// Same as data(), but doesn't copy anything if no payload was referenced.
+	// Leaves the segments empty.
+	std::vector<u8> release();
+
+	void clear();
+
+private:
+	struct Segment {
+		// Either points to a payload, or is null for a segment of buf.
+		const u8* data;
+		size_t offset;
+		size_t size;
+	};
+
+	size_t threshold;
+
+	std::vector<u8> buf;
+	// Only used once a payload is referenced. The bytes of buf after flushed
+	// are implicitly part of a final segment.
+	std::vector<Segment> parts;
+	size_t flushed;
+};
+
+} // namespace amf
+
+#endif
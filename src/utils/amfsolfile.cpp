@@ -0,0 +1,248 @@
+#include "amfsolfile.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#ifndef _WIN32
+	#include <dirent.h>
+#endif
+
+#include "deserializer.hpp"
+#include "types/amfstring.hpp"
+#include "utils/amfmappedfile.hpp"
+
+namespace amf {
+
+// TCSO signature and reserved bytes following the length of the file.
+static const u8 solSignature[] = { 'T', 'C', 'S', 'O', 0x00, 0x04, 0x00, 0x00, 0x00, 0x00 };
+static const uint32_t amf3Version = 3;
+
+// Reads the header of a .sol file and returns the name of the shared object.
+// Sets end to the end of the body as given by the header.
+static std::string readSolHeader(v8::const_iterator& it, v8::const_iterator& end) {
+	if (end - it < 2)
+		throw std::out_of_range("Not enough bytes for AmfSolFile");
+
+	if (*it++ != 0x00 || *it++ != 0xBF)
+		throw std::invalid_argument("AmfSolFile: Invalid magic number");
+
+	uint32_t length = read_network<uint32_t>(it, end);
+	if (static_cast<uint32_t>(end - it) < length)
+		throw std::out_of_range("Not enough bytes for AmfSolFile");
+	end = it + length;
+
+	if (end - it < static_cast<int>(sizeof(solSignature)))
+		throw std::out_of_range("Not enough bytes for AmfSolFile");
+
+	if (!std::equal(solSignature, solSignature + sizeof(solSignature), it))
+		throw std::invalid_argument("AmfSolFile: Invalid signature");
+	it += sizeof(solSignature);
+
+	uint16_t nameLength = read_network<uint16_t>(it, end);
+	if (end - it < nameLength)
+		throw std::out_of_range("Not enough bytes for AmfSolFile");
+
+	std::string name(it, it + nameLength);
+	it += nameLength;
+
+	if (read_network<uint32_t>(it, end) != amf3Version)
+		throw std::invalid_argument("AmfSolFile: Only AMF3 bodies are supported");
+
+	return name;
+}
+
+// Reads the next entry of the body, if there is one.
+static bool readSolEntry(v8::const_iterator& it, v8::const_iterator end,
+	SerializationContext& ctx, std::string& name, AmfItemPtr& value) {
+	if (it == end)
+		return false;
+
+	name = AmfString::deserializeValue(it, end, ctx);
+	value = Deserializer::deserialize(it, end, ctx);
+
+	// Every entry is followed by a padding byte.
+	if (it == end)
+		throw std::out_of_range("Not enough bytes for AmfSolFile");
+	++it;
+
+	return true;
+}
+
+// The decoders work on vectors, so the mapping is copied once, in a single
+// allocation of the right size.
+static v8 readFile(const std::string& path) {
+	AmfMappedFile file(path);
+	return v8(file.data(), file.data() + file.size());
+}
+
+bool AmfSolFile::operator==(const AmfSolFile& other) const {
+	if (name != other.name || entries.size() != other.entries.size())
+		return false;
+
+	for (size_t i = 0; i < entries.size(); ++i) {
+		if (entries[i].first != other.entries[i].first ||
+			!(entries[i].second == other.entries[i].second))
+			return false;
+	}
+
+	return true;
+}
+
+const AmfItemPtr& AmfSolFile::get(const std::string& name) const {
+	for (const auto& entry : entries) {
+		if (entry.first == name)
+			return entry.second;
+	}
+
+	throw std::out_of_range("AmfSolFile::get");
+}
+
+v8 AmfSolFile::serialize() const {
+	if (name.size() >= 65536)
+		throw std::length_error("AmfSolFile::serialize name too long");
+
+	SerializationContext ctx;
+	v8 body(solSignature, solSignature + sizeof(solSignature));
+
+	v8 nameLength = network_bytes<uint16_t>(name.size());
+	body.insert(body.end(), nameLength.begin(), nameLength.end());
+	body.insert(body.end(), name.begin(), name.end());
+
+	v8 version = network_bytes<uint32_t>(amf3Version);
+	body.insert(body.end(), version.begin(), version.end());
+
+	for (const auto& entry : entries) {
+		v8 entryName = AmfString(entry.first).serializeValue(ctx);
+		body.insert(body.end(), entryName.begin(), entryName.end());
+
+		v8 value = entry.second->serialize(ctx);
+		body.insert(body.end(), value.begin(), value.end());
+
+		body.push_back(0x00);
+	}
+
+	v8 buf { 0x00, 0xBF };
+	v8 length = network_bytes<uint32_t>(body.size());
+	buf.reserve(buf.size() + length.size() + body.size());
+	buf.insert(buf.end(), length.begin(), length.end());
+	buf.insert(buf.end(), body.begin(), body.end());
+
+	return buf;
+}
+
+AmfSolFile AmfSolFile::deserialize(v8::const_iterator& it, v8::const_iterator end) {
+	AmfSolFile ret(readSolHeader(it, end));
+
+	SerializationContext ctx;
+	std::string name;
+	AmfItemPtr value;
+	while (readSolEntry(it, end, ctx, name, value))
+		ret.entries.emplace_back(std::move(name), std::move(value));
+
+	return ret;
+}
+
+AmfSolFile AmfSolFile::load(const std::string& path) {
+	v8 data = readFile(path);
+	auto it = data.cbegin();
+	return deserialize(it, data.cend());
+}
+
+void AmfSolFile::save(const std::string& path) const {
+	v8 data = serialize();
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(data.data()), data.size());
+	if (!file)
+		throw std::runtime_error("AmfSolFile: Could not write " + path);
+}
+
+std::vector<std::pair<std::string, std::string>> AmfSolFile::loadAll(
+	const std::vector<std::string>& paths, Callback callback, unsigned int threads) {
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	threads = std::min<size_t>(threads, paths.size());
+
+	std::atomic<size_t> next(0);
+	std::mutex errorsMutex;
+	std::vector<std::pair<std::string, std::string>> errors;
+
+	auto work = [&]() {
+		for (size_t i = next++; i < paths.size(); i = next++) {
+			AmfSolFile file;
+			try {
+				file = load(paths[i]);
+			} catch (const std::exception& e) {
+				std::lock_guard<std::mutex> lock(errorsMutex);
+				errors.emplace_back(paths[i], e.what());
+				continue;
+			}
+
+			callback(paths[i], file);
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (unsigned int i = 1; i < threads; ++i)
+		workers.emplace_back(work);
+	// The calling thread does its share of the work as well.
+	work();
+
+	for (std::thread& worker : workers)
+		worker.join();
+
+	std::sort(errors.begin(), errors.end());
+	return errors;
+}
+
+std::vector<std::string> AmfSolFile::list(const std::string& directory) {
+	std::vector<std::string> ret;
+
+#ifdef _WIN32
+	throw std::runtime_error("AmfSolFile::list is not supported on Windows");
+#else
+	DIR* dir = opendir(directory.c_str());
+	if (dir == nullptr)
+		throw std::runtime_error("AmfSolFile: Could not open " + directory);
+
+	while (dirent* entry = readdir(dir)) {
+		std::string name(entry->d_name);
+		if (name.size() > 4 && name.compare(name.size() - 4, 4, ".sol") == 0)
+			ret.push_back(directory + "/" + name);
+	}
+	closedir(dir);
+#endif
+
+	std::sort(ret.begin(), ret.end());
+	return ret;
+}
+
+AmfSolReader::AmfSolReader(const std::string& path) : data(readFile(path)) {
+	readHeader();
+}
+
+AmfSolReader::AmfSolReader(v8 data) : data(std::move(data)) {
+	readHeader();
+}
+
+void AmfSolReader::readHeader() {
+	auto it = data.cbegin();
+	auto end = data.cend();
+	solName = readSolHeader(it, end);
+
+	pos = it - data.cbegin();
+	// Ignore trailing bytes after the length given in the header.
+	data.resize(end - data.cbegin());
+}
+
+bool AmfSolReader::next(std::string& name, AmfItemPtr& value) {
+	auto it = data.cbegin() + pos;
+	bool ret = readSolEntry(it, data.cend(), ctx, name, value);
+	pos = it - data.cbegin();
+	return ret;
+}
+
+} // namespace amf
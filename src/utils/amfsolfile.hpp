@@ -0,0 +1,82 @@
+#pragma once
+#ifndef AMFSOLFILE_HPP
+#define AMFSOLFILE_HPP
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "amf.hpp"
+#include "serializationcontext.hpp"
+#include "utils/amfitemptr.hpp"
+
+namespace amf {
+
+// A Flash Local Shared Object, i.e. the contents of a .sol file: a name and a
+// list of named values. Only files with an AMF3 body are supported.
+class AmfSolFile {
+public:
+	AmfSolFile() { }
+	explicit AmfSolFile(std::string name) : name(name) { }
+
+	bool operator==(const AmfSolFile& other) const;
+	bool operator!=(const AmfSolFile& other) const {
+		return !(*this == other);
+	}
+
+	template<class T>
+	void add(std::string name, T&& value) {
+		entries.emplace_back(name, AmfItemPtr(new typename std::decay<T>::type(std::forward<T>(value))));
+	}
+
+	// Returns the value of the first entry with the given name.
+	const AmfItemPtr& get(const std::string& name) const;
+
+	v8 serialize() const;
+	static AmfSolFile deserialize(v8::const_iterator& it, v8::const_iterator end);
+
+	static AmfSolFile load(const std::string& path);
+	void save(const std::string& path) const;
+
+	// Loads the given files on up to threads threads and calls callback for
+	// each of them, possibly concurrently. Files that can't be read are
+	// skipped and returned together with the error message.
+	typedef std::function<void(const std::string& path, AmfSolFile& file)> Callback;
+	static std::vector<std::pair<std::string, std::string>> loadAll(
+		const std::vector<std::string>& paths, Callback callback, unsigned int threads = 0);
+
+	// Returns the paths of all .sol files in the given directory, sorted.
+	static std::vector<std::string> list(const std::string& directory);
+
+	std::string name;
+	std::vector<std::pair<std::string, AmfItemPtr>> entries;
+};
+
+// Decodes the entries of a .sol file one at a time, as they are requested.
+class AmfSolReader {
+public:
+	// Maps the file at path into memory and reads its header.
+	explicit AmfSolReader(const std::string& path);
+	explicit AmfSolReader(v8 data);
+
+	const std::string& name() const {
+		return solName;
+	}
+
+	// Decodes the next entry into name and value. Returns false once all
+	// entries were read.
+	bool next(std::string& name, AmfItemPtr& value);
+
+private:
+	void readHeader();
+
+	v8 data;
+	size_t pos;
+	std::string solName;
+	SerializationContext ctx;
+};
+
+} // namespace amf
+
+#endif
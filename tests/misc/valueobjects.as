@@ -0,0 +1,44 @@
+package de.ventero.amftest {
+	import flash.net.registerClassAlias;
+	import flash.utils.ByteArray;
+
+	[RemoteClass(alias="de.ventero.AmfTest.Point")]
+	public class Point {
+		public var x:int;
+		public var y:Number = 0.5;
+		// not serialized
+		public static var origin:Point = new Point();
+		private var cache:String;
+
+		public function Point(x:int = 0, y:Number = 0) {
+			this.x = x;
+			this.y = y;
+		}
+	}
+
+	[RemoteClass(alias="de.ventero.AmfTest.Shape")]
+	public dynamic class Shape {
+		public var name:String;
+		public var visible:Boolean = true;
+		public var id:uint;
+		public var origin:Point;
+		public var data:ByteArray;
+		[Transient]
+		public var selected:Boolean;
+
+		private var _tags:Array;
+
+		public function get tags():Array {
+			return _tags;
+		}
+
+		public function set tags(value:Array):void {
+			_tags = value;
+		}
+
+		// read-only accessors are not serialized
+		public function get area():Number {
+			return 0;
+		}
+	}
+}
@@ -0,0 +1,212 @@
+// Generated by amfgen from valueobjects.as. Do not edit.
+#pragma once
+#ifndef VALUEOBJECTS_HPP
+#define VALUEOBJECTS_HPP
+
+#include <string>
+#include <vector>
+
+#include "amf.hpp"
+#include "serializationcontext.hpp"
+#include "types/amfitem.hpp"
+#include "utils/amfcodegen.hpp"
+#include "utils/amfitemptr.hpp"
+#include "utils/amfobjecttraits.hpp"
+
+namespace amftest {
+
+class Point;
+class Shape;
+
+class Point : public amf::AmfItem {
+public:
+	Point() :
+		x(0), y(0.5) { }
+
+	bool operator==(const amf::AmfItem& other) const;
+	amf::v8 serialize(amf::SerializationContext& ctx) const;
+	static amf::AmfItemPtr deserializePtr(amf::v8::const_iterator& it, amf::v8::const_iterator end, amf::SerializationContext& ctx);
+	static Point deserialize(amf::v8::const_iterator& it, amf::v8::const_iterator end, amf::SerializationContext& ctx);
+
+	static const amf::AmfObjectTraits& traits();
+
+	int x;
+	double y;
+};
+
+class Shape : public amf::AmfItem {
+public:
+	Shape() :
+		visible(true), id(0) { }
+
+	bool operator==(const amf::AmfItem& other) const;
+	amf::v8 serialize(amf::SerializationContext& ctx) const;
+	static amf::AmfItemPtr deserializePtr(amf::v8::const_iterator& it, amf::v8::const_iterator end, amf::SerializationContext& ctx);
+	static Shape deserialize(amf::v8::const_iterator& it, amf::v8::const_iterator end, amf::SerializationContext& ctx);
+
+	static const amf::AmfObjectTraits& traits();
+
+	std::string name;
+	bool visible;
+	unsigned int id;
+	amf::AmfItemPtr origin;
+	amf::AmfItemPtr data;
+	amf::AmfItemPtr tags;
+};
+
+inline const amf::AmfObjectTraits& Point::traits() {
+	static const amf::AmfObjectTraits traits = [] {
+		amf::AmfObjectTraits t("de.ventero.AmfTest.Point", false, false);
+		t.attributes.push_back("x");
+		t.attributes.push_back("y");
+		return t;
+	}();
+
+	return traits;
+}
+
+inline bool Point::operator==(const amf::AmfItem& other) const {
+	const Point* p = dynamic_cast<const Point*>(&other);
+	return p != nullptr &&
+		x == p->x &&
+		y == p->y;
+}
+
+inline amf::v8 Point::serialize(amf::SerializationContext& ctx) const {
+	amf::v8 buf = amf::AmfCodegen::writeReference(*this, ctx);
+	if (!buf.empty())
+		return buf;
+
+	amf::AmfCodegen::writeHeader(buf, traits(), ctx);
+	amf::AmfCodegen::writeInt(buf, x, ctx);
+	amf::AmfCodegen::writeDouble(buf, y, ctx);
+
+	return buf;
+}
+
+inline amf::AmfItemPtr Point::deserializePtr(amf::v8::const_iterator& it, amf::v8::const_iterator end, amf::SerializationContext& ctx) {
+	amf::AmfCodegen::Header header = amf::AmfCodegen::readHeader(it, end, ctx,
+		traits().className, traits().attributes);
+	if (header.reference != -1)
+		return ctx.getPointer<Point>(header.reference);
+
+	Point* ret = new Point();
+	amf::AmfItemPtr ptr(ret);
+	ctx.addPointer(ptr);
+
+	if (header.inOrder) {
+		ret->x = amf::AmfCodegen::readInt(it, end, ctx);
+		ret->y = amf::AmfCodegen::readDouble(it, end, ctx);
+	} else {
+		for (const std::string& name : header.attributes) {
+			if (name == "x")
+				ret->x = amf::AmfCodegen::readInt(it, end, ctx);
+			else if (name == "y")
+				ret->y = amf::AmfCodegen::readDouble(it, end, ctx);
+			else
+				amf::AmfCodegen::readItem(it, end, ctx);
+		}
+	}
+
+	if (header.dynamic)
+		amf::AmfCodegen::skipDynamicMembers(it, end, ctx);
+
+	return ptr;
+}
+
+inline Point Point::deserialize(amf::v8::const_iterator& it, amf::v8::const_iterator end, amf::SerializationContext& ctx) {
+	return deserializePtr(it, end, ctx).as<Point>();
+}
+
+inline const amf::AmfObjectTraits& Shape::traits() {
+	static const amf::AmfObjectTraits traits = [] {
+		amf::AmfObjectTraits t("de.ventero.AmfTest.Shape", true, false);
+		t.attributes.push_back("name");
+		t.attributes.push_back("visible");
+		t.attributes.push_back("id");
+		t.attributes.push_back("origin");
+		t.attributes.push_back("data");
+		t.attributes.push_back("tags");
+		return t;
+	}();
+
+	return traits;
+}
+
+inline bool Shape::operator==(const amf::AmfItem& other) const {
+	const Shape* p = dynamic_cast<const Shape*>(&other);
+	return p != nullptr &&
+		name == p->name &&
+		visible == p->visible &&
+		id == p->id &&
+		amf::AmfCodegen::equal(origin, p->origin) &&
+		amf::AmfCodegen::equal(data, p->data) &&
+		amf::AmfCodegen::equal(tags, p->tags);
+}
+
+inline amf::v8 Shape::serialize(amf::SerializationContext& ctx) const {
+	amf::v8 buf = amf::AmfCodegen::writeReference(*this, ctx);
+	if (!buf.empty())
+		return buf;
+
+	amf::AmfCodegen::writeHeader(buf, traits(), ctx);
+	amf::AmfCodegen::writeString(buf, name, ctx);
+	amf::AmfCodegen::writeBool(buf, visible, ctx);
+	amf::AmfCodegen::writeUint(buf, id, ctx);
+	amf::AmfCodegen::writeItem(buf, origin, ctx);
+	amf::AmfCodegen::writeItem(buf, data, ctx);
+	amf::AmfCodegen::writeItem(buf, tags, ctx);
+	amf::AmfCodegen::writeDynamicEnd(buf);
+
+	return buf;
+}
+
+inline amf::AmfItemPtr Shape::deserializePtr(amf::v8::const_iterator& it, amf::v8::const_iterator end, amf::SerializationContext& ctx) {
+	amf::AmfCodegen::Header header = amf::AmfCodegen::readHeader(it, end, ctx,
+		traits().className, traits().attributes);
+	if (header.reference != -1)
+		return ctx.getPointer<Shape>(header.reference);
+
+	Shape* ret = new Shape();
+	amf::AmfItemPtr ptr(ret);
+	ctx.addPointer(ptr);
+
+	if (header.inOrder) {
+		ret->name = amf::AmfCodegen::readString(it, end, ctx);
+		ret->visible = amf::AmfCodegen::readBool(it, end, ctx);
+		ret->id = amf::AmfCodegen::readUint(it, end, ctx);
+		ret->origin = amf::AmfCodegen::readObject<Point>(it, end, ctx);
+		ret->data = amf::AmfCodegen::readItem(it, end, ctx);
+		ret->tags = amf::AmfCodegen::readItem(it, end, ctx);
+	} else {
+		for (const std::string& name : header.attributes) {
+			if (name == "name")
+				ret->name = amf::AmfCodegen::readString(it, end, ctx);
+			else if (name == "visible")
+				ret->visible = amf::AmfCodegen::readBool(it, end, ctx);
+			else if (name == "id")
+				ret->id = amf::AmfCodegen::readUint(it, end, ctx);
+			else if (name == "origin")
+				ret->origin = amf::AmfCodegen::readObject<Point>(it, end, ctx);
+			else if (name == "data")
+				ret->data = amf::AmfCodegen::readItem(it, end, ctx);
+			else if (name == "tags")
+				ret->tags = amf::AmfCodegen::readItem(it, end, ctx);
+			else
+				amf::AmfCodegen::readItem(it, end, ctx);
+		}
+	}
+
+	if (header.dynamic)
+		amf::AmfCodegen::skipDynamicMembers(it, end, ctx);
+
+	return ptr;
+}
+
+inline Shape Shape::deserialize(amf::v8::const_iterator& it, amf::v8::const_iterator end, amf::SerializationContext& ctx) {
+	return deserializePtr(it, end, ctx).as<Shape>();
+}
+
+} // namespace amftest
+
+#endif
@@ -1,9 +1,15 @@
 #include "amftest.hpp"
 
+#include "deserializer.hpp"
 #include "serializationcontext.hpp"
+#include "serializer.hpp"
+#include "types/amfarray.hpp"
+#include "types/amfbytearray.hpp"
 #include "types/amfinteger.hpp"
 #include "types/amfnull.hpp"
+#include "types/amfobject.hpp"
 #include "types/amfdouble.hpp"
+#include "types/amfstring.hpp"
 
 TEST(SerializationContext, String) {
 	SerializationContext ctx;
@@ -39,6 +45,59 @@ TEST(SerializationContext, ObjectTraits) {
 	ASSERT_THROW(ctx.getTraits(2), std::out_of_range);
 }
 
+TEST(SerializationContext, TraitsPlan) {
+	SerializationContext ctx;
+
+	AmfObjectTraits o1("foo", false, false);
+	o1.attributes = { "b", "a", "b" };
+	EXPECT_EQ(nullptr, ctx.getPlan(o1));
+
+	ctx.addTraits(AmfObjectTraits("bar", true, false));
+	ctx.addTraits(o1);
+	const TraitsPlan* plan = ctx.getPlan(o1);
+	ASSERT_NE(nullptr, plan);
+	EXPECT_EQ((std::vector<std::string> { "a", "b" }), plan->attributes);
+	EXPECT_EQ((v8 { 0x05 }), plan->reference);
+	// Plans are only built once.
+	EXPECT_EQ(plan, ctx.getPlan(o1));
+
+	// Equal traits are always referenced through the first index.
+	ctx.addTraits(o1);
+	EXPECT_EQ(1, ctx.getIndex(o1));
+	EXPECT_EQ(plan, ctx.getPlan(o1));
+
+	ctx.clear();
+	EXPECT_EQ(nullptr, ctx.getPlan(o1));
+}
+
+TEST(SerializationContext, DecodePlan) {
+	SerializationContext ctx;
+	ASSERT_THROW(ctx.getPlan(0), std::out_of_range);
+
+	AmfObjectTraits o1("foo", false, false);
+	o1.attributes = { "b", "a", "b" };
+	AmfObjectTraits o2("bar", true, false);
+	o2.attributes = { "a", "b" };
+	ctx.addTraits(o1);
+	ctx.addTraits(o2);
+
+	const TraitsPlan& p1 = ctx.getPlan(0);
+	EXPECT_EQ(o1, *p1.traits);
+	EXPECT_FALSE(p1.inOrder);
+	EXPECT_EQ((std::vector<size_t> { 1, 0, 1 }), p1.slots);
+	EXPECT_EQ(ctx.getPlan(o1), &p1);
+
+	const TraitsPlan& p2 = ctx.getPlan(1);
+	EXPECT_EQ(o2, *p2.traits);
+	EXPECT_TRUE(p2.inOrder);
+	EXPECT_EQ((std::vector<size_t> { 0, 1 }), p2.slots);
+	EXPECT_EQ((v8 { 0x05 }), p2.reference);
+
+	// Copies of a context share the (immutable) plans.
+	SerializationContext copy(ctx);
+	EXPECT_EQ(p2.traits, copy.getPlan(1).traits);
+}
+
 TEST(SerializationContext, Item) {
 	SerializationContext ctx;
 
@@ -108,4 +167,109 @@ TEST(SerializationContext, Clear) {
 	ASSERT_THROW(ctx.getString(0), std::out_of_range);
 	ASSERT_THROW(ctx.getTraits(0), std::out_of_range);
 	ASSERT_THROW(ctx.getObject<AmfNull>(0), std::out_of_range);
+
+	// Lookups work again after clearing.
+	ctx.addString("bar");
+	ctx.addObject(AmfDouble(1.0));
+	ASSERT_EQ(0, ctx.getIndex(std::string("bar")));
+	ASSERT_EQ(0, ctx.getIndex(AmfDouble(1.0)));
+	ASSERT_EQ(-1, ctx.getIndex(AmfInteger(17)));
+}
+
+TEST(SerializationContext, ObjectIndex) {
+	SerializationContext ctx;
+	AmfArray a1(std::vector<AmfInteger> { 1, 2 });
+	AmfArray a2(std::vector<AmfInteger> { 3 });
+
+	ASSERT_EQ(-1, ctx.getIndex(a1));
+	ASSERT_FALSE(ctx.hasObject(a1));
+
+	ctx.addObject(a1);
+	ctx.addPointer(AmfItemPtr());
+	ctx.addObject(AmfString("foo"));
+	ctx.addObject(a2);
+	// Only the first of several equal objects is referenced.
+	ctx.addObject(a1);
+
+	ASSERT_EQ(0, ctx.getIndex(a1));
+	ASSERT_EQ(3, ctx.getIndex(a2));
+	ASSERT_EQ(-1, ctx.getIndex(AmfArray(std::vector<AmfInteger> { 2, 1 })));
+	ASSERT_TRUE(ctx.hasObject(a2));
+	ASSERT_TRUE(ctx.hasObject(AmfString("foo")));
+	ASSERT_FALSE(ctx.hasObject(AmfString("bar")));
+
+	// Objects added after the first lookup are found as well.
+	ctx.addObject(AmfDouble(0.5));
+	ASSERT_EQ(5, ctx.getIndex(AmfDouble(0.5)));
+	ASSERT_TRUE(ctx.hasObject(AmfDouble(0.5)));
+
+	// Indices are per type, even for equal hashes.
+	ctx.addObject(AmfNull());
+	ASSERT_EQ(6, ctx.getIndex(AmfNull()));
+}
+
+TEST(SerializationContext, ChunkedValues) {
+	v8 payload(10);
+	for (size_t i = 0; i < payload.size(); ++i)
+		payload[i] = static_cast<u8>(i);
+
+	AmfObject obj("", true, false);
+	obj.addDynamicProperty("data", AmfByteArray(payload));
+	obj.addDynamicProperty("name", AmfString("0123456789"));
+	obj.addDynamicProperty("small", AmfString("foo"));
+	obj.addDynamicProperty("reference", AmfString("0123456789"));
+
+	Serializer serializer;
+	serializer << obj;
+	v8 data = serializer.data();
+
+	std::vector<AmfChunk> chunks;
+	std::vector<v8> contents;
+	SerializationContext ctx;
+	ctx.setChunkSink(10, [&](const AmfChunk& chunk) {
+		// Data points into the input.
+		EXPECT_GE(chunk.data, data.data());
+		EXPECT_LE(chunk.data + chunk.size, data.data() + data.size());
+		chunks.push_back(chunk);
+		contents.emplace_back(chunk.data, chunk.data + chunk.size);
+	}, 4);
+
+	auto it = data.cbegin();
+	AmfItemPtr ptr = Deserializer::deserialize(it, data.cend(), ctx);
+	EXPECT_EQ(data.cend(), it);
+
+	// Property values are serialized sorted by name, "reference" is a reference.
+	ASSERT_EQ(6u, chunks.size());
+	v8 streamed, name;
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		const AmfChunk& chunk = chunks[i];
+		EXPECT_EQ(10u, chunk.total);
+		EXPECT_EQ(i < 3 ? 0u : 1u, chunk.id);
+		EXPECT_EQ(i < 3 ? AMF_BYTEARRAY : AMF_STRING, chunk.marker);
+		EXPECT_EQ((i % 3) * 4, chunk.offset);
+		EXPECT_EQ(i % 3 == 2 ? 2u : 4u, chunk.size);
+		EXPECT_EQ(i % 3 == 2, chunk.last());
+
+		v8& target = i < 3 ? streamed : name;
+		target.insert(target.end(), contents[i].begin(), contents[i].end());
+	}
+	EXPECT_EQ(payload, streamed);
+	EXPECT_EQ("0123456789", std::string(name.begin(), name.end()));
+
+	// Chunked values are left empty, smaller ones are decoded as usual.
+	AmfObject& result = ptr.as<AmfObject>();
+	EXPECT_EQ(AmfByteArray(), result.getDynamicProperty<AmfByteArray>("data"));
+	EXPECT_EQ(AmfString(""), result.getDynamicProperty<AmfString>("name"));
+	EXPECT_EQ(AmfString(""), result.getDynamicProperty<AmfString>("reference"));
+	EXPECT_EQ(AmfString("foo"), result.getDynamicProperty<AmfString>("small"));
+
+	// Ids restart after clearing, the sink stays set.
+	ctx.clear();
+	chunks.clear();
+	it = data.cbegin();
+	Deserializer::deserialize(it, data.cend(), ctx);
+	ASSERT_EQ(6u, chunks.size());
+	EXPECT_EQ(0u, chunks[0].id);
+
+	EXPECT_THROW(ctx.setChunkSink(8, [](const AmfChunk&) { }, 0), std::invalid_argument);
 }
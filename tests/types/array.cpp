@@ -299,19 +299,28 @@ TEST(ArrayEquality, MixedTypes) {
 	EXPECT_NE(a0, v2);
 }
 
-// Stack overflow when comparing ptr and ptr2
-// should use ecmascript equality semantics instead (reference comparison
-// for object types, value comparison for primitives)?
-TEST(ArrayEquality, DISABLED_SelfReference) {
+TEST(ArrayEquality, SelfReference) {
 	AmfItemPtr ptr((AmfArray()));
 	ptr.as<AmfArray>().dense.push_back(ptr);
 
 	EXPECT_EQ(ptr, ptr);
 
+	// Equality is structural, and both arrays contain nothing but themselves.
 	AmfItemPtr ptr2((AmfArray()));
 	ptr2.as<AmfArray>().dense.push_back(ptr2);
 
-	EXPECT_NE(ptr, ptr2);
+	EXPECT_EQ(ptr, ptr2);
+
+	AmfItemPtr ptr3((AmfArray()));
+	ptr3.as<AmfArray>().dense.push_back(ptr3);
+	ptr3.as<AmfArray>().dense.push_back(ptr3);
+
+	EXPECT_NE(ptr, ptr3);
+
+	// Break the cycles.
+	ptr.as<AmfArray>().dense.clear();
+	ptr2.as<AmfArray>().dense.clear();
+	ptr3.as<AmfArray>().dense.clear();
 }
 
 static void deserializesTo(AmfArray value, const v8& data, int left = 0,
@@ -590,3 +599,28 @@ TEST(ArrayDeserialization, ArrayReferenceOrder) {
 	ASSERT_EQ(arr.dense.at(1), deserialized);
 	ASSERT_EQ(arr.associative.at("y"), arr.dense.at(0));
 }
+
+TEST(ArrayMember, MoveElements) {
+	v8 data(1024, 0xab);
+	const u8* p = data.data();
+	std::string str(1024, 'x');
+	const char* s = str.data();
+
+	AmfArray array;
+	array.push_back(AmfByteArray(std::move(data)));
+	array.insert("str", AmfString(std::move(str)));
+	EXPECT_EQ(p, array.at<AmfByteArray>(0).value.data());
+	EXPECT_EQ(s, array.at<AmfString>("str").value.data());
+
+	std::vector<AmfByteArray> dense;
+	dense.emplace_back(v8(1024, 0xcd));
+	p = dense[0].value.data();
+	AmfArray fromVector(std::move(dense));
+	EXPECT_EQ(p, fromVector.at<AmfByteArray>(0).value.data());
+
+	// Lvalues are still copied.
+	AmfByteArray ba(v8 { 1, 2, 3 });
+	array.push_back(ba);
+	EXPECT_NE(ba.value.data(), array.at<AmfByteArray>(1).value.data());
+	EXPECT_EQ(ba, array.at<AmfByteArray>(1));
+}
@@ -3,6 +3,8 @@
 #include <array>
 
 #include "amf.hpp"
+#include "deserializer.hpp"
+#include "deserializer.hpp"
 #include "types/amfarray.hpp"
 #include "types/amfbytearray.hpp"
 #include "types/amfinteger.hpp"
@@ -153,3 +155,32 @@ TEST(ByteArrayDeserialization, ObjectReferences) {
 	deserializesTo({1, 2, 3}, {0x0c, 0x00}, 0, &ctx);
 	deserializesTo({4, 5, 6}, {0x0c, 0x02}, 0, &ctx);
 }
+
+TEST(ByteArrayMove, DataIsNotCopied) {
+	v8 data(1024, 0xab);
+	const u8* p = data.data();
+
+	AmfByteArray ba(std::move(data));
+	EXPECT_EQ(p, ba.value.data());
+
+	AmfByteArray moved(std::move(ba));
+	EXPECT_EQ(p, moved.value.data());
+
+	AmfByteArray assigned;
+	assigned = std::move(moved);
+	EXPECT_EQ(p, assigned.value.data());
+
+	AmfItemPtr ptr(std::move(assigned));
+	EXPECT_EQ(p, ptr.as<AmfByteArray>().value.data());
+}
+
+TEST(ByteArrayMove, DeserializerSharesWithContext) {
+	v8 data { 0x0c, 0x07, 0x01, 0x02, 0x03, 0x0c, 0x00 };
+	SerializationContext ctx;
+	auto it = data.cbegin();
+	AmfItemPtr ptr = Deserializer::deserialize(it, data.cend(), ctx);
+	EXPECT_EQ(AmfByteArray(v8 { 1, 2, 3 }), ptr.as<AmfByteArray>());
+	EXPECT_EQ(ctx.getPointer<AmfByteArray>(0).get(), ptr.get());
+	EXPECT_EQ(ptr.get(), Deserializer::deserialize(it, data.cend(), ctx).get());
+	EXPECT_EQ(data.cend(), it);
+}
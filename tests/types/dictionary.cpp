@@ -4,6 +4,7 @@
 #include "types/amfarray.hpp"
 #include "types/amfbytearray.hpp"
 #include "types/amfbool.hpp"
+#include "types/amfdate.hpp"
 #include "types/amfdictionary.hpp"
 #include "types/amfdouble.hpp"
 #include "types/amfinteger.hpp"
@@ -477,6 +478,92 @@ TEST(DictionarySerialization, DifferentPropertiesNoReference) {
 	isEqual({ 0x11, 0x04 }, d3.serialize(ctx));
 }
 
+TEST(DictionaryLookup, At) {
+	AmfDictionary d(false, false);
+	d.insert(AmfInteger(1), AmfString("foo"));
+	d.insert(AmfString("1"), AmfString("bar"));
+
+	EXPECT_EQ("foo", d.at<AmfString>(AmfInteger(1)).value);
+	EXPECT_EQ("bar", d.at<AmfString>(AmfString("1")).value);
+	EXPECT_THROW(d.at<AmfString>(AmfDouble(1)), std::out_of_range);
+	EXPECT_THROW(d.at<AmfString>(AmfNull()), std::out_of_range);
+	// Failed lookups don't add any entries.
+	EXPECT_EQ(2u, d.values.size());
+
+	d.at<AmfString>(AmfInteger(1)).value = "baz";
+	const AmfDictionary& cd = d;
+	EXPECT_EQ("baz", cd.at<AmfString>(AmfInteger(1)).value);
+}
+
+static AmfObject objectKey(int i) {
+	AmfObject key("foo", true, false);
+	key.addSealedProperty("id", AmfInteger(i));
+	key.addDynamicProperty("data", AmfArray(std::vector<AmfInteger> { i, i + 1 }));
+	return key;
+}
+
+TEST(DictionaryLookup, ObjectKeys) {
+	AmfDictionary d(false, false);
+	for (int i = 0; i < 100; ++i)
+		d.insert(objectKey(i), AmfInteger(i));
+	EXPECT_EQ(100u, d.values.size());
+
+	for (int i = 0; i < 100; ++i) {
+		EXPECT_EQ(i, d.at<AmfInteger>(objectKey(i)).value);
+
+		// Overwriting an entry keeps the existing key.
+		d.insert(objectKey(i), AmfInteger(-i));
+	}
+	EXPECT_EQ(100u, d.values.size());
+	EXPECT_EQ(-5, d.at<AmfInteger>(objectKey(5)).value);
+	EXPECT_THROW(d.at<AmfInteger>(objectKey(100)), std::out_of_range);
+}
+
+TEST(DictionaryLookup, StructuralHash) {
+	// Items comparing equal have to hash equally.
+	EXPECT_EQ(AmfDouble(0.0).hash(), AmfDouble(-0.0).hash());
+	EXPECT_EQ(AmfString("foo").hash(), AmfString(std::string("foo")).hash());
+	EXPECT_EQ(AmfDate(1234).hash(), AmfDate(1234).hash());
+	EXPECT_EQ(AmfByteArray(v8 { 1, 2 }).hash(), AmfByteArray(v8 { 1, 2 }).hash());
+	EXPECT_EQ(AmfVector<double>({ 0.0 }).hash(), AmfVector<double>({ -0.0 }).hash());
+
+	AmfObject o1("foo", true, false);
+	o1.addSealedProperty("a", AmfInteger(1));
+	AmfObject o2 = o1;
+	// Dynamic properties are not compared on sealed objects.
+	AmfObject s1("foo", false, false), s2("foo", false, false);
+	s1.addDynamicProperty("x", AmfNull());
+	EXPECT_EQ(s1, s2);
+	EXPECT_EQ(s1.hash(), s2.hash());
+
+	AmfVector<AmfObject> v1({ o1 }, "foo");
+	AmfVector<AmfItem> v2("foo");
+	v2.values.emplace_back(new AmfObject(o2));
+	EXPECT_EQ(v2, v1);
+	EXPECT_EQ(v2.hash(), v1.hash());
+
+	// Values are part of the hash, so keys of the same type don't all collide.
+	o2.addDynamicProperty("b", AmfInteger(2));
+	EXPECT_NE(o1.hash(), o2.hash());
+	EXPECT_NE(AmfInteger(1).hash(), AmfInteger(2).hash());
+	EXPECT_NE(AmfArray(std::vector<AmfInteger> { 1 }).hash(), AmfArray(std::vector<AmfInteger> { 2 }).hash());
+}
+
+TEST(DictionaryLookup, SelfReferentialKey) {
+	// Hashing nested items stops at a fixed depth, so hashing terminates.
+	AmfItemPtr ptr(new AmfArray());
+	ptr.as<AmfArray>().dense.push_back(ptr);
+	ptr.as<AmfArray>().dense.push_back(ptr);
+	EXPECT_EQ(ptr->hash(), ptr->hash());
+
+	AmfDictionary d(false, false);
+	d.values[ptr] = AmfItemPtr(new AmfNull());
+	EXPECT_EQ(AmfNull(), d.values.at(ptr).as<AmfNull>());
+
+	// Break the cycle.
+	ptr.as<AmfArray>().dense.clear();
+}
+
 TEST(DictionaryEquality, EmptyDictionary) {
 	AmfDictionary d0(true);
 	AmfDictionary d1(true, false);
@@ -732,8 +819,7 @@ TEST(DictionaryDeserialization, SelfReference2) {
 	EXPECT_EQ(ptr.get(), inner.get());
 }
 
-TEST(DictionaryDeserialization, DISABLED_SelfReference2b) {
-	// TODO: segfault due to AmfDictionaryHash
+TEST(DictionaryDeserialization, SelfReference2b) {
 	v8 data {
 		0x11,
 		0x05,
@@ -753,8 +839,7 @@ TEST(DictionaryDeserialization, DISABLED_SelfReference2b) {
 	EXPECT_EQ(AmfUndefined(), inner2.as<AmfUndefined>());
 }
 
-// Broken due to AmfDictionaryHash recursing
-TEST(DictionaryDeserialization, DISABLED_SelfReference3) {
+TEST(DictionaryDeserialization, SelfReference3) {
 	v8 data {
 		0x11, 0x05, 0x00,
 		0x11, 0x00,
@@ -766,4 +851,10 @@ TEST(DictionaryDeserialization, DISABLED_SelfReference3) {
 	SerializationContext ctx;
 	auto it = data.cbegin();
 	AmfItemPtr ptr = AmfDictionary::deserializePtr(it, data.cend(), ctx);
+	EXPECT_EQ(data.cend(), it);
+
+	// Both entries use the dictionary itself as key.
+	AmfDictionary & d = ptr.as<AmfDictionary>();
+	ASSERT_EQ(1u, d.values.size());
+	EXPECT_EQ(AmfUndefined(), d.values.at(ptr).as<AmfUndefined>());
 }
@@ -1,5 +1,8 @@
 #include "amftest.hpp"
 
+#include <atomic>
+#include <thread>
+
 #include "amf.hpp"
 #include "deserializer.hpp"
 #include "types/amfarray.hpp"
@@ -490,6 +493,27 @@ TEST(ObjectSerialization, ExternalizableTraitsReference) {
 	isEqual(data, array);
 }
 
+TEST(ObjectSerialization, LargeTraitsReference) {
+	SerializationContext ctx;
+	for (int i = 0; i < 70; ++i) {
+		AmfObject obj("c" + std::to_string(i), false, false);
+		obj.serialize(ctx);
+	}
+
+	AmfObject obj("c65", false, false);
+	obj.addSealedProperty("x", AmfInteger(1));
+	AmfObject ref("c65", false, false);
+	ref.addSealedProperty("x", AmfInteger(2));
+	obj.serialize(ctx);
+
+	isEqual(v8 {
+		0x0a,
+		// U29O-traits-ref to index 70, 70 << 2 | 1 = 0x119
+		0x82, 0x19,
+		0x04, 0x02
+	}, ref, &ctx);
+}
+
 TEST(ObjectSerialization, SelfReference) {
 	AmfItemPtr ptr(AmfObject("", true, false));
 	ptr.as<AmfObject>().dynamicProperties["f"] = ptr;
@@ -827,6 +851,56 @@ TEST(ObjectDeserialization, DuplicateSealedPropertiesTraitsReference) {
 	deserialize(o1, data_ref, 0, &ctx);
 }
 
+TEST(ObjectDeserialization, SharedTraits) {
+	v8 data {
+		0x0a, 0x23, 0x01,
+		0x03, 0x61, 0x03, 0x62,
+		0x04, 0x01, 0x04, 0x02,
+		0x0a, 0x01,
+		0x04, 0x03, 0x04, 0x04
+	};
+
+	SerializationContext ctx;
+	auto it = data.cbegin();
+	AmfObject o1 = AmfObject::deserialize(it, data.cend(), ctx);
+	AmfObject o2 = AmfObject::deserialize(it, data.cend(), ctx);
+	EXPECT_EQ(data.cend(), it);
+
+	EXPECT_EQ(&o1.objectTraits(), &o2.objectTraits());
+	EXPECT_EQ(&ctx.getPlan(0).traits->attributes, &o1.objectTraits().attributes);
+	EXPECT_EQ(3, o2.getSealedProperty<AmfInteger>("a").value);
+	EXPECT_EQ(4, o2.getSealedProperty<AmfInteger>("b").value);
+
+	// Modifying the traits of one object must not affect the others.
+	o2.addSealedProperty("c", AmfNull());
+	EXPECT_NE(&o1.objectTraits(), &o2.objectTraits());
+	EXPECT_EQ((std::vector<std::string> { "a", "b" }), o1.objectTraits().attributes);
+	EXPECT_EQ((std::vector<std::string> { "a", "b" }), ctx.getTraits(0).attributes);
+	EXPECT_EQ((std::vector<std::string> { "a", "b", "c" }), o2.objectTraits().attributes);
+}
+
+TEST(ObjectDeserialization, HomogeneousArray) {
+	// Sealed names are sent out of order, so the values have to be moved to
+	// their sorted position.
+	AmfArray array;
+	for (int i = 0; i < 4; ++i) {
+		AmfObject obj("foo", false, false);
+		obj.addSealedProperty("y", AmfInteger(i + 10));
+		obj.addSealedProperty("x", AmfInteger(i));
+		array.push_back(obj);
+	}
+
+	v8 data {
+		0x09, 0x09, 0x01,
+		0x0a, 0x23, 0x07, 0x66, 0x6f, 0x6f, 0x03, 0x79, 0x03, 0x78,
+		0x04, 0x0a, 0x04, 0x00,
+		0x0a, 0x01, 0x04, 0x0b, 0x04, 0x01,
+		0x0a, 0x01, 0x04, 0x0c, 0x04, 0x02,
+		0x0a, 0x01, 0x04, 0x0d, 0x04, 0x03
+	};
+	deserialize(array, data);
+}
+
 TEST(ObjectDeserialization, MultipleProperties) {
 	AmfObject obj("", true, false);
 	obj.addDynamicProperty("1", AmfInteger(1));
@@ -1053,6 +1127,81 @@ TEST(ObjectDeserialization, ExternalizableInContext) {
 	deserialize(AmfObject("foo", false, false), { 0x0a, 0x00 }, 0, &ctx);
 }
 
+TEST(ObjectDeserialization, ExternalizableRegistry) {
+	Deserializer::externalDeserializers["asd"] = [] (v8::const_iterator&, v8::const_iterator, SerializationContext&) {
+		return AmfObject("global", false, false);
+	};
+
+	int calls = 0;
+	auto registry = std::make_shared<ExternalDeserializerRegistry>();
+	registry->add("asd", [&calls] (v8::const_iterator&, v8::const_iterator, SerializationContext&) {
+		++calls;
+		return AmfObject("registry", false, false);
+	});
+	EXPECT_EQ(1u, registry->size());
+	EXPECT_EQ(nullptr, registry->find("foo"));
+
+	// The registry of a context takes precedence over the global map, also
+	// for objects using a traits reference.
+	SerializationContext ctx;
+	ctx.setExternalDeserializers(registry);
+	deserialize(AmfObject("registry", false, false), { 0x0a, 0x07, 0x07, 0x61, 0x73, 0x64 }, 0, &ctx);
+	deserialize(AmfObject("registry", false, false), { 0x0a, 0x01 }, 0, &ctx);
+	EXPECT_EQ(2, calls);
+
+	// It stays set when clearing the context.
+	ctx.clear();
+	deserialize(AmfObject("registry", false, false), { 0x0a, 0x07, 0x07, 0x61, 0x73, 0x64 }, 0, &ctx);
+	EXPECT_EQ(3, calls);
+
+	deserialize(AmfObject("global", false, false), { 0x0a, 0x07, 0x07, 0x61, 0x73, 0x64 });
+
+	// Class names missing from the registry are not looked up globally.
+	SerializationContext empty;
+	empty.setExternalDeserializers(std::make_shared<ExternalDeserializerRegistry>());
+	v8 data { 0x0a, 0x07, 0x07, 0x61, 0x73, 0x64 };
+	auto it = data.cbegin();
+	EXPECT_THROW(AmfObject::deserialize(it, data.cend(), empty), std::out_of_range);
+}
+
+TEST(ObjectDeserialization, ExternalizableRegistryConcurrent) {
+	std::atomic<int> calls(0);
+	std::shared_ptr<const ExternalDeserializerRegistry> registry(new ExternalDeserializerRegistry {
+		{ "asd", [&calls] (v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+			++calls;
+			return AmfObject(AmfString::deserializeValue(it, end, ctx), false, false);
+		} }
+	});
+
+	v8 data {
+		0x0a, 0x07, 0x07, 0x61, 0x73, 0x64, 0x03, 0x61,
+		0x0a, 0x01, 0x03, 0x62
+	};
+
+	std::vector<std::thread> threads;
+	std::atomic<int> mismatches(0);
+	for (int t = 0; t < 4; ++t) {
+		threads.emplace_back([&]() {
+			Deserializer deserializer(registry);
+			for (int i = 0; i < 100; ++i) {
+				auto it = data.cbegin();
+				AmfItemPtr a = deserializer.deserialize(it, data.cend());
+				AmfItemPtr b = deserializer.deserialize(it, data.cend());
+				if (a.as<AmfObject>() != AmfObject("a", false, false) ||
+					b.as<AmfObject>() != AmfObject("b", false, false))
+					++mismatches;
+				deserializer.clearContext();
+			}
+		});
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	EXPECT_EQ(0, mismatches.load());
+	EXPECT_EQ(4 * 100 * 2, calls.load());
+}
+
 TEST(ObjectDeserialization, TraitRefs) {
 	AmfObject obj("foo", true, false);
 	obj.addDynamicProperty("foo", AmfNull());
@@ -1083,6 +1232,23 @@ TEST(ObjectDeserialization, ReferenceOrder) {
 	deserialize(obj, data);
 }
 
+TEST(ObjectMember, MoveProperties) {
+	v8 data(1024, 0xab);
+	const u8* p = data.data();
+	std::string str(1024, 'x');
+	const char* s = str.data();
+
+	AmfObject obj("", true, false);
+	obj.addSealedProperty("data", AmfByteArray(std::move(data)));
+	obj.addDynamicProperty("str", AmfString(std::move(str)));
+	EXPECT_EQ(p, obj.getSealedProperty<AmfByteArray>("data").value.data());
+	EXPECT_EQ(s, obj.getDynamicProperty<AmfString>("str").value.data());
+
+	AmfString copied("foo");
+	obj.addDynamicProperty("copied", copied);
+	EXPECT_EQ(copied, obj.getDynamicProperty<AmfString>("copied"));
+}
+
 TEST(ObjectDeserialization, SelfReference) {
 	// Dynamic, non-externalizable Object containing property "f", which
 	// points to itself.
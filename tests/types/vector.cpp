@@ -1,6 +1,7 @@
 #include "amftest.hpp"
 
 #include "amf.hpp"
+#include "deserializer.hpp"
 #include "types/amfarray.hpp"
 #include "types/amfbool.hpp"
 #include "types/amfbytearray.hpp"
@@ -611,6 +612,37 @@ TEST(VectorType, VectorNonAmfSubclassNotConstructible) {
 }
 #endif
 
+TEST(VectorType, MoveValues) {
+	std::vector<double> values(1024, 0.5);
+	const double* p = values.data();
+	AmfVector<double> doubles(std::move(values));
+	EXPECT_EQ(p, doubles.values.data());
+
+	std::vector<AmfByteArray> arrays;
+	arrays.emplace_back(v8(1024, 0xab));
+	const u8* data = arrays[0].value.data();
+	AmfVector<AmfByteArray> vector(std::move(arrays), "flash.utils.ByteArray");
+	EXPECT_EQ(data, vector.at(0).value.data());
+
+	vector.push_back(AmfByteArray(v8(1024, 0xcd)));
+	EXPECT_EQ(2u, vector.values.size());
+}
+
+TEST(VectorType, DeserializerSharesWithContext) {
+	v8 data { 0x0d, 0x05, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x02, 0x0d, 0x00 };
+	SerializationContext ctx;
+	auto it = data.cbegin();
+	AmfItemPtr ptr = Deserializer::deserialize(it, data.cend(), ctx);
+	EXPECT_EQ(AmfVector<int>({ 1, 2 }), ptr.as<AmfVector<int>>());
+	EXPECT_EQ(ctx.getPointer<AmfVector<int>>(0).get(), ptr.get());
+	EXPECT_EQ(ptr.get(), Deserializer::deserialize(it, data.cend(), ctx).get());
+	EXPECT_EQ(data.cend(), it);
+
+	// The typed API still returns a copy.
+	it = data.cbegin() + 11;
+	EXPECT_EQ(AmfVector<int>({ 1, 2 }), AmfVector<int>::deserialize(it, data.cend(), ctx));
+}
+
 TEST(VectorEquality, IntVector) {
 	AmfVector<int> vec { { 1, 2, 3 }, false };
 	AmfVector<int> vec2 { { 1, 2, 3 }, false };
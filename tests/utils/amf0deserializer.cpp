@@ -0,0 +1,108 @@
+#include "amftest.hpp"
+
+#include "amfpacket.hpp"
+#include "types/amfarray.hpp"
+#include "types/amfbool.hpp"
+#include "types/amfdate.hpp"
+#include "types/amfdouble.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfnull.hpp"
+#include "types/amfobject.hpp"
+#include "types/amfstring.hpp"
+#include "types/amfundefined.hpp"
+#include "types/amfxmldocument.hpp"
+#include "utils/amf0deserializer.hpp"
+
+static AmfItemPtr deserialize(const v8& data) {
+	Amf0Deserializer deserializer;
+	auto it = data.cbegin();
+	AmfItemPtr ret = deserializer.deserialize(it, data.cend());
+	EXPECT_EQ(data.cend(), it);
+	return ret;
+}
+
+TEST(Amf0Deserializer, Primitives) {
+	EXPECT_EQ(AmfItemPtr(AmfDouble(1.5)), deserialize(v8 { 0x00, 0x3F, 0xF8, 0, 0, 0, 0, 0, 0 }));
+	EXPECT_EQ(AmfItemPtr(AmfBool(true)), deserialize(v8 { 0x01, 0x01 }));
+	EXPECT_EQ(AmfItemPtr(AmfBool(false)), deserialize(v8 { 0x01, 0x00 }));
+	EXPECT_EQ(AmfItemPtr(AmfString("foo")), deserialize(v8 { 0x02, 0x00, 0x03, 'f', 'o', 'o' }));
+	EXPECT_EQ(AmfItemPtr(AmfString("ab")), deserialize(v8 { 0x0C, 0x00, 0x00, 0x00, 0x02, 'a', 'b' }));
+	EXPECT_EQ(AmfItemPtr(AmfXmlDocument("<a/>")), deserialize(v8 { 0x0F, 0x00, 0x00, 0x00, 0x04, '<', 'a', '/', '>' }));
+	EXPECT_EQ(AmfItemPtr(AmfNull()), deserialize(v8 { 0x05 }));
+	EXPECT_EQ(AmfItemPtr(AmfUndefined()), deserialize(v8 { 0x06 }));
+	// 1000 ms, time zone 0
+	EXPECT_EQ(AmfItemPtr(AmfDate(1000)), deserialize(v8 { 0x0B, 0x40, 0x8F, 0x40, 0, 0, 0, 0, 0, 0x00, 0x00 }));
+}
+
+TEST(Amf0Deserializer, Objects) {
+	AmfObject anonymous("", true, false);
+	anonymous.addDynamicProperty("a", AmfBool(true));
+	EXPECT_EQ(AmfItemPtr(anonymous), deserialize(v8 {
+		0x03, 0x00, 0x01, 'a', 0x01, 0x01, 0x00, 0x00, 0x09
+	}));
+
+	AmfObject typed("Foo", true, false);
+	typed.addDynamicProperty("b", AmfNull());
+	EXPECT_EQ(AmfItemPtr(typed), deserialize(v8 {
+		0x10, 0x00, 0x03, 'F', 'o', 'o', 0x00, 0x01, 'b', 0x05, 0x00, 0x00, 0x09
+	}));
+
+	AmfArray ecma;
+	ecma.insert("x", AmfString("y"));
+	EXPECT_EQ(AmfItemPtr(ecma), deserialize(v8 {
+		0x08, 0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 'x', 0x02, 0x00, 0x01, 'y', 0x00, 0x00, 0x09
+	}));
+
+	AmfArray strict;
+	strict.push_back(AmfNull());
+	strict.push_back(AmfBool(false));
+	EXPECT_EQ(AmfItemPtr(strict), deserialize(v8 {
+		0x0A, 0x00, 0x00, 0x00, 0x02, 0x05, 0x01, 0x00
+	}));
+}
+
+TEST(Amf0Deserializer, References) {
+	// [{}, ref 1] where ref 1 is the object, the array itself is ref 0.
+	AmfItemPtr ptr = deserialize(v8 {
+		0x0A, 0x00, 0x00, 0x00, 0x03,
+		0x03, 0x00, 0x00, 0x09,
+		0x07, 0x00, 0x01,
+		0x07, 0x00, 0x00
+	});
+
+	AmfArray& array = ptr.as<AmfArray>();
+	ASSERT_EQ(3u, array.dense.size());
+	EXPECT_EQ(array.dense[0].get(), array.dense[1].get());
+	EXPECT_EQ(ptr.get(), array.dense[2].get());
+	array.dense.clear();
+
+	v8 invalid { 0x07, 0x00, 0x00 };
+	Amf0Deserializer deserializer;
+	auto it = invalid.cbegin();
+	EXPECT_THROW(deserializer.deserialize(it, invalid.cend()), std::out_of_range);
+}
+
+TEST(Amf0Deserializer, AvmPlus) {
+	AmfArray expected(std::vector<AmfInteger> { 1, 2 });
+	EXPECT_EQ(AmfItemPtr(expected), deserialize(v8 {
+		AVMPLUS_OBJECT, 0x09, 0x05, 0x01, 0x04, 0x01, 0x04, 0x02
+	}));
+}
+
+TEST(Amf0Deserializer, Invalid) {
+	for (const v8& data : {
+		v8 { }, v8 { 0x00, 0x01 }, v8 { 0x01 }, v8 { 0x02, 0x00, 0x02, 'a' },
+		v8 { 0x03, 0x00, 0x01, 'a', 0x05 }, v8 { 0x0A, 0x00, 0x00, 0x00, 0x02, 0x05 }
+	}) {
+		Amf0Deserializer deserializer;
+		auto it = data.cbegin();
+		EXPECT_THROW(deserializer.deserialize(it, data.cend()), std::out_of_range);
+	}
+
+	for (const v8& data : { v8 { AMF0_MOVIECLIP }, v8 { AMF0_RECORDSET }, v8 { 0x12 },
+		v8 { 0x03, 0x00, 0x00, 0x05 } }) {
+		Amf0Deserializer deserializer;
+		auto it = data.cbegin();
+		EXPECT_THROW(deserializer.deserialize(it, data.cend()), std::invalid_argument);
+	}
+}
@@ -0,0 +1,170 @@
+#include "amftest.hpp"
+
+#include "serializer.hpp"
+#include "types/amfarray.hpp"
+#include "types/amfbool.hpp"
+#include "types/amfbytearray.hpp"
+#include "types/amfdouble.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfnull.hpp"
+#include "types/amfobject.hpp"
+#include "types/amfstring.hpp"
+#include "utils/amfcodegen.hpp"
+
+// Generated from misc/valueobjects.as by
+// tools/amfgen -n amftest -o tests/misc/valueobjects.hpp tests/misc/valueobjects.as
+#include "misc/valueobjects.hpp"
+
+using amftest::Point;
+using amftest::Shape;
+
+static AmfObject genericPoint(int x, double y) {
+	AmfObject obj("de.ventero.AmfTest.Point", false, false);
+	obj.addSealedProperty("x", AmfInteger(x));
+	obj.addSealedProperty("y", AmfDouble(y));
+	return obj;
+}
+
+TEST(AmfCodegen, DefaultValues) {
+	Point p;
+	EXPECT_EQ(0, p.x);
+	EXPECT_EQ(0.5, p.y);
+
+	Shape s;
+	EXPECT_EQ("", s.name);
+	EXPECT_TRUE(s.visible);
+	EXPECT_EQ(0u, s.id);
+	EXPECT_EQ(nullptr, s.origin.get());
+}
+
+TEST(AmfCodegen, Traits) {
+	const AmfObjectTraits& traits = Shape::traits();
+	EXPECT_EQ("de.ventero.AmfTest.Shape", traits.className);
+	EXPECT_TRUE(traits.dynamic);
+	EXPECT_FALSE(traits.externalizable);
+
+	// Transient, static, private and read-only properties are not included.
+	std::vector<std::string> expected { "name", "visible", "id", "origin", "data", "tags" };
+	EXPECT_EQ(expected, traits.attributes);
+}
+
+TEST(AmfCodegen, SerializeMatchesGenericObject) {
+	Point p;
+	p.x = 300;
+	p.y = -1.5;
+
+	SerializationContext ctx;
+	isEqual(genericPoint(300, -1.5).serialize(ctx), p);
+}
+
+TEST(AmfCodegen, DeserializeInOrder) {
+	SerializationContext sctx;
+	v8 data = genericPoint(-7, 2.25).serialize(sctx);
+
+	SerializationContext ctx;
+	auto it = data.cbegin();
+	Point p = Point::deserialize(it, data.cend(), ctx);
+	EXPECT_EQ(data.cend(), it);
+	EXPECT_EQ(-7, p.x);
+	EXPECT_EQ(2.25, p.y);
+}
+
+TEST(AmfCodegen, DeserializeOutOfOrder) {
+	// AmfObject serializes sealed properties sorted by name, which doesn't
+	// match the declaration order of Shape.
+	AmfObject obj("de.ventero.AmfTest.Shape", true, false);
+	obj.addSealedProperty("name", AmfString("square"));
+	obj.addSealedProperty("visible", AmfBool(false));
+	obj.addSealedProperty("id", AmfDouble(4000000000.0));
+	obj.addSealedProperty("origin", genericPoint(1, 2));
+	obj.addSealedProperty("data", AmfByteArray(v8 { 1, 2, 3 }));
+	obj.addSealedProperty("tags", AmfArray(std::vector<AmfString> { "a", "b" }));
+	obj.addDynamicProperty("extra", AmfInteger(1));
+
+	SerializationContext sctx;
+	v8 data = obj.serialize(sctx);
+
+	SerializationContext ctx;
+	auto it = data.cbegin();
+	Shape s = Shape::deserialize(it, data.cend(), ctx);
+	EXPECT_EQ(data.cend(), it);
+
+	EXPECT_EQ("square", s.name);
+	EXPECT_FALSE(s.visible);
+	EXPECT_EQ(4000000000u, s.id);
+	ASSERT_NE(nullptr, s.origin.get());
+	EXPECT_EQ(1, s.origin.as<Point>().x);
+	EXPECT_EQ(2, s.origin.as<Point>().y);
+	EXPECT_EQ(AmfByteArray(v8 { 1, 2, 3 }), s.data.as<AmfByteArray>());
+	EXPECT_EQ(AmfArray(std::vector<AmfString> { "a", "b" }), s.tags.as<AmfArray>());
+}
+
+TEST(AmfCodegen, RoundTrip) {
+	Shape s;
+	s.name = "circle";
+	s.id = 17;
+	s.origin = AmfItemPtr(new Point());
+
+	SerializationContext sctx;
+	v8 data = s.serialize(sctx);
+
+	SerializationContext ctx;
+	auto it = data.cbegin();
+	EXPECT_EQ(s, Shape::deserialize(it, data.cend(), ctx));
+	EXPECT_EQ(data.cend(), it);
+}
+
+TEST(AmfCodegen, NullValues) {
+	Shape s;
+	SerializationContext sctx;
+	v8 data = s.serialize(sctx);
+
+	SerializationContext ctx;
+	auto it = data.cbegin();
+	Shape d = Shape::deserialize(it, data.cend(), ctx);
+	EXPECT_EQ("", d.name);
+	EXPECT_EQ(nullptr, d.origin.get());
+	EXPECT_EQ(nullptr, d.data.get());
+	EXPECT_EQ(nullptr, d.tags.get());
+}
+
+TEST(AmfCodegen, References) {
+	Point p1, p2;
+	p2.x = 1;
+
+	Serializer serializer;
+	serializer << p1 << p2 << p1;
+	v8 data = serializer.data();
+
+	// Second object uses a traits reference, third is an object reference.
+	SerializationContext sctx;
+	v8 expected = genericPoint(0, 0.5).serialize(sctx);
+	EXPECT_EQ(expected, v8(data.begin(), data.begin() + expected.size()));
+	EXPECT_EQ(0x01, data[expected.size() + 1]);
+	EXPECT_EQ((v8 { AMF_OBJECT, 0x00 }), v8(data.end() - 2, data.end()));
+
+	SerializationContext ctx;
+	auto it = data.cbegin();
+	AmfItemPtr d1 = Point::deserializePtr(it, data.cend(), ctx);
+	AmfItemPtr d2 = Point::deserializePtr(it, data.cend(), ctx);
+	AmfItemPtr d3 = Point::deserializePtr(it, data.cend(), ctx);
+	EXPECT_EQ(data.cend(), it);
+
+	EXPECT_EQ(p1, d1.as<Point>());
+	EXPECT_EQ(p2, d2.as<Point>());
+	EXPECT_EQ(d1.get(), d3.get());
+}
+
+TEST(AmfCodegen, UnexpectedClass) {
+	AmfObject obj("de.ventero.AmfTest.Other", false, false);
+	SerializationContext sctx;
+	v8 data = obj.serialize(sctx);
+
+	SerializationContext ctx;
+	auto it = data.cbegin();
+	EXPECT_THROW(Point::deserialize(it, data.cend(), ctx), std::invalid_argument);
+
+	v8 notAnObject { AMF_NULL };
+	it = notAnObject.cbegin();
+	EXPECT_THROW(Point::deserialize(it, notAnObject.cend(), ctx), std::invalid_argument);
+}
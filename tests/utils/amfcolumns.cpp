@@ -0,0 +1,255 @@
+#include "amftest.hpp"
+
+#include "deserializer.hpp"
+#include "serializer.hpp"
+#include "types/amfarray.hpp"
+#include "types/amfbool.hpp"
+#include "types/amfdouble.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfnull.hpp"
+#include "types/amfobject.hpp"
+#include "types/amfstring.hpp"
+#include "types/amfvector.hpp"
+#include "utils/amfcolumns.hpp"
+
+static AmfObject item(int id, double price, std::string name, bool enabled) {
+	AmfObject obj("de.ventero.AmfTest.Item", false, false);
+	obj.addSealedProperty("id", AmfInteger(id));
+	obj.addSealedProperty("price", AmfDouble(price));
+	obj.addSealedProperty("name", AmfString(name));
+	obj.addSealedProperty("enabled", AmfBool(enabled));
+	obj.addSealedProperty("tags", AmfArray(std::vector<AmfString> { name }));
+	return obj;
+}
+
+static AmfColumns columns(const v8& data, SerializationContext& ctx) {
+	auto it = data.cbegin();
+	AmfColumns ret = AmfColumns::deserialize(it, data.cend(), ctx);
+	EXPECT_EQ(data.cend(), it);
+	return ret;
+}
+
+TEST(AmfColumns, TypedColumns) {
+	AmfArray array;
+	array.push_back(item(1, 0.5, "foo", true));
+	array.push_back(item(2, 1.5, "bar", false));
+	array.push_back(item(3, 2.5, "foo", true));
+
+	SerializationContext sctx;
+	v8 data = array.serialize(sctx);
+
+	SerializationContext ctx;
+	AmfColumns cols = columns(data, ctx);
+	EXPECT_EQ(3u, cols.rows);
+	EXPECT_EQ("de.ventero.AmfTest.Item", cols.traits.className);
+	std::vector<std::string> attributes { "enabled", "id", "name", "price", "tags" };
+	EXPECT_EQ(attributes, cols.traits.attributes);
+	ASSERT_EQ(5u, cols.columns.size());
+
+	const AmfColumn& id = cols.column("id");
+	EXPECT_EQ(AmfColumn::INTEGER, id.type);
+	EXPECT_EQ((std::vector<int> { 1, 2, 3 }), id.integers);
+
+	const AmfColumn& price = cols.column("price");
+	EXPECT_EQ(AmfColumn::DOUBLE, price.type);
+	EXPECT_EQ((std::vector<double> { 0.5, 1.5, 2.5 }), price.doubles);
+
+	const AmfColumn& name = cols.column("name");
+	EXPECT_EQ(AmfColumn::STRING, name.type);
+	ASSERT_EQ(3u, name.size());
+	EXPECT_EQ("foo", name.strings[0].str());
+	EXPECT_EQ("bar", name.strings[1].str());
+	// Inline strings point into the input, references to them are resolved
+	// to the same view.
+	EXPECT_EQ(name.strings[0].data, name.strings[2].data);
+	EXPECT_GE(name.strings[0].data, reinterpret_cast<const char*>(data.data()));
+	EXPECT_LT(name.strings[0].data, reinterpret_cast<const char*>(data.data() + data.size()));
+
+	const AmfColumn& enabled = cols.column("enabled");
+	EXPECT_EQ(AmfColumn::BOOL, enabled.type);
+	EXPECT_EQ((std::vector<bool> { true, false, true }), enabled.bools);
+
+	const AmfColumn& tags = cols.column("tags");
+	EXPECT_EQ(AmfColumn::ITEM, tags.type);
+	EXPECT_EQ(AmfArray(std::vector<AmfString> { "bar" }), tags.items[1].as<AmfArray>());
+
+	EXPECT_THROW(cols.column("missing"), std::out_of_range);
+}
+
+TEST(AmfColumns, MatchesObjectDeserialization) {
+	AmfArray array;
+	for (int i = 0; i < 10; ++i)
+		array.push_back(item(i, i * 0.25, "name" + std::to_string(i % 3), i % 2 == 0));
+
+	SerializationContext sctx;
+	v8 data = array.serialize(sctx);
+
+	SerializationContext ctx;
+	AmfColumns cols = columns(data, ctx);
+
+	SerializationContext octx;
+	auto oit = data.cbegin();
+	AmfArray objects = AmfArray::deserialize(oit, data.cend(), octx);
+	ASSERT_EQ(objects.dense.size(), cols.rows);
+	for (size_t row = 0; row < cols.rows; ++row) {
+		const AmfObject& obj = objects.dense[row].as<AmfObject>();
+		for (const AmfColumn& column : cols.columns)
+			EXPECT_EQ(obj.sealedProperties.at(column.name), column.item(row));
+	}
+}
+
+TEST(AmfColumns, Promotion) {
+	AmfObject a("", false, false);
+	a.addSealedProperty("x", AmfInteger(1));
+	a.addSealedProperty("y", AmfInteger(1));
+	a.addSealedProperty("z", AmfString("a"));
+	AmfObject b("", false, false);
+	b.addSealedProperty("x", AmfDouble(1.5));
+	b.addSealedProperty("y", AmfString("b"));
+	b.addSealedProperty("z", AmfNull());
+
+	AmfArray array;
+	array.push_back(a);
+	array.push_back(b);
+	array.push_back(a);
+
+	SerializationContext sctx;
+	v8 data = array.serialize(sctx);
+
+	SerializationContext ctx;
+	AmfColumns cols = columns(data, ctx);
+	EXPECT_EQ(3u, cols.rows);
+
+	// Integers are widened to doubles.
+	const AmfColumn& x = cols.column("x");
+	EXPECT_EQ(AmfColumn::DOUBLE, x.type);
+	EXPECT_EQ((std::vector<double> { 1, 1.5, 1 }), x.doubles);
+	EXPECT_TRUE(x.integers.empty());
+
+	// Other mixes fall back to generic items.
+	const AmfColumn& y = cols.column("y");
+	EXPECT_EQ(AmfColumn::ITEM, y.type);
+	ASSERT_EQ(3u, y.items.size());
+	EXPECT_EQ(AmfItemPtr(AmfInteger(1)), y.items[0]);
+	EXPECT_EQ(AmfItemPtr(AmfString("b")), y.items[1]);
+
+	const AmfColumn& z = cols.column("z");
+	EXPECT_EQ(AmfColumn::ITEM, z.type);
+	EXPECT_EQ(AmfItemPtr(AmfString("a")), z.items[0]);
+	EXPECT_EQ(AmfItemPtr(AmfNull()), z.items[1]);
+}
+
+TEST(AmfColumns, RowReferences) {
+	AmfObject a("", false, false);
+	a.addSealedProperty("x", AmfInteger(1));
+	AmfObject b("", false, false);
+	b.addSealedProperty("x", AmfInteger(2));
+
+	AmfArray array;
+	array.push_back(a);
+	array.push_back(b);
+	array.push_back(a);
+
+	SerializationContext sctx;
+	v8 data = array.serialize(sctx);
+	// The third element is sent as a reference to the first.
+	EXPECT_EQ((v8 { 0x0a, 0x02 }), v8(data.end() - 2, data.end()));
+
+	SerializationContext ctx;
+	AmfColumns cols = columns(data, ctx);
+	EXPECT_EQ((std::vector<int> { 1, 2, 1 }), cols.column("x").integers);
+}
+
+TEST(AmfColumns, Vector) {
+	AmfVector<AmfObject> vector { {}, "de.ventero.AmfTest.Item", false };
+	vector.push_back(item(1, 2, "foo", false));
+	vector.push_back(item(3, 4, "bar", true));
+
+	SerializationContext sctx;
+	v8 data = vector.serialize(sctx);
+
+	SerializationContext ctx;
+	AmfColumns cols = columns(data, ctx);
+	EXPECT_EQ(2u, cols.rows);
+	EXPECT_EQ((std::vector<int> { 1, 3 }), cols.column("id").integers);
+	EXPECT_EQ((std::vector<double> { 2, 4 }), cols.column("price").doubles);
+}
+
+TEST(AmfColumns, DuplicateSealedProperties) {
+	v8 data {
+		0x09, 0x05, 0x01,
+		0x0a, 0x33, 0x01,
+		0x03, 0x62, 0x03, 0x61, 0x03, 0x62,
+		0x04, 0x01, 0x04, 0x02, 0x04, 0x03,
+		0x0a, 0x01,
+		0x04, 0x04, 0x04, 0x05, 0x04, 0x06
+	};
+
+	SerializationContext ctx;
+	AmfColumns cols = columns(data, ctx);
+	ASSERT_EQ(2u, cols.columns.size());
+	EXPECT_EQ((std::vector<int> { 2, 5 }), cols.column("a").integers);
+	EXPECT_EQ((std::vector<int> { 3, 6 }), cols.column("b").integers);
+}
+
+TEST(AmfColumns, ContextStaysValid) {
+	AmfArray array;
+	array.push_back(item(1, 0.5, "foo", true));
+
+	Serializer serializer;
+	serializer << array << AmfString("foo") << item(2, 1, "bar", false);
+	v8 data = serializer.data();
+
+	SerializationContext ctx;
+	auto it = data.cbegin();
+	AmfColumns cols = AmfColumns::deserialize(it, data.cend(), ctx);
+	EXPECT_EQ(1u, cols.rows);
+
+	// Later items may refer to strings and traits read by AmfColumns.
+	EXPECT_EQ(AmfItemPtr(AmfString("foo")), Deserializer::deserialize(it, data.cend(), ctx));
+	AmfItemPtr obj = Deserializer::deserialize(it, data.cend(), ctx);
+	EXPECT_EQ(item(2, 1, "bar", false).sealedProperties, obj.as<AmfObject>().sealedProperties);
+	EXPECT_EQ(data.cend(), it);
+}
+
+TEST(AmfColumns, EmptyArray) {
+	SerializationContext ctx;
+	AmfColumns cols = columns(v8 { 0x09, 0x01, 0x01 }, ctx);
+	EXPECT_EQ(0u, cols.rows);
+	EXPECT_TRUE(cols.columns.empty());
+}
+
+TEST(AmfColumns, Unsupported) {
+	AmfObject other("de.ventero.AmfTest.Other", false, false);
+	other.addSealedProperty("id", AmfInteger(0));
+
+	AmfArray differentTraits;
+	differentTraits.push_back(item(1, 0.5, "foo", true));
+	differentTraits.push_back(other);
+
+	AmfArray notAnObject;
+	notAnObject.push_back(AmfInteger(1));
+
+	AmfArray associative;
+	associative.push_back(item(1, 0.5, "foo", true));
+	associative.insert("foo", AmfNull());
+
+	AmfObject dynamic("", true, false);
+	dynamic.addDynamicProperty("foo", AmfNull());
+	AmfArray dynamicMembers;
+	dynamicMembers.push_back(dynamic);
+
+	for (const AmfArray& array : { differentTraits, notAnObject, associative, dynamicMembers }) {
+		SerializationContext sctx;
+		v8 data = array.serialize(sctx);
+
+		SerializationContext ctx;
+		auto it = data.cbegin();
+		EXPECT_THROW(AmfColumns::deserialize(it, data.cend(), ctx), std::invalid_argument);
+	}
+
+	SerializationContext ctx;
+	v8 data { AMF_NULL };
+	auto it = data.cbegin();
+	EXPECT_THROW(AmfColumns::deserialize(it, data.cend(), ctx), std::invalid_argument);
+}
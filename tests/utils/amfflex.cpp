@@ -0,0 +1,98 @@
+#include "amftest.hpp"
+
+#include "deserializer.hpp"
+#include "serializer.hpp"
+#include "types/amfarray.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfobject.hpp"
+#include "types/amfstring.hpp"
+#include "utils/amfexternalregistry.hpp"
+#include "utils/amfflex.hpp"
+
+static v8 className(const std::string& name) {
+	SerializationContext ctx;
+	return AmfString(name).serializeValue(ctx);
+}
+
+TEST(AmfFlex, SerializeArrayCollection) {
+	AmfArray source(std::vector<AmfInteger> { 1, 2 });
+	AmfObject collection = AmfFlex::arrayCollection(AmfItemPtr(source));
+
+	// U29O-traits-ext, class name, followed by the source array
+	v8 expected { 0x0a, 0x07 };
+	v8 name = className(AmfFlex::ArrayCollection);
+	expected.insert(expected.end(), name.begin(), name.end());
+	expected.insert(expected.end(), { 0x09, 0x05, 0x01, 0x04, 0x01, 0x04, 0x02 });
+
+	isEqual(expected, collection);
+}
+
+TEST(AmfFlex, RoundTrip) {
+	AmfObject inner("", true, false);
+	inner.addDynamicProperty("a", AmfString("b"));
+
+	AmfArray response;
+	response.push_back(AmfFlex::arrayCollection(AmfItemPtr(AmfArray(std::vector<AmfString> { "x" }))));
+	response.push_back(AmfFlex::arrayList(AmfItemPtr(AmfArray())));
+	response.push_back(AmfFlex::objectProxy(AmfItemPtr(inner)));
+
+	SerializationContext sctx;
+	v8 data = response.serialize(sctx);
+
+	SerializationContext ctx;
+	auto it = data.cbegin();
+	AmfItemPtr ptr = Deserializer::deserialize(it, data.cend(), ctx);
+	EXPECT_EQ(data.cend(), it);
+	EXPECT_EQ(AmfItemPtr(response), ptr);
+
+	const AmfArray& array = ptr.as<AmfArray>();
+	const AmfObject& collection = array.at<AmfObject>(0);
+	EXPECT_EQ(AmfFlex::ArrayCollection, collection.objectTraits().className);
+	EXPECT_TRUE(collection.objectTraits().externalizable);
+	EXPECT_EQ(AmfItemPtr(AmfArray(std::vector<AmfString> { "x" })), AmfFlex::wrapped(collection));
+	EXPECT_EQ(AmfItemPtr(inner), AmfFlex::wrapped(array.at<AmfObject>(2)));
+
+	// Deserialized objects can be serialized again.
+	SerializationContext rctx;
+	EXPECT_EQ(data, ptr->serialize(rctx));
+}
+
+TEST(AmfFlex, References) {
+	AmfItemPtr collection(AmfFlex::arrayCollection(AmfItemPtr(AmfArray())));
+	Serializer serializer;
+	serializer << *collection << *collection;
+	v8 data = serializer.data();
+
+	SerializationContext ctx;
+	auto it = data.cbegin();
+	AmfItemPtr first = Deserializer::deserialize(it, data.cend(), ctx);
+	AmfItemPtr second = Deserializer::deserialize(it, data.cend(), ctx);
+	EXPECT_EQ(data.cend(), it);
+	EXPECT_EQ(first.get(), second.get());
+}
+
+TEST(AmfFlex, BuiltinFallback) {
+	SerializationContext sctx;
+	v8 data = AmfFlex::arrayList(AmfItemPtr(AmfInteger(3))).serialize(sctx);
+
+	// Used for contexts whose registry doesn't contain the class.
+	SerializationContext ctx;
+	ctx.setExternalDeserializers(std::make_shared<ExternalDeserializerRegistry>());
+	auto it = data.cbegin();
+	AmfItemPtr ptr = Deserializer::deserialize(it, data.cend(), ctx);
+	EXPECT_EQ(AmfItemPtr(AmfInteger(3)), AmfFlex::wrapped(ptr.as<AmfObject>()));
+
+	// Registered functions take precedence.
+	auto registry = std::make_shared<ExternalDeserializerRegistry>();
+	registry->add(AmfFlex::ArrayList, [] (v8::const_iterator& it, v8::const_iterator end, SerializationContext& ctx) {
+		Deserializer::deserialize(it, end, ctx);
+		return AmfObject("custom", false, false);
+	});
+	SerializationContext custom;
+	custom.setExternalDeserializers(registry);
+	it = data.cbegin();
+	ptr = Deserializer::deserialize(it, data.cend(), custom);
+	EXPECT_EQ("custom", ptr.as<AmfObject>().objectTraits().className);
+
+	EXPECT_NE(nullptr, ExternalDeserializerRegistry::builtin().find(AmfFlex::ObjectProxy));
+}
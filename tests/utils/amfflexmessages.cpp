@@ -0,0 +1,233 @@
+#include "amftest.hpp"
+
+#include "deserializer.hpp"
+#include "types/amfarray.hpp"
+#include "types/amfbytearray.hpp"
+#include "types/amfdouble.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfnull.hpp"
+#include "types/amfobject.hpp"
+#include "types/amfstring.hpp"
+#include "utils/amfflexmessages.hpp"
+
+static const std::string uuid("0A1B2C3D-4E5F-6071-8293-A4B5C6D7E8F9");
+static const v8 uuidData { 0x0A, 0x1B, 0x2C, 0x3D, 0x4E, 0x5F, 0x60, 0x71,
+	0x82, 0x93, 0xA4, 0xB5, 0xC6, 0xD7, 0xE8, 0xF9 };
+
+static AcknowledgeMessage buildAcknowledge() {
+	AcknowledgeMessage msg;
+	msg.body = AmfItemPtr(AmfArray(std::vector<AmfInteger> { 1, 2 }));
+	msg.clientId = uuid;
+	msg.destination = "service";
+	msg.messageId = "not-a-uuid";
+	msg.timestamp = 1400000000000.0;
+	msg.correlationId = "0123456789ABCDEF0123456789ABCDEF0123";
+	return msg;
+}
+
+TEST(AmfFlexMessages, DeserializeSmall) {
+	AcknowledgeMessage expected;
+	expected.body = AmfItemPtr(AmfInteger(5));
+	expected.destination = "foo";
+	expected.timestamp = 100;
+	expected.correlationId = "bar";
+
+	v8 data {
+		0x0a, 0x07, 0x07, 'D', 'S', 'K',
+		// body, destination and timestamp
+		0x25, 0x04, 0x05, 0x06, 0x07, 'f', 'o', 'o', 0x04, 0x64,
+		// correlationId
+		0x01, 0x06, 0x07, 'b', 'a', 'r',
+		// no AcknowledgeMessage fields
+		0x00
+	};
+
+	deserialize(expected, data);
+
+	data.push_back(0x01);
+	deserialize(expected, data, 1);
+}
+
+TEST(AmfFlexMessages, SerializeSmall) {
+	AcknowledgeMessage msg;
+	msg.destination = "foo";
+	msg.timestamp = 0.5;
+
+	isEqual(v8 {
+		0x0a, 0x07, 0x07, 'D', 'S', 'K',
+		0x24, 0x06, 0x07, 'f', 'o', 'o',
+		0x05, 0x3F, 0xE0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00
+	}, msg);
+}
+
+TEST(AmfFlexMessages, UuidBytes) {
+	AsyncMessage msg;
+	msg.messageId = uuid;
+
+	// The id is sent as a ByteArray flagged in the second flag byte.
+	v8 expected { 0x0a, 0x07, 0x07, 'D', 'S', 'A', 0x80, 0x02, 0x0c, 0x21 };
+	expected.insert(expected.end(), uuidData.begin(), uuidData.end());
+	expected.push_back(0x00);
+	isEqual(expected, msg);
+	deserialize(msg, expected);
+
+	// Lower case UUIDs are sent as strings, so they are read back unchanged.
+	AsyncMessage lower;
+	lower.messageId = "0a1b2c3d-4e5f-6071-8293-a4b5c6d7e8f9";
+	SerializationContext sctx;
+	v8 data = lower.serialize(sctx);
+	EXPECT_EQ(0x10, data[6]);
+	deserialize(lower, data);
+
+	// A UUID that isn't 16 bytes long is rejected.
+	v8 invalid { 0x0a, 0x07, 0x07, 'D', 'S', 'A', 0x80, 0x02, 0x0c, 0x03, 0x01, 0x00 };
+	SerializationContext ctx;
+	auto it = invalid.cbegin();
+	EXPECT_THROW(AsyncMessage::deserialize(it, invalid.cend(), ctx), std::invalid_argument);
+}
+
+TEST(AmfFlexMessages, RoundTrip) {
+	AcknowledgeMessage ack = buildAcknowledge();
+
+	CommandMessage command;
+	command.operation = 5;
+	command.clientId = uuid;
+	command.headers = AmfItemPtr(AmfObject("", true, false));
+	command.timeToLive = 30000;
+	command.correlationId = uuid;
+
+	AsyncMessage async;
+
+	SerializationContext sctx;
+	v8 data = ack.serialize(sctx);
+	v8 commandData = command.serialize(sctx);
+	v8 asyncData = async.serialize(sctx);
+	// The second message refers to the traits and UUID of the first one.
+	v8 ackRef = ack.serialize(sctx);
+	data.insert(data.end(), commandData.begin(), commandData.end());
+	data.insert(data.end(), asyncData.begin(), asyncData.end());
+	data.insert(data.end(), ackRef.begin(), ackRef.end());
+
+	SerializationContext ctx;
+	auto it = data.cbegin();
+	AmfItemPtr ackPtr = AcknowledgeMessage::deserializePtr(it, data.cend(), ctx);
+	EXPECT_EQ(ack, ackPtr.as<AcknowledgeMessage>());
+	EXPECT_EQ(command, CommandMessage::deserialize(it, data.cend(), ctx));
+	EXPECT_EQ(async, AsyncMessage::deserialize(it, data.cend(), ctx));
+	EXPECT_EQ(ackPtr.get(), AcknowledgeMessage::deserializePtr(it, data.cend(), ctx).get());
+	EXPECT_EQ(data.cend(), it);
+
+	EXPECT_NE(ack, command);
+	EXPECT_NE(AmfItemPtr(ack), AmfItemPtr(AsyncMessage(ack)));
+}
+
+TEST(AmfFlexMessages, GenericDeserializer) {
+	CommandMessage command;
+	command.operation = 2;
+	command.body = AmfItemPtr(AmfString("body"));
+	command.messageId = uuid;
+
+	AmfArray messages;
+	messages.push_back(buildAcknowledge());
+	messages.push_back(command);
+
+	SerializationContext sctx;
+	v8 data = messages.serialize(sctx);
+
+	SerializationContext ctx;
+	auto it = data.cbegin();
+	AmfItemPtr ptr = Deserializer::deserialize(it, data.cend(), ctx);
+	EXPECT_EQ(data.cend(), it);
+
+	const AmfArray& array = ptr.as<AmfArray>();
+	const AmfObject& ack = array.at<AmfObject>(0);
+	EXPECT_EQ(AcknowledgeMessage::smallName, ack.objectTraits().className);
+	EXPECT_EQ(AmfString(uuid), ack.sealedProperties.at("clientId").as<AmfString>());
+	EXPECT_EQ(AmfString("service"), ack.sealedProperties.at("destination").as<AmfString>());
+	EXPECT_EQ(AmfNull(), ack.sealedProperties.at("headers").as<AmfNull>());
+	EXPECT_EQ(AmfDouble(1400000000000.0), ack.sealedProperties.at("timestamp").as<AmfDouble>());
+
+	const AmfObject& cmd = array.at<AmfObject>(1);
+	EXPECT_EQ(AmfInteger(2), cmd.sealedProperties.at("operation").as<AmfInteger>());
+	EXPECT_EQ(AmfString(uuid), cmd.sealedProperties.at("messageId").as<AmfString>());
+
+	// The generic objects are serialized in the same small form.
+	SerializationContext rctx;
+	EXPECT_EQ(data, ptr->serialize(rctx));
+}
+
+TEST(AmfFlexMessages, RemotingMessage) {
+	RemotingMessage msg;
+	msg.body = AmfItemPtr(AmfArray(std::vector<AmfString> { "arg" }));
+	msg.destination = "remoting";
+	msg.messageId = uuid;
+	msg.operation = "getItems";
+	msg.timestamp = 0;
+
+	SerializationContext sctx;
+	v8 data = msg.serialize(sctx);
+	// Sealed object with nine attributes
+	EXPECT_EQ(0x0a, data[0]);
+	EXPECT_EQ(0x81, data[1]);
+	EXPECT_EQ(0x13, data[2]);
+	deserialize(msg, data);
+
+	// The regular form is a plain sealed object, so the generic deserializer
+	// reads it just as well.
+	SerializationContext ctx;
+	auto it = data.cbegin();
+	AmfItemPtr ptr = Deserializer::deserialize(it, data.cend(), ctx);
+	const AmfObject& obj = ptr.as<AmfObject>();
+	EXPECT_EQ(RemotingMessage::className, obj.objectTraits().className);
+	EXPECT_EQ(AmfString("getItems"), obj.sealedProperties.at("operation").as<AmfString>());
+	EXPECT_EQ(AmfNull(), obj.sealedProperties.at("source").as<AmfNull>());
+
+	// And the regular form of the other messages is accepted as well.
+	AmfObject async(AsyncMessage::className, true, false);
+	async.addSealedProperty("correlationId", AmfString("abc"));
+	async.addSealedProperty("timeToLive", AmfInteger(5));
+	async.addDynamicProperty("extra", AmfString("ignored"));
+
+	AsyncMessage expected;
+	expected.correlationId = "abc";
+	expected.timeToLive = 5;
+
+	SerializationContext actx;
+	deserialize(expected, async.serialize(actx));
+}
+
+TEST(AmfFlexMessages, SkipsUnknownFlags) {
+	AcknowledgeMessage expected;
+	expected.destination = "foo";
+
+	v8 data {
+		0x0a, 0x07, 0x07, 'D', 'S', 'K',
+		// destination, followed by a second and a third flag byte with
+		// unknown fields
+		0x84, 0x84, 0x01,
+		0x06, 0x07, 'f', 'o', 'o', 0x04, 0x01, 0x04, 0x02,
+		// an unknown AsyncMessage field
+		0x04, 0x06, 0x01,
+		// two unknown AcknowledgeMessage fields
+		0x03, 0x02, 0x03
+	};
+
+	deserialize(expected, data);
+}
+
+TEST(AmfFlexMessages, Invalid) {
+	SerializationContext ctx;
+
+	v8 otherClass { 0x0a, 0x07, 0x07, 'D', 'S', 'A', 0x00, 0x00 };
+	auto it = otherClass.cbegin();
+	EXPECT_THROW(AcknowledgeMessage::deserialize(it, otherClass.cend(), ctx), std::invalid_argument);
+
+	v8 truncated { 0x0a, 0x07, 0x07, 'D', 'S', 'K', 0x80 };
+	it = truncated.cbegin();
+	EXPECT_THROW(AcknowledgeMessage::deserialize(it, truncated.cend(), ctx), std::out_of_range);
+
+	v8 notAnObject { 0x06, 0x01 };
+	it = notAnObject.cbegin();
+	EXPECT_THROW(AsyncMessage::deserialize(it, notAnObject.cend(), ctx), std::invalid_argument);
+}
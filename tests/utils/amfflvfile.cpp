@@ -0,0 +1,121 @@
+#include "amftest.hpp"
+
+#include <cstdio>
+#include <fstream>
+
+#include "types/amfarray.hpp"
+#include "types/amfdouble.hpp"
+#include "types/amfstring.hpp"
+#include "utils/amfflvfile.hpp"
+
+static void append(v8& buf, const v8& data) {
+	buf.insert(buf.end(), data.begin(), data.end());
+}
+
+static v8 flvHeader() {
+	// audio and video, previous tag size 0
+	return v8 { 'F', 'L', 'V', 0x01, 0x05, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x00 };
+}
+
+static void appendTag(v8& buf, u8 type, uint32_t timestamp, const v8& body) {
+	size_t size = body.size();
+	append(buf, v8 {
+		type,
+		static_cast<u8>(size >> 16), static_cast<u8>(size >> 8), static_cast<u8>(size),
+		static_cast<u8>(timestamp >> 16), static_cast<u8>(timestamp >> 8), static_cast<u8>(timestamp),
+		static_cast<u8>(timestamp >> 24),
+		0x00, 0x00, 0x00
+	});
+	append(buf, body);
+	append(buf, network_bytes<uint32_t>(11 + size));
+}
+
+static v8 scriptBody(const std::string& name, double duration) {
+	v8 body { 0x02, 0x00, static_cast<u8>(name.size()) };
+	body.insert(body.end(), name.begin(), name.end());
+	// ECMA array with a single "duration" member
+	append(body, v8 { 0x08, 0x00, 0x00, 0x00, 0x01, 0x00, 0x08 });
+	append(body, v8 { 'd', 'u', 'r', 'a', 't', 'i', 'o', 'n', 0x00 });
+	append(body, network_bytes<double>(duration));
+	append(body, v8 { 0x00, 0x00, 0x09 });
+	return body;
+}
+
+static v8 sampleFile() {
+	v8 data = flvHeader();
+	appendTag(data, 9, 0, v8(100, 0xAA));
+	appendTag(data, 18, 0, scriptBody("onMetaData", 12.5));
+	appendTag(data, 8, 20, v8(50, 0xBB));
+	appendTag(data, 18, 0x01000010, scriptBody("onCuePoint", 1));
+	// encrypted script tag
+	appendTag(data, 18 | 0x20, 40, v8(10, 0xCC));
+	return data;
+}
+
+static std::vector<AmfFlvScriptTag> scan(const v8& data) {
+	std::vector<AmfFlvScriptTag> ret;
+	AmfFlvFile::scan(data.data(), data.size(), [&](const AmfFlvScriptTag& tag) {
+		ret.push_back(tag);
+		return true;
+	});
+	return ret;
+}
+
+TEST(AmfFlvFile, ScriptTags) {
+	v8 data = sampleFile();
+	std::vector<AmfFlvScriptTag> tags = scan(data);
+	ASSERT_EQ(2u, tags.size());
+
+	EXPECT_EQ("onMetaData", tags[0].name);
+	EXPECT_EQ(13u + 11 + 100 + 4, tags[0].offset);
+	EXPECT_EQ(0u, tags[0].timestamp);
+	AmfArray meta;
+	meta.insert("duration", AmfDouble(12.5));
+	EXPECT_EQ(AmfItemPtr(meta), tags[0].value);
+
+	EXPECT_EQ("onCuePoint", tags[1].name);
+	EXPECT_EQ(0x01000010u, tags[1].timestamp);
+}
+
+TEST(AmfFlvFile, TruncatedFile) {
+	v8 data = sampleFile();
+	// Cut off in the middle of the second script tag.
+	data.resize(data.size() - 40);
+	EXPECT_EQ(1u, scan(data).size());
+
+	EXPECT_THROW(scan(v8 { 'F', 'L', 'V' }), std::out_of_range);
+	EXPECT_THROW(scan(v8 { 'F', 'L', 'X', 0x01, 0x05, 0x00, 0x00, 0x00, 0x09, 0, 0, 0, 0 }), std::invalid_argument);
+}
+
+TEST(AmfFlvFile, TagSizeMismatch) {
+	v8 data = flvHeader();
+	appendTag(data, 9, 0, v8(10, 0xAA));
+	data[data.size() - 1] = 0;
+	EXPECT_THROW(scan(data), std::invalid_argument);
+}
+
+TEST(AmfFlvFile, MappedFile) {
+	std::string path = testing::TempDir() + "amftest.flv";
+	v8 data = sampleFile();
+	{
+		std::ofstream out(path, std::ios::binary);
+		out.write(reinterpret_cast<const char*>(data.data()), data.size());
+	}
+
+	AmfFlvFile file(path);
+	EXPECT_TRUE(file.hasAudio());
+	EXPECT_TRUE(file.hasVideo());
+	EXPECT_EQ(2u, file.scriptTags().size());
+	ASSERT_NE(nullptr, file.metaData().get());
+	EXPECT_EQ(AmfDouble(12.5), file.metaData().as<AmfArray>().at<AmfDouble>("duration"));
+
+	// Returning false stops the scan.
+	int calls = 0;
+	file.scan([&](const AmfFlvScriptTag&) {
+		++calls;
+		return false;
+	});
+	EXPECT_EQ(1, calls);
+
+	std::remove(path.c_str());
+}
@@ -0,0 +1,149 @@
+#include "amftest.hpp"
+
+#include "serializer.hpp"
+#include "types/amfarray.hpp"
+#include "types/amfbytearray.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfobject.hpp"
+#include "types/amfstring.hpp"
+#include "utils/amffrozenitem.hpp"
+
+static AmfObject config() {
+	AmfObject obj("de.ventero.AmfTest.Config", true, false);
+	obj.addSealedProperty("name", AmfString("config"));
+	obj.addSealedProperty("version", AmfInteger(3));
+	obj.addSealedProperty("data", AmfByteArray(v8 { 1, 2, 3 }));
+	obj.addDynamicProperty("servers", AmfArray(std::vector<AmfString> { "a", "b" }));
+	return obj;
+}
+
+// Serializes like an AmfString, but counts how often it was serialized.
+class CountingString : public AmfString {
+public:
+	CountingString(std::string value) : AmfString(value) { }
+
+	std::vector<u8> serialize(SerializationContext& ctx) const {
+		++count;
+		return AmfString::serialize(ctx);
+	}
+
+	static int count;
+};
+
+int CountingString::count = 0;
+
+// Serializes prefix, item and suffix through the same context and checks that
+// the output matches serializing the unfrozen item in its place.
+static void sameAsUnfrozen(const std::vector<AmfItemPtr>& prefix, const AmfItem& item,
+	const AmfFrozenItem& frozen) {
+	Serializer expected, actual;
+	for (const AmfItemPtr& ptr : prefix) {
+		expected << *ptr;
+		actual << *ptr;
+	}
+
+	expected << item;
+	actual << frozen;
+
+	// Items serialized afterwards see the same reference tables.
+	expected << item << AmfString("config") << AmfString("b");
+	actual << frozen << AmfString("config") << AmfString("b");
+
+	EXPECT_EQ(expected.data(), actual.data());
+}
+
+TEST(AmfFrozenItem, EmptyContext) {
+	AmfObject obj = config();
+	AmfFrozenItem frozen(obj);
+	EXPECT_TRUE(frozen.relocatable());
+	EXPECT_EQ(obj, frozen.item());
+
+	SerializationContext ctx, fctx;
+	EXPECT_EQ(obj.serialize(ctx), frozen.serialize(fctx));
+	sameAsUnfrozen({}, obj, frozen);
+}
+
+TEST(AmfFrozenItem, RelocatedIntoNonEmptyContext) {
+	AmfObject obj = config();
+	AmfFrozenItem frozen(obj);
+
+	sameAsUnfrozen({
+		AmfItemPtr(AmfString("foo")),
+		AmfItemPtr(AmfArray()),
+		AmfItemPtr(AmfObject("foo", false, false))
+	}, obj, frozen);
+}
+
+TEST(AmfFrozenItem, ConflictingEntries) {
+	AmfObject obj = config();
+	AmfFrozenItem frozen(obj);
+
+	// Strings, traits and objects of the item that are already known to the
+	// context are sent by reference.
+	sameAsUnfrozen({ AmfItemPtr(AmfString("a")) }, obj, frozen);
+	sameAsUnfrozen({ AmfItemPtr(config()) }, obj, frozen);
+	sameAsUnfrozen({ AmfItemPtr(AmfByteArray(v8 { 1, 2, 3 })) }, obj, frozen);
+
+	AmfObject other("de.ventero.AmfTest.Config", true, false);
+	other.addSealedProperty("name", AmfString("other"));
+	other.addSealedProperty("version", AmfInteger(1));
+	other.addSealedProperty("data", AmfByteArray(v8 { }));
+	sameAsUnfrozen({ AmfItemPtr(other) }, obj, frozen);
+}
+
+TEST(AmfFrozenItem, InternalReferences) {
+	AmfObject obj("", true, false);
+	obj.addDynamicProperty("a", AmfString("foo"));
+	obj.addDynamicProperty("b", AmfString("foo"));
+
+	AmfFrozenItem frozen(obj);
+	EXPECT_FALSE(frozen.relocatable());
+
+	sameAsUnfrozen({}, obj, frozen);
+	sameAsUnfrozen({ AmfItemPtr(AmfString("bar")) }, obj, frozen);
+}
+
+TEST(AmfFrozenItem, NestedInOtherItems) {
+	AmfObject obj = config();
+	AmfFrozenItem frozen(obj);
+
+	AmfArray expected;
+	expected.push_back(AmfString("foo"));
+	expected.push_back(obj);
+	expected.push_back(obj);
+
+	AmfArray actual;
+	actual.push_back(AmfString("foo"));
+	actual.push_back(frozen);
+	actual.push_back(frozen);
+
+	SerializationContext ectx, actx;
+	EXPECT_EQ(expected.serialize(ectx), actual.serialize(actx));
+}
+
+TEST(AmfFrozenItem, UsesCachedData) {
+	AmfObject obj = config();
+	obj.addDynamicProperty("counted", CountingString("counted"));
+
+	CountingString::count = 0;
+	AmfFrozenItem frozen(obj);
+	int afterFreeze = CountingString::count;
+
+	Serializer serializer;
+	serializer << frozen;
+	serializer << AmfString("foo") << AmfFrozenItem(AmfInteger(1)) << frozen;
+	EXPECT_EQ(afterFreeze, CountingString::count);
+
+	// Falls back to serializing the item if the data can't be reused.
+	Serializer other;
+	other << AmfString("counted") << frozen;
+	EXPECT_EQ(afterFreeze + 1, CountingString::count);
+}
+
+TEST(AmfFrozenItem, Equality) {
+	AmfFrozenItem frozen(config());
+	EXPECT_EQ(frozen, AmfFrozenItem(config()));
+	EXPECT_EQ(frozen, config());
+	EXPECT_NE(frozen, AmfFrozenItem(AmfString("config")));
+	EXPECT_NE(frozen, AmfString("config"));
+}
@@ -0,0 +1,138 @@
+#include "amftest.hpp"
+
+#include "deserializer.hpp"
+#include "types/amfarray.hpp"
+#include "types/amfdictionary.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfobject.hpp"
+#include "types/amfstring.hpp"
+#include "utils/amfgraph.hpp"
+
+// Dense array containing itself and the string "foo", and a dynamic object
+// containing the array, with a property pointing back to the object.
+static const v8 cyclic {
+	0x09, 0x05, 0x01,
+		0x09, 0x00,
+		0x06, 0x07, 0x66, 0x6f, 0x6f,
+};
+
+static const v8 cyclicObject {
+	0x0a, 0x0b, 0x01,
+		0x03, 0x61,
+		0x09, 0x05, 0x01,
+			0x09, 0x02,
+			0x06, 0x07, 0x66, 0x6f, 0x6f,
+		0x03, 0x6f,
+		0x0a, 0x00,
+		0x01
+};
+
+TEST(AmfGraph, DecodeLoopDoesNotLeak) {
+	int leaked = 0;
+	for (int i = 0; i < 10000; ++i) {
+		AmfItemPtr leaf;
+		{
+			SerializationContext ctx;
+			auto it = cyclic.cbegin();
+			AmfGraph graph = AmfGraph::deserialize(it, cyclic.cend(), ctx);
+			const AmfArray& array = graph.root().as<AmfArray>();
+			ASSERT_EQ(graph.root().get(), array.dense.at(0).get());
+			leaf = array.dense.at(1);
+		}
+
+		// The array was freed along with its reference to the string.
+		if (leaf.use_count() != 1)
+			++leaked;
+	}
+
+	EXPECT_EQ(0, leaked);
+}
+
+TEST(AmfGraph, ContextOutlivesGraph) {
+	AmfItemPtr leaf;
+	SerializationContext ctx;
+	{
+		auto it = cyclicObject.cbegin();
+		AmfGraph graph = AmfGraph::deserialize(it, cyclicObject.cend(), ctx);
+		EXPECT_EQ(cyclicObject.cend(), it);
+
+		const AmfObject& obj = graph.root().as<AmfObject>();
+		EXPECT_EQ(graph.root(), obj.dynamicProperties.at("o"));
+		leaf = obj.dynamicProperties.at("a").as<AmfArray>().dense.at(1);
+	}
+
+	// Still referenced by the context.
+	EXPECT_EQ(AmfString("foo"), leaf.as<AmfString>());
+	EXPECT_EQ(2, leaf.use_count());
+	const AmfObject& obj = ctx.getObject<AmfObject>(0);
+	EXPECT_EQ(ctx.getPointer<AmfArray>(1), obj.dynamicProperties.at("a"));
+
+	// Clearing the context frees the cycles.
+	ctx.clear();
+	EXPECT_EQ(1, leaf.use_count());
+}
+
+TEST(AmfGraph, ExternalReferencesStayIntact) {
+	AmfItemPtr inner(new AmfArray());
+	inner.as<AmfArray>().dense.push_back(inner);
+	inner.as<AmfArray>().push_back(AmfInteger(1));
+
+	AmfItemPtr outer(new AmfArray());
+	outer.as<AmfArray>().dense.push_back(outer);
+	outer.as<AmfArray>().dense.push_back(inner);
+
+	AmfGraph graph(outer);
+	outer.reset();
+
+	// Only outer is freed, inner is still referenced.
+	EXPECT_EQ(1u, graph.reset());
+	EXPECT_EQ(nullptr, graph.root().get());
+	EXPECT_EQ(2, inner.use_count());
+	ASSERT_EQ(2u, inner.as<AmfArray>().dense.size());
+	EXPECT_EQ(inner.get(), inner.as<AmfArray>().dense[0].get());
+
+	EXPECT_EQ(0u, AmfGraph(AmfItemPtr(new AmfInteger(1))).reset());
+
+	// Nothing is freed while the root is referenced from elsewhere.
+	AmfGraph other(inner);
+	EXPECT_EQ(0u, other.reset());
+	EXPECT_EQ(2u, inner.as<AmfArray>().dense.size());
+
+	// Break the cycle.
+	inner.as<AmfArray>().dense.clear();
+}
+
+TEST(AmfGraph, Dictionary) {
+	// Dictionary containing itself as key and value.
+	AmfItemPtr dict(new AmfDictionary(false));
+	dict.as<AmfDictionary>().values[dict] = dict;
+	AmfItemPtr leaf(new AmfString("foo"));
+	dict.as<AmfDictionary>().values[leaf] = leaf;
+
+	AmfGraph graph(dict);
+	dict.reset();
+	EXPECT_EQ(3, leaf.use_count());
+	EXPECT_EQ(1u, graph.reset());
+	EXPECT_EQ(1, leaf.use_count());
+}
+
+TEST(AmfGraph, Move) {
+	AmfItemPtr leaf(new AmfString("foo"));
+	AmfItemPtr ptr(new AmfArray());
+	ptr.as<AmfArray>().dense.push_back(ptr);
+	ptr.as<AmfArray>().dense.push_back(leaf);
+
+	AmfGraph graph(ptr);
+	ptr.reset();
+
+	AmfGraph moved(std::move(graph));
+	EXPECT_EQ(nullptr, graph.root().get());
+	EXPECT_EQ(2, leaf.use_count());
+
+	graph = std::move(moved);
+	EXPECT_EQ(nullptr, moved.root().get());
+	EXPECT_EQ(2, leaf.use_count());
+
+	graph = AmfGraph();
+	EXPECT_EQ(1, leaf.use_count());
+}
@@ -0,0 +1,99 @@
+#include "amftest.hpp"
+
+#include "types/amfarray.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfobject.hpp"
+#include "utils/amffrozenitem.hpp"
+#include "utils/amfhashstate.hpp"
+
+// Hashes like an AmfInteger, but counts how often it was hashed.
+class CountingInteger : public AmfInteger {
+public:
+	CountingInteger(int value) : AmfInteger(value) { }
+
+	size_t hashValue(int depth, AmfHashState& state) const {
+		++count;
+		return AmfInteger::hashValue(depth, state);
+	}
+
+	static int count;
+};
+
+int CountingInteger::count = 0;
+
+// Builds arrays in which every level contains the next one twice.
+static AmfItemPtr chain(int levels, bool shared) {
+	if (levels == 0)
+		return AmfItemPtr(new AmfInteger(levels));
+
+	AmfItemPtr inner = chain(levels - 1, shared);
+	AmfItemPtr ptr(new AmfArray());
+	ptr.as<AmfArray>().dense.push_back(inner);
+	ptr.as<AmfArray>().dense.push_back(shared ? inner : chain(levels - 1, shared));
+	return ptr;
+}
+
+TEST(AmfHashState, SharedItemsHashLikeCopies) {
+	for (int levels = 0; levels < 8; ++levels) {
+		AmfItemPtr shared = chain(levels, true);
+		AmfItemPtr copy = chain(levels, false);
+		EXPECT_EQ(shared, copy);
+		EXPECT_EQ(shared->hash(), copy->hash());
+	}
+}
+
+TEST(AmfHashState, SharedItemsAreHashedOnce) {
+	AmfItemPtr counted(new CountingInteger(1));
+	AmfArray array;
+	for (int i = 0; i < 100; ++i)
+		array.dense.push_back(counted);
+
+	CountingInteger::count = 0;
+	size_t hash = array.hash();
+	EXPECT_EQ(1, CountingInteger::count);
+
+	// Unshared items are hashed every time.
+	AmfArray unshared;
+	for (int i = 0; i < 100; ++i)
+		unshared.push_back(CountingInteger(1));
+
+	CountingInteger::count = 0;
+	EXPECT_EQ(hash, unshared.hash());
+	EXPECT_EQ(100, CountingInteger::count);
+
+	// Every hash() call starts with an empty state.
+	CountingInteger::count = 0;
+	array.hash();
+	EXPECT_EQ(1, CountingInteger::count);
+}
+
+TEST(AmfHashState, SelfReference) {
+	AmfItemPtr ptr(new AmfArray());
+	ptr.as<AmfArray>().dense.push_back(ptr);
+	ptr.as<AmfArray>().dense.push_back(AmfItemPtr(new AmfInteger(1)));
+
+	AmfHashState state;
+	size_t hash = state.hash(ptr, AmfItem::HASH_DEPTH);
+	EXPECT_EQ(hash, ptr->hash());
+	// The memoized value is returned for the same depth.
+	EXPECT_EQ(hash, state.hash(ptr, AmfItem::HASH_DEPTH));
+
+	// Break the cycle.
+	ptr.as<AmfArray>().dense.clear();
+}
+
+TEST(AmfHashState, FrozenItemsCacheTheirHash) {
+	AmfObject obj("", true, false);
+	obj.addSealedProperty("a", CountingInteger(1));
+	obj.addDynamicProperty("b", AmfArray(std::vector<AmfInteger> { 1, 2 }));
+
+	AmfFrozenItem frozen(obj);
+	EXPECT_EQ(obj.hash(), frozen.hash());
+
+	CountingInteger::count = 0;
+	frozen.hash();
+	AmfArray array;
+	array.push_back(frozen);
+	EXPECT_EQ(AmfArray(std::vector<AmfObject> { obj }).hash(), array.hash());
+	EXPECT_EQ(1, CountingInteger::count);
+}
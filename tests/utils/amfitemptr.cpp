@@ -1,7 +1,9 @@
 #include "amftest.hpp"
 
+#include "types/amfarray.hpp"
 #include "types/amfdouble.hpp"
 #include "types/amfinteger.hpp"
+#include "types/amfobject.hpp"
 #include "utils/amfitemptr.hpp"
 
 TEST(AmfItemPtr, Construction) {
@@ -54,4 +56,80 @@ TEST(AmfItemPtr, Equality) {
 	EXPECT_EQ(i1, i1);
 	EXPECT_EQ(i1, i2);
 	EXPECT_NE(i1, d1);
+
+	AmfItemPtr empty;
+	EXPECT_NE(i1, empty);
+	EXPECT_NE(empty, i1);
+}
+
+// Builds arrays in which every level contains the next one twice.
+static AmfItemPtr sharedChain(int levels, int leaf) {
+	AmfItemPtr ptr(new AmfInteger(leaf));
+	for (int i = 0; i < levels; ++i) {
+		AmfItemPtr next(new AmfArray());
+		next.as<AmfArray>().dense.push_back(ptr);
+		next.as<AmfArray>().dense.push_back(ptr);
+		ptr = next;
+	}
+	return ptr;
+}
+
+TEST(AmfItemPtr, SharedEquality) {
+	// Without remembering compared pairs, this would compare 2^64 leaves.
+	EXPECT_EQ(sharedChain(64, 1), sharedChain(64, 1));
+	EXPECT_NE(sharedChain(64, 1), sharedChain(64, 2));
+	EXPECT_NE(sharedChain(64, 1), sharedChain(63, 1));
+}
+
+TEST(AmfItemPtr, CyclicEquality) {
+	// a = { next: b }, b = { next: a }
+	AmfItemPtr a(new AmfObject("", true, false));
+	AmfItemPtr b(new AmfObject("", true, false));
+	a.as<AmfObject>().dynamicProperties["next"] = b;
+	b.as<AmfObject>().dynamicProperties["next"] = a;
+
+	// c = { next: c }
+	AmfItemPtr c(new AmfObject("", true, false));
+	c.as<AmfObject>().dynamicProperties["next"] = c;
+
+	// d = { next: d, value: 1 }
+	AmfItemPtr d(new AmfObject("", true, false));
+	d.as<AmfObject>().dynamicProperties["next"] = d;
+	d.as<AmfObject>().dynamicProperties["value"] = AmfItemPtr(new AmfInteger(1));
+
+	// All of a, b and c unfold to the same infinite structure.
+	EXPECT_EQ(a, b);
+	EXPECT_EQ(a, c);
+	EXPECT_EQ(c, b);
+	EXPECT_NE(a, d);
+	EXPECT_NE(d, c);
+
+	// Break the cycles.
+	a.as<AmfObject>().dynamicProperties.clear();
+	b.as<AmfObject>().dynamicProperties.clear();
+	c.as<AmfObject>().dynamicProperties.clear();
+	d.as<AmfObject>().dynamicProperties.clear();
+}
+
+TEST(AmfItemPtr, AssumptionsAreRolledBack) {
+	// x = [x, 1] and y = [y, 2]: comparing x[0] with y[0] assumes x == y,
+	// which turns out to be wrong once x[1] and y[1] are compared.
+	AmfItemPtr x(new AmfArray());
+	x.as<AmfArray>().dense.push_back(x);
+	x.as<AmfArray>().dense.push_back(AmfItemPtr(new AmfInteger(1)));
+	AmfItemPtr y(new AmfArray());
+	y.as<AmfArray>().dense.push_back(y);
+	y.as<AmfArray>().dense.push_back(AmfItemPtr(new AmfInteger(2)));
+
+	AmfArray outer1, outer2;
+	outer1.dense = { x, x };
+	outer2.dense = { y, x };
+	EXPECT_NE(outer1, outer2);
+	outer2.dense = { x, y };
+	EXPECT_NE(outer1, outer2);
+	outer2.dense = { x, x };
+	EXPECT_EQ(outer1, outer2);
+
+	x.as<AmfArray>().dense.clear();
+	y.as<AmfArray>().dense.clear();
 }
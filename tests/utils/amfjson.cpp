@@ -0,0 +1,336 @@
+#include "amftest.hpp"
+
+#include <cmath>
+
+#include "deserializer.hpp"
+#include "types/amfarray.hpp"
+#include "types/amfbool.hpp"
+#include "types/amfbytearray.hpp"
+#include "types/amfdate.hpp"
+#include "types/amfdictionary.hpp"
+#include "types/amfdouble.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfnull.hpp"
+#include "types/amfobject.hpp"
+#include "types/amfstring.hpp"
+#include "types/amfundefined.hpp"
+#include "types/amfvector.hpp"
+#include "types/amfxml.hpp"
+#include "utils/amfflex.hpp"
+#include "utils/amfjson.hpp"
+
+static std::string json(const v8& data, const AmfJson::Options& options = AmfJson::Options()) {
+	auto it = data.cbegin();
+	std::string ret = AmfJson::toJson(it, data.cend(), options);
+	EXPECT_EQ(data.cend(), it);
+	return ret;
+}
+
+static std::string json(const AmfItem& item) {
+	SerializationContext ctx;
+	return json(item.serialize(ctx));
+}
+
+TEST(AmfJson, Scalars) {
+	EXPECT_EQ("null", json(AmfUndefined()));
+	EXPECT_EQ("null", json(AmfNull()));
+	EXPECT_EQ("true", json(AmfBool(true)));
+	EXPECT_EQ("false", json(AmfBool(false)));
+	EXPECT_EQ("-268435456", json(AmfInteger(-268435456)));
+	EXPECT_EQ("0.1", json(AmfDouble(0.1)));
+	EXPECT_EQ("1e+300", json(AmfDouble(1e300)));
+	EXPECT_EQ("0.30000000000000004", json(AmfDouble(0.1 + 0.2)));
+	EXPECT_EQ("null", json(AmfDouble(NAN)));
+	EXPECT_EQ("null", json(AmfDouble(-INFINITY)));
+}
+
+TEST(AmfJson, Strings) {
+	EXPECT_EQ("\"\"", json(AmfString("")));
+	EXPECT_EQ("\"a\\\"b\\\\c\\n\\t\\u0001\xc3\xa9\"", json(AmfString("a\"b\\c\n\t\x01\xc3\xa9")));
+	EXPECT_EQ("\"<a>b</a>\"", json(AmfXml("<a>b</a>")));
+}
+
+TEST(AmfJson, Dates) {
+	EXPECT_EQ("\"2014-05-13T16:53:20.000Z\"", json(AmfDate(1400000000000LL)));
+	EXPECT_EQ("\"1970-01-01T00:00:00.123Z\"", json(AmfDate(123)));
+	EXPECT_EQ("\"1969-12-31T23:59:59.999Z\"", json(AmfDate(-1)));
+	EXPECT_EQ("\"2000-02-29T23:59:59.000Z\"", json(AmfDate(951868799000LL)));
+}
+
+TEST(AmfJson, ByteArrays) {
+	EXPECT_EQ("\"\"", json(AmfByteArray(v8 { })));
+	EXPECT_EQ("\"Zg==\"", json(AmfByteArray(v8 { 'f' })));
+	EXPECT_EQ("\"Zm8=\"", json(AmfByteArray(v8 { 'f', 'o' })));
+	EXPECT_EQ("\"Zm9v\"", json(AmfByteArray(v8 { 'f', 'o', 'o' })));
+	EXPECT_EQ("\"Zm9vYg==\"", json(AmfByteArray(v8 { 'f', 'o', 'o', 'b' })));
+	EXPECT_EQ("\"AP/+\"", json(AmfByteArray(v8 { 0x00, 0xff, 0xfe })));
+}
+
+TEST(AmfJson, Arrays) {
+	EXPECT_EQ("[]", json(AmfArray()));
+
+	AmfArray dense;
+	dense.push_back(AmfInteger(1));
+	dense.push_back(AmfString("a"));
+	dense.push_back(AmfNull());
+	EXPECT_EQ("[1,\"a\",null]", json(dense));
+
+	AmfArray mixed(std::vector<AmfInteger> { 1, 2 });
+	mixed.insert("a", AmfBool(true));
+	mixed.insert("b", AmfString("c"));
+	EXPECT_EQ("{\"a\":true,\"b\":\"c\",\"0\":1,\"1\":2}", json(mixed));
+}
+
+TEST(AmfJson, Objects) {
+	AmfObject sealed("de.ventero.Test", false, false);
+	sealed.addSealedProperty("x", AmfInteger(1));
+	sealed.addSealedProperty("y", AmfString("z"));
+	EXPECT_EQ("{\"x\":1,\"y\":\"z\"}", json(sealed));
+
+	AmfObject dynamic("", true, false);
+	dynamic.addDynamicProperty("k", AmfArray());
+	EXPECT_EQ("{\"k\":[]}", json(dynamic));
+	EXPECT_EQ("{}", json(AmfObject("", true, false)));
+
+	AmfObject both("de.ventero.Test", true, false);
+	both.addSealedProperty("x", AmfInteger(1));
+	both.addDynamicProperty("d", AmfNull());
+	EXPECT_EQ("{\"x\":1,\"d\":null}", json(both));
+}
+
+TEST(AmfJson, Vectors) {
+	EXPECT_EQ("[-1,2]", json(AmfVector<int>({ -1, 2 })));
+	EXPECT_EQ("[4294967295]", json(AmfVector<unsigned int>({ 4294967295u })));
+	EXPECT_EQ("[0.5,-2]", json(AmfVector<double>({ 0.5, -2 }, true)));
+	EXPECT_EQ("[]", json(AmfVector<double>()));
+	EXPECT_EQ("[\"a\",\"b\"]", json(AmfVector<AmfString>({ "a", "b" }, "String")));
+}
+
+TEST(AmfJson, Dictionaries) {
+	AmfDictionary strings(false);
+	strings.insert(AmfString("a"), AmfInteger(1));
+	EXPECT_EQ("{\"a\":1}", json(strings));
+
+	AmfDictionary numbers(false);
+	numbers.insert(AmfInteger(2), AmfString("b"));
+	EXPECT_EQ("{\"2\":\"b\"}", json(numbers));
+
+	AmfDictionary objects(false, true);
+	objects.insert(AmfArray(std::vector<AmfString> { "x" }), AmfBool(false));
+	EXPECT_EQ("{\"[\\\"x\\\"]\":false}", json(objects));
+}
+
+TEST(AmfJson, Externalizable) {
+	AmfArray source(std::vector<AmfInteger> { 1 });
+	EXPECT_EQ("[1]", json(AmfFlex::arrayCollection(AmfItemPtr(source))));
+
+	// ObjectProxy wraps an object.
+	AmfObject inner("", true, false);
+	inner.addDynamicProperty("a", AmfInteger(1));
+	EXPECT_EQ("{\"a\":1}", json(AmfFlex::objectProxy(AmfItemPtr(inner))));
+
+	v8 unknown { 0x0a, 0x07, 0x07, 'F', 'o', 'o', 0x01 };
+	auto it = unknown.cbegin();
+	EXPECT_THROW(AmfJson::toJson(it, unknown.cend()), std::invalid_argument);
+}
+
+TEST(AmfJson, References) {
+	AmfObject first("de.ventero.Test", false, false);
+	first.addSealedProperty("a", AmfString("x"));
+	AmfObject second("de.ventero.Test", false, false);
+	second.addSealedProperty("a", AmfString("y"));
+
+	AmfArray array;
+	array.push_back(first);
+	array.push_back(first);
+	// Reading the reference again must not add the traits or strings of
+	// the first object a second time.
+	array.push_back(second);
+	array.push_back(AmfString("x"));
+	array.push_back(AmfDate(0LL));
+	array.push_back(AmfDate(0LL));
+
+	SerializationContext ctx;
+	v8 data = array.serialize(ctx);
+	EXPECT_EQ("[{\"a\":\"x\"},{\"a\":\"x\"},{\"a\":\"y\"},\"x\","
+		"\"1970-01-01T00:00:00.000Z\",\"1970-01-01T00:00:00.000Z\"]", json(data));
+
+	AmfJson::Options options;
+	options.expandReferences = false;
+	EXPECT_EQ("[{\"a\":\"x\"},{\"$ref\":1},{\"a\":\"y\"},\"x\","
+		"\"1970-01-01T00:00:00.000Z\",{\"$ref\":3}]", json(data, options));
+
+	v8 invalid { 0x09, 0x03, 0x01, 0x09, 0x02 };
+	auto it = invalid.cbegin();
+	EXPECT_THROW(AmfJson::toJson(it, invalid.cend()), std::out_of_range);
+}
+
+TEST(AmfJson, Cycles) {
+	// An array containing itself, and an object containing an array
+	// containing the object.
+	v8 array { 0x09, 0x03, 0x01, 0x09, 0x00 };
+	v8 object { 0x0a, 0x0b, 0x01, 0x03, 'a', 0x09, 0x03, 0x01, 0x0a, 0x00, 0x01 };
+
+	auto it = array.cbegin();
+	EXPECT_THROW(AmfJson::toJson(it, array.cend()), std::invalid_argument);
+
+	AmfJson::Options options;
+	options.cycles = AmfJson::CYCLE_NULL;
+	EXPECT_EQ("[null]", json(array, options));
+	EXPECT_EQ("{\"a\":[null]}", json(object, options));
+
+	options.cycles = AmfJson::CYCLE_MARKER;
+	EXPECT_EQ("[{\"$ref\":0}]", json(array, options));
+	EXPECT_EQ("{\"a\":[{\"$ref\":0}]}", json(object, options));
+}
+
+TEST(AmfJson, Sink) {
+	AmfArray array;
+	for (int i = 0; i < 20000; ++i)
+		array.push_back(AmfString("item" + std::to_string(i)));
+
+	SerializationContext ctx;
+	v8 data = array.serialize(ctx);
+
+	std::string text;
+	int calls = 0;
+	auto it = data.cbegin();
+	AmfJson::transcode(it, data.cend(), [&](const char* data, size_t size) {
+		text.append(data, size);
+		++calls;
+	});
+
+	EXPECT_GT(calls, 1);
+	EXPECT_EQ(json(data), text);
+	EXPECT_EQ("[\"item0\",", text.substr(0, 9));
+}
+
+TEST(AmfJson, NotEnoughBytes) {
+	for (const v8& data : { v8 { }, v8 { 0x05, 0x00 }, v8 { 0x06, 0x07, 'a' },
+		v8 { 0x09, 0x05, 0x01, 0x04 }, v8 { 0x0c, 0x05, 0x00 }, v8 { 0x0d, 0x05, 0x00, 0x00 } }) {
+		auto it = data.cbegin();
+		EXPECT_THROW(AmfJson::toJson(it, data.cend()), std::out_of_range);
+	}
+
+	v8 invalid { 0x20 };
+	auto it = invalid.cbegin();
+	EXPECT_THROW(AmfJson::toJson(it, invalid.cend()), std::invalid_argument);
+}
+
+static v8 encode(const std::string& json) {
+	SerializationContext ctx;
+	return AmfJson::fromJson(json, ctx);
+}
+
+static v8 serialized(const AmfItem& item) {
+	SerializationContext ctx;
+	return item.serialize(ctx);
+}
+
+TEST(AmfJson, FromJsonScalars) {
+	EXPECT_EQ(serialized(AmfNull()), encode("null"));
+	EXPECT_EQ(serialized(AmfBool(true)), encode(" true "));
+	EXPECT_EQ(serialized(AmfBool(false)), encode("false"));
+	EXPECT_EQ(serialized(AmfInteger(0)), encode("0"));
+	EXPECT_EQ(serialized(AmfInteger(268435455)), encode("268435455"));
+	EXPECT_EQ(serialized(AmfInteger(-268435456)), encode("-268435456"));
+	EXPECT_EQ(serialized(AmfDouble(268435456)), encode("268435456"));
+	EXPECT_EQ(serialized(AmfDouble(-268435457)), encode("-268435457"));
+	EXPECT_EQ(serialized(AmfDouble(12345678901234.0)), encode("12345678901234"));
+	EXPECT_EQ(serialized(AmfDouble(1)), encode("1.0"));
+	EXPECT_EQ(serialized(AmfDouble(-0.0)), encode("-0"));
+	EXPECT_EQ(serialized(AmfDouble(-0.25e-3)), encode("-0.25E-3"));
+}
+
+TEST(AmfJson, FromJsonStrings) {
+	EXPECT_EQ(serialized(AmfString("")), encode("\"\""));
+	EXPECT_EQ(serialized(AmfString("a\"b\\c/\b\f\n\r\t")), encode("\"a\\\"b\\\\c\\/\\b\\f\\n\\r\\t\""));
+	// U+00E9, U+20AC and U+1F600 as surrogate pair
+	EXPECT_EQ(serialized(AmfString("\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80")),
+		encode("\"\\u00e9\\u20AC\\ud83d\\ude00\""));
+	EXPECT_EQ(serialized(AmfString("\xc3\xa9")), encode("\"\xc3\xa9\""));
+}
+
+TEST(AmfJson, FromJsonContainers) {
+	AmfArray inner;
+	inner.push_back(AmfInteger(1));
+	inner.push_back(AmfDouble(2.5));
+	inner.push_back(AmfString("a"));
+
+	AmfObject obj("", true, false);
+	obj.addDynamicProperty("a", inner);
+	obj.addDynamicProperty("b", AmfNull());
+	obj.addDynamicProperty("c", AmfObject("", true, false));
+
+	// The second "a" and the inner object's traits are sent by reference.
+	EXPECT_EQ(serialized(obj), encode("{\"a\": [1, 2.5, \"a\"], \"b\": null, \"c\": {}}"));
+	EXPECT_EQ(serialized(AmfArray()), encode("[ ]"));
+
+	AmfArray nested;
+	nested.push_back(AmfArray());
+	nested.push_back(AmfArray(std::vector<AmfBool> { true }));
+	EXPECT_EQ(serialized(nested), encode("[[],[true]]"));
+}
+
+TEST(AmfJson, FromJsonLargeArray) {
+	// More than 127 elements need a longer U29A-value.
+	std::string json("[");
+	AmfArray array;
+	for (int i = 0; i < 20000; ++i) {
+		json += (i > 0 ? "," : "") + std::to_string(i);
+		array.push_back(AmfInteger(i));
+	}
+	json += "]";
+
+	EXPECT_EQ(serialized(array), encode(json));
+}
+
+TEST(AmfJson, FromJsonRoundTrip) {
+	std::string text("{\"id\":5,\"name\":\"x\\ny\",\"tags\":[\"x\\ny\",null,true],"
+		"\"nested\":{\"price\":0.1,\"items\":[{\"id\":-1},{}]}}");
+
+	v8 data = encode(text);
+	EXPECT_EQ(text, json(data));
+
+	// The same objects as read by the deserializer.
+	SerializationContext ctx;
+	auto it = data.cbegin();
+	AmfItemPtr ptr = Deserializer::deserialize(it, data.cend(), ctx);
+	EXPECT_EQ(data.cend(), it);
+	EXPECT_EQ(AmfString("x\ny"), ptr.as<AmfObject>().getDynamicProperty<AmfString>("name"));
+}
+
+TEST(AmfJson, FromJsonSharedContext) {
+	// Values encoded with the same context form a stream, which may also
+	// contain values serialized otherwise.
+	SerializationContext sctx;
+	v8 data = AmfJson::fromJson("[{\"a\":\"b\"}]", sctx);
+	AmfArray array(std::vector<AmfString> { "b" });
+	v8 value = array.serialize(sctx);
+	data.insert(data.end(), value.begin(), value.end());
+	value = AmfJson::fromJson("{\"a\":\"b\"}", sctx);
+	data.insert(data.end(), value.begin(), value.end());
+	value = array.serialize(sctx);
+	data.insert(data.end(), value.begin(), value.end());
+
+	SerializationContext ctx;
+	auto it = data.cbegin();
+	Deserializer::deserialize(it, data.cend(), ctx);
+	EXPECT_EQ(AmfItemPtr(array), Deserializer::deserialize(it, data.cend(), ctx));
+	AmfItemPtr obj = Deserializer::deserialize(it, data.cend(), ctx);
+	EXPECT_EQ(AmfString("b"), obj.as<AmfObject>().getDynamicProperty<AmfString>("a"));
+	// A reference to the second value, which is the third entry of the object
+	// table.
+	EXPECT_EQ(v8({ 0x09, 0x04 }), value);
+	EXPECT_EQ(AmfItemPtr(array), Deserializer::deserialize(it, data.cend(), ctx));
+	EXPECT_EQ(data.cend(), it);
+}
+
+TEST(AmfJson, FromJsonInvalid) {
+	for (const char* json : { "", " ", "nul", "truex", "[1,]", "[1 2]", "{\"a\" 1}",
+		"{\"a\":1,}", "{1:2}", "\"abc", "\"\\x\"", "\"\\u12\"", "\"a\x01\"", "01", "1.",
+		"-", "1e", ".5", "+1", "[1] x", "{\"\":1}", "[", "{" }) {
+		SerializationContext ctx;
+		EXPECT_THROW(AmfJson::fromJson(json, ctx), std::invalid_argument) << json;
+	}
+}
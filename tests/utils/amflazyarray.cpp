@@ -0,0 +1,145 @@
+#include "amftest.hpp"
+
+#include "deserializer.hpp"
+#include "types/amfarray.hpp"
+#include "types/amfbool.hpp"
+#include "types/amfdate.hpp"
+#include "types/amfdouble.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfobject.hpp"
+#include "types/amfstring.hpp"
+#include "types/amfvector.hpp"
+#include "utils/amflazyarray.hpp"
+
+static AmfObject item(int id) {
+	AmfObject ret("de.ventero.Item", false, false);
+	ret.addSealedProperty("id", AmfInteger(id));
+	ret.addSealedProperty("name", AmfString("item" + std::to_string(id)));
+	return ret;
+}
+
+TEST(AmfLazyArray, Elements) {
+	AmfArray array;
+	array.insert("key", AmfString("value"));
+	array.push_back(item(1));
+	array.push_back(AmfString("item1"));
+	array.push_back(AmfString("other"));
+	array.push_back(AmfInteger(3));
+	array.push_back(AmfDouble(0.5));
+	array.push_back(AmfBool(true));
+	array.push_back(AmfDate(1LL));
+	array.push_back(item(2));
+
+	SerializationContext sctx;
+	v8 data = array.serialize(sctx);
+
+	SerializationContext ctx;
+	auto it = data.cbegin();
+	AmfLazyArray lazy = AmfLazyArray::deserialize(it, data.cend(), ctx);
+	EXPECT_EQ(data.cend(), it);
+	ASSERT_EQ(8u, lazy.size());
+
+	EXPECT_FALSE(lazy.isDecoded(7));
+	AmfObject& last = lazy.at<AmfObject>(7);
+	EXPECT_EQ(item(2), last);
+	EXPECT_TRUE(lazy.isDecoded(7));
+	EXPECT_FALSE(lazy.isDecoded(0));
+	EXPECT_EQ(&last, &lazy.at<AmfObject>(7));
+
+	EXPECT_EQ(item(1), lazy.at<AmfObject>(0));
+	EXPECT_EQ(AmfString("item1"), lazy.at<AmfString>(1));
+	EXPECT_EQ(AmfString("other"), lazy.at<AmfString>(2));
+	EXPECT_EQ(AmfInteger(3), lazy.at<AmfInteger>(3));
+	EXPECT_EQ(AmfDouble(0.5), lazy.at<AmfDouble>(4));
+	EXPECT_EQ(AmfBool(true), lazy.at<AmfBool>(5));
+	EXPECT_EQ(AmfDate(1LL), lazy.at<AmfDate>(6));
+	EXPECT_THROW(lazy.item(8), std::out_of_range);
+
+	EXPECT_EQ(array, lazy.array().as<AmfArray>());
+	EXPECT_EQ(&last, &lazy.array().as<AmfArray>().at<AmfObject>(7));
+}
+
+TEST(AmfLazyArray, Vector) {
+	AmfVector<AmfObject> vector({ item(1), item(2), item(3) }, "de.ventero.Item", true);
+
+	SerializationContext sctx;
+	v8 data = vector.serialize(sctx);
+
+	SerializationContext ctx;
+	auto it = data.cbegin();
+	AmfLazyArray lazy = AmfLazyArray::deserialize(it, data.cend(), ctx);
+	ASSERT_EQ(3u, lazy.size());
+	EXPECT_EQ(item(2), lazy.at<AmfObject>(1));
+
+	const AmfVector<AmfItem>& ret = lazy.array().as<AmfVector<AmfItem>>();
+	EXPECT_EQ("de.ventero.Item", ret.type);
+	EXPECT_TRUE(ret.fixed);
+	EXPECT_EQ(vector, ret.as<AmfObject>());
+}
+
+TEST(AmfLazyArray, LaterReferences) {
+	AmfObject first = item(1);
+	AmfArray array(std::vector<AmfObject> { first, item(2) });
+
+	// The stream continues with references to an element, to the array and
+	// to a string only sent inside of the array.
+	SerializationContext sctx;
+	v8 data = array.serialize(sctx);
+	v8 rest = AmfArray(std::vector<AmfObject> { first }).serialize(sctx);
+	data.insert(data.end(), rest.begin(), rest.end());
+	rest = array.serialize(sctx);
+	data.insert(data.end(), rest.begin(), rest.end());
+	rest = AmfString("item2").serialize(sctx);
+	data.insert(data.end(), rest.begin(), rest.end());
+
+	SerializationContext ctx;
+	auto it = data.cbegin();
+	AmfLazyArray lazy = AmfLazyArray::deserialize(it, data.cend(), ctx);
+
+	AmfItemPtr next = Deserializer::deserialize(it, data.cend(), ctx);
+	EXPECT_EQ(first, next.as<AmfArray>().at<AmfObject>(0));
+	EXPECT_EQ(&next.as<AmfArray>().at<AmfObject>(0), &lazy.at<AmfObject>(0));
+
+	AmfItemPtr same = Deserializer::deserialize(it, data.cend(), ctx);
+	EXPECT_EQ(lazy.array(), same);
+	EXPECT_EQ(lazy.array().get(), same.get());
+	EXPECT_TRUE(lazy.isDecoded(1));
+
+	EXPECT_EQ(AmfString("item2"), Deserializer::deserialize(it, data.cend(), ctx).as<AmfString>());
+	EXPECT_EQ(data.cend(), it);
+
+	// A lazy array for a reference to a decoded array.
+	v8 reference { 0x09, 0x00 };
+	auto ref = reference.cbegin();
+	AmfLazyArray again = AmfLazyArray::deserialize(ref, reference.cend(), ctx);
+	EXPECT_TRUE(again.isDecoded(1));
+	EXPECT_EQ(&lazy.at<AmfObject>(1), &again.at<AmfObject>(1));
+}
+
+TEST(AmfLazyArray, Cycles) {
+	// An array containing itself, and an object containing the array.
+	v8 data { 0x09, 0x05, 0x01, 0x09, 0x00, 0x0a, 0x0b, 0x01, 0x03, 'a', 0x09, 0x00, 0x01 };
+
+	SerializationContext ctx;
+	auto it = data.cbegin();
+	AmfLazyArray lazy = AmfLazyArray::deserialize(it, data.cend(), ctx);
+
+	AmfArray& self = lazy.at<AmfArray>(0);
+	EXPECT_EQ(&self, &lazy.array().as<AmfArray>());
+	EXPECT_EQ(&self, &lazy.at<AmfObject>(1).getDynamicProperty<AmfArray>("a"));
+}
+
+TEST(AmfLazyArray, Invalid) {
+	SerializationContext ctx;
+	v8 object { 0x0a, 0x0b, 0x01, 0x01 };
+	auto it = object.cbegin();
+	EXPECT_THROW(AmfLazyArray::deserialize(it, object.cend(), ctx), std::invalid_argument);
+
+	v8 truncated { 0x09, 0x05, 0x01, 0x04, 0x01 };
+	it = truncated.cbegin();
+	EXPECT_THROW(AmfLazyArray::deserialize(it, truncated.cend(), ctx), std::out_of_range);
+
+	v8 reference { 0x09, 0x03, 0x01, 0x0a, 0x04 };
+	it = reference.cbegin();
+	EXPECT_THROW(AmfLazyArray::deserialize(it, reference.cend(), ctx), std::out_of_range);
+}
@@ -0,0 +1,274 @@
+#include "amftest.hpp"
+
+#include "deserializer.hpp"
+#include "types/amfarray.hpp"
+#include "types/amfbool.hpp"
+#include "types/amfbytearray.hpp"
+#include "types/amfdate.hpp"
+#include "types/amfdouble.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfobject.hpp"
+#include "types/amfstring.hpp"
+#include "types/amfvector.hpp"
+#include "utils/amfflex.hpp"
+#include "utils/amfparallel.hpp"
+
+static AmfObject item(int id) {
+	AmfObject payload("", true, false);
+	payload.addDynamicProperty("data", AmfByteArray(v8 { 1, 2, 3 }));
+	payload.addDynamicProperty("created", AmfDate(0LL));
+
+	AmfObject ret("de.ventero.Item", false, false);
+	ret.addSealedProperty("id", AmfInteger(id));
+	ret.addSealedProperty("name", AmfString("item" + std::to_string(id)));
+	ret.addSealedProperty("payload", payload);
+	return ret;
+}
+
+// Decodes data with threads threads, and checks that all values of the
+// stream are the same as after decoding it sequentially.
+static std::vector<AmfItemPtr> decode(const v8& data, unsigned threads) {
+	SerializationContext ctx;
+	auto it = data.cbegin();
+	std::vector<AmfItemPtr> ret { AmfParallel::deserialize(it, data.cend(), ctx, threads) };
+	while (it != data.cend())
+		ret.push_back(Deserializer::deserialize(it, data.cend(), ctx));
+
+	SerializationContext sequential;
+	auto expected = data.cbegin();
+	for (const AmfItemPtr& value : ret)
+		EXPECT_EQ(Deserializer::deserialize(expected, data.cend(), sequential), value);
+
+	return ret;
+}
+
+TEST(AmfParallel, Elements) {
+	AmfArray array;
+	array.insert("key", AmfString("item1"));
+	for (int i = 0; i < 20; ++i) {
+		array.push_back(item(i));
+		array.push_back(AmfString("item" + std::to_string(i)));
+		array.push_back(AmfInteger(i));
+		array.push_back(AmfDouble(i * 0.5));
+		array.push_back(AmfBool(i % 2 == 0));
+	}
+
+	SerializationContext sctx;
+	v8 data = array.serialize(sctx);
+
+	for (unsigned threads : { 1, 2, 3, 4, 8, 200 }) {
+		std::vector<AmfItemPtr> ret = decode(data, threads);
+		ASSERT_EQ(1u, ret.size());
+		EXPECT_EQ(array, ret[0].as<AmfArray>());
+	}
+}
+
+TEST(AmfParallel, Vector) {
+	AmfVector<AmfObject> vector({ item(1), item(2), item(3), item(4) }, "de.ventero.Item", true);
+
+	SerializationContext sctx;
+	v8 data = vector.serialize(sctx);
+
+	AmfItemPtr ret = decode(data, 4)[0];
+	const AmfVector<AmfItem>& values = ret.as<AmfVector<AmfItem>>();
+	EXPECT_EQ("de.ventero.Item", values.type);
+	EXPECT_TRUE(values.fixed);
+	EXPECT_EQ(vector, values.as<AmfObject>());
+}
+
+TEST(AmfParallel, References) {
+	// Elements referring to each other, to the array and to the associative
+	// part.
+	AmfObject shared = item(1);
+	AmfArray array;
+	array.insert("shared", shared);
+	array.push_back(item(2));
+	array.push_back(shared);
+	array.push_back(item(3));
+	array.push_back(AmfArray(std::vector<AmfObject> { item(2), item(4) }));
+	array.push_back(item(5));
+	array.push_back(item(3));
+
+	SerializationContext sctx;
+	v8 data = array.serialize(sctx);
+
+	AmfItemPtr ptr = decode(data, 4)[0];
+	AmfArray& ret = ptr.as<AmfArray>();
+	EXPECT_EQ(array, ret);
+	EXPECT_EQ(&ret.at<AmfObject>("shared"), &ret.at<AmfObject>(1));
+	EXPECT_EQ(&ret.at<AmfObject>(0), &ret.at<AmfArray>(3).at<AmfObject>(0));
+	EXPECT_EQ(&ret.at<AmfObject>(2), &ret.at<AmfObject>(5));
+
+	// An array containing itself, and an object containing the array.
+	v8 cycle { 0x09, 0x05, 0x01, 0x09, 0x00, 0x0a, 0x0b, 0x01, 0x03, 'a', 0x09, 0x00, 0x01 };
+	ptr = decode(cycle, 2)[0];
+	AmfArray& self = ptr.as<AmfArray>();
+	EXPECT_EQ(&self, &self.at<AmfArray>(0));
+	EXPECT_EQ(&self, &self.at<AmfObject>(1).getDynamicProperty<AmfArray>("a"));
+}
+
+TEST(AmfParallel, SharedContext) {
+	AmfObject first = item(1);
+	AmfArray array(std::vector<AmfObject> { first, item(2), item(3), item(4) });
+
+	// The stream starts with an object and a string that elements refer to,
+	// and continues with references to an element, to the array and to a
+	// string only sent inside of the array.
+	AmfObject before = item(5);
+	SerializationContext sctx;
+	v8 data = AmfVector<AmfObject>({ before }, "de.ventero.Item").serialize(sctx);
+	v8 rest = AmfString("item3").serialize(sctx);
+	data.insert(data.end(), rest.begin(), rest.end());
+	size_t start = data.size();
+
+	array.push_back(before);
+	rest = array.serialize(sctx);
+	data.insert(data.end(), rest.begin(), rest.end());
+	rest = AmfArray(std::vector<AmfObject> { first }).serialize(sctx);
+	data.insert(data.end(), rest.begin(), rest.end());
+	rest = array.serialize(sctx);
+	data.insert(data.end(), rest.begin(), rest.end());
+	rest = AmfString("item2").serialize(sctx);
+	data.insert(data.end(), rest.begin(), rest.end());
+
+	SerializationContext ctx;
+	auto it = data.cbegin();
+	AmfItemPtr vector = Deserializer::deserialize(it, data.cend(), ctx);
+	EXPECT_EQ(AmfString("item3"), Deserializer::deserialize(it, data.cend(), ctx).as<AmfString>());
+	ASSERT_EQ(data.cbegin() + start, it);
+
+	AmfItemPtr ptr = AmfParallel::deserialize(it, data.cend(), ctx, 3);
+	AmfArray& ret = ptr.as<AmfArray>();
+	EXPECT_EQ(array, ret);
+	EXPECT_EQ(vector.as<AmfVector<AmfItem>>().values.at(0).get(), &ret.at<AmfObject>(4));
+
+	AmfItemPtr next = Deserializer::deserialize(it, data.cend(), ctx);
+	EXPECT_EQ(&ret.at<AmfObject>(0), &next.as<AmfArray>().at<AmfObject>(0));
+	EXPECT_EQ(ptr.get(), Deserializer::deserialize(it, data.cend(), ctx).get());
+	EXPECT_EQ(AmfString("item2"), Deserializer::deserialize(it, data.cend(), ctx).as<AmfString>());
+	EXPECT_EQ(data.cend(), it);
+}
+
+TEST(AmfParallel, Externalizable) {
+	AmfArray source(std::vector<AmfInteger> { 1, 2 });
+	AmfArray array;
+	array.push_back(item(1));
+	array.push_back(AmfFlex::arrayCollection(AmfItemPtr(source)));
+	array.push_back(source);
+	array.push_back(item(2));
+
+	SerializationContext sctx;
+	v8 data = array.serialize(sctx);
+
+	AmfItemPtr ptr = decode(data, 4)[0];
+	AmfArray& ret = ptr.as<AmfArray>();
+	EXPECT_EQ(source, ret.at<AmfArray>(2));
+	EXPECT_EQ(&ret.at<AmfArray>(2), &AmfFlex::wrapped(ret.at<AmfObject>(1)).as<AmfArray>());
+}
+
+TEST(AmfParallel, Sequential) {
+	SerializationContext ctx;
+	v8 integer { 0x04, 0x05 };
+	auto it = integer.cbegin();
+	EXPECT_EQ(AmfInteger(5), AmfParallel::deserialize(it, integer.cend(), ctx, 4).as<AmfInteger>());
+	EXPECT_EQ(integer.cend(), it);
+
+	SerializationContext sctx;
+	v8 data = AmfArray(std::vector<AmfObject> { item(1), item(2) }).serialize(sctx);
+	data.push_back(0x09);
+	data.push_back(0x00);
+	std::vector<AmfItemPtr> values = decode(data, 4);
+	ASSERT_EQ(2u, values.size());
+	EXPECT_EQ(values[0].get(), values[1].get());
+
+	v8 reference { 0x09, 0x00 };
+	it = reference.cbegin();
+	EXPECT_THROW(AmfParallel::deserialize(it, reference.cend(), ctx, 4), std::out_of_range);
+
+	v8 truncated { 0x09, 0x05, 0x01, 0x04, 0x01 };
+	it = truncated.cbegin();
+	EXPECT_THROW(AmfParallel::deserialize(it, truncated.cend(), ctx, 4), std::out_of_range);
+
+	v8 invalid { 0x09, 0x05, 0x01, 0x04, 0x01, 0x0a, 0x06 };
+	it = invalid.cbegin();
+	EXPECT_THROW(AmfParallel::deserialize(it, invalid.cend(), ctx, 4), std::out_of_range);
+}
+
+// Serializes value with threads threads into a context that already contains
+// the values in before, and checks that the output and the context are the
+// same as after serializing it sequentially.
+static v8 encode(const AmfItem& value, unsigned threads, const std::vector<AmfItemPtr>& before = {}) {
+	SerializationContext ctx, sequential;
+	for (const AmfItemPtr& prior : before) {
+		prior->serialize(ctx);
+		prior->serialize(sequential);
+	}
+
+	v8 ret = AmfParallel::serialize(value, ctx, threads);
+	EXPECT_EQ(value.serialize(sequential), ret);
+
+	for (const AmfItemPtr& prior : before)
+		EXPECT_EQ(prior->serialize(sequential), prior->serialize(ctx));
+	EXPECT_EQ(value.serialize(sequential), value.serialize(ctx));
+	EXPECT_EQ(AmfString("item7").serialize(sequential), AmfString("item7").serialize(ctx));
+	EXPECT_EQ(item(7).serialize(sequential), item(7).serialize(ctx));
+
+	return ret;
+}
+
+TEST(AmfParallel, Serialize) {
+	AmfArray array;
+	array.insert("key", AmfString("item1"));
+	for (int i = 0; i < 20; ++i) {
+		array.push_back(item(i));
+		array.push_back(AmfString("item" + std::to_string(i)));
+		array.push_back(AmfInteger(i));
+		array.push_back(AmfDouble(i * 0.5));
+		array.push_back(AmfBool(i % 2 == 0));
+		array.push_back(item(i / 2));
+	}
+
+	for (unsigned threads : { 1, 2, 3, 4, 8, 200 }) {
+		v8 data = encode(array, threads);
+
+		SerializationContext ctx;
+		EXPECT_EQ(array, Deserializer::deserialize(data, ctx).as<AmfArray>());
+	}
+
+	SerializationContext ctx;
+	std::vector<v8> buffers = AmfParallel::serializeBuffers(array, ctx, 4);
+	EXPECT_EQ(5u, buffers.size());
+}
+
+TEST(AmfParallel, SerializeSharedContext) {
+	AmfArray array;
+	for (int i = 0; i < 10; ++i) {
+		array.push_back(item(i));
+		array.push_back(AmfVector<AmfObject>({ item(i), item(i + 1) }, "de.ventero.Item"));
+		array.push_back(AmfArray(std::vector<AmfInteger> { 1, 2, 3 }));
+		array.push_back(AmfByteArray(v8 { 1, 2, u8(i) }));
+		array.push_back(AmfDate(i * 1000LL));
+		array.push_back(AmfFlex::arrayCollection(AmfItemPtr(AmfArray(std::vector<AmfObject> { item(i) }))));
+	}
+
+	std::vector<AmfItemPtr> before {
+		AmfItemPtr(item(3)),
+		AmfItemPtr(AmfString("item5")),
+		AmfItemPtr(AmfArray(std::vector<AmfInteger> { 1, 2, 3 }))
+	};
+
+	AmfVector<AmfItem> vector("", false);
+	vector.values = array.dense;
+	for (unsigned threads : { 2, 4, 7 }) {
+		encode(array, threads, before);
+		encode(vector, threads, before);
+	}
+
+	// A reference to the array itself.
+	SerializationContext ctx;
+	array.serialize(ctx);
+	EXPECT_EQ(array.serialize(ctx), AmfParallel::serialize(array, ctx, 4));
+
+	// Other types are serialized sequentially.
+	EXPECT_EQ(item(1).serialize(ctx), AmfParallel::serialize(item(1), ctx, 4));
+}
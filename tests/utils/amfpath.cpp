@@ -0,0 +1,199 @@
+#include "amftest.hpp"
+
+#include "types/amfarray.hpp"
+#include "types/amfdictionary.hpp"
+#include "types/amfdouble.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfnull.hpp"
+#include "types/amfobject.hpp"
+#include "types/amfstring.hpp"
+#include "types/amfvector.hpp"
+#include "utils/amfflex.hpp"
+#include "utils/amfpath.hpp"
+
+static v8 serialized(const AmfItem& item) {
+	SerializationContext ctx;
+	return item.serialize(ctx);
+}
+
+static AmfItemPtr get(const std::string& path, const v8& data) {
+	return AmfPath(path).get(data.cbegin(), data.cend());
+}
+
+// Resembles a RemotingMessage: the members preceding the body and headers
+// put strings and traits into the reference tables.
+static v8 message() {
+	AmfObject call("de.ventero.Call", false, false);
+	call.addSealedProperty("operation", AmfString("getItems"));
+	call.addSealedProperty("source", AmfString("de.ventero.Items"));
+
+	AmfObject headers("", true, false);
+	headers.addDynamicProperty("DSEndpoint", AmfString("my-amf"));
+	headers.addDynamicProperty("DSId", AmfString("0A1B2C3D"));
+
+	AmfObject msg("flex.messaging.messages.RemotingMessage", false, false);
+	msg.addSealedProperty("destination", AmfString("de.ventero.Items"));
+	msg.addSealedProperty("source", AmfNull());
+	msg.addSealedProperty("body", AmfArray(std::vector<AmfObject> { call, call }));
+	msg.addSealedProperty("headers", headers);
+	msg.addSealedProperty("timeToLive", AmfInteger(0));
+	return serialized(msg);
+}
+
+TEST(AmfPath, Message) {
+	v8 data = message();
+
+	EXPECT_EQ(AmfString("getItems"), get("body[0].operation", data).as<AmfString>());
+	EXPECT_EQ(AmfString("de.ventero.Items"), get("body[0].source", data).as<AmfString>());
+	EXPECT_EQ(AmfString("0A1B2C3D"), get("headers.DSId", data).as<AmfString>());
+	EXPECT_EQ(AmfInteger(0), get("timeToLive", data).as<AmfInteger>());
+
+	// The second element is a reference to the first one.
+	EXPECT_EQ(AmfString("getItems"), get("body[1].operation", data).as<AmfString>());
+
+	AmfObject headers("", true, false);
+	headers.addDynamicProperty("DSEndpoint", AmfString("my-amf"));
+	headers.addDynamicProperty("DSId", AmfString("0A1B2C3D"));
+	EXPECT_EQ(headers, get("headers", data).as<AmfObject>());
+}
+
+TEST(AmfPath, Find) {
+	v8 data = message();
+
+	size_t offset, size;
+	ASSERT_TRUE(AmfPath("headers.DSId").find(data.cbegin(), data.cend(), offset, size));
+	EXPECT_EQ(v8({ 0x06, 0x11, '0', 'A', '1', 'B', '2', 'C', '3', 'D' }),
+		v8(data.begin() + offset, data.begin() + offset + size));
+
+	// The reference resolves to the encoding of the first element.
+	size_t first, firstSize;
+	ASSERT_TRUE(AmfPath("body[0]").find(data.cbegin(), data.cend(), first, firstSize));
+	ASSERT_TRUE(AmfPath("body[1]").find(data.cbegin(), data.cend(), offset, size));
+	EXPECT_EQ(first, offset);
+	EXPECT_EQ(firstSize, size);
+
+	ASSERT_TRUE(AmfPath("").find(data.cbegin(), data.cend(), offset, size));
+	EXPECT_EQ(0u, offset);
+	EXPECT_EQ(data.size(), size);
+}
+
+TEST(AmfPath, Missing) {
+	v8 data = message();
+
+	EXPECT_EQ(nullptr, get("body[2]", data).get());
+	EXPECT_EQ(nullptr, get("body.operation", data).get());
+	EXPECT_EQ(nullptr, get("headers[0]", data).get());
+	EXPECT_EQ(nullptr, get("headers.DSId.length", data).get());
+	EXPECT_EQ(nullptr, get("clientId", data).get());
+
+	size_t offset, size;
+	EXPECT_FALSE(AmfPath("nope").find(data.cbegin(), data.cend(), offset, size));
+}
+
+TEST(AmfPath, OutsideReferences) {
+	AmfObject item("de.ventero.Item", false, false);
+	item.addSealedProperty("name", AmfString("x"));
+
+	AmfArray items;
+	items.push_back(item);
+	items.push_back(AmfArray(std::vector<AmfObject> { item }));
+
+	// The leaf refers to the first element and reuses its traits and string.
+	v8 data = serialized(items);
+	AmfArray expected(std::vector<AmfObject> { item });
+	EXPECT_EQ(expected, get("[1]", data).as<AmfArray>());
+	EXPECT_EQ(item, get("[1][0]", data).as<AmfObject>());
+
+	// The leaf is a reference to an object preceding it.
+	AmfObject outer("de.ventero.Outer", false, false);
+	outer.addSealedProperty("a", items);
+	outer.addSealedProperty("b", AmfArray(std::vector<AmfArray> { items }));
+	data = serialized(outer);
+	EXPECT_EQ(items, get("b[0]", data).as<AmfArray>());
+	EXPECT_EQ(AmfString("x"), get("b[0][1][0].name", data).as<AmfString>());
+}
+
+TEST(AmfPath, Cycles) {
+	// An object containing an array containing the object.
+	v8 data { 0x0a, 0x0b, 0x01, 0x03, 'a', 0x09, 0x03, 0x01, 0x0a, 0x00,
+		0x03, 'b', 0x04, 0x05, 0x01 };
+
+	EXPECT_EQ(AmfInteger(5), get("a[0].a[0].b", data).as<AmfInteger>());
+
+	size_t offset, size;
+	ASSERT_TRUE(AmfPath("a[0]").find(data.cbegin(), data.cend(), offset, size));
+	EXPECT_EQ(0u, offset);
+	EXPECT_EQ(data.size(), size);
+
+	AmfItemPtr ptr = get("a[0].a[0]", data);
+	AmfObject& obj = ptr.as<AmfObject>();
+	EXPECT_EQ(AmfInteger(5), obj.getDynamicProperty<AmfInteger>("b"));
+	AmfArray& array = obj.getDynamicProperty<AmfArray>("a");
+	EXPECT_EQ(&obj, &array.at<AmfObject>(0));
+}
+
+TEST(AmfPath, Vectors) {
+	AmfObject obj("", true, false);
+	obj.addDynamicProperty("ints", AmfVector<int>({ 1, -2, 3 }));
+	obj.addDynamicProperty("uints", AmfVector<unsigned int>({ 4294967295u }));
+	obj.addDynamicProperty("doubles", AmfVector<double>({ 0.5, 1.5 }));
+	obj.addDynamicProperty("strings", AmfVector<AmfString>({ "a", "b" }, "String"));
+	v8 data = serialized(obj);
+
+	EXPECT_EQ(AmfInteger(-2), get("ints[1]", data).as<AmfInteger>());
+	EXPECT_EQ(AmfDouble(4294967295.0), get("uints[0]", data).as<AmfDouble>());
+	EXPECT_EQ(AmfDouble(1.5), get("doubles[1]", data).as<AmfDouble>());
+	EXPECT_EQ(AmfString("b"), get("strings[1]", data).as<AmfString>());
+	EXPECT_EQ(nullptr, get("ints[3]", data).get());
+	EXPECT_EQ(nullptr, get("ints[0].a", data).get());
+
+	size_t offset, size;
+	ASSERT_TRUE(AmfPath("doubles[0]").find(data.cbegin(), data.cend(), offset, size));
+	EXPECT_EQ(8u, size);
+}
+
+TEST(AmfPath, Dictionaries) {
+	AmfDictionary dict(false);
+	dict.insert(AmfArray(), AmfNull());
+	dict.insert(AmfString("a"), AmfInteger(1));
+	dict.insert(AmfInteger(2), AmfString("b"));
+	v8 data = serialized(dict);
+
+	EXPECT_EQ(AmfInteger(1), get("a", data).as<AmfInteger>());
+	EXPECT_EQ(AmfString("b"), get("[2]", data).as<AmfString>());
+	EXPECT_EQ(nullptr, get("[1]", data).get());
+	EXPECT_EQ(nullptr, get("b", data).get());
+}
+
+TEST(AmfPath, FlexCollections) {
+	AmfObject inner("", true, false);
+	inner.addDynamicProperty("a", AmfInteger(1));
+	AmfArray source(std::vector<AmfObject> { inner });
+	v8 data = serialized(AmfFlex::arrayCollection(AmfItemPtr(source)));
+
+	EXPECT_EQ(AmfInteger(1), get("[0].a", data).as<AmfInteger>());
+
+	v8 unknown { 0x09, 0x05, 0x01, 0x0a, 0x07, 0x07, 'F', 'o', 'o', 0x01, 0x04, 0x01 };
+	EXPECT_EQ(nullptr, get("[0].a", unknown).get());
+	EXPECT_THROW(get("[1]", unknown), std::invalid_argument);
+}
+
+TEST(AmfPath, InvalidPath) {
+	EXPECT_THROW(AmfPath("a..b"), std::invalid_argument);
+	EXPECT_THROW(AmfPath(".a"), std::invalid_argument);
+	EXPECT_THROW(AmfPath("a."), std::invalid_argument);
+	EXPECT_THROW(AmfPath("a["), std::invalid_argument);
+	EXPECT_THROW(AmfPath("a[]"), std::invalid_argument);
+	EXPECT_THROW(AmfPath("a[x]"), std::invalid_argument);
+	EXPECT_THROW(AmfPath("[0]a"), std::invalid_argument);
+	EXPECT_NO_THROW(AmfPath("[0].a[1][2].b"));
+}
+
+TEST(AmfPath, NotEnoughBytes) {
+	v8 data = message();
+	data.resize(data.size() - 4);
+	EXPECT_THROW(get("timeToLive", data), std::out_of_range);
+
+	v8 invalid { 0x09, 0x05, 0x01, 0x09, 0x02, 0x04, 0x01 };
+	EXPECT_THROW(get("[1]", invalid), std::out_of_range);
+}
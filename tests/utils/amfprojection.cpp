@@ -0,0 +1,234 @@
+#include "amftest.hpp"
+
+#include "deserializer.hpp"
+#include "types/amfarray.hpp"
+#include "types/amfbytearray.hpp"
+#include "types/amfdate.hpp"
+#include "types/amfdictionary.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfobject.hpp"
+#include "types/amfstring.hpp"
+#include "types/amfvector.hpp"
+#include "utils/amfflex.hpp"
+#include "utils/amfprojection.hpp"
+
+static v8 serialized(const AmfItem& item) {
+	SerializationContext ctx;
+	return item.serialize(ctx);
+}
+
+static AmfItemPtr decode(const v8& data, const AmfProjection& projection) {
+	Deserializer d(std::make_shared<AmfProjection>(projection));
+	auto it = data.cbegin();
+	AmfItemPtr ret = d.deserialize(it, data.cend());
+	EXPECT_EQ(data.cend(), it);
+	return ret;
+}
+
+static AmfObject item(int id) {
+	AmfObject payload("", true, false);
+	payload.addDynamicProperty("data", AmfByteArray(v8 { 1, 2, 3 }));
+	payload.addDynamicProperty("created", AmfDate(0LL));
+
+	AmfObject ret("de.ventero.Item", false, false);
+	ret.addSealedProperty("id", AmfInteger(id));
+	ret.addSealedProperty("name", AmfString("item" + std::to_string(id)));
+	ret.addSealedProperty("payload", payload);
+	return ret;
+}
+
+TEST(AmfProjection, Classes) {
+	AmfArray array;
+	array.push_back(item(1));
+	array.push_back(item(2));
+	// References to a skipped string and to skipped traits.
+	array.push_back(AmfString("item1"));
+	array.push_back(item(3));
+
+	AmfProjection projection;
+	projection.keepClass("de.ventero.Item", { "id", "missing" });
+	AmfArray ret = decode(serialized(array), projection).as<AmfArray>();
+
+	ASSERT_EQ(4u, ret.dense.size());
+	for (int i : { 0, 1, 3 }) {
+		const AmfObject& obj = ret.at<AmfObject>(i);
+		EXPECT_EQ(1u, obj.sealedProperties.size());
+		EXPECT_EQ(AmfInteger(i == 3 ? 3 : i + 1), obj.sealedProperties.at("id").as<AmfInteger>());
+	}
+	EXPECT_EQ(AmfString("item1"), ret.at<AmfString>(2));
+
+	// Other classes and dynamic properties.
+	AmfObject other("de.ventero.Other", true, false);
+	other.addDynamicProperty("a", AmfInteger(1));
+	other.addDynamicProperty("b", AmfString("x"));
+	EXPECT_EQ(other, decode(serialized(other), projection).as<AmfObject>());
+
+	projection.keepClass("de.ventero.Other", { "b" });
+	AmfObject expected("de.ventero.Other", true, false);
+	expected.addDynamicProperty("b", AmfString("x"));
+	EXPECT_EQ(expected, decode(serialized(other), projection).as<AmfObject>());
+}
+
+TEST(AmfProjection, SkippedReferences) {
+	AmfObject first = item(1);
+	AmfArray array;
+	array.push_back(first);
+	// References to the skipped payload of the first item, and to the date
+	// inside of it.
+	array.push_back(first.getSealedProperty<AmfObject>("payload"));
+	array.push_back(AmfDate(0LL));
+	array.push_back(first);
+
+	AmfProjection projection;
+	projection.keepClass("de.ventero.Item", { "id" });
+	AmfItemPtr ptr = decode(serialized(array), projection);
+	AmfArray& ret = ptr.as<AmfArray>();
+
+	EXPECT_EQ(first.getSealedProperty<AmfObject>("payload"), ret.at<AmfObject>(1));
+	EXPECT_EQ(AmfDate(0LL), ret.at<AmfDate>(2));
+	// The object keeps the properties selected where it occurred first.
+	EXPECT_EQ(&ret.at<AmfObject>(0), &ret.at<AmfObject>(3));
+	EXPECT_EQ(1u, ret.at<AmfObject>(3).sealedProperties.size());
+}
+
+TEST(AmfProjection, SkippedCycles) {
+	// Objects of class C, whose skipped property is an array containing
+	// itself, and an array referring to the first one. The last element
+	// refers to the second array.
+	v8 data {
+		0x09, 0x07, 0x01,
+		0x0a, 0x13, 0x03, 'C', 0x03, 'a', 0x09, 0x03, 0x01, 0x09, 0x04,
+		0x0a, 0x01, 0x09, 0x05, 0x01, 0x09, 0x04, 0x04, 0x07,
+		0x09, 0x08
+	};
+
+	AmfProjection projection;
+	projection.keepClass("C", { });
+	AmfItemPtr ptr = decode(data, projection);
+	AmfArray& ret = ptr.as<AmfArray>();
+
+	ASSERT_EQ(3u, ret.dense.size());
+	EXPECT_TRUE(ret.at<AmfObject>(0).sealedProperties.empty());
+	EXPECT_TRUE(ret.at<AmfObject>(1).sealedProperties.empty());
+
+	AmfArray& second = ret.at<AmfArray>(2);
+	ASSERT_EQ(2u, second.dense.size());
+	EXPECT_EQ(AmfInteger(7), second.at<AmfInteger>(1));
+	AmfArray& first = second.at<AmfArray>(0);
+	EXPECT_EQ(&first, &first.at<AmfArray>(0));
+}
+
+TEST(AmfProjection, SkippedExternalizable) {
+	AmfArray source(std::vector<AmfInteger> { 1, 2 });
+	AmfObject proxy("", true, false);
+	proxy.addDynamicProperty("collection", AmfFlex::arrayCollection(AmfItemPtr(source)));
+	proxy.addDynamicProperty("keep", AmfInteger(1));
+
+	AmfArray array;
+	array.push_back(proxy);
+	array.push_back(source);
+
+	AmfProjection projection;
+	projection.keepClass("", { "keep" });
+	AmfItemPtr ptr = decode(serialized(array), projection);
+	AmfArray& ret = ptr.as<AmfArray>();
+
+	EXPECT_EQ(1u, ret.at<AmfObject>(0).dynamicProperties.size());
+	EXPECT_EQ(source, ret.at<AmfArray>(1));
+}
+
+// Resembles a RemotingMessage, see tests/utils/amfpath.cpp.
+static AmfObject message() {
+	AmfObject call("de.ventero.Call", false, false);
+	call.addSealedProperty("operation", AmfString("getItems"));
+	call.addSealedProperty("items", AmfArray(std::vector<AmfObject> { item(1), item(2) }));
+
+	AmfObject headers("", true, false);
+	headers.addDynamicProperty("DSEndpoint", AmfString("my-amf"));
+	headers.addDynamicProperty("DSId", AmfString("0A1B2C3D"));
+
+	AmfObject msg("flex.messaging.messages.RemotingMessage", false, false);
+	msg.addSealedProperty("destination", AmfString("de.ventero.Items"));
+	msg.addSealedProperty("body", AmfArray(std::vector<AmfObject> { call, call }));
+	msg.addSealedProperty("headers", headers);
+	return msg;
+}
+
+TEST(AmfProjection, Paths) {
+	AmfProjection projection;
+	projection.keepPath("body.operation").keepPath("headers.DSId");
+	AmfItemPtr ptr = decode(serialized(message()), projection);
+	AmfObject& ret = ptr.as<AmfObject>();
+
+	EXPECT_EQ(2u, ret.sealedProperties.size());
+	AmfArray& body = ret.getSealedProperty<AmfArray>("body");
+	ASSERT_EQ(2u, body.dense.size());
+	for (int i = 0; i < 2; ++i) {
+		AmfObject& call = body.at<AmfObject>(i);
+		EXPECT_EQ(1u, call.sealedProperties.size());
+		EXPECT_EQ(AmfString("getItems"), call.getSealedProperty<AmfString>("operation"));
+	}
+
+	AmfObject headers("", true, false);
+	headers.addDynamicProperty("DSId", AmfString("0A1B2C3D"));
+	EXPECT_EQ(headers, ret.getSealedProperty<AmfObject>("headers"));
+
+	// Everything below the end of a path is kept, apart from what the class
+	// rules exclude.
+	projection.keepPath("body.items").keepClass("de.ventero.Item", { "name" });
+	ptr = decode(serialized(message()), projection);
+	AmfObject& call = ptr.as<AmfObject>().getSealedProperty<AmfArray>("body").at<AmfObject>(0);
+	AmfArray& items = call.getSealedProperty<AmfArray>("items");
+	ASSERT_EQ(2u, items.dense.size());
+	EXPECT_EQ(1u, items.at<AmfObject>(1).sealedProperties.size());
+	EXPECT_EQ(AmfString("item2"), items.at<AmfObject>(1).getSealedProperty<AmfString>("name"));
+
+	// A shorter path keeps all of the longer one.
+	AmfProjection all;
+	all.keepPath("headers").keepPath("headers.DSId");
+	ptr = decode(serialized(message()), all);
+	EXPECT_EQ(2u, ptr.as<AmfObject>().getSealedProperty<AmfObject>("headers").dynamicProperties.size());
+}
+
+TEST(AmfProjection, SharedContext) {
+	// The second value refers to objects skipped in the first one, whose
+	// input is gone by then.
+	AmfObject first = item(1);
+	SerializationContext sctx;
+	v8 data = first.serialize(sctx);
+	v8 next = AmfArray(std::vector<AmfObject> { first.getSealedProperty<AmfObject>("payload"), first }).serialize(sctx);
+
+	AmfProjection projection;
+	projection.keepClass("de.ventero.Item", { "name" });
+	Deserializer d(std::make_shared<AmfProjection>(projection));
+	AmfItemPtr ret = d.deserialize(data);
+	EXPECT_EQ(1u, ret.as<AmfObject>().sealedProperties.size());
+
+	AmfItemPtr array = d.deserialize(next);
+	EXPECT_EQ(first.getSealedProperty<AmfObject>("payload"), array.as<AmfArray>().at<AmfObject>(0));
+	EXPECT_EQ(ret, array.as<AmfArray>().dense[1]);
+}
+
+TEST(AmfProjection, Failure) {
+	AmfProjection projection;
+	projection.keepPath("body.operation");
+	Deserializer d(std::make_shared<AmfProjection>(projection));
+
+	v8 data = serialized(message());
+	v8 truncated(data.begin(), data.begin() + data.size() / 2);
+	auto it = truncated.cbegin();
+	EXPECT_THROW(d.deserialize(it, truncated.cend()), std::out_of_range);
+
+	// The path starts at the top-level value again.
+	d.clearContext();
+	AmfItemPtr ret = d.deserialize(data);
+	EXPECT_EQ(1u, ret.as<AmfObject>().sealedProperties.size());
+}
+
+TEST(AmfProjection, InvalidPath) {
+	AmfProjection projection;
+	EXPECT_THROW(projection.keepPath(""), std::invalid_argument);
+	EXPECT_THROW(projection.keepPath("a..b"), std::invalid_argument);
+	EXPECT_THROW(projection.keepPath("a."), std::invalid_argument);
+	EXPECT_EQ(nullptr, projection.root());
+}
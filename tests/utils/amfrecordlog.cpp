@@ -0,0 +1,163 @@
+#include "amftest.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+
+#include "types/amfarray.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfobject.hpp"
+#include "types/amfstring.hpp"
+#include "utils/amfrecordlog.hpp"
+
+static AmfObject record(int id) {
+	AmfObject obj("de.ventero.AmfTest.Record", false, false);
+	obj.addSealedProperty("id", AmfInteger(id));
+	obj.addSealedProperty("name", AmfString("record"));
+	return obj;
+}
+
+class AmfRecordLogTest : public testing::Test {
+protected:
+	void SetUp() {
+		path = testing::TempDir() + "amftest_records.log";
+		remove();
+	}
+
+	void TearDown() {
+		remove();
+	}
+
+	void remove() {
+		std::remove(path.c_str());
+		std::remove((path + ".idx").c_str());
+	}
+
+	size_t fileSize(const std::string& file) {
+		std::ifstream in(file, std::ios::binary | std::ios::ate);
+		return static_cast<size_t>(in.tellg());
+	}
+
+	std::string path;
+};
+
+TEST(AmfRecordLog, Checksum) {
+	std::string check("123456789");
+	EXPECT_EQ(0xCBF43926u, AmfRecordLog::checksum(reinterpret_cast<const u8*>(check.data()), check.size()));
+	EXPECT_EQ(0u, AmfRecordLog::checksum(nullptr, 0));
+}
+
+TEST_F(AmfRecordLogTest, RandomAccess) {
+	{
+		AmfRecordLogWriter writer(path);
+		for (int i = 0; i < 100; ++i)
+			EXPECT_EQ(static_cast<size_t>(i), writer.append(record(i)));
+	}
+
+	AmfRecordLog log(path);
+	ASSERT_EQ(100u, log.size());
+	EXPECT_EQ(8u * 100, fileSize(path + ".idx"));
+
+	// Every record is self-contained, so strings and traits are not sent as
+	// references to earlier records.
+	EXPECT_EQ(AmfItemPtr(record(57)), log.get(57));
+	EXPECT_EQ(AmfItemPtr(record(0)), log.get(0));
+	EXPECT_EQ(AmfItemPtr(record(99)), log.get(99));
+	EXPECT_THROW(log.get(100), std::out_of_range);
+}
+
+TEST_F(AmfRecordLogTest, Append) {
+	{
+		AmfRecordLogWriter writer(path);
+		writer.append(AmfString("foo"));
+	}
+
+	AmfRecordLogWriter writer(path);
+	EXPECT_EQ(1u, writer.size());
+	EXPECT_EQ(1u, writer.append(AmfInteger(1)));
+	writer.flush();
+
+	AmfRecordLog log(path);
+	ASSERT_EQ(2u, log.size());
+	EXPECT_EQ(AmfItemPtr(AmfString("foo")), log.get(0));
+	EXPECT_EQ(AmfItemPtr(AmfInteger(1)), log.get(1));
+}
+
+TEST_F(AmfRecordLogTest, Recovery) {
+	{
+		AmfRecordLogWriter writer(path);
+		for (int i = 0; i < 3; ++i)
+			writer.append(record(i));
+	}
+
+	// Lose the last index entry and leave half a record at the end.
+	size_t indexSize = fileSize(path + ".idx");
+	{
+		AmfMappedFile index(path + ".idx");
+		v8 entries(index.data(), index.data() + indexSize - 8);
+		std::ofstream out(path + ".idx", std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(entries.data()), entries.size());
+	}
+	{
+		std::ofstream out(path, std::ios::binary | std::ios::app);
+		out.write("\x00\x00\x01\x00\x00", 5);
+	}
+
+	AmfRecordLog log(path);
+	ASSERT_EQ(3u, log.size());
+	EXPECT_EQ(AmfItemPtr(record(2)), log.get(2));
+
+	// The writer repairs the index and drops the incomplete record.
+	{
+		AmfRecordLogWriter writer(path);
+		EXPECT_EQ(3u, writer.append(record(3)));
+	}
+	EXPECT_EQ(indexSize + 8, fileSize(path + ".idx"));
+
+	AmfRecordLog repaired(path);
+	ASSERT_EQ(4u, repaired.size());
+	EXPECT_EQ(AmfItemPtr(record(3)), repaired.get(3));
+}
+
+TEST_F(AmfRecordLogTest, Corruption) {
+	{
+		AmfRecordLogWriter writer(path);
+		writer.append(AmfString("foo"));
+	}
+
+	{
+		std::fstream out(path, std::ios::binary | std::ios::in | std::ios::out);
+		out.seekp(9);
+		out.put('x');
+	}
+
+	AmfRecordLog log(path);
+	ASSERT_EQ(1u, log.size());
+	EXPECT_THROW(log.get(0), std::invalid_argument);
+}
+
+TEST_F(AmfRecordLogTest, Scan) {
+	{
+		AmfRecordLogWriter writer(path);
+		for (int i = 0; i < 50; ++i)
+			writer.append(record(i));
+	}
+
+	AmfRecordLog log(path);
+	for (unsigned int threads : { 1u, 3u, 8u, 64u }) {
+		std::mutex mutex;
+		std::vector<int> seen(50, -1);
+		log.scan([&](size_t n, const AmfItemPtr& item) {
+			std::lock_guard<std::mutex> lock(mutex);
+			seen[n] = item.as<AmfObject>().sealedProperties.at("id").as<AmfInteger>().value;
+		}, threads);
+
+		for (int i = 0; i < 50; ++i)
+			EXPECT_EQ(i, seen[i]);
+	}
+
+	EXPECT_THROW(log.scan([](size_t n, const AmfItemPtr&) {
+		if (n == 20)
+			throw std::runtime_error("callback");
+	}, 4), std::runtime_error);
+}
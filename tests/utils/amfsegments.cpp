@@ -0,0 +1,154 @@
+#include "amftest.hpp"
+
+#include <unistd.h>
+
+#include "serializer.hpp"
+#include "types/amfarray.hpp"
+#include "types/amfbytearray.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfobject.hpp"
+#include "types/amfstring.hpp"
+#include "types/amfvector.hpp"
+#include "types/amfxml.hpp"
+#include "types/amfxmldocument.hpp"
+#include "utils/amfsegments.hpp"
+
+static AmfObject payload() {
+	AmfObject obj("de.ventero.AmfTest.File", true, false);
+	obj.addSealedProperty("name", AmfString("file.bin"));
+	obj.addSealedProperty("data", AmfByteArray(v8(256, 0xab)));
+	obj.addDynamicProperty("small", AmfByteArray(v8 { 1, 2, 3 }));
+	obj.addDynamicProperty("xml", AmfXml(std::string(100, 'x')));
+	obj.addDynamicProperty("doc", AmfXmlDocument(std::string(100, 'y')));
+
+	AmfVector<AmfByteArray> files({}, "flash.utils.ByteArray");
+	files.push_back(AmfByteArray(v8(64, 0xcd)));
+	obj.addDynamicProperty("files", files);
+	return obj;
+}
+
+TEST(AmfSegments, SameDataAsSerialize) {
+	AmfObject obj = payload();
+
+	SerializationContext ctx;
+	v8 expected = obj.serialize(ctx);
+
+	for (size_t threshold : { 0, 16, 64, 100, 1000 }) {
+		SerializationContext sctx;
+		AmfSegments out(threshold);
+		obj.serializeInto(sctx, out);
+		EXPECT_EQ(expected.size(), out.size());
+		EXPECT_EQ(expected, out.data());
+	}
+}
+
+TEST(AmfSegments, ReferencesLargePayloads) {
+	AmfObject obj = payload();
+	const AmfByteArray& data = obj.getSealedProperty<AmfByteArray>("data");
+	const AmfXml& xml = obj.getDynamicProperty<AmfXml>("xml");
+
+	SerializationContext ctx;
+	AmfSegments out(100);
+	obj.serializeInto(ctx, out);
+
+	// data and the two XML values are referenced, everything else is copied.
+	auto segments = out.segments();
+	ASSERT_EQ(7u, segments.size());
+	bool foundData = false, foundXml = false;
+	for (const auto& segment : segments) {
+		if (segment.first == data.value.data()) {
+			EXPECT_EQ(256u, segment.second);
+			foundData = true;
+		} else if (segment.first == reinterpret_cast<const u8*>(xml.value.data())) {
+			EXPECT_EQ(100u, segment.second);
+			foundXml = true;
+		}
+	}
+	EXPECT_TRUE(foundData);
+	EXPECT_TRUE(foundXml);
+
+	// Nothing is referenced in contiguous mode.
+	SerializationContext cctx;
+	AmfSegments contiguous = AmfSegments::contiguous();
+	obj.serializeInto(cctx, contiguous);
+	EXPECT_EQ(1u, contiguous.segments().size());
+}
+
+TEST(AmfSegments, ObjectReferences) {
+	AmfByteArray ba(v8(32, 0x01));
+	AmfArray array;
+	array.push_back(ba);
+	array.push_back(ba);
+	array.push_back(AmfString("foo"));
+
+	Serializer serializer;
+	serializer << array << ba;
+
+	Serializer segmented;
+	AmfSegments out(16);
+	segmented.serializeInto(array, out);
+	segmented.serializeInto(ba, out);
+	EXPECT_EQ(serializer.data(), out.data());
+
+	// Only the first occurrence is sent inline.
+	size_t referenced = 0;
+	for (const auto& segment : out.segments()) {
+		if (segment.second == 32)
+			++referenced;
+	}
+	EXPECT_EQ(1u, referenced);
+}
+
+TEST(AmfSegments, Writev) {
+	AmfObject obj = payload();
+	SerializationContext ctx;
+	v8 expected = obj.serialize(ctx);
+
+	SerializationContext sctx;
+	AmfSegments out(16);
+	obj.serializeInto(sctx, out);
+	std::vector<struct iovec> iov = out.iovecs();
+	ASSERT_LT(1u, iov.size());
+
+	int fds[2];
+	ASSERT_EQ(0, pipe(fds));
+	ssize_t written = writev(fds[1], iov.data(), static_cast<int>(iov.size()));
+	close(fds[1]);
+	ASSERT_EQ(static_cast<ssize_t>(expected.size()), written);
+
+	v8 actual(expected.size());
+	size_t read = 0;
+	while (read < actual.size()) {
+		ssize_t n = ::read(fds[0], actual.data() + read, actual.size() - read);
+		ASSERT_LT(0, n);
+		read += n;
+	}
+	close(fds[0]);
+	EXPECT_EQ(expected, actual);
+}
+
+TEST(AmfSegments, Release) {
+	AmfSegments contiguous(16);
+	contiguous.append(v8 { 1, 2, 3 });
+	contiguous.push_back(4);
+	const u8* p = contiguous.segments().at(0).first;
+	v8 data = contiguous.release();
+	EXPECT_EQ((v8 { 1, 2, 3, 4 }), data);
+	// Not copied.
+	EXPECT_EQ(p, data.data());
+	EXPECT_EQ(0u, contiguous.size());
+
+	v8 large(16, 0xff);
+	AmfSegments segmented(16);
+	segmented.push_back(1);
+	EXPECT_TRUE(segmented.appendPayload(large.data(), large.size()));
+	EXPECT_FALSE(segmented.appendPayload(large.data(), 15));
+	EXPECT_EQ(3u, segmented.segments().size());
+	EXPECT_EQ(32u, segmented.size());
+
+	data = segmented.release();
+	EXPECT_EQ(32u, data.size());
+	EXPECT_EQ(1, data[0]);
+	EXPECT_EQ(0xff, data[31]);
+	EXPECT_TRUE(segmented.segments().empty());
+}
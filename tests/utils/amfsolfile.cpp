@@ -0,0 +1,147 @@
+#include "amftest.hpp"
+
+#include <cstdio>
+#include <mutex>
+
+#include "types/amfarray.hpp"
+#include "types/amfbytearray.hpp"
+#include "types/amfinteger.hpp"
+#include "types/amfobject.hpp"
+#include "types/amfstring.hpp"
+#include "utils/amfsolfile.hpp"
+
+static AmfSolFile settings() {
+	AmfObject obj("", true, false);
+	obj.addDynamicProperty("volume", AmfInteger(7));
+
+	AmfSolFile file("settings");
+	file.add("name", AmfString("foo"));
+	file.add("data", AmfByteArray(v8 { 1, 2, 3 }));
+	file.add("prefs", obj);
+	file.add("other", AmfString("name"));
+	return file;
+}
+
+static std::string tempPath(const std::string& name) {
+	return testing::TempDir() + name;
+}
+
+TEST(AmfSolFile, Serialize) {
+	AmfSolFile file("a");
+	file.add("x", AmfInteger(1));
+
+	v8 expected {
+		0x00, 0xBF,
+		0x00, 0x00, 0x00, 0x16,
+		'T', 'C', 'S', 'O', 0x00, 0x04, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x01, 'a',
+		0x00, 0x00, 0x00, 0x03,
+		0x03, 'x', 0x04, 0x01, 0x00
+	};
+	EXPECT_EQ(expected, file.serialize());
+}
+
+TEST(AmfSolFile, RoundTrip) {
+	AmfSolFile file = settings();
+	v8 data = file.serialize();
+
+	auto it = data.cbegin();
+	AmfSolFile result = AmfSolFile::deserialize(it, data.cend());
+	EXPECT_EQ(data.cend(), it);
+	EXPECT_EQ(file, result);
+	EXPECT_EQ("settings", result.name);
+	EXPECT_EQ(AmfItemPtr(AmfString("name")), result.get("other"));
+	EXPECT_THROW(result.get("missing"), std::out_of_range);
+}
+
+TEST(AmfSolFile, Reader) {
+	v8 data = settings().serialize();
+
+	AmfSolReader reader(data);
+	EXPECT_EQ("settings", reader.name());
+
+	std::string name;
+	AmfItemPtr value;
+	ASSERT_TRUE(reader.next(name, value));
+	EXPECT_EQ("name", name);
+	EXPECT_EQ(AmfItemPtr(AmfString("foo")), value);
+
+	// Entries share a context, so later ones may refer to earlier strings.
+	std::vector<std::string> names;
+	while (reader.next(name, value))
+		names.push_back(name);
+	EXPECT_EQ((std::vector<std::string> { "data", "prefs", "other" }), names);
+	EXPECT_EQ(AmfItemPtr(AmfString("name")), value);
+	EXPECT_FALSE(reader.next(name, value));
+}
+
+TEST(AmfSolFile, SaveAndLoad) {
+	std::string path = tempPath("amftest_settings.sol");
+	AmfSolFile file = settings();
+	file.save(path);
+
+	EXPECT_EQ(file, AmfSolFile::load(path));
+
+	AmfSolReader reader(path);
+	EXPECT_EQ("settings", reader.name());
+
+	std::remove(path.c_str());
+	EXPECT_THROW(AmfSolFile::load(path), std::runtime_error);
+}
+
+TEST(AmfSolFile, LoadAll) {
+	std::vector<std::string> paths;
+	for (int i = 0; i < 8; ++i) {
+		AmfSolFile file("file" + std::to_string(i));
+		file.add("index", AmfInteger(i));
+		paths.push_back(tempPath("amftest_batch" + std::to_string(i) + ".sol"));
+		file.save(paths.back());
+	}
+	paths.push_back(tempPath("amftest_batch_missing.sol"));
+
+	std::mutex mutex;
+	std::vector<int> seen;
+	auto errors = AmfSolFile::loadAll(paths, [&](const std::string&, AmfSolFile& file) {
+		std::lock_guard<std::mutex> lock(mutex);
+		seen.push_back(file.get("index").as<AmfInteger>().value);
+	}, 3);
+
+	std::sort(seen.begin(), seen.end());
+	EXPECT_EQ((std::vector<int> { 0, 1, 2, 3, 4, 5, 6, 7 }), seen);
+	ASSERT_EQ(1u, errors.size());
+	EXPECT_EQ(paths.back(), errors[0].first);
+
+	for (const std::string& path : paths)
+		std::remove(path.c_str());
+}
+
+TEST(AmfSolFile, Invalid) {
+	v8 valid = settings().serialize();
+
+	for (size_t size = 0; size < valid.size(); ++size) {
+		v8 truncated(valid.begin(), valid.begin() + size);
+		auto it = truncated.cbegin();
+		EXPECT_THROW(AmfSolFile::deserialize(it, truncated.cend()), std::out_of_range);
+	}
+
+	v8 magic(valid);
+	magic[1] = 0xBE;
+	auto it = magic.cbegin();
+	EXPECT_THROW(AmfSolFile::deserialize(it, magic.cend()), std::invalid_argument);
+
+	v8 signature(valid);
+	signature[6] = 'X';
+	it = signature.cbegin();
+	EXPECT_THROW(AmfSolFile::deserialize(it, signature.cend()), std::invalid_argument);
+
+	// AMF0 body
+	v8 amf0 {
+		0x00, 0xBF,
+		0x00, 0x00, 0x00, 0x11,
+		'T', 'C', 'S', 'O', 0x00, 0x04, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x01, 'a',
+		0x00, 0x00, 0x00, 0x00
+	};
+	it = amf0.cbegin();
+	EXPECT_THROW(AmfSolFile::deserialize(it, amf0.cend()), std::invalid_argument);
+}
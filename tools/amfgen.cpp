@@ -0,0 +1,647 @@
+// amfgen - generates C++ value object codecs from ActionScript 3 classes.
+//
+// Usage: amfgen [-n namespace] [-o output.hpp] input.as...
+//
+// Every class with a [RemoteClass(alias="...")] annotation (or a matching
+// registerClassAlias("...", Class) call in one of the inputs) is turned into
+// an AmfItem subclass with one typed member per serialized property. The
+// generated codecs know the sealed attribute order, so decoding an instance
+// whose traits match the declaration reads the values in a straight line,
+// without building property maps.
+//
+// Serialized properties are public, non-static variables and public
+// getter/setter pairs that are not marked as [Transient]. Externalizable
+// classes are skipped, as their wire format is defined by readExternal.
+
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+enum TokenType {
+	IDENTIFIER,
+	STRING,
+	PUNCTUATION
+};
+
+struct Token {
+	TokenType type;
+	std::string value;
+};
+
+struct Property {
+	std::string name;
+	std::string type;
+	// literal initializer, if any
+	std::string value;
+};
+
+struct ClassInfo {
+	ClassInfo() : dynamic(false), externalizable(false) { }
+
+	std::string name;
+	std::string alias;
+	bool dynamic;
+	bool externalizable;
+	std::vector<Property> properties;
+};
+
+// Removes comments and splits the source into identifiers, string literals
+// and single punctuation characters. Numbers end up as identifiers.
+std::vector<Token> tokenize(const std::string& src) {
+	std::vector<Token> tokens;
+	size_t i = 0;
+	while (i < src.size()) {
+		char c = src[i];
+		if (std::isspace(static_cast<unsigned char>(c))) {
+			++i;
+		} else if (src.compare(i, 2, "//") == 0) {
+			i = src.find('\n', i);
+			if (i == std::string::npos) break;
+		} else if (src.compare(i, 2, "/*") == 0) {
+			i = src.find("*/", i + 2);
+			if (i == std::string::npos) break;
+			i += 2;
+		} else if (c == '"' || c == '\'') {
+			std::string value;
+			for (++i; i < src.size() && src[i] != c; ++i) {
+				if (src[i] == '\\' && i + 1 < src.size()) ++i;
+				value += src[i];
+			}
+			++i;
+			tokens.push_back(Token { STRING, value });
+		} else if (std::isdigit(static_cast<unsigned char>(c))) {
+			size_t start = i;
+			while (i < src.size() && (std::isalnum(static_cast<unsigned char>(src[i])) ||
+				src[i] == '.'))
+				++i;
+			tokens.push_back(Token { IDENTIFIER, src.substr(start, i - start) });
+		} else if (std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$') {
+			size_t start = i;
+			while (i < src.size() && (std::isalnum(static_cast<unsigned char>(src[i])) ||
+				src[i] == '_' || src[i] == '$'))
+				++i;
+			tokens.push_back(Token { IDENTIFIER, src.substr(start, i - start) });
+		} else {
+			tokens.push_back(Token { PUNCTUATION, std::string(1, c) });
+			++i;
+		}
+	}
+
+	return tokens;
+}
+
+class Parser {
+public:
+	Parser(const std::vector<Token>& tokens) : tokens(tokens), pos(0) { }
+
+	void parse(std::vector<ClassInfo>& classes, std::map<std::string, std::string>& aliases);
+
+private:
+	bool at(const std::string& value, size_t offset = 0) const {
+		return pos + offset < tokens.size() && tokens[pos + offset].value == value &&
+			tokens[pos + offset].type != STRING;
+	}
+
+	const Token& next() {
+		if (pos >= tokens.size())
+			throw std::runtime_error("unexpected end of input");
+		return tokens[pos++];
+	}
+
+	std::string identifier() {
+		const Token& t = next();
+		if (t.type != IDENTIFIER)
+			throw std::runtime_error("expected identifier, got '" + t.value + "'");
+		return t.value;
+	}
+
+	std::string literal(size_t begin, size_t end) const;
+	void skipBlock();
+	std::string parseMetadata();
+	std::string parseType(const std::set<std::string>& terminators);
+	void parseClass(ClassInfo& info, std::string alias);
+
+	const std::vector<Token>& tokens;
+	size_t pos;
+};
+
+// Skips a balanced {...} block, with pos pointing at the opening brace.
+void Parser::skipBlock() {
+	int depth = 0;
+	do {
+		const Token& t = next();
+		if (t.type != PUNCTUATION) continue;
+		if (t.value == "{") ++depth;
+		if (t.value == "}") --depth;
+	} while (depth > 0);
+}
+
+// Returns the tokens [begin, end) as C++ literal if they form a boolean,
+// numeric or string literal, and an empty string otherwise.
+std::string Parser::literal(size_t begin, size_t end) const {
+	std::string sign;
+	if (end - begin == 2 && tokens[begin].value == "-") {
+		sign = "-";
+		++begin;
+	}
+
+	if (end - begin != 1)
+		return "";
+
+	const Token& t = tokens[begin];
+	if (t.type == STRING) {
+		std::string escaped;
+		for (char c : t.value) {
+			if (c == '"' || c == '\\') escaped += '\\';
+			escaped += c;
+		}
+		return sign.empty() ? "\"" + escaped + "\"" : "";
+	}
+
+	if (t.type == IDENTIFIER && std::isdigit(static_cast<unsigned char>(t.value[0])))
+		return sign + t.value;
+
+	if (sign.empty() && (t.value == "true" || t.value == "false"))
+		return t.value;
+
+	return "";
+}
+
+// Parses [Name(...)] metadata and returns its name. For RemoteClass, the
+// name is followed by the alias, separated by a colon.
+std::string Parser::parseMetadata() {
+	next(); // [
+	std::string name = identifier();
+	std::string alias;
+	while (!at("]")) {
+		if (at("alias") && at("=", 1) && pos + 2 < tokens.size() &&
+			tokens[pos + 2].type == STRING)
+			alias = tokens[pos + 2].value;
+		next();
+	}
+	next(); // ]
+
+	return alias.empty() ? name : name + ":" + alias;
+}
+
+// Reads a type annotation such as int, flash.utils.ByteArray or
+// Vector.<String> until one of the terminators.
+std::string Parser::parseType(const std::set<std::string>& terminators) {
+	std::string type;
+	while (pos < tokens.size() && !(tokens[pos].type == PUNCTUATION &&
+		terminators.count(tokens[pos].value)))
+		type += next().value;
+
+	return type;
+}
+
+void Parser::parse(std::vector<ClassInfo>& classes, std::map<std::string, std::string>& aliases) {
+	// registerClassAlias("alias", Class) calls usually live in function
+	// bodies, which the class parser skips, so look for them first.
+	for (size_t i = 0; i + 5 < tokens.size(); ++i) {
+		if (tokens[i].value == "registerClassAlias" && tokens[i + 1].value == "(" &&
+			tokens[i + 2].type == STRING && tokens[i + 3].value == "," &&
+			tokens[i + 4].type == IDENTIFIER && tokens[i + 5].value == ")")
+			aliases[tokens[i + 4].value] = tokens[i + 2].value;
+	}
+
+	std::string alias;
+	bool dynamic = false;
+
+	while (pos < tokens.size()) {
+		if (at("[")) {
+			std::string meta = parseMetadata();
+			if (meta.compare(0, 12, "RemoteClass:") == 0)
+				alias = meta.substr(12);
+		} else if (at("dynamic")) {
+			dynamic = true;
+			++pos;
+		} else if (at("class")) {
+			++pos;
+			ClassInfo info;
+			info.name = identifier();
+			info.dynamic = dynamic;
+			parseClass(info, alias);
+			classes.push_back(info);
+
+			alias.clear();
+			dynamic = false;
+		} else if (at(";") || at("}") || at("{")) {
+			// package blocks and other statements reset pending modifiers
+			alias.clear();
+			dynamic = false;
+			++pos;
+		} else {
+			++pos;
+		}
+	}
+}
+
+void Parser::parseClass(ClassInfo& info, std::string alias) {
+	info.alias = alias;
+
+	// extends / implements clauses
+	while (!at("{")) {
+		if (at("IExternalizable"))
+			info.externalizable = true;
+		next();
+	}
+	next(); // {
+
+	std::map<std::string, std::string> getters;
+	std::set<std::string> setters;
+	std::vector<std::string> accessorOrder;
+
+	bool isPublic = false, isStatic = false, isTransient = false;
+	while (!at("}")) {
+		if (at("[")) {
+			if (parseMetadata() == "Transient")
+				isTransient = true;
+			continue;
+		}
+
+		const Token& t = next();
+		if (t.type == STRING) {
+			continue;
+		} else if (t.value == "{") {
+			--pos;
+			skipBlock();
+		} else if (t.value == "public") {
+			isPublic = true;
+		} else if (t.value == "static") {
+			isStatic = true;
+		} else if (t.value == "var" || t.value == "const") {
+			bool isConst = (t.value == "const");
+			Property prop;
+			prop.name = identifier();
+			if (at(":")) {
+				next();
+				prop.type = parseType({ ";", "=", "}" });
+			}
+
+			// skip the initializer, but remember simple literals
+			size_t start = pos + 1;
+			while (!at(";") && !at("}")) {
+				if (at("{"))
+					skipBlock();
+				else
+					next();
+			}
+			if (start < pos && tokens[start - 1].value == "=")
+				prop.value = literal(start, pos);
+
+			if (isPublic && !isStatic && !isConst && !isTransient)
+				info.properties.push_back(prop);
+
+			isPublic = isStatic = isTransient = false;
+		} else if (t.value == "function") {
+			std::string kind;
+			if ((at("get") || at("set")) && !at("(", 1))
+				kind = next().value;
+			std::string name = identifier();
+
+			// parameter list
+			while (!at(")"))
+				next();
+			next(); // )
+
+			std::string returnType;
+			if (at(":")) {
+				next();
+				returnType = parseType({ "{", ";" });
+			}
+			if (at("{"))
+				skipBlock();
+
+			if (isPublic && !isStatic && !isTransient) {
+				if (kind == "get") {
+					getters[name] = returnType;
+					accessorOrder.push_back(name);
+				} else if (kind == "set") {
+					setters.insert(name);
+				}
+			}
+
+			isPublic = isStatic = isTransient = false;
+		} else if (t.value == ";") {
+			isPublic = isStatic = isTransient = false;
+		}
+	}
+	next(); // }
+
+	// Accessors are only serialized if they can be read and written.
+	for (const std::string& name : accessorOrder) {
+		if (setters.count(name))
+			info.properties.push_back(Property { name, getters[name], "" });
+	}
+}
+
+class Generator {
+public:
+	Generator(const std::vector<ClassInfo>& classes, std::string ns) :
+		classes(classes), ns(ns) {
+		for (const ClassInfo& c : classes)
+			names.insert(c.name);
+	}
+
+	void generate(std::ostream& out, const std::string& guard, const std::string& sources);
+
+private:
+	std::string cppType(const std::string& type) const;
+	std::string reader(const std::string& type) const;
+	std::string writer(const std::string& type) const;
+	std::string initializer(const Property& prop) const;
+
+	void declaration(std::ostream& out, const ClassInfo& c);
+	void definition(std::ostream& out, const ClassInfo& c);
+
+	const std::vector<ClassInfo>& classes;
+	std::set<std::string> names;
+	std::string ns;
+};
+
+std::string Generator::cppType(const std::string& type) const {
+	if (type == "int") return "int";
+	if (type == "uint") return "unsigned int";
+	if (type == "Number") return "double";
+	if (type == "Boolean") return "bool";
+	if (type == "String") return "std::string";
+	return "amf::AmfItemPtr";
+}
+
+std::string Generator::reader(const std::string& type) const {
+	if (type == "int") return "amf::AmfCodegen::readInt(it, end, ctx)";
+	if (type == "uint") return "amf::AmfCodegen::readUint(it, end, ctx)";
+	if (type == "Number") return "amf::AmfCodegen::readDouble(it, end, ctx)";
+	if (type == "Boolean") return "amf::AmfCodegen::readBool(it, end, ctx)";
+	if (type == "String") return "amf::AmfCodegen::readString(it, end, ctx)";
+	if (names.count(type)) return "amf::AmfCodegen::readObject<" + type + ">(it, end, ctx)";
+	return "amf::AmfCodegen::readItem(it, end, ctx)";
+}
+
+std::string Generator::writer(const std::string& type) const {
+	if (type == "int") return "amf::AmfCodegen::writeInt";
+	if (type == "uint") return "amf::AmfCodegen::writeUint";
+	if (type == "Number") return "amf::AmfCodegen::writeDouble";
+	if (type == "Boolean") return "amf::AmfCodegen::writeBool";
+	if (type == "String") return "amf::AmfCodegen::writeString";
+	return "amf::AmfCodegen::writeItem";
+}
+
+std::string Generator::initializer(const Property& prop) const {
+	const std::string& type = prop.type;
+	bool isNumber = (type == "int" || type == "uint" || type == "Number");
+	bool isString = (!prop.value.empty() && prop.value[0] == '"');
+	bool isBool = (prop.value == "true" || prop.value == "false");
+
+	if ((isNumber && !isString && !isBool) || (type == "Boolean" && isBool) ||
+		(type == "String" && isString))
+		if (!prop.value.empty())
+			return prop.value;
+
+	if (isNumber) return "0";
+	if (type == "Boolean") return "false";
+	return "";
+}
+
+void Generator::generate(std::ostream& out, const std::string& guard, const std::string& sources) {
+	out << "// Generated by amfgen from " << sources << ". Do not edit.\n"
+	    << "#pragma once\n"
+	    << "#ifndef " << guard << "\n"
+	    << "#define " << guard << "\n\n"
+	    << "#include <string>\n"
+	    << "#include <vector>\n\n"
+	    << "#include \"amf.hpp\"\n"
+	    << "#include \"serializationcontext.hpp\"\n"
+	    << "#include \"types/amfitem.hpp\"\n"
+	    << "#include \"utils/amfcodegen.hpp\"\n"
+	    << "#include \"utils/amfitemptr.hpp\"\n"
+	    << "#include \"utils/amfobjecttraits.hpp\"\n\n";
+
+	if (!ns.empty())
+		out << "namespace " << ns << " {\n\n";
+
+	for (const ClassInfo& c : classes)
+		out << "class " << c.name << ";\n";
+	out << "\n";
+
+	for (const ClassInfo& c : classes)
+		declaration(out, c);
+
+	for (const ClassInfo& c : classes)
+		definition(out, c);
+
+	if (!ns.empty())
+		out << "} // namespace " << ns << "\n\n";
+
+	out << "#endif\n";
+}
+
+void Generator::declaration(std::ostream& out, const ClassInfo& c) {
+	out << "class " << c.name << " : public amf::AmfItem {\n"
+	    << "public:\n"
+	    << "\t" << c.name << "()";
+
+	bool first = true;
+	for (const Property& p : c.properties) {
+		std::string init = initializer(p);
+		if (init.empty()) continue;
+		out << (first ? " :\n\t\t" : ", ") << p.name << "(" << init << ")";
+		first = false;
+	}
+
+	out << " { }\n\n"
+	    << "\tbool operator==(const amf::AmfItem& other) const;\n"
+	    << "\tamf::v8 serialize(amf::SerializationContext& ctx) const;\n"
+	    << "\tstatic amf::AmfItemPtr deserializePtr(amf::v8::const_iterator& it, "
+	       "amf::v8::const_iterator end, amf::SerializationContext& ctx);\n"
+	    << "\tstatic " << c.name << " deserialize(amf::v8::const_iterator& it, "
+	       "amf::v8::const_iterator end, amf::SerializationContext& ctx);\n\n"
+	    << "\tstatic const amf::AmfObjectTraits& traits();\n\n";
+
+	for (const Property& p : c.properties)
+		out << "\t" << cppType(p.type) << " " << p.name << ";\n";
+
+	out << "};\n\n";
+}
+
+void Generator::definition(std::ostream& out, const ClassInfo& c) {
+	const std::string& n = c.name;
+
+	// traits
+	out << "inline const amf::AmfObjectTraits& " << n << "::traits() {\n"
+	    << "\tstatic const amf::AmfObjectTraits traits = [] {\n"
+	    << "\t\tamf::AmfObjectTraits t(\"" << c.alias << "\", "
+	    << (c.dynamic ? "true" : "false") << ", false);\n";
+	for (const Property& p : c.properties)
+		out << "\t\tt.attributes.push_back(\"" << p.name << "\");\n";
+	out << "\t\treturn t;\n"
+	    << "\t}();\n\n"
+	    << "\treturn traits;\n"
+	    << "}\n\n";
+
+	// operator==
+	out << "inline bool " << n << "::operator==(const amf::AmfItem& other) const {\n"
+	    << "\tconst " << n << "* p = dynamic_cast<const " << n << "*>(&other);\n"
+	    << "\treturn p != nullptr";
+	for (const Property& p : c.properties) {
+		if (cppType(p.type) == "amf::AmfItemPtr")
+			out << " &&\n\t\tamf::AmfCodegen::equal(" << p.name << ", p->" << p.name << ")";
+		else
+			out << " &&\n\t\t" << p.name << " == p->" << p.name;
+	}
+	out << ";\n}\n\n";
+
+	// serialize
+	out << "inline amf::v8 " << n << "::serialize(amf::SerializationContext& ctx) const {\n"
+	    << "\tamf::v8 buf = amf::AmfCodegen::writeReference(*this, ctx);\n"
+	    << "\tif (!buf.empty())\n"
+	    << "\t\treturn buf;\n\n"
+	    << "\tamf::AmfCodegen::writeHeader(buf, traits(), ctx);\n";
+	for (const Property& p : c.properties)
+		out << "\t" << writer(p.type) << "(buf, " << p.name << ", ctx);\n";
+	if (c.dynamic)
+		out << "\tamf::AmfCodegen::writeDynamicEnd(buf);\n";
+	out << "\n\treturn buf;\n}\n\n";
+
+	// deserializePtr
+	out << "inline amf::AmfItemPtr " << n << "::deserializePtr(amf::v8::const_iterator& it, "
+	       "amf::v8::const_iterator end, amf::SerializationContext& ctx) {\n"
+	    << "\tamf::AmfCodegen::Header header = amf::AmfCodegen::readHeader(it, end, ctx,\n"
+	    << "\t\ttraits().className, traits().attributes);\n"
+	    << "\tif (header.reference != -1)\n"
+	    << "\t\treturn ctx.getPointer<" << n << ">(header.reference);\n\n"
+	    << "\t" << n << "* ret = new " << n << "();\n"
+	    << "\tamf::AmfItemPtr ptr(ret);\n"
+	    << "\tctx.addPointer(ptr);\n\n"
+	    << "\tif (header.inOrder) {\n";
+	for (const Property& p : c.properties)
+		out << "\t\tret->" << p.name << " = " << reader(p.type) << ";\n";
+	out << "\t} else {\n"
+	    << "\t\tfor (const std::string& name : header.attributes) {\n";
+	if (c.properties.empty())
+		out << "\t\t\t(void) name;\n\t\t\tamf::AmfCodegen::readItem(it, end, ctx);\n";
+	for (size_t i = 0; i < c.properties.size(); ++i) {
+		const Property& p = c.properties[i];
+		out << "\t\t\t" << (i == 0 ? "if" : "else if") << " (name == \"" << p.name << "\")\n"
+		    << "\t\t\t\tret->" << p.name << " = " << reader(p.type) << ";\n";
+	}
+	if (!c.properties.empty())
+		out << "\t\t\telse\n\t\t\t\tamf::AmfCodegen::readItem(it, end, ctx);\n";
+	out << "\t\t}\n"
+	    << "\t}\n\n"
+	    << "\tif (header.dynamic)\n"
+	    << "\t\tamf::AmfCodegen::skipDynamicMembers(it, end, ctx);\n\n"
+	    << "\treturn ptr;\n"
+	    << "}\n\n";
+
+	// deserialize
+	out << "inline " << n << " " << n << "::deserialize(amf::v8::const_iterator& it, "
+	       "amf::v8::const_iterator end, amf::SerializationContext& ctx) {\n"
+	    << "\treturn deserializePtr(it, end, ctx).as<" << n << ">();\n"
+	    << "}\n\n";
+}
+
+std::string guardName(const std::string& output) {
+	std::string base = output.substr(output.find_last_of("/\\") + 1);
+	if (base.empty())
+		base = "amfgen_generated.hpp";
+
+	std::string guard;
+	for (char c : base)
+		guard += std::isalnum(static_cast<unsigned char>(c)) ?
+			static_cast<char>(std::toupper(static_cast<unsigned char>(c))) : '_';
+	return guard;
+}
+
+int usage(const char* name) {
+	std::cerr << "Usage: " << name << " [-n namespace] [-o output.hpp] input.as...\n";
+	return 2;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+	std::string ns, output;
+	std::vector<std::string> inputs;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg(argv[i]);
+		if ((arg == "-n" || arg == "-o") && i + 1 < argc)
+			(arg == "-n" ? ns : output) = argv[++i];
+		else if (!arg.empty() && arg[0] == '-')
+			return usage(argv[0]);
+		else
+			inputs.push_back(arg);
+	}
+
+	if (inputs.empty())
+		return usage(argv[0]);
+
+	std::vector<ClassInfo> parsed;
+	std::map<std::string, std::string> aliases;
+	std::string sources;
+	for (const std::string& input : inputs) {
+		std::ifstream in(input.c_str());
+		if (!in) {
+			std::cerr << "amfgen: cannot read " << input << "\n";
+			return 1;
+		}
+
+		std::stringstream src;
+		src << in.rdbuf();
+
+		try {
+			Parser(tokenize(src.str())).parse(parsed, aliases);
+		} catch (std::exception& e) {
+			std::cerr << "amfgen: " << input << ": " << e.what() << "\n";
+			return 1;
+		}
+
+		sources += (sources.empty() ? "" : ", ") +
+			input.substr(input.find_last_of("/\\") + 1);
+	}
+
+	std::vector<ClassInfo> classes;
+	for (ClassInfo& c : parsed) {
+		if (c.alias.empty() && aliases.count(c.name))
+			c.alias = aliases[c.name];
+
+		if (c.alias.empty())
+			continue;
+
+		if (c.externalizable) {
+			std::cerr << "amfgen: skipping externalizable class " << c.name << "\n";
+			continue;
+		}
+
+		classes.push_back(c);
+	}
+
+	if (classes.empty()) {
+		std::cerr << "amfgen: no remote classes found\n";
+		return 1;
+	}
+
+	Generator generator(classes, ns);
+	if (output.empty()) {
+		generator.generate(std::cout, guardName(output), sources);
+	} else {
+		std::ofstream out(output.c_str());
+		generator.generate(out, guardName(output), sources);
+		if (!out) {
+			std::cerr << "amfgen: cannot write " << output << "\n";
+			return 1;
+		}
+	}
+
+	return 0;
+}